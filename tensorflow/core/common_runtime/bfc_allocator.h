@@ -34,11 +34,13 @@ limitations under the License.
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tsl/framework/bfc_allocator.h"
+#include "tsl/framework/size_class_cache_allocator.h"
 
 namespace tensorflow {
 
 class MemoryDump;         // NOLINT
 using tsl::BFCAllocator;  // NOLINT
+using tsl::SizeClassCacheAllocator;  // NOLINT
 
 }  // namespace tensorflow
 
@@ -50,6 +50,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/run_handler.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
@@ -63,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/threadpool_options.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/numbers.h"
@@ -160,6 +162,46 @@ string GetRendezvousKey(const string& tensor_name,
                          frame_iter.frame_id, ":", frame_iter.iter_id);
 }
 
+// Wraps the caller's call frame for a step that uses step arenas, copying any
+// return value that was allocated from one of them so that fetched tensors
+// never pin an arena past the end of the step.
+class StepArenaCallFrame : public CallFrameInterface {
+ public:
+  StepArenaCallFrame(
+      CallFrameInterface* wrapped,
+      const std::vector<core::RefCountPtr<StepArenaAllocator>>* step_arenas)
+      : wrapped_(wrapped), step_arenas_(step_arenas) {}
+
+  size_t num_args() const override { return wrapped_->num_args(); }
+  size_t num_retvals() const override { return wrapped_->num_retvals(); }
+
+  Status GetArg(int index, const Tensor** val) override {
+    return wrapped_->GetArg(index, val);
+  }
+  void ConsumeArg(int index, Tensor* val) override {
+    wrapped_->ConsumeArg(index, val);
+  }
+  bool CanConsumeArg(int index) const override {
+    return wrapped_->CanConsumeArg(index);
+  }
+
+  Status SetRetval(int index, const Tensor& val) override {
+    if (val.IsInitialized() && val.TotalBytes() > 0) {
+      for (const auto& arena : *step_arenas_) {
+        if (arena && arena->Owns(val.data())) {
+          return wrapped_->SetRetval(index, tensor::DeepCopy(val));
+        }
+      }
+    }
+    return wrapped_->SetRetval(index, val);
+  }
+
+ private:
+  CallFrameInterface* const wrapped_;  // Not owned.
+  const std::vector<core::RefCountPtr<StepArenaAllocator>>* const
+      step_arenas_;  // Not owned.
+};
+
 }  // namespace
 
 class DirectSessionFactory : public SessionFactory {
@@ -710,6 +752,33 @@ Status DirectSession::RunInternal(
   }
   args.cancellation_manager = &step_cancellation_manager;
 
+  // Lease a step arena for every partition that uses one. The arenas are
+  // returned when this function exits, by which point all executors for the
+  // step have finished.
+  std::vector<core::RefCountPtr<StepArenaAllocator>> step_arenas(
+      executors_and_keys->items.size());
+  for (size_t i = 0; i < executors_and_keys->items.size(); ++i) {
+    if (executors_and_keys->items[i].step_arenas) {
+      step_arenas[i] = executors_and_keys->items[i].step_arenas->Acquire();
+    }
+  }
+  auto release_step_arenas = gtl::MakeCleanup([&step_arenas,
+                                               executors_and_keys]() {
+    for (size_t i = 0; i < step_arenas.size(); ++i) {
+      if (step_arenas[i]) {
+        executors_and_keys->items[i].step_arenas->Release(
+            std::move(step_arenas[i]));
+      }
+    }
+  });
+  absl::optional<StepArenaCallFrame> step_arena_call_frame;
+  if (call_frame != nullptr &&
+      std::any_of(step_arenas.begin(), step_arenas.end(),
+                  [](const auto& arena) { return arena != nullptr; })) {
+    step_arena_call_frame.emplace(call_frame, &step_arenas);
+    args.call_frame = &*step_arena_call_frame;
+  }
+
   Status run_status;
 
   auto set_threadpool_args_for_item =
@@ -742,6 +811,7 @@ Status DirectSession::RunInternal(
 
     const auto& item = executors_and_keys->items[0];
     set_threadpool_args_for_item(item, &args);
+    args.step_arena = step_arenas[0].get();
     run_status = item.executor->Run(args);
   } else {
     core::RefCountPtr<RefCountedIntraProcessRendezvous> rendezvous(
@@ -760,8 +830,10 @@ Status DirectSession::RunInternal(
                               executors_done.Notify();
                             });
 
-    for (const auto& item : executors_and_keys->items) {
+    for (size_t i = 0; i < executors_and_keys->items.size(); ++i) {
+      const auto& item = executors_and_keys->items[i];
       set_threadpool_args_for_item(item, &args);
+      args.step_arena = step_arenas[i].get();
       item.executor->RunAsync(args, barrier->Get());
     }
 
@@ -1423,6 +1495,12 @@ Status DirectSession::CreateExecutors(
       if (kernel && !OpSegment::ShouldOwnKernel(lib, kernel->type_string()))
         delete kernel;
     };
+    // Partial runs keep tensors alive across calls, so they never use the
+    // per-step arena.
+    params.enable_step_arena =
+        options_.config.experimental().enable_per_step_arena() &&
+        !run_state_args->is_partial_run &&
+        device->device_type() == DEVICE_CPU;
 
     optimizer.Optimize(lib, options_.env, device, &partition_graph,
                        GraphOptimizer::Options());
@@ -1441,6 +1519,11 @@ Status DirectSession::CreateExecutors(
 
     item->executor = nullptr;
     item->device = device;
+    if (params.enable_step_arena) {
+      item->step_arenas = std::make_unique<StepArenaPool>(
+          device->GetAllocator(AllocatorAttributes()),
+          StepArenaAllocator::Options());
+    }
     auto executor_type = options_.config.experimental().executor_type();
     TF_RETURN_IF_ERROR(
         NewExecutor(executor_type, params, *partition_graph, &item->executor));
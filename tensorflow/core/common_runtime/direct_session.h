@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -148,6 +149,10 @@ class DirectSession : public Session {
     Device* device = nullptr;                // not owned.
     FunctionLibraryRuntime* flib = nullptr;  // not owned.
     std::unique_ptr<Executor> executor;
+    // Arenas for step-local temporaries; null unless
+    // `ConfigProto.Experimental.enable_per_step_arena` is set and the
+    // partition runs on a CPU device.
+    std::unique_ptr<StepArenaPool> step_arenas;
   };
 
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
@@ -2801,6 +2801,108 @@ BENCHMARK(BM_FeedFetchCallableSingleThreadExecutor)
     ->Arg(5)
     ->Arg(10);
 
+// Builds `num_branches` chains of small elementwise ops on a fed vector `x`,
+// where branch i computes (i + 1) * x + chain_length * x, and sums them into
+// one fetch. This resembles the many small intermediates of the dense part of
+// a recommendation model.
+GraphDef SmallTensorBranchesGraph(int num_branches, int chain_length,
+                                  string* feed, string* fetch) {
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_CHECK_OK(NodeBuilder(g.NewName("Placeholder"), "Placeholder")
+                  .Attr("shape", TensorShape({64}))
+                  .Attr("dtype", DT_FLOAT)
+                  .Device("/cpu:0")
+                  .Finalize(&g, &x));
+  Node* sum = nullptr;
+  for (int i = 0; i < num_branches; ++i) {
+    Node* y = test::graph::Binary(
+        &g, "Mul", x, test::graph::Constant(&g, test::AsScalar<float>(i + 1)));
+    for (int j = 0; j < chain_length; ++j) {
+      y = test::graph::Binary(&g, "Add", y, x);
+    }
+    sum = sum == nullptr ? y : test::graph::Binary(&g, "Add", sum, y);
+  }
+  *feed = x->name() + ":0";
+  *fetch = sum->name() + ":0";
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  return gd;
+}
+
+TEST(DirectSessionTest, PerStepArenaMatchesDefaultAllocation) {
+  string feed, fetch;
+  GraphDef gd = SmallTensorBranchesGraph(/*num_branches=*/8,
+                                         /*chain_length=*/4, &feed, &fetch);
+  Tensor x(DT_FLOAT, TensorShape({64}));
+  x.flat<float>().setConstant(2.0f);
+
+  for (bool enable_arena : {false, true}) {
+    SessionOptions options = DefaultSessionOptions();
+    options.config.mutable_experimental()->set_enable_per_step_arena(
+        enable_arena);
+    std::unique_ptr<Session> session(NewSession(options));
+    TF_ASSERT_OK(session->Create(gd));
+    std::vector<Tensor> first;
+    for (int step = 0; step < 3; ++step) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run({{feed, x}}, {fetch}, {}, &outputs));
+      ASSERT_EQ(1, outputs.size());
+      // 2 * ((1 + 2 + ... + 8) + 8 * 4)
+      EXPECT_EQ(136.0f, outputs[0].flat<float>()(63));
+      if (step == 0) {
+        first = outputs;
+      }
+    }
+    // Fetched tensors are copied out of the arena, so earlier results are not
+    // overwritten by later steps.
+    EXPECT_EQ(136.0f, first[0].flat<float>()(0));
+  }
+}
+
+// Reports the number of allocations that reach the CPU allocator per step,
+// with and without the per-step arena.
+void BM_SmallTensorBranches(::testing::benchmark::State& state) {
+  const bool enable_arena = state.range(0);
+  const int num_branches = state.range(1);
+
+  string feed, fetch;
+  GraphDef gd = SmallTensorBranchesGraph(num_branches, /*chain_length=*/4,
+                                         &feed, &fetch);
+  Tensor x(DT_FLOAT, TensorShape({64}));
+  x.flat<float>().setConstant(1.0f);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_enable_per_step_arena(
+      enable_arena);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_CHECK_OK(session->Create(gd));
+  {
+    // Ignore the first run, which builds the executors.
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({{feed, x}}, {fetch}, {}, &outputs));
+  }
+
+  EnableCPUAllocatorStats();
+  cpu_allocator()->ClearStats();
+  for (auto s : state) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({{feed, x}}, {fetch}, {}, &outputs));
+  }
+  absl::optional<AllocatorStats> stats = cpu_allocator()->GetStats();
+  DisableCPUAllocatorStats();
+  if (stats && state.iterations() > 0) {
+    state.counters["allocs_per_step"] =
+        static_cast<double>(stats->num_allocs) / state.iterations();
+  }
+}
+
+BENCHMARK(BM_SmallTensorBranches)
+    ->ArgPair(false, 16)
+    ->ArgPair(true, 16)
+    ->ArgPair(false, 128)
+    ->ArgPair(true, 128);
+
 }  // namespace
 
 class DirectSessionCollectiveTest : public ::testing::Test {
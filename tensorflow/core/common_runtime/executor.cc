@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -62,6 +63,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -145,9 +147,153 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Name under which the work-stealing variant of the default executor is
+// registered with `ExecutorFactory`.
+static const char* const kWorkStealingExecutor = "WORK_STEALING_EXECUTOR";
+
+// Per-worker ready queues used by the work-stealing executor mode.
+//
+// Every inter-op closure that runs nodes for a step acts as a "worker" and owns
+// one slot. Nodes that become ready on a worker are pushed onto its own slot
+// and popped back in LIFO order, so the successors of a finished node tend to
+// run on the thread that produced their inputs. Workers whose slot is empty
+// steal from the front of the other slots, and a worker exits once there is
+// nothing left to steal. The queues are shared with the workers, because a
+// worker may still look at them after the last node of the step has finished
+// and the `ExecutorState` has been deleted.
+template <class TaggedNode>
+class WorkStealingReadyQueues {
+ public:
+  explicit WorkStealingReadyQueues(int num_slots)
+      : num_slots_(num_slots), slots_(new Slot[num_slots]) {}
+
+  // Binds the calling thread to a slot for the lifetime of this object.
+  class ScopedWorker {
+   public:
+    explicit ScopedWorker(WorkStealingReadyQueues* queues)
+        : prev_queues_(current_queues_), prev_slot_(current_slot_) {
+      current_queues_ = queues;
+      current_slot_ = queues->next_slot_.fetch_add(
+                          1, std::memory_order_relaxed) %
+                      queues->num_slots_;
+    }
+    ~ScopedWorker() {
+      current_queues_ = prev_queues_;
+      current_slot_ = prev_slot_;
+    }
+
+    int slot() const { return current_slot_; }
+
+   private:
+    const WorkStealingReadyQueues* const prev_queues_;
+    const int prev_slot_;
+  };
+
+  // Returns true if the calling thread is a worker of these queues.
+  bool IsWorkerThread() const { return current_queues_ == this; }
+
+  // Pushes the nodes in [begin, end) onto the calling worker's slot.
+  //
+  // REQUIRES: `IsWorkerThread()`.
+  template <typename Iter>
+  void Push(Iter begin, Iter end) {
+    DCHECK(IsWorkerThread());
+    if (begin == end) return;
+    Slot& slot = slots_[current_slot_];
+    {
+      mutex_lock l(slot.mu);
+      slot.nodes.insert(slot.nodes.end(), begin, end);
+    }
+    num_queued_.fetch_add(end - begin);
+  }
+
+  // Pops the most recently pushed node from `slot`, or steals the oldest node
+  // from another slot if `slot` is empty. Returns `std::nullopt` if all slots
+  // are empty.
+  std::optional<TaggedNode> Pop(int slot) {
+    if (num_queued_.load() == 0) return std::nullopt;
+    for (int i = 0; i < num_slots_; ++i) {
+      Slot& victim = slots_[(slot + i) % num_slots_];
+      mutex_lock l(victim.mu);
+      if (victim.head == victim.nodes.size()) continue;
+      std::optional<TaggedNode> node;
+      if (i == 0) {
+        node.emplace(victim.nodes.back());
+        victim.nodes.pop_back();
+      } else {
+        node.emplace(victim.nodes[victim.head++]);
+      }
+      if (victim.head == victim.nodes.size()) {
+        victim.nodes.clear();
+        victim.head = 0;
+      }
+      num_queued_.fetch_sub(1);
+      return node;
+    }
+    return std::nullopt;
+  }
+
+  // Registers up to `num_nodes` new workers, without exceeding the number of
+  // slots, and returns how many the caller must start.
+  int ReserveWorkers(int num_nodes) {
+    int num_workers = num_workers_.load();
+    while (true) {
+      const int num_new = std::min(num_nodes, num_slots_ - num_workers);
+      if (num_new <= 0) return 0;
+      if (num_workers_.compare_exchange_weak(num_workers,
+                                             num_workers + num_new)) {
+        return num_new;
+      }
+    }
+  }
+
+  // Registers one new worker regardless of the current number of workers.
+  void AddWorker() { num_workers_.fetch_add(1); }
+
+  // Called by a worker that found all slots empty. Returns true if the worker
+  // should exit, or false if nodes were pushed concurrently and the worker
+  // should keep stealing.
+  bool TryRetireWorker() {
+    int num_workers = num_workers_.fetch_sub(1) - 1;
+    while (num_queued_.load() > 0 && num_workers < num_slots_) {
+      if (num_workers_.compare_exchange_weak(num_workers, num_workers + 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Aligned to avoid false sharing between the slots of different workers.
+  struct alignas(64) Slot {
+    mutex mu;
+    // The queued nodes are `nodes[head:]`. The owner pops from the back, and
+    // thieves take from the front.
+    std::vector<TaggedNode> nodes TF_GUARDED_BY(mu);
+    size_t head TF_GUARDED_BY(mu) = 0;
+  };
+
+  static thread_local const WorkStealingReadyQueues* current_queues_;
+  static thread_local int current_slot_;
+
+  const int num_slots_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<int64_t> num_queued_{0};
+  std::atomic<int> num_workers_{0};
+  std::atomic<uint32> next_slot_{0};
+};
+
+template <class TaggedNode>
+thread_local const WorkStealingReadyQueues<TaggedNode>*
+    WorkStealingReadyQueues<TaggedNode>::current_queues_ = nullptr;
+template <class TaggedNode>
+thread_local int WorkStealingReadyQueues<TaggedNode>::current_slot_ = -1;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool use_work_stealing = false)
+      : immutable_state_(p), use_work_stealing_(use_work_stealing) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
@@ -226,6 +372,10 @@ class ExecutorImpl : public Executor {
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // If true, ready nodes are scheduled through per-worker work-stealing queues
+  // instead of one inter-op closure per expensive node.
+  const bool use_work_stealing_;
+
   ExecutorImpl(const ExecutorImpl&) = delete;
   void operator=(const ExecutorImpl&) = delete;
 };
@@ -284,7 +434,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                bool use_work_stealing = false);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -295,6 +446,7 @@ class ExecutorState {
   typedef
       typename PropagatorStateType::TaggedNodeReadyQueue TaggedNodeReadyQueue;
   typedef typename PropagatorStateType::TaggedNodeSeq TaggedNodeSeq;
+  typedef WorkStealingReadyQueues<TaggedNode> WorkQueues;
 
   struct AsyncState;
 
@@ -340,6 +492,24 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Work-stealing mode only. Hands one of the nodes in [begin, end) to each
+  // newly started worker, and pushes the rest onto the calling worker's queue.
+  //
+  // REQUIRES: The calling thread is a worker of `work_queues_`.
+  void ShareWithWorkers(typename TaggedNodeSeq::const_iterator begin,
+                        typename TaggedNodeSeq::const_iterator end,
+                        int64_t scheduled_nsec);
+
+  // Work-stealing mode only. Processes the nodes in `ready`, then keeps
+  // running nodes from `queues` until all of its slots are empty.
+  //
+  // This is a static method because `state` may be deleted by the time the
+  // worker finds no more nodes to run. `state` is dereferenced only while the
+  // worker holds a node that has not completed yet.
+  static void RunWorker(ExecutorState* state,
+                        std::shared_ptr<WorkQueues> queues,
+                        TaggedNodeSeq ready, int64_t scheduled_nsec);
+
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
   // directly.
@@ -370,6 +540,9 @@ class ExecutorState {
   // TODO(fishx): Make it configurable if necessary.
   static constexpr uint64 kInlineScheduleReadyThreshold = 500;
 
+  // Non-null iff the executor runs in work-stealing mode.
+  std::shared_ptr<WorkQueues> work_queues_;
+
   // Not owned.
   RendezvousInterface* rendezvous_;
   CollectiveExecutor* collective_executor_ = nullptr;
@@ -398,6 +571,9 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
+  // Non-null iff the executor computed step-local outputs and the caller
+  // provided an arena for this step.
+  Allocator* const step_arena_;
 
   PropagatorStateType propagator_;
 
@@ -419,7 +595,7 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, bool use_work_stealing)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -448,6 +624,8 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
+      step_arena_(immutable_state.params().enable_step_arena ? args.step_arena
+                                                             : nullptr),
       propagator_(immutable_state, step_id_, vlog_),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
@@ -455,6 +633,9 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (use_work_stealing && !run_all_kernels_inline_) {
+    work_queues_ = std::make_shared<WorkQueues>(port::MaxParallelism());
+  }
 }
 
 template <class PropagatorStateType>
@@ -863,6 +1044,8 @@ void ExecutorState<PropagatorStateType>::ProcessInline(
             /*level=*/2);
 
     params->track_allocations = false;
+    params->step_arena_allocator =
+        item.outputs_are_step_local ? step_arena_ : nullptr;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.get_is_dead()) {
       stats = stats_collector_->CreateNodeExecStats(&item.kernel->def());
@@ -1297,6 +1480,35 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         inline_ready->push_back(tagged_node);
       }
     }
+  } else if (work_queues_ != nullptr) {
+    if (inline_ready == nullptr) {
+      // We are not running on one of this step's workers, e.g. when activating
+      // the roots or when an asynchronous kernel completes. Hand the whole
+      // batch to a single new worker, which shares it out from there.
+      work_queues_->AddWorker();
+      RunTask([this, queues = work_queues_, ready = std::move(*ready),
+               scheduled_nsec]() mutable {
+        RunWorker(this, std::move(queues), std::move(ready), scheduled_nsec);
+      });
+    } else {
+      // Inline the inexpensive nodes as usual. The expensive ones stay on this
+      // worker's queue, except for one per idle worker that we wake up.
+      TaggedNodeSeq expensive_nodes;
+      for (auto& tagged_node : *ready) {
+        const NodeItem& item = *tagged_node.node_item;
+        if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+          inline_ready->push_back(tagged_node);
+        } else {
+          expensive_nodes.push_back(tagged_node);
+        }
+      }
+      auto begin = expensive_nodes.cbegin();
+      if (inline_ready->empty() && begin != expensive_nodes.cend()) {
+        inline_ready->push_back(*begin);
+        ++begin;
+      }
+      ShareWithWorkers(begin, expensive_nodes.cend(), scheduled_nsec);
+    }
   } else {
     const TaggedNode* curr_expensive_node = nullptr;
     TaggedNodeSeq expensive_nodes;
@@ -1374,6 +1586,55 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ShareWithWorkers(
+    typename TaggedNodeSeq::const_iterator begin,
+    typename TaggedNodeSeq::const_iterator end, int64_t scheduled_nsec) {
+  if (begin == end) return;
+  const int num_new_workers = work_queues_->ReserveWorkers(end - begin);
+  const auto first_queued = begin + num_new_workers;
+  // NOTE: The calling worker still holds a node that has not completed, so
+  // `this` stays alive until all new workers have been dispatched.
+  work_queues_->Push(first_queued, end);
+  for (auto it = begin; it != first_queued; ++it) {
+    TaggedNodeSeq seed;
+    seed.push_back(*it);
+    RunTask(
+        [this, queues = work_queues_, seed = std::move(seed),
+         scheduled_nsec]() mutable {
+          RunWorker(this, std::move(queues), std::move(seed), scheduled_nsec);
+        },
+        /*sample_rate=*/num_new_workers);
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorker(
+    ExecutorState* state, std::shared_ptr<WorkQueues> queues,
+    TaggedNodeSeq ready, int64_t scheduled_nsec) {
+  profiler::TraceMe activity(
+      [&]() {
+        return strings::StrCat("ExecutorState::RunWorker#",
+                               "ready_size=", ready.size(), "#");
+      },
+      profiler::GetTFTraceMeLevel(/*is_expensive=*/false));
+  typename WorkQueues::ScopedWorker worker(queues.get());
+  if (!ready.empty()) {
+    TaggedNodeReadyQueue inline_ready;
+    inline_ready.push_back(*ready.begin());
+    state->ShareWithWorkers(ready.cbegin() + 1, ready.cend(), scheduled_nsec);
+    state->ProcessInline(&inline_ready, scheduled_nsec);
+  }
+  while (true) {
+    std::optional<TaggedNode> tagged_node = queues->Pop(worker.slot());
+    if (tagged_node.has_value()) {
+      state->Process(*tagged_node, scheduled_nsec);
+    } else if (queues->TryRetireWorker()) {
+      return;
+    }
+  }
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1516,11 +1777,12 @@ void ExecutorImpl::RunAsyncInternal(const Args& args, DoneCallback done) {
                                                &kernel_stats_))
         ->RunAsync(std::move(done));
   } else if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        use_work_stealing_))
         ->RunAsync(std::move(done));
   } else {
-    (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, use_work_stealing_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1559,6 +1821,7 @@ class DefaultExecutorRegistrar {
     Factory* factory = new Factory;
     ExecutorFactory::Register("", factory);
     ExecutorFactory::Register("DEFAULT", factory);
+    ExecutorFactory::Register(kWorkStealingExecutor, new WorkStealingFactory);
   }
 
  private:
@@ -1571,6 +1834,20 @@ class DefaultExecutorRegistrar {
       return absl::OkStatus();
     }
   };
+
+  // Creates executors that keep the successors of a finished node on the
+  // inter-op thread that ran it, and let idle inter-op threads steal ready
+  // nodes from each other. See `WorkStealingReadyQueues`.
+  class WorkStealingFactory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = std::make_unique<ExecutorImpl>(params,
+                                                 /*use_work_stealing=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return absl::OkStatus();
+    }
+  };
 };
 static DefaultExecutorRegistrar registrar;
 
@@ -125,6 +125,12 @@ class Executor {
     // If true, all kernels will be treated as "inexpensive", and hence executed
     // on the scheduling thread.
     bool run_all_kernels_inline = false;
+
+    // If non-null and the executor was created with
+    // `LocalExecutorParams::enable_step_arena`, allocations made by kernels
+    // whose outputs never outlive this step are served from `step_arena`.
+    // Not owned; must outlive the step.
+    Allocator* step_arena = nullptr;
   };
   typedef std::function<void(const Status&)> DoneCallback;
 
@@ -158,6 +164,11 @@ class Executor {
 //
 // "params" provides a set of context for the executor. We expect that
 // different context would provide different implementations.
+//
+// A variant of this executor that schedules ready nodes through per-worker
+// work-stealing queues is registered with `ExecutorFactory` as
+// "WORK_STEALING_EXECUTOR", and can be selected through
+// `ConfigProto.experimental.executor_type`.
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph& graph, Executor** executor);
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
@@ -78,7 +79,8 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -93,7 +95,9 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type, params, *graph, &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -266,6 +270,23 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING_EXECUTOR");
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous::Args args;
+    TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args,
+                               V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -443,7 +464,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(::testing::benchmark::State& state) {
+static void BM_executor_helper(::testing::benchmark::State& state,
+                               const char* executor_type) {
   const int width = state.range(0);
   const int depth = state.range(1);
 
@@ -477,12 +499,19 @@ static void BM_executor(::testing::benchmark::State& state) {
   }
 
   FixupSourceAndSinkEdges(g);
-  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type,
+                  /*old_benchmark_api=*/false)
+      .Run(state);
 
   state.SetLabel(strings::StrCat("Nodes = ", cur));
   state.SetItemsProcessed(cur * static_cast<int64_t>(state.iterations()));
 }
 
+static void BM_executor(::testing::benchmark::State& state) {
+  BM_executor_helper(state, /*executor_type=*/"");
+}
+
 // Tall skinny graphs
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(32, 8192);
@@ -494,6 +523,18 @@ BENCHMARK(BM_executor)->UseRealTime()->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->UseRealTime()->ArgPair(1024, 1024);
 
+static void BM_executor_work_stealing(::testing::benchmark::State& state) {
+  BM_executor_helper(state, "WORK_STEALING_EXECUTOR");
+}
+
+// Same shapes as BM_executor, for comparing step latency with the
+// work-stealing executor.
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(32, 8192);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(8192, 32);
+BENCHMARK(BM_executor_work_stealing)->UseRealTime()->ArgPair(1024, 1024);
+
 static void BM_const_identity(::testing::benchmark::State& state) {
   const int width = state.range(0);
   const int outputs_per_const = state.range(1);
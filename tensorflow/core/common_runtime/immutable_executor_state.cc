@@ -217,6 +217,7 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     item->is_recv_or_switch = IsRecv(n) || IsSwitch(n);
     item->is_next_iteration = IsNextIteration(n);
     item->is_distributed_communication = IsDistributedCommunication(n);
+    item->outputs_are_step_local = false;
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -290,6 +291,10 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     }
   }
 
+  if (params_.enable_step_arena) {
+    ComputeStepLocalOutputs(graph);
+  }
+
   // Initialize PendingCounts only after pending_ids_[node.id] is initialized
   // for all nodes.
   InitializePending(&graph, cf_info);
@@ -316,6 +321,53 @@ bool ExtractScopedAllocatorAttr(const std::vector<int>& sc_attr,
 }
 }  // namespace
 
+void ImmutableExecutorState::ComputeStepLocalOutputs(const Graph& graph) {
+  // A tensor escapes the step if it can reach a node that may retain it past
+  // the end of the step. Stateless kernels may alias or forward an input
+  // buffer to an output, so a producer escapes whenever any of its data
+  // consumers escapes, and we propagate backwards from the retaining nodes.
+  // Return values are not retaining: the caller copies any fetched tensor
+  // that lives in the arena before the step ends.
+  const int num_nodes = graph.num_node_ids();
+  std::vector<bool> escapes(num_nodes, false);
+  std::vector<const Node*> ready;
+  for (const Node* n : graph.nodes()) {
+    if (!n->IsOp() || n->op_def().is_stateful() || IsTransferNode(n) ||
+        n->IsFunctionCall() ||
+        gview_.node(n->id())->is_any_input_ref_typed) {
+      escapes[n->id()] = true;
+      ready.push_back(n);
+      continue;
+    }
+    for (DataType dt : n->output_types()) {
+      if (IsRefType(dt)) {
+        escapes[n->id()] = true;
+        ready.push_back(n);
+        break;
+      }
+    }
+  }
+  while (!ready.empty()) {
+    const Node* n = ready.back();
+    ready.pop_back();
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge() || escapes[e->src()->id()]) continue;
+      escapes[e->src()->id()] = true;
+      ready.push_back(e->src());
+    }
+  }
+
+  int num_step_local = 0;
+  for (const Node* n : graph.nodes()) {
+    if (IsSink(n) || escapes[n->id()]) continue;
+    gview_.node(n->id())->outputs_are_step_local = true;
+    ++num_step_local;
+  }
+  VLOG(1) << num_step_local << " of " << graph.num_op_nodes()
+          << " nodes on " << params_.device->name()
+          << " may allocate from the step arena";
+}
+
 Status ImmutableExecutorState::BuildControlFlowInfo(const Graph* g,
                                                     ControlFlowInfo* cf_info) {
   const int num_nodes = g->num_node_ids();
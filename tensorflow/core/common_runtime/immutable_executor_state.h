@@ -133,6 +133,10 @@ class ImmutableExecutorState {
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
 
+  // Sets NodeItem::outputs_are_step_local for every node whose outputs cannot
+  // reach a send, a function call or a stateful op.
+  void ComputeStepLocalOutputs(const Graph& graph);
+
   FrameInfo* EnsureFrameInfo(const string& fname);
 
   // Owned.
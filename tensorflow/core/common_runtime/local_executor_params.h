@@ -50,6 +50,11 @@ struct LocalExecutorParams {
 
   // Whether control flow nodes are allowed to be executed synchronously.
   bool allow_control_flow_sync_execution = false;
+
+  // If true, the executor computes which nodes only produce tensors that are
+  // consumed within a step (see NodeItem::outputs_are_step_local), and serves
+  // their allocations from `Executor::Args::step_arena` when one is provided.
+  bool enable_step_arena = false;
 };
 
 }  // end namespace tensorflow
@@ -44,7 +44,9 @@ namespace tensorflow {
 }
 
 ProcessState::ProcessState()
-    : numa_enabled_(false), cpu_allocators_cached_(0) {}
+    : numa_enabled_(false),
+      cpu_size_class_cache_enabled_(false),
+      cpu_allocators_cached_(0) {}
 
 string ProcessState::MemDesc::DebugString() {
   return strings::StrCat((loc == CPU ? "CPU " : "GPU "), dev_index,
@@ -76,9 +78,19 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
     // depending on env var setting.
     const bool alloc_visitors_defined =
         (!cpu_alloc_visitors_.empty() || !cpu_free_visitors_.empty());
+    // Size-class caches serve small allocations in front of a BFCAllocator,
+    // so that inter-op threads do not all serialize on the BFC mutex.
+    bool use_size_class_cache = false;
+    Status status = ReadBoolFromEnvVar("TF_CPU_BFC_USE_SIZE_CLASS_CACHE",
+                                       cpu_size_class_cache_enabled_,
+                                       &use_size_class_cache);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCPUAllocator: " << status.message();
+    }
     bool use_bfc_allocator = false;
-    Status status = ReadBoolFromEnvVar(
-        "TF_CPU_ALLOCATOR_USE_BFC", alloc_visitors_defined, &use_bfc_allocator);
+    status = ReadBoolFromEnvVar("TF_CPU_ALLOCATOR_USE_BFC",
+                                alloc_visitors_defined || use_size_class_cache,
+                                &use_bfc_allocator);
     if (!status.ok()) {
       LOG(ERROR) << "GetCPUAllocator: " << status.message();
     }
@@ -109,6 +121,15 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
 
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
+
+      if (use_size_class_cache) {
+        allocator = new SizeClassCacheAllocator(
+            absl::WrapUnique(allocator),
+            /*name=*/"size_class_cache_cpu_bfc_allocator",
+            SizeClassCacheAllocator::Options());
+        VLOG(2) << "Using size-class caches in front of the ProcessState CPU "
+                << "BFCAllocator";
+      }
     } else if (sub_allocator) {
       DCHECK(sub_allocator);
       allocator =
@@ -58,6 +58,11 @@ class ProcessState : public ProcessStateInterface {
   // Allocator accessor.
   void EnableNUMA() { numa_enabled_ = true; }
 
+  // If the CPU allocators should serve small allocations from per-thread
+  // size-class caches in front of a BFCAllocator, call this before calling
+  // any Allocator accessor.
+  void EnableCPUSizeClassCache() { cpu_size_class_cache_enabled_ = true; }
+
   // Returns what we know about the memory at ptr.
   // If we know nothing, it's called CPU 0 with no other attributes.
   MemDesc PtrType(const void* ptr);
@@ -93,6 +98,7 @@ class ProcessState : public ProcessStateInterface {
 
   static ProcessState* instance_;
   bool numa_enabled_;
+  bool cpu_size_class_cache_enabled_;
 
   mutex mu_;
 
@@ -0,0 +1,173 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t n, size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* backing,
+                                       const Options& options)
+    : backing_(backing), options_(options) {
+  CHECK(backing_ != nullptr);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  mutex_lock l(mu_);
+  DCHECK(backing_allocations_.empty());
+  FreeChunks();
+}
+
+bool StepArenaAllocator::AddChunk(size_t min_bytes) {
+  const size_t size = std::max(options_.chunk_bytes, min_bytes);
+  if (total_chunk_bytes_ + size > options_.max_arena_bytes) {
+    return false;
+  }
+  void* base = backing_->AllocateRaw(Allocator::kAllocatorAlignment, size);
+  if (base == nullptr) {
+    return false;
+  }
+  chunks_.push_back({static_cast<char*>(base), size});
+  total_chunk_bytes_ += size;
+  offset_ = 0;
+  return true;
+}
+
+void StepArenaAllocator::FreeChunks() {
+  for (const Chunk& chunk : chunks_) {
+    backing_->DeallocateRaw(chunk.base);
+  }
+  chunks_.clear();
+  total_chunk_bytes_ = 0;
+  offset_ = 0;
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  // Every allocation, including forwarded ones, keeps the arena alive until
+  // it is deallocated.
+  Ref();
+  const size_t align = std::max(alignment, Allocator::kAllocatorAlignment);
+  if (num_bytes <= options_.max_arena_allocation_bytes &&
+      align <= Allocator::kAllocatorAlignment) {
+    mutex_lock l(mu_);
+    size_t start = RoundUp(offset_, align);
+    if (chunks_.empty() || start + num_bytes > chunks_.back().size) {
+      start = AddChunk(num_bytes) ? 0 : SIZE_MAX;
+    }
+    if (start != SIZE_MAX) {
+      offset_ = start + num_bytes;
+      num_arena_allocations_.fetch_add(1, std::memory_order_relaxed);
+      return chunks_.back().base + start;
+    }
+  }
+
+  void* ptr = backing_->AllocateRaw(alignment, num_bytes);
+  if (ptr == nullptr) {
+    Unref();
+    return nullptr;
+  }
+  num_backing_allocations_.fetch_add(1, std::memory_order_relaxed);
+  mutex_lock l(mu_);
+  backing_allocations_.insert(ptr);
+  num_live_backing_allocations_.fetch_add(1, std::memory_order_release);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (num_live_backing_allocations_.load(std::memory_order_acquire) > 0) {
+    bool forwarded;
+    {
+      mutex_lock l(mu_);
+      forwarded = backing_allocations_.erase(ptr) > 0;
+      if (forwarded) {
+        num_live_backing_allocations_.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+    if (forwarded) {
+      backing_->DeallocateRaw(ptr);
+    }
+  }
+  // May delete `this`.
+  Unref();
+}
+
+bool StepArenaAllocator::Owns(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  mutex_lock l(mu_);
+  for (const Chunk& chunk : chunks_) {
+    if (p >= chunk.base && p < chunk.base + chunk.size) {
+      return true;
+    }
+  }
+  return backing_allocations_.contains(ptr);
+}
+
+void StepArenaAllocator::Reset() {
+  DCHECK(RefCountIsOne());
+  mutex_lock l(mu_);
+  if (chunks_.size() > 1) {
+    // Size the arena for the whole of the previous step so that the next one
+    // is served from a single chunk.
+    const size_t total = total_chunk_bytes_;
+    FreeChunks();
+    AddChunk(total);
+  }
+  offset_ = 0;
+}
+
+StepArenaPool::StepArenaPool(Allocator* backing,
+                             const StepArenaAllocator::Options& options)
+    : backing_(backing), options_(options) {}
+
+StepArenaPool::~StepArenaPool() {}
+
+core::RefCountPtr<StepArenaAllocator> StepArenaPool::Acquire() {
+  {
+    mutex_lock l(mu_);
+    if (!free_.empty()) {
+      core::RefCountPtr<StepArenaAllocator> arena = std::move(free_.back());
+      free_.pop_back();
+      return arena;
+    }
+  }
+  return core::RefCountPtr<StepArenaAllocator>(
+      new StepArenaAllocator(backing_, options_));
+}
+
+void StepArenaPool::Release(core::RefCountPtr<StepArenaAllocator> arena) {
+  if (!arena->RefCountIsOne()) {
+    // Some buffer from this step is still alive. Dropping our reference lets
+    // the arena free itself once that buffer goes away.
+    VLOG(1) << "Step arena still has live allocations; not reusing it.";
+    return;
+  }
+  arena->Reset();
+  mutex_lock l(mu_);
+  free_.push_back(std::move(arena));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,152 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bump allocator whose memory is reclaimed as a whole rather than per
+// allocation.
+//
+// A StepArenaAllocator is leased from a StepArenaPool for the duration of one
+// step and serves the temporaries of kernels whose outputs cannot outlive that
+// step. DeallocateRaw() only drops the allocation's reference on the arena;
+// memory is rewound when the arena is returned to its pool with no live
+// allocations left. If some buffer is still alive at that point (for example
+// because a kernel cached a tensor it was not expected to keep), the arena is
+// not reused and frees its chunks once the last buffer is released.
+//
+// Requests larger than `Options::max_arena_allocation_bytes`, or that would
+// grow the arena past `Options::max_arena_bytes`, are forwarded to the backing
+// allocator.
+class StepArenaAllocator : public Allocator, public core::RefCounted {
+ public:
+  struct Options {
+    // Size of the first chunk requested from the backing allocator, and of
+    // each subsequent chunk when the arena runs out of space mid-step.
+    size_t chunk_bytes = 1 << 20;
+
+    // Upper bound on the memory held by one arena.
+    size_t max_arena_bytes = 64 << 20;
+
+    // Requests above this size bypass the arena.
+    size_t max_arena_allocation_bytes = 256 << 10;
+  };
+
+  // `backing` is not owned and must outlive this allocator.
+  StepArenaAllocator(Allocator* backing, const Options& options);
+
+  string Name() override { return "step_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return backing_->GetMemoryType();
+  }
+
+  // Returns true if `ptr` points into one of this arena's chunks or is a live
+  // allocation that was forwarded to the backing allocator.
+  bool Owns(const void* ptr);
+
+  // Rewinds the arena so that the next step starts from an empty chunk. If
+  // the previous step spilled into more than one chunk, the chunks are
+  // coalesced into a single one that fits the whole step. REQUIRES: no
+  // allocation from this arena is live.
+  void Reset();
+
+  // Number of allocations served from the arena's chunks, and forwarded to
+  // the backing allocator, since construction.
+  int64_t num_arena_allocations() const {
+    return num_arena_allocations_.load(std::memory_order_relaxed);
+  }
+  int64_t num_backing_allocations() const {
+    return num_backing_allocations_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  ~StepArenaAllocator() override;
+
+  struct Chunk {
+    char* base;
+    size_t size;
+  };
+
+  // Appends a chunk of at least `min_bytes`. Returns false if that would
+  // exceed `max_arena_bytes`.
+  bool AddChunk(size_t min_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void FreeChunks() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const backing_;  // Not owned.
+  const Options options_;
+
+  mutex mu_;
+  std::vector<Chunk> chunks_ TF_GUARDED_BY(mu_);
+  size_t offset_ TF_GUARDED_BY(mu_) = 0;  // Into chunks_.back().
+  size_t total_chunk_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  // Live allocations that were forwarded to `backing_`. The count lets
+  // DeallocateRaw() skip the lookup when there are none.
+  std::atomic<int64_t> num_live_backing_allocations_{0};
+  absl::flat_hash_set<void*> backing_allocations_ TF_GUARDED_BY(mu_);
+
+  std::atomic<int64_t> num_arena_allocations_{0};
+  std::atomic<int64_t> num_backing_allocations_{0};
+
+  StepArenaAllocator(const StepArenaAllocator&) = delete;
+  void operator=(const StepArenaAllocator&) = delete;
+};
+
+// A thread-safe free list of StepArenaAllocators over one backing allocator.
+// Each concurrent step acquires its own arena, so the pool grows to the
+// maximum number of concurrently running steps.
+class StepArenaPool {
+ public:
+  StepArenaPool(Allocator* backing,
+                const StepArenaAllocator::Options& options);
+  ~StepArenaPool();
+
+  // Returns an empty arena for a new step.
+  core::RefCountPtr<StepArenaAllocator> Acquire();
+
+  // Returns `arena` to the pool at the end of a step. The arena is only
+  // reused if none of its allocations are still live.
+  void Release(core::RefCountPtr<StepArenaAllocator> arena);
+
+ private:
+  Allocator* const backing_;  // Not owned.
+  const StepArenaAllocator::Options options_;
+
+  mutex mu_;
+  std::vector<core::RefCountPtr<StepArenaAllocator>> free_ TF_GUARDED_BY(mu_);
+
+  StepArenaPool(const StepArenaPool&) = delete;
+  void operator=(const StepArenaPool&) = delete;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
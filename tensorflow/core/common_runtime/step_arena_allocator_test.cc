@@ -0,0 +1,96 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StepArenaAllocatorTest, ReusesArenaAcrossSteps) {
+  StepArenaAllocator::Options options;
+  options.chunk_bytes = 4096;
+  StepArenaPool pool(cpu_allocator(), options);
+
+  core::RefCountPtr<StepArenaAllocator> arena = pool.Acquire();
+  StepArenaAllocator* first = arena.get();
+  void* p = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  void* q = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(q) % Allocator::kAllocatorAlignment,
+            0);
+  EXPECT_EQ(static_cast<char*>(q) - static_cast<char*>(p), 128);
+  arena->DeallocateRaw(p);
+  arena->DeallocateRaw(q);
+  EXPECT_EQ(arena->num_arena_allocations(), 2);
+  pool.Release(std::move(arena));
+
+  // With no live allocations, the next step rewinds the same arena.
+  arena = pool.Acquire();
+  EXPECT_EQ(arena.get(), first);
+  void* r = arena->AllocateRaw(Allocator::kAllocatorAlignment, 100);
+  EXPECT_EQ(r, p);
+  arena->DeallocateRaw(r);
+  pool.Release(std::move(arena));
+}
+
+TEST(StepArenaAllocatorTest, LargeAllocationsBypassArena) {
+  StepArenaAllocator::Options options;
+  options.chunk_bytes = 4096;
+  options.max_arena_allocation_bytes = 1024;
+  options.max_arena_bytes = 8192;
+  StepArenaPool pool(cpu_allocator(), options);
+
+  core::RefCountPtr<StepArenaAllocator> arena = pool.Acquire();
+  void* large = arena->AllocateRaw(Allocator::kAllocatorAlignment, 2048);
+  EXPECT_EQ(arena->num_backing_allocations(), 1);
+
+  // Four 1000-byte allocations fit in each 4KiB chunk. Once the arena has
+  // reached its 8KiB cap, further allocations are forwarded.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 12; ++i) {
+    ptrs.push_back(arena->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+  }
+  EXPECT_EQ(arena->num_arena_allocations(), 8);
+  EXPECT_EQ(arena->num_backing_allocations(), 5);
+  for (void* p : ptrs) {
+    arena->DeallocateRaw(p);
+  }
+  arena->DeallocateRaw(large);
+  pool.Release(std::move(arena));
+}
+
+TEST(StepArenaAllocatorTest, LiveTensorKeepsArenaAlive) {
+  StepArenaPool pool(cpu_allocator(), StepArenaAllocator::Options());
+
+  core::RefCountPtr<StepArenaAllocator> arena = pool.Acquire();
+  StepArenaAllocator* first = arena.get();
+  Tensor t(arena.get(), DT_FLOAT, TensorShape({16}));
+  t.flat<float>().setConstant(1.0f);
+  pool.Release(std::move(arena));
+
+  // The live tensor prevents the arena from being rewound and reused.
+  core::RefCountPtr<StepArenaAllocator> next = pool.Acquire();
+  EXPECT_NE(next.get(), first);
+  EXPECT_EQ(t.flat<float>()(15), 1.0f);
+  pool.Release(std::move(next));
+}
+
+}  // namespace
+}  // namespace tensorflow
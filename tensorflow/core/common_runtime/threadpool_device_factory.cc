@@ -38,6 +38,9 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
     int num_numa_nodes = port::NUMANumNodes();
+    if (options.config.experimental().use_cpu_size_class_cache()) {
+      ProcessState::singleton()->EnableCPUSizeClassCache();
+    }
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
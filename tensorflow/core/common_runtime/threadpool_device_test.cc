@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/device_factory.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
@@ -68,5 +72,20 @@ TEST(ThreadPoolDeviceTest, CopyTensor) {
   device_context->Unref();
 }
 
+TEST(ThreadPoolDeviceTest, SizeClassCacheOption) {
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_cpu_size_class_cache(true);
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("CPU")->CreateDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+  ASSERT_FALSE(devices.empty());
+  Allocator* allocator = devices[0]->GetAllocator(AllocatorAttributes());
+  EXPECT_EQ(allocator->Name(), "size_class_cache_cpu_bfc_allocator");
+
+  void* ptr = allocator->AllocateRaw(Allocator::kAllocatorAlignment, 64);
+  ASSERT_NE(ptr, nullptr);
+  allocator->DeallocateRaw(ptr);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/data/compression_utils.h"
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,10 +23,12 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
+#include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/types.h"
+#include "zstd.h"  // from @net_zstd
 
 namespace tensorflow {
 namespace data {
@@ -34,7 +37,15 @@ namespace {
 // Increment this when making changes to the `CompressedElement` proto. The
 // `UncompressElement` function will determine what to read according to the
 // version.
-constexpr int kCompressedElementVersion = 0;
+constexpr int kCompressedElementVersion = 1;
+
+// Snappy-compressed elements are still written with the version that predates
+// the `compression` field, so that older readers can consume them.
+constexpr int kSnappyCompressedElementVersion = 0;
+
+// Zstandard level used for dataset elements. Elements are typically sent over
+// the network right after being compressed, so favor speed over ratio.
+constexpr int kZstdCompressionLevel = 1;
 
 }  // namespace
 
@@ -61,8 +72,137 @@ class Iov {
   size_t num_bytes_;
 };
 
+namespace {
+
+// Uncompresses the Snappy data in `input` directly into the pieces of `iov`.
+Status SnappyUncompress(const std::string& input, Iov& iov) {
+  size_t uncompressed_size;
+  if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                         &uncompressed_size)) {
+    return errors::Internal(
+        "Could not get snappy uncompressed length. Compressed data size: ",
+        input.size());
+  }
+  if (uncompressed_size != static_cast<size_t>(iov.NumBytes())) {
+    return errors::Internal(
+        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+        " whereas the tensor metadata suggests ", iov.NumBytes());
+  }
+  if (!port::Snappy_UncompressToIOVec(input.data(), input.size(), iov.Data(),
+                                      iov.NumPieces())) {
+    return errors::Internal("Failed to perform snappy decompression.");
+  }
+  return absl::OkStatus();
+}
+
+// Compresses the pieces of `iov` into a single Zstandard frame. Unlike Snappy,
+// the frame format has no limit on the uncompressed size.
+Status ZstdCompress(Iov& iov, std::string* output) {
+  std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(ZSTD_createCCtx(),
+                                                            &ZSTD_freeCCtx);
+  if (cctx == nullptr) {
+    return errors::ResourceExhausted("Failed to create zstd context.");
+  }
+  size_t result = ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel,
+                                         kZstdCompressionLevel);
+  if (!ZSTD_isError(result)) {
+    result = ZSTD_CCtx_setPledgedSrcSize(cctx.get(), iov.NumBytes());
+  }
+  if (ZSTD_isError(result)) {
+    return errors::Internal("Failed to configure zstd compression: ",
+                            ZSTD_getErrorName(result));
+  }
+
+  // The output is sized for the worst case up front, so every call below
+  // makes progress without having to grow it.
+  output->resize(ZSTD_compressBound(iov.NumBytes()));
+  ZSTD_outBuffer out = {output->data(), output->size(), 0};
+  for (size_t i = 0; i < iov.NumPieces(); ++i) {
+    ZSTD_inBuffer in = {iov.Data()[i].iov_base, iov.Data()[i].iov_len, 0};
+    while (in.pos < in.size) {
+      result = ZSTD_compressStream2(cctx.get(), &out, &in, ZSTD_e_continue);
+      if (ZSTD_isError(result)) {
+        return errors::Internal("Failed to compress using zstd: ",
+                                ZSTD_getErrorName(result));
+      }
+    }
+  }
+  ZSTD_inBuffer in = {nullptr, 0, 0};
+  do {
+    result = ZSTD_compressStream2(cctx.get(), &out, &in, ZSTD_e_end);
+    if (ZSTD_isError(result)) {
+      return errors::Internal("Failed to compress using zstd: ",
+                              ZSTD_getErrorName(result));
+    }
+  } while (result != 0);
+  output->resize(out.pos);
+  return absl::OkStatus();
+}
+
+// Uncompresses the Zstandard frame in `input` directly into the pieces of
+// `iov`. Fails unless the frame holds exactly `iov.NumBytes()` bytes.
+Status ZstdUncompress(const std::string& input, Iov& iov) {
+  std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(ZSTD_createDCtx(),
+                                                            &ZSTD_freeDCtx);
+  if (dctx == nullptr) {
+    return errors::ResourceExhausted("Failed to create zstd context.");
+  }
+  ZSTD_inBuffer in = {input.data(), input.size(), 0};
+  size_t result = 1;
+  for (size_t i = 0; i < iov.NumPieces(); ++i) {
+    ZSTD_outBuffer out = {iov.Data()[i].iov_base, iov.Data()[i].iov_len, 0};
+    while (out.pos < out.size) {
+      const size_t in_pos = in.pos;
+      const size_t out_pos = out.pos;
+      result = ZSTD_decompressStream(dctx.get(), &out, &in);
+      if (ZSTD_isError(result)) {
+        return errors::Internal("Failed to perform zstd decompression: ",
+                                ZSTD_getErrorName(result));
+      }
+      if (in.pos == in_pos && out.pos == out_pos) {
+        return errors::Internal(
+            "Uncompressed size mismatch. Zstd data ended before the ",
+            iov.NumBytes(), " bytes suggested by the tensor metadata.");
+      }
+    }
+  }
+  // Consume the end of the frame, which must not produce any more data.
+  while (result != 0) {
+    ZSTD_outBuffer out = {nullptr, 0, 0};
+    const size_t in_pos = in.pos;
+    result = ZSTD_decompressStream(dctx.get(), &out, &in);
+    if (ZSTD_isError(result)) {
+      return errors::Internal("Failed to perform zstd decompression: ",
+                              ZSTD_getErrorName(result));
+    }
+    if (result != 0 && in.pos == in_pos) {
+      return errors::Internal(
+          "Uncompressed size mismatch. Zstd data is larger than the ",
+          iov.NumBytes(), " bytes suggested by the tensor metadata.");
+    }
+  }
+  if (in.pos != in.size) {
+    return errors::Internal("Found ", in.size - in.pos,
+                            " trailing bytes after the zstd frame.");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out) {
+  return CompressElement(element, io::compression::kSnappy, out);
+}
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       const std::string& compression, CompressedElement* out) {
+  if (compression != io::compression::kSnappy &&
+      compression != io::compression::kZstd) {
+    return errors::InvalidArgument("Unsupported element compression: ",
+                                   compression);
+  }
+
   // First pass: preprocess the non`memcpy`able tensors.
   size_t num_string_tensors = 0;
   size_t num_string_tensor_strings = 0;
@@ -120,16 +260,22 @@ Status CompressElement(const std::vector<Tensor>& element,
     }
   }
 
-  if (iov.NumBytes() > kuint32max) {
-    return errors::OutOfRange("Encountered dataset element of size ",
-                              iov.NumBytes(),
-                              ", exceeding the 4GB Snappy limit.");
-  }
-  if (!port::Snappy_CompressFromIOVec(iov.Data(), iov.NumBytes(),
-                                      out->mutable_data())) {
-    return errors::Internal("Failed to compress using snappy.");
+  if (compression == io::compression::kZstd) {
+    TF_RETURN_IF_ERROR(ZstdCompress(iov, out->mutable_data()));
+    out->set_compression(compression);
+    out->set_version(kCompressedElementVersion);
+  } else {
+    if (iov.NumBytes() > kuint32max) {
+      return errors::OutOfRange("Encountered dataset element of size ",
+                                iov.NumBytes(),
+                                ", exceeding the 4GB Snappy limit.");
+    }
+    if (!port::Snappy_CompressFromIOVec(iov.Data(), iov.NumBytes(),
+                                        out->mutable_data())) {
+      return errors::Internal("Failed to compress using snappy.");
+    }
+    out->set_version(kSnappyCompressedElementVersion);
   }
-  out->set_version(kCompressedElementVersion);
   VLOG(3) << "Compressed element from " << iov.NumBytes() << " bytes to "
           << out->data().size() << " bytes";
   return absl::OkStatus();
@@ -137,10 +283,17 @@ Status CompressElement(const std::vector<Tensor>& element,
 
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out) {
-  if (compressed.version() != kCompressedElementVersion) {
+  if (compressed.version() < 0 ||
+      compressed.version() > kCompressedElementVersion) {
     return errors::Internal("Unsupported compressed element version: ",
                             compressed.version());
   }
+  const std::string& compression = compressed.compression();
+  if (!compression.empty() && compression != io::compression::kSnappy &&
+      compression != io::compression::kZstd) {
+    return errors::Internal("Unsupported compressed element compression: ",
+                            compression);
+  }
   int num_components = compressed.component_metadata_size();
   out->clear();
   out->reserve(num_components);
@@ -191,22 +344,10 @@ Status UncompressElement(const CompressedElement& compressed,
 
   // Step 2: Uncompress into the iovec.
   const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal(
-        "Could not get snappy uncompressed length. Compressed data size: ",
-        compressed_data.size());
-  }
-  if (uncompressed_size != static_cast<size_t>(iov.NumBytes())) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", iov.NumBytes());
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.Data(),
-                                      iov.NumPieces())) {
-    return errors::Internal("Failed to perform snappy decompression.");
+  if (compression == io::compression::kZstd) {
+    TF_RETURN_IF_ERROR(ZstdUncompress(compressed_data, iov));
+  } else {
+    TF_RETURN_IF_ERROR(SnappyUncompress(compressed_data, iov));
   }
 
   // Third pass: deserialize nonstring, non`memcpy`able tensors.
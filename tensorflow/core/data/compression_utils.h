@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_COMPRESSION_UTILS_H_
 #define TENSORFLOW_CORE_DATA_COMPRESSION_UTILS_H_
 
+#include <string>
 #include <vector>
 
 #include "tensorflow/core/framework/dataset.pb.h"
@@ -33,6 +34,12 @@ namespace data {
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out);
 
+// Like above, but compresses with `compression`, which must be one of
+// `io::compression::kSnappy` or `io::compression::kZstd`. Zstd has no limit on
+// the element size and usually yields smaller elements at a higher CPU cost.
+Status CompressElement(const std::vector<Tensor>& element,
+                       const std::string& compression, CompressedElement* out);
+
 // Uncompresses a `CompressedElement` into a vector of tensor components.
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
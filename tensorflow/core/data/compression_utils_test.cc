@@ -14,12 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/dataset_test_base.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tsl/platform/status_matchers.h"
 
@@ -98,7 +102,30 @@ TEST_P(ParameterizedCompressionUtilsTest, VersionMismatch) {
   CompressedElement compressed;
   TF_ASSERT_OK(CompressElement(element, &compressed));
 
-  compressed.set_version(1);
+  compressed.set_version(2);
+  std::vector<Tensor> round_trip_element;
+  EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
+              StatusIs(error::INTERNAL));
+}
+
+TEST_P(ParameterizedCompressionUtilsTest, ZstdRoundTrip) {
+  std::vector<Tensor> element = GetParam();
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, io::compression::kZstd, &compressed));
+  EXPECT_EQ(1, compressed.version());
+  EXPECT_EQ(io::compression::kZstd, compressed.compression());
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+TEST_P(ParameterizedCompressionUtilsTest, ZstdTruncated) {
+  std::vector<Tensor> element = GetParam();
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, io::compression::kZstd, &compressed));
+
+  compressed.mutable_data()->resize(compressed.data().size() / 2);
   std::vector<Tensor> round_trip_element;
   EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
               StatusIs(error::INTERNAL));
@@ -107,6 +134,62 @@ TEST_P(ParameterizedCompressionUtilsTest, VersionMismatch) {
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
+TEST(CompressionUtilsTest, UnsupportedCompression) {
+  std::vector<Tensor> element = CreateTensors<int64_t>(TensorShape{1}, {{1}});
+  CompressedElement compressed;
+  EXPECT_THAT(CompressElement(element, io::compression::kGzip, &compressed),
+              StatusIs(error::INVALID_ARGUMENT));
+
+  TF_ASSERT_OK(CompressElement(element, io::compression::kZstd, &compressed));
+  compressed.set_compression("LZO");
+  std::vector<Tensor> round_trip_element;
+  EXPECT_THAT(UncompressElement(compressed, &round_trip_element),
+              StatusIs(error::INTERNAL));
+}
+
+// Compresses and uncompresses an element of `state.range(1)` float32 values
+// and a batch of short strings with each codec. Values are drawn from a small
+// set so that the payload is compressible, as is typical for decoded images
+// and token ids.
+void BM_CompressionRoundTrip(::testing::benchmark::State& state) {
+  const std::string compression = state.range(0) == 0
+                                      ? io::compression::kSnappy
+                                      : io::compression::kZstd;
+  const int64_t num_values = state.range(1);
+  Tensor values(DT_FLOAT, TensorShape({num_values}));
+  auto flat_values = values.flat<float>();
+  for (int64_t i = 0; i < num_values; ++i) {
+    flat_values(i) = static_cast<float>(i % 251);
+  }
+  int64_t uncompressed_bytes = values.TotalBytes();
+  Tensor strings(DT_STRING, TensorShape({256}));
+  auto flat_strings = strings.flat<tstring>();
+  for (int i = 0; i < 256; ++i) {
+    flat_strings(i) = absl::StrCat("token_", i % 16);
+    uncompressed_bytes += flat_strings(i).size();
+  }
+  std::vector<Tensor> element = {values, strings};
+
+  int64_t compressed_bytes = 0;
+  for (auto s : state) {
+    CompressedElement compressed;
+    TF_CHECK_OK(CompressElement(element, compression, &compressed));
+    std::vector<Tensor> round_trip_element;
+    TF_CHECK_OK(UncompressElement(compressed, &round_trip_element));
+    compressed_bytes = compressed.data().size();
+  }
+  state.SetBytesProcessed(state.iterations() * uncompressed_bytes);
+  state.SetLabel(absl::StrCat(compression, " ratio ",
+                              static_cast<double>(uncompressed_bytes) /
+                                  std::max<int64_t>(compressed_bytes, 1)));
+}
+
+BENCHMARK(BM_CompressionRoundTrip)
+    ->ArgPair(0, 1 << 10)
+    ->ArgPair(1, 1 << 10)
+    ->ArgPair(0, 1 << 20)
+    ->ArgPair(1, 1 << 20);
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
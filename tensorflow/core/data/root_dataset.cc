@@ -23,11 +23,15 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/status/statusor.h"
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/hash_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/rewrite_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/dataset_options.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/model.pb.h"
@@ -105,6 +109,26 @@ void SetRootDatasetParams(const Options& options, RootDataset::Params* params) {
     ram_budget_share = model::kRamBudgetShare;
   }
   params->ram_budget_share = ram_budget_share;
+  params->autotune_tuned_parameters_file =
+      options.autotune_options().tuned_parameters_file();
+}
+
+// Returns the fingerprint of the graph of `dataset`. Random seeds and data
+// tensors are left out of the graph, so that the fingerprint is the same
+// across runs of the same input pipeline.
+absl::StatusOr<uint64> GetDatasetFingerprint(const DatasetBase* dataset) {
+  SerializationContext::Params params;
+  std::vector<std::pair<string, Tensor>> input_list;
+  params.input_list = &input_list;
+  params.external_state_policy = ExternalStatePolicy::POLICY_IGNORE;
+  params.is_graph_rewrite = true;
+  params.resource_mgr = nullptr;
+  GraphDef graph_def;
+  TF_RETURN_IF_ERROR(
+      AsGraphDef(dataset, SerializationContext(params), &graph_def));
+  uint64 fingerprint;
+  TF_RETURN_IF_ERROR(HashGraph(graph_def, &fingerprint));
+  return fingerprint;
 }
 
 void AddTraceMetadata(const RootDataset::Params& params, const Options& options,
@@ -216,6 +240,9 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
       if (experiments.contains("autotune_buffer_optimization")) {
         model_->AddExperiment("autotune_buffer_optimization");
       }
+      if (!dataset()->params_.autotune_tuned_parameters_file.empty()) {
+        WarmStartModel(dataset()->params_.autotune_tuned_parameters_file);
+      }
     }
     IteratorContext iter_ctx(CreateParams(ctx));
     if (model_) {
@@ -232,10 +259,11 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
 
   Status GetNextInternal(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) override {
+    const uint64_t start_time_usec = ctx->env()->NowMicros();
     {
       tf_shared_lock l(mu_);
       if (model_ != nullptr && end_time_usec_ > 0) {
-        model_->RecordIteratorGapTime(ctx->env()->NowMicros() - end_time_usec_);
+        model_->RecordIteratorGapTime(start_time_usec - end_time_usec_);
       }
     }
     if (dataset()->params_.autotune) {
@@ -247,7 +275,11 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
     ctx->MergeCheckpoint(iter_ctx.checkpoint());
     {
       mutex_lock l(mu_);
-      end_time_usec_ = std::max(ctx->env()->NowMicros(), end_time_usec_);
+      const uint64_t now_usec = ctx->env()->NowMicros();
+      end_time_usec_ = std::max(now_usec, end_time_usec_);
+      if (model_ != nullptr) {
+        model_->RecordIteratorWaitTime(now_usec - start_time_usec);
+      }
     }
     return absl::OkStatus();
   }
@@ -340,6 +372,28 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
     return params;
   }
 
+  // Starts autotuning from the parameter values saved in `fname` by a previous
+  // run of this input pipeline, if any, and saves the values tuned by this run
+  // to `fname`.
+  void WarmStartModel(const std::string& fname) {
+    absl::StatusOr<uint64> fingerprint =
+        GetDatasetFingerprint(dataset()->input_);
+    if (!fingerprint.ok()) {
+      LOG(WARNING) << "Failed to fingerprint the input pipeline, so its tuned "
+                      "parameters will not be saved to "
+                   << fname << ": " << fingerprint.status();
+      return;
+    }
+    Status s = model_->LoadTunedParameters(fname, *fingerprint);
+    if (s.ok()) {
+      VLOG(1) << "Warm-starting autotuning from " << fname;
+    } else if (!errors::IsNotFound(s)) {
+      LOG(WARNING) << "Not warm-starting autotuning from " << fname << ": "
+                   << s;
+    }
+    model_->SetTunedParametersFile(fname, *fingerprint);
+  }
+
   Status EnsureModelThreadStarted(IteratorContext* ctx) {
     mutex_lock l(mu_);
     if (!model_thread_) {
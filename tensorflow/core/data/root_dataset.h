@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "tensorflow/core/framework/dataset.h"
@@ -38,6 +39,7 @@ class RootDataset : public DatasetBase {
     std::function<int64_t()> autotune_cpu_budget_func;
     double ram_budget_share;
     int64_t autotune_ram_budget_from_options;
+    std::string autotune_tuned_parameters_file;
     int64_t max_intra_op_parallelism = 1;
     int64_t private_threadpool_size = 0;
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERIALIZATION_UTILS_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -42,6 +43,12 @@ Status ReadElementsFromCheckpoint(IteratorContext* ctx,
                                   StringPiece key_prefix,
                                   std::vector<std::vector<Tensor>>* elements);
 
+// As above, but passes the elements to `add_element` one at a time, in order,
+// instead of collecting them.
+Status ReadElementsFromCheckpoint(
+    IteratorContext* ctx, IteratorStateReader* reader, StringPiece key_prefix,
+    const std::function<Status(std::vector<Tensor> element)>& add_element);
+
 // Writes dataset elements to the checkpoint writer using the given key prefix.
 // The elements can be read back by passing the same key prefix to
 // ReadElementsFromCheckpoint. Only one list of elements can be written under
@@ -50,6 +57,13 @@ Status WriteElementsToCheckpoint(
     IteratorStateWriter* writer, StringPiece key_prefix,
     const std::vector<std::vector<Tensor>>& elements);
 
+// As above, but writes `num_elements` elements that `get_element` produces one
+// at a time, so that they need not all be held in memory at once.
+Status WriteElementsToCheckpoint(
+    IteratorStateWriter* writer, StringPiece key_prefix, int64_t num_elements,
+    const std::function<Status(int64_t index, std::vector<Tensor>* element)>&
+        get_element);
+
 // Updates the dataset elements in the checkpoint for given `checkpoint_indices`
 // using the given key prefix, assuming that vector of elements have
 // checkpointed these before. The elements can be read back by passing the same
@@ -82,6 +82,57 @@ TEST(SerializationUtilsTest, CheckpointElementsRoundTrip) {
   }
 }
 
+TEST(SerializationUtilsTest, CheckpointElementsStreamingRoundTrip) {
+  VariantTensorDataWriter writer;
+  tstring test_prefix = full_name("test_prefix");
+  TF_ASSERT_OK(WriteElementsToCheckpoint(
+      &writer, test_prefix, /*num_elements=*/3,
+      [](int64_t index, std::vector<Tensor>* element) {
+        *element = CreateTensors<int64_t>(TensorShape({2}),
+                                          {{index, index * 10}});
+        return absl::OkStatus();
+      }));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+
+  // Elements written one at a time can be read back all at once.
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TestContext> ctx,
+                          TestContext::Create());
+  std::vector<std::vector<Tensor>> read_elements;
+  TF_ASSERT_OK(ReadElementsFromCheckpoint(ctx->iter_ctx(), &reader, test_prefix,
+                                          &read_elements));
+  ASSERT_EQ(read_elements.size(), 3);
+  for (int64_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(read_elements[i].size(), 1);
+    test::ExpectEqual(read_elements[i][0],
+                      test::AsTensor<int64_t>({i, i * 10}));
+  }
+
+  // And one at a time.
+  int64_t num_read = 0;
+  TF_ASSERT_OK(ReadElementsFromCheckpoint(
+      ctx->iter_ctx(), &reader, test_prefix,
+      [&num_read](std::vector<Tensor> element) {
+        EXPECT_EQ(element.size(), 1);
+        test::ExpectEqual(element[0],
+                          test::AsTensor<int64_t>({num_read, num_read * 10}));
+        ++num_read;
+        return absl::OkStatus();
+      }));
+  EXPECT_EQ(num_read, 3);
+
+  // An error from the callback stops the read.
+  num_read = 0;
+  EXPECT_TRUE(errors::IsCancelled(ReadElementsFromCheckpoint(
+      ctx->iter_ctx(), &reader, test_prefix,
+      [&num_read](std::vector<Tensor> element) {
+        ++num_read;
+        return errors::Cancelled("Stop");
+      })));
+  EXPECT_EQ(num_read, 1);
+}
+
 TEST(SerializationUtilsTest, VariantTensorDataRoundtrip) {
   VariantTensorDataWriter writer;
   TF_ASSERT_OK(writer.WriteScalar(full_name("Int64"), 24));
@@ -0,0 +1,732 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_data_transfer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/service_config.pb.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Ring blocks and the tensors in them are aligned to this many bytes, which
+// satisfies Eigen. A block starts with a BlockHeader padded to this size.
+constexpr uint64_t kAlignment = 64;
+
+// Default size of the ring of each client.
+constexpr int64_t kDefaultRingBytes = 256 << 20;
+
+// Upper bound on the size of a message on the socket.
+constexpr uint32_t kMaxMessageBytes = 1u << 31;
+
+// Header of a ring block. The server writes it when it allocates the block and
+// the client sets `released` when it no longer uses the block.
+struct BlockHeader {
+  uint64_t size;  // Including the header.
+  std::atomic<uint32_t> released;
+};
+static_assert(sizeof(BlockHeader) <= kAlignment);
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Ring blocks are released across processes");
+
+uint64_t RoundUp(uint64_t n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+#if defined(MSG_NOSIGNAL)
+// Reports a closed peer as EPIPE instead of raising SIGPIPE.
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// Identifies this host. Containers on the same host share the boot id.
+std::string HostId() {
+  std::string boot_id;
+  if (!ReadFileToString(Env::Default(), "/proc/sys/kernel/random/boot_id",
+                        &boot_id)
+           .ok()) {
+    boot_id.clear();
+  }
+  return absl::StrCat(port::Hostname(), "/", boot_id);
+}
+
+Status SendFully(int fd, const char* data, size_t n) {
+  while (n > 0) {
+    const ssize_t r = send(fd, data, n, kSendFlags);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      return errors::IOError("shm data transfer socket", errno);
+    }
+    data += r;
+    n -= r;
+  }
+  return absl::OkStatus();
+}
+
+Status ReceiveFully(int fd, char* data, size_t n) {
+  while (n > 0) {
+    const ssize_t r = recv(fd, data, n, 0);
+    if (r == 0) {
+      return errors::Unavailable("shm data transfer peer closed the socket");
+    }
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      return errors::IOError("shm data transfer socket", errno);
+    }
+    data += r;
+    n -= r;
+  }
+  return absl::OkStatus();
+}
+
+// Messages are sent as a fixed32 length followed by the serialized proto.
+Status SendMessage(int fd, const protobuf::MessageLite& message) {
+  std::string buffer(sizeof(uint32_t), '\0');
+  if (!message.AppendToString(&buffer) ||
+      buffer.size() - sizeof(uint32_t) >= kMaxMessageBytes) {
+    return errors::Internal("Failed to serialize a shm data transfer message");
+  }
+  core::EncodeFixed32(&buffer[0], buffer.size() - sizeof(uint32_t));
+  return SendFully(fd, buffer.data(), buffer.size());
+}
+
+Status ReceiveMessage(int fd, protobuf::MessageLite* message) {
+  char length_buffer[sizeof(uint32_t)];
+  TF_RETURN_IF_ERROR(ReceiveFully(fd, length_buffer, sizeof(length_buffer)));
+  const uint32_t length = core::DecodeFixed32(length_buffer);
+  if (length >= kMaxMessageBytes) {
+    return errors::DataLoss("Invalid shm data transfer message length ",
+                            length);
+  }
+  std::string buffer(length, '\0');
+  TF_RETURN_IF_ERROR(ReceiveFully(fd, &buffer[0], length));
+  if (!message->ParseFromString(buffer)) {
+    return errors::DataLoss("Failed to parse a shm data transfer message");
+  }
+  return absl::OkStatus();
+}
+
+// Passes the shared memory file descriptor `shm_fd` of a ring of `ring_bytes`
+// bytes to the client.
+Status SendRing(int fd, int shm_fd, uint64_t ring_bytes) {
+  char payload[sizeof(uint64_t)];
+  core::EncodeFixed64(payload, ring_bytes);
+  struct iovec iov = {payload, sizeof(payload)};
+  union {
+    struct cmsghdr align;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &shm_fd, sizeof(int));
+  ssize_t r;
+  do {
+    r = sendmsg(fd, &msg, kSendFlags);
+  } while (r < 0 && errno == EINTR);
+  if (r != sizeof(payload)) {
+    return errors::IOError("Failed to send the shm data transfer ring", errno);
+  }
+  return absl::OkStatus();
+}
+
+Status ReceiveRing(int fd, int* shm_fd, uint64_t* ring_bytes) {
+  char payload[sizeof(uint64_t)];
+  struct iovec iov = {payload, sizeof(payload)};
+  union {
+    struct cmsghdr align;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+  ssize_t r;
+  do {
+    r = recvmsg(fd, &msg, 0);
+  } while (r < 0 && errno == EINTR);
+  if (r < 0) {
+    return errors::IOError("Failed to receive the shm data transfer ring",
+                           errno);
+  }
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (r != sizeof(payload) || cmsg == nullptr ||
+      cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+    return errors::DataLoss("Invalid shm data transfer handshake");
+  }
+  memcpy(shm_fd, CMSG_DATA(cmsg), sizeof(int));
+  *ring_bytes = core::DecodeFixed64(payload);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+// The server's end of a client connection, with the client's ring.
+class ShmDataTransferServer::Connection {
+ public:
+  Connection(int fd, const GetElementT& get_element)
+      : fd_(fd), get_element_(get_element) {}
+
+  ~Connection() {
+    Shutdown();
+    thread_.reset();
+    if (ring_ != nullptr) {
+      munmap(ring_, capacity_);
+    }
+    close(fd_);
+  }
+
+  // Creates the ring and passes it to the client.
+  Status Initialize(int64_t ring_bytes) {
+    capacity_ = ring_bytes / kAlignment * kAlignment;
+    const std::string name =
+        absl::StrCat("/tf_data_shm_", getpid(), "_", random::New64());
+    const int shm_fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (shm_fd < 0) {
+      return errors::IOError(name, errno);
+    }
+    // The client receives the file descriptor, so the name is not needed.
+    shm_unlink(name.c_str());
+    Status s = CreateRing(shm_fd);
+    if (s.ok()) {
+      s = SendRing(fd_, shm_fd, capacity_);
+    }
+    close(shm_fd);
+    return s;
+  }
+
+  void Start() {
+    thread_ = absl::WrapUnique(Env::Default()->StartThread(
+        {}, "tf_data_shm_connection", [this]() { Serve(); }));
+  }
+
+  // Unblocks the connection's thread.
+  void Shutdown() { shutdown(fd_, SHUT_RDWR); }
+
+  bool done() const { return done_; }
+
+ private:
+  Status CreateRing(int shm_fd) {
+#if defined(__linux__)
+    // Reserves the memory up front: writing to a ring that /dev/shm cannot back
+    // would raise SIGBUS.
+    if (int error = posix_fallocate(shm_fd, 0, capacity_); error != 0) {
+      return errors::IOError("Failed to allocate the shm data transfer ring",
+                             error);
+    }
+#else
+    if (ftruncate(shm_fd, capacity_) < 0) {
+      return errors::IOError("Failed to allocate the shm data transfer ring",
+                             errno);
+    }
+#endif
+    void* ring = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      shm_fd, 0);
+    if (ring == MAP_FAILED) {
+      return errors::IOError("Failed to map the shm data transfer ring", errno);
+    }
+    ring_ = static_cast<char*>(ring);
+    return absl::OkStatus();
+  }
+
+  void Serve() {
+    while (true) {
+      GetElementRequest request;
+      if (!ReceiveMessage(fd_, &request).ok()) break;
+      ShmGetElementResponse response;
+      HandleRequest(request, response);
+      if (!SendMessage(fd_, response).ok()) break;
+    }
+    done_ = true;
+  }
+
+  void HandleRequest(const GetElementRequest& request,
+                     ShmGetElementResponse& response) {
+    GetElementResult result;
+    Status s = get_element_(&request, &result);
+    if (!s.ok()) {
+      response.set_error_code(s.raw_code());
+      response.set_error_message(std::string(s.message()));
+      return;
+    }
+    response.set_element_index(result.element_index);
+    response.set_end_of_sequence(result.end_of_sequence);
+    response.set_skip_task(result.skip);
+
+    uint64_t block_size = kAlignment;
+    for (const Tensor& component : result.components) {
+      if (DataTypeCanUseMemcpy(component.dtype())) {
+        block_size += RoundUp(component.TotalBytes());
+      }
+    }
+    const int64_t block =
+        block_size > kAlignment ? AllocateBlock(block_size) : -1;
+    if (block >= 0) {
+      response.set_block_offset(block);
+    }
+    uint64_t offset = block + kAlignment;
+    for (const Tensor& component : result.components) {
+      ShmGetElementResponse::Component* proto = response.add_components();
+      if (block < 0 || !DataTypeCanUseMemcpy(component.dtype())) {
+        component.AsProtoTensorContent(proto->mutable_tensor());
+        continue;
+      }
+      proto->mutable_tensor()->set_dtype(component.dtype());
+      component.shape().AsProto(proto->mutable_tensor()->mutable_tensor_shape());
+      const StringPiece data = component.tensor_data();
+      memcpy(ring_ + offset, data.data(), data.size());
+      proto->set_shm_offset(offset);
+      offset += RoundUp(data.size());
+    }
+  }
+
+  // Returns the offset of a new block of `size` bytes, or -1 if the ring has
+  // no room for it. Elements in blocks that do not fit are sent inline rather
+  // than waiting for the client, which may hold on to its tensors.
+  int64_t AllocateBlock(uint64_t size) {
+    ReclaimBlocks();
+    if (size > capacity_) {
+      return -1;
+    }
+    if (used_ == 0) {
+      head_ = tail_ = 0;
+    } else if (head_ == tail_) {
+      return -1;
+    }
+    if (head_ >= tail_) {
+      // Free space is [head_, capacity_) and [0, tail_).
+      if (capacity_ - head_ < size) {
+        if (tail_ < size) {
+          return -1;
+        }
+        // Pads the end of the ring with a released block.
+        WriteBlockHeader(head_, capacity_ - head_, /*released=*/true);
+        used_ += capacity_ - head_;
+        head_ = 0;
+      }
+    } else if (tail_ - head_ < size) {
+      return -1;
+    }
+    const int64_t block = head_;
+    WriteBlockHeader(block, size, /*released=*/false);
+    used_ += size;
+    head_ = (head_ + size) % capacity_;
+    return block;
+  }
+
+  // Frees the blocks at the tail of the ring that the client has released.
+  void ReclaimBlocks() {
+    while (used_ > 0) {
+      auto* header = reinterpret_cast<BlockHeader*>(ring_ + tail_);
+      if (!header->released.load(std::memory_order_acquire)) break;
+      used_ -= header->size;
+      tail_ = (tail_ + header->size) % capacity_;
+    }
+  }
+
+  void WriteBlockHeader(uint64_t offset, uint64_t size, bool released) {
+    auto* header = reinterpret_cast<BlockHeader*>(ring_ + offset);
+    header->size = size;
+    header->released.store(released, std::memory_order_release);
+  }
+
+  const int fd_;
+  const GetElementT get_element_;
+  char* ring_ = nullptr;
+  uint64_t capacity_ = 0;
+  // Only accessed by the connection's thread.
+  uint64_t head_ = 0;  // Where the next block goes.
+  uint64_t tail_ = 0;  // The oldest block that has not been reclaimed.
+  uint64_t used_ = 0;  // Bytes from tail_ to head_.
+  std::atomic<bool> done_ = false;
+  std::unique_ptr<Thread> thread_;
+};
+
+ShmDataTransferServer::ShmDataTransferServer(GetElementT get_element,
+                                             int64_t ring_bytes)
+    : get_element_(std::move(get_element)), ring_bytes_(ring_bytes) {}
+
+ShmDataTransferServer::~ShmDataTransferServer() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (auto& connection : connections_) {
+      connection->Shutdown();
+    }
+  }
+  if (listen_fd_ >= 0) {
+    shutdown(listen_fd_, SHUT_RDWR);
+  }
+  accept_thread_.reset();
+  {
+    mutex_lock l(mu_);
+    connections_.clear();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+  if (!socket_dir_.empty()) {
+    unlink(socket_path_.c_str());
+    rmdir(socket_dir_.c_str());
+  }
+}
+
+Status ShmDataTransferServer::Start(const experimental::WorkerConfig& config) {
+  // Only processes of the same user may read the elements. The socket is
+  // created in a directory that only they can enter, as restricting the mode
+  // of the socket itself after bind() would leave a window open to others.
+  char socket_dir[] = "/tmp/tf_data_shm_XXXXXX";
+  if (mkdtemp(socket_dir) == nullptr) {
+    return errors::IOError(
+        "Failed to create a directory for the shm data transfer socket",
+        errno);
+  }
+  socket_dir_ = socket_dir;
+  socket_path_ = absl::StrCat(socket_dir_, "/socket");
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path_.size() >= sizeof(address.sun_path)) {
+    return errors::InvalidArgument("Socket path ", socket_path_,
+                                   " is too long");
+  }
+  strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path));
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return errors::IOError("Failed to create a Unix domain socket", errno);
+  }
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) < 0) {
+    return errors::IOError(socket_path_, errno);
+  }
+  if (listen(listen_fd_, 64) < 0) {
+    return errors::IOError(socket_path_, errno);
+  }
+  accept_thread_ = absl::WrapUnique(Env::Default()->StartThread(
+      {}, "tf_data_shm_accept", [this]() { AcceptConnections(); }));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> ShmDataTransferServer::GetCompatibilityInfo()
+    const {
+  ShmTransferServerInfo info;
+  info.set_host_id(HostId());
+  info.set_socket_path(socket_path_);
+  return info.SerializeAsString();
+}
+
+void ShmDataTransferServer::AcceptConnections() {
+  while (true) {
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      mutex_lock l(mu_);
+      if (!cancelled_) {
+        LOG(ERROR) << "shm data transfer server at " << socket_path_
+                   << " stopped accepting connections: " << strerror(errno);
+      }
+      return;
+    }
+    auto connection = std::make_unique<Connection>(fd, get_element_);
+    Status s = connection->Initialize(ring_bytes_);
+    if (!s.ok()) {
+      // The client sees the closed socket and falls back to gRPC.
+      LOG(WARNING) << "Failed to set up a shm data transfer connection: " << s;
+      continue;
+    }
+    mutex_lock l(mu_);
+    if (cancelled_) return;
+    // Joins the threads of closed connections.
+    connections_.erase(
+        std::remove_if(connections_.begin(), connections_.end(),
+                       [](const auto& c) { return c->done(); }),
+        connections_.end());
+    connection->Start();
+    connections_.push_back(std::move(connection));
+  }
+}
+
+// The client's mapping of its ring. Tensors over the ring share it, so it
+// stays mapped while they are alive even after the client is destroyed.
+class ShmDataTransferClient::Ring {
+ public:
+  Ring(char* data, uint64_t size) : data_(data), size_(size) {}
+  ~Ring() { munmap(data_, size_); }
+
+  char* data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+ private:
+  char* const data_;
+  const uint64_t size_;
+};
+
+namespace {
+
+// A block of the ring, which is released when the last tensor over it is
+// destroyed.
+class RingBlock : public core::RefCounted {
+ public:
+  RingBlock(std::shared_ptr<const void> ring, BlockHeader* header)
+      : ring_(std::move(ring)), header_(header) {}
+  ~RingBlock() override {
+    header_->released.store(1, std::memory_order_release);
+  }
+
+ private:
+  const std::shared_ptr<const void> ring_;
+  BlockHeader* const header_;
+};
+
+class RingTensorBuffer : public TensorBuffer {
+ public:
+  RingTensorBuffer(core::RefCountPtr<RingBlock> block, char* data, size_t size)
+      : TensorBuffer(data), block_(std::move(block)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("tf_data_shm");
+  }
+
+ private:
+  const core::RefCountPtr<RingBlock> block_;
+  const size_t size_;
+};
+
+}  // namespace
+
+ShmDataTransferClient::~ShmDataTransferClient() {
+  mutex_lock l(mu_);
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+Status ShmDataTransferClient::CheckCompatibility(
+    const std::string& server_compatibility_info) const {
+  ShmTransferServerInfo info;
+  if (!info.ParseFromString(server_compatibility_info)) {
+    return errors::InvalidArgument(
+        "Failed to parse the shm data transfer server information");
+  }
+  if (info.host_id() != HostId()) {
+    return errors::FailedPrecondition(
+        "The shm data transfer server runs on host ", info.host_id(),
+        ", not on this host (", HostId(), ")");
+  }
+
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (info.socket_path().size() >= sizeof(address.sun_path)) {
+    return errors::InvalidArgument("Socket path ", info.socket_path(),
+                                   " is too long");
+  }
+  strncpy(address.sun_path, info.socket_path().c_str(),
+          sizeof(address.sun_path));
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return errors::IOError("Failed to create a Unix domain socket", errno);
+  }
+  int shm_fd = -1;
+  uint64_t ring_bytes = 0;
+  Status s;
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    s = errors::IOError(info.socket_path(), errno);
+  } else {
+    s = ReceiveRing(fd, &shm_fd, &ring_bytes);
+  }
+  void* ring = MAP_FAILED;
+  if (s.ok()) {
+    ring = mmap(nullptr, ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                shm_fd, 0);
+    if (ring == MAP_FAILED) {
+      s = errors::IOError("Failed to map the shm data transfer ring", errno);
+    }
+    close(shm_fd);
+  }
+  if (!s.ok()) {
+    close(fd);
+    return s;
+  }
+
+  mutex_lock l(mu_);
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = fd;
+  ring_ = std::make_shared<Ring>(static_cast<char*>(ring), ring_bytes);
+  return absl::OkStatus();
+}
+
+Status ShmDataTransferClient::GetElement(const GetElementRequest& req,
+                                         GetElementResult& result) {
+  mutex_lock request_lock(request_mu_);
+  int fd;
+  std::shared_ptr<Ring> ring;
+  {
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      return errors::Cancelled("Client was cancelled.");
+    }
+    if (fd_ < 0) {
+      return errors::FailedPrecondition(
+          "The shm data transfer client is not connected");
+    }
+    fd = fd_;
+    ring = ring_;
+  }
+
+  int64_t start_time_us = env_->NowMicros();
+  TF_RETURN_IF_ERROR(SendMessage(fd, req));
+  ShmGetElementResponse response;
+  TF_RETURN_IF_ERROR(ReceiveMessage(fd, &response));
+  if (response.error_code() != 0) {
+    return Status(static_cast<absl::StatusCode>(response.error_code()),
+                  response.error_message());
+  }
+  metrics::RecordTFDataServiceGetElementDuration(
+      kShmTransferProtocol, env_->NowMicros() - start_time_us);
+
+  core::RefCountPtr<RingBlock> block;
+  if (response.has_block_offset()) {
+    if (response.block_offset() < 0 ||
+        response.block_offset() + kAlignment > ring->size()) {
+      return errors::DataLoss("Invalid shm ring block offset ",
+                              response.block_offset());
+    }
+    block.reset(new RingBlock(
+        ring,
+        reinterpret_cast<BlockHeader*>(ring->data() + response.block_offset())));
+  }
+  result.element_index = response.element_index();
+  result.end_of_sequence = response.end_of_sequence();
+  result.skip = response.skip_task();
+  for (const ShmGetElementResponse::Component& component :
+       response.components()) {
+    if (!component.has_shm_offset()) {
+      result.components.emplace_back();
+      if (!result.components.back().FromProto(component.tensor())) {
+        return errors::Internal("Failed to parse tensor.");
+      }
+      continue;
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(
+        component.tensor().tensor_shape(), &shape));
+    const DataType dtype = component.tensor().dtype();
+    if (block == nullptr || !DataTypeCanUseMemcpy(dtype)) {
+      return errors::DataLoss("Invalid shm data transfer component");
+    }
+    const uint64_t size = shape.num_elements() * DataTypeSize(dtype);
+    if (component.shm_offset() < 0 ||
+        component.shm_offset() + size > ring->size()) {
+      return errors::DataLoss("Invalid shm tensor offset ",
+                              component.shm_offset());
+    }
+    core::RefCountPtr<RingTensorBuffer> buffer(new RingTensorBuffer(
+        block.GetNewRef(), ring->data() + component.shm_offset(), size));
+    result.components.push_back(Tensor(dtype, shape, buffer.get()));
+  }
+  return absl::OkStatus();
+}
+
+void ShmDataTransferClient::TryCancel() {
+  VLOG(2) << "Cancel ShmDataTransferClient.";
+  mutex_lock l(mu_);
+  cancelled_ = true;
+  if (fd_ >= 0) {
+    // Unblocks an outstanding request.
+    shutdown(fd_, SHUT_RDWR);
+  }
+}
+
+namespace {
+
+class ShmTransferRegistrar {
+ public:
+  ShmTransferRegistrar() {
+    DataTransferServer::Register(
+        kShmTransferProtocol,
+        [](DataTransferServer::GetElementT get_element,
+           std::shared_ptr<DataTransferServer>* out) {
+          int64_t ring_bytes;
+          TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+              "TF_DATA_SERVICE_SHM_RING_BYTES", kDefaultRingBytes,
+              &ring_bytes));
+          *out = std::make_shared<ShmDataTransferServer>(std::move(get_element),
+                                                         ring_bytes);
+          return absl::OkStatus();
+        });
+    DataTransferClient::Register(
+        kShmTransferProtocol, [](DataTransferClient::Config config,
+                                 std::unique_ptr<DataTransferClient>* out) {
+          *out = std::make_unique<ShmDataTransferClient>();
+          return absl::OkStatus();
+        });
+  }
+};
+static ShmTransferRegistrar shm_transfer_registrar;
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
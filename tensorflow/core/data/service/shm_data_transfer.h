@@ -0,0 +1,111 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/service_config.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// Data transfer protocol for trainers that run on the same host as the
+// tf.data service worker, in another process.
+//
+// Each client connects to the server over a Unix domain socket and receives a
+// POSIX shared memory ring of its own. The server copies the bytes of each
+// element's tensors into the ring once, and the client builds `Tensor`s over
+// the ring without copying them. A ring block is released when the client
+// destroys the last tensor over it. Tensors that cannot be placed in the ring
+// (strings, variants, elements that do not fit) are sent inline instead.
+//
+// Clients on another host fail the compatibility check, after which the tf.data
+// service client falls back to gRPC.
+constexpr const char kShmTransferProtocol[] = "shm";
+
+class ShmDataTransferServer : public DataTransferServer {
+ public:
+  // Gives each client a ring of `ring_bytes` bytes.
+  ShmDataTransferServer(GetElementT get_element, int64_t ring_bytes);
+  ~ShmDataTransferServer() override;
+
+  Status Start(const experimental::WorkerConfig& config) override;
+
+  // The server listens on a Unix domain socket, so it has no port.
+  int Port() const override { return 0; }
+
+  absl::StatusOr<std::string> GetCompatibilityInfo() const override;
+
+ private:
+  class Connection;
+
+  void AcceptConnections();
+
+  const GetElementT get_element_;
+  const int64_t ring_bytes_;
+  // Directory, only accessible to this user, that holds the socket.
+  std::string socket_dir_;
+  std::string socket_path_;
+  int listen_fd_ = -1;
+
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::vector<std::unique_ptr<Connection>> connections_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<Thread> accept_thread_;
+};
+
+class ShmDataTransferClient : public DataTransferClient {
+ public:
+  ShmDataTransferClient() = default;
+  ~ShmDataTransferClient() override;
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override;
+
+  void TryCancel() override;
+
+  // Checks that the server runs on this host. As this is the first call that
+  // learns the server's socket, it also connects to the server.
+  Status CheckCompatibility(
+      const std::string& server_compatibility_info) const override;
+
+ private:
+  class Ring;
+
+  // Serializes requests: responses arrive in request order on the socket.
+  mutex request_mu_;
+
+  // The connection is set up by the const `CheckCompatibility`.
+  mutable mutex mu_;
+  mutable int fd_ TF_GUARDED_BY(mu_) = -1;
+  mutable std::shared_ptr<Ring> ring_ TF_GUARDED_BY(mu_);
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHM_DATA_TRANSFER_H_
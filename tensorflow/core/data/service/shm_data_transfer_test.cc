@@ -0,0 +1,198 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shm_data_transfer.h"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/service_config.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Returns whether `tensor` was built over the shared memory ring.
+bool InRing(const Tensor& tensor) {
+  TensorDescription description;
+  tensor.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         "tf_data_shm";
+}
+
+// Serves elements made of an int64 vector of `num_values` values counting
+// from the element index, and a string scalar.
+class ShmDataTransferTest : public ::testing::Test {
+ protected:
+  void StartServer(int64_t ring_bytes, int64_t num_values) {
+    server_ = std::make_unique<ShmDataTransferServer>(
+        [this, num_values](const GetElementRequest* request,
+                           GetElementResult* result) {
+          if (!status_.ok()) return status_;
+          Tensor values(DT_INT64, TensorShape({num_values}));
+          for (int64_t i = 0; i < num_values; ++i) {
+            values.vec<int64_t>()(i) = next_index_ + i;
+          }
+          result->components.push_back(std::move(values));
+          result->components.push_back(Tensor(tstring("element")));
+          result->element_index = next_index_++;
+          return absl::OkStatus();
+        },
+        ring_bytes);
+    TF_ASSERT_OK(server_->Start(experimental::WorkerConfig()));
+    TF_ASSERT_OK_AND_ASSIGN(std::string info,
+                            server_->GetCompatibilityInfo());
+    client_ = std::make_unique<ShmDataTransferClient>();
+    TF_ASSERT_OK(client_->CheckCompatibility(info));
+  }
+
+  void ExpectElement(const GetElementResult& result, int64_t num_values) {
+    ASSERT_EQ(result.components.size(), 2);
+    Tensor expected(DT_INT64, TensorShape({num_values}));
+    for (int64_t i = 0; i < num_values; ++i) {
+      expected.vec<int64_t>()(i) = result.element_index + i;
+    }
+    test::ExpectEqual(result.components[0], expected);
+    test::ExpectEqual(result.components[1], Tensor(tstring("element")));
+    EXPECT_FALSE(InRing(result.components[1]));
+  }
+
+  std::unique_ptr<ShmDataTransferServer> server_;
+  std::unique_ptr<ShmDataTransferClient> client_;
+  int64_t next_index_ = 0;
+  Status status_;
+};
+
+TEST_F(ShmDataTransferTest, GetElement) {
+  StartServer(/*ring_bytes=*/1 << 20, /*num_values=*/100);
+  for (int i = 0; i < 10; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+    EXPECT_EQ(result.element_index, i);
+    EXPECT_FALSE(result.end_of_sequence);
+    ExpectElement(result, /*num_values=*/100);
+    EXPECT_TRUE(InRing(result.components[0]));
+  }
+}
+
+TEST_F(ShmDataTransferTest, ReusesReleasedBlocks) {
+  // Each element takes more than a third of the ring.
+  StartServer(/*ring_bytes=*/32 << 10, /*num_values=*/1500);
+  for (int i = 0; i < 100; ++i) {
+    GetElementResult result;
+    TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+    ExpectElement(result, /*num_values=*/1500);
+    EXPECT_TRUE(InRing(result.components[0]));
+  }
+}
+
+TEST_F(ShmDataTransferTest, SendsElementsInlineWhenTheRingIsFull) {
+  StartServer(/*ring_bytes=*/32 << 10, /*num_values=*/1500);
+  std::vector<GetElementResult> held;
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(client_->GetElement(GetElementRequest(), held.emplace_back()));
+    EXPECT_TRUE(InRing(held.back().components[0]));
+  }
+  GetElementResult result;
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  ExpectElement(result, /*num_values=*/1500);
+  EXPECT_FALSE(InRing(result.components[0]));
+
+  // The held tensors stay valid until they are released.
+  for (const GetElementResult& element : held) {
+    ExpectElement(element, /*num_values=*/1500);
+  }
+  held.clear();
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  ExpectElement(result, /*num_values=*/1500);
+  EXPECT_TRUE(InRing(result.components[0]));
+}
+
+TEST_F(ShmDataTransferTest, SendsElementsLargerThanTheRingInline) {
+  StartServer(/*ring_bytes=*/4 << 10, /*num_values=*/1500);
+  GetElementResult result;
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  ExpectElement(result, /*num_values=*/1500);
+  EXPECT_FALSE(InRing(result.components[0]));
+}
+
+TEST_F(ShmDataTransferTest, TensorsOutliveTheClient) {
+  StartServer(/*ring_bytes=*/1 << 20, /*num_values=*/100);
+  GetElementResult result;
+  TF_ASSERT_OK(client_->GetElement(GetElementRequest(), result));
+  client_.reset();
+  ExpectElement(result, /*num_values=*/100);
+}
+
+TEST_F(ShmDataTransferTest, PropagatesErrors) {
+  StartServer(/*ring_bytes=*/1 << 20, /*num_values=*/100);
+  status_ = errors::NotFound("no element");
+  GetElementResult result;
+  EXPECT_TRUE(
+      errors::IsNotFound(client_->GetElement(GetElementRequest(), result)));
+}
+
+TEST_F(ShmDataTransferTest, Cancel) {
+  StartServer(/*ring_bytes=*/1 << 20, /*num_values=*/100);
+  client_->TryCancel();
+  GetElementResult result;
+  EXPECT_TRUE(
+      errors::IsCancelled(client_->GetElement(GetElementRequest(), result)));
+}
+
+TEST_F(ShmDataTransferTest, SocketIsOnlyAccessibleToOwner) {
+  StartServer(/*ring_bytes=*/1 << 20, /*num_values=*/100);
+  TF_ASSERT_OK_AND_ASSIGN(std::string serialized_info,
+                          server_->GetCompatibilityInfo());
+  ShmTransferServerInfo info;
+  ASSERT_TRUE(info.ParseFromString(serialized_info));
+  struct stat dir_stat;
+  ASSERT_EQ(stat(std::string(io::Dirname(info.socket_path())).c_str(),
+                 &dir_stat),
+            0);
+  EXPECT_EQ(dir_stat.st_mode & 0777, 0700);
+
+  const std::string socket_path = info.socket_path();
+  server_.reset();
+  EXPECT_NE(stat(socket_path.c_str(), &dir_stat), 0);
+}
+
+TEST(ShmDataTransferClientTest, RejectsServersOnOtherHosts) {
+  ShmTransferServerInfo info;
+  info.set_host_id("other_host");
+  info.set_socket_path("/tmp/nonexistent");
+  ShmDataTransferClient client;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      client.CheckCompatibility(info.SerializeAsString())));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
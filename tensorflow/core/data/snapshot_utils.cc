@@ -49,6 +49,9 @@ limitations under the License.
 #include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tsl/lib/io/snappy/snappy_inputbuffer.h"
 #include "tsl/lib/io/snappy/snappy_outputbuffer.h"
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/lib/io/zstd/zstd_inputstream.h"
+#include "tsl/lib/io/zstd/zstd_outputbuffer.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
@@ -225,6 +228,14 @@ Status CustomWriter::Initialize(tensorflow::Env* env) {
         zlib_options.output_buffer_size, zlib_options);
     TF_CHECK_OK(zlib_output_buffer->Init());
     dest_.reset(zlib_output_buffer);
+  } else if (compression_type_ == io::compression::kZstd) {
+    zlib_underlying_dest_.swap(dest_);
+    tsl::io::ZstdCompressionOptions zstd_options;
+    auto zstd_output_buffer = std::make_unique<tsl::io::ZstdOutputBuffer>(
+        zlib_underlying_dest_.get(), zstd_options.input_buffer_size,
+        zstd_options.output_buffer_size, zstd_options);
+    TF_RETURN_IF_ERROR(zstd_output_buffer->Init());
+    dest_ = std::move(zstd_output_buffer);
   }
 #endif  // IS_SLIM_BUILD
   simple_tensor_mask_.reserve(dtypes_.size());
@@ -833,6 +844,11 @@ Status CustomReader::Initialize(Env* env) {
     input_stream_ = std::make_unique<io::ZlibInputStream>(
         input_stream_.release(), zlib_options.input_buffer_size,
         zlib_options.output_buffer_size, zlib_options, true);
+  } else if (compression_type_ == io::compression::kZstd) {
+    tsl::io::ZstdCompressionOptions zstd_options;
+    input_stream_ = std::make_unique<tsl::io::ZstdInputStream>(
+        input_stream_.release(), zstd_options.input_buffer_size,
+        zstd_options.output_buffer_size, zstd_options, true);
   } else if (compression_type_ == io::compression::kSnappy) {
     if (version_ == 0) {
       input_stream_ = std::make_unique<tsl::io::SnappyInputBuffer>(
@@ -20,6 +20,7 @@ limitations under the License.
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
@@ -138,6 +139,24 @@ std::shared_ptr<model::Model> TfDatazMetricsCollector::GetModel() {
   return model_;
 }
 
+std::vector<AutotuneDecision> TfDatazMetricsCollector::GetAutotuneDecisions() {
+  std::vector<AutotuneDecision> decisions;
+  if (model_ == nullptr) {
+    return decisions;
+  }
+  for (const auto& [node_name, parameter] : model_->GetTunedParameters()) {
+    decisions.push_back({node_name, parameter->name, parameter->value});
+  }
+  return decisions;
+}
+
+int64_t TfDatazMetricsCollector::GetAutotuneCpuBudget() {
+  if (model_ == nullptr) {
+    return 0;
+  }
+  return model_->GetOptimizationParams().cpu_budget();
+}
+
 namespace {
 static mutex* get_tfdataz_metrics_registry_lock() {
   static mutex tfdataz_metrics_registry_lock(LINKER_INITIALIZED);
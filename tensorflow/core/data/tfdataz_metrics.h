@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/time/time.h"
@@ -88,6 +89,14 @@ class ApproximateLatencyEstimator {
   int64_t latency_count_[kSlots] TF_GUARDED_BY(mu_);
 };
 
+// A value that autotuning chose for a tunable parameter of an input pipeline
+// node.
+struct AutotuneDecision {
+  std::string node_name;
+  std::string parameter_name;
+  double value = 0.0;
+};
+
 // Collects and exports the tf.data performance metrics to /tfdataz.
 class TfDatazMetricsCollector {
  public:
@@ -120,6 +129,14 @@ class TfDatazMetricsCollector {
 
   std::shared_ptr<model::Model> GetModel();
 
+  // Returns the values that the latest autotuning optimization chose for the
+  // tunable parameters of the pipeline. Empty if autotuning has not run.
+  std::vector<AutotuneDecision> GetAutotuneDecisions();
+
+  // Returns the number of cores that the latest autotuning optimization could
+  // use, or 0 if autotuning has not run.
+  int64_t GetAutotuneCpuBudget();
+
  private:
   DatasetBaseIterator* iterator_;  // not owned
   std::shared_ptr<model::Model> model_;
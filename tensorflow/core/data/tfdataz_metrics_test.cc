@@ -16,9 +16,12 @@ limitations under the License.
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/time/time.h"
+#include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/util/fake_clock_env.h"
@@ -197,6 +200,47 @@ class ScopedTfDataMetricsRegistration {
   std::shared_ptr<TfDatazMetricsCollector> collector_;
 };
 
+TEST_F(TfDatazMetricsTest, GetAutotuneDecisionsWithoutModel) {
+  EXPECT_TRUE(tfdataz_metrics_->GetAutotuneDecisions().empty());
+  EXPECT_EQ(tfdataz_metrics_->GetAutotuneCpuBudget(), 0);
+}
+
+TEST(TfDatazMetricsAutotuneTest, GetAutotuneDecisions) {
+  auto model = std::make_shared<model::Model>();
+  std::shared_ptr<model::Node> node;
+  model->AddNode(
+      [](model::Node::Args args) {
+        return model::MakeAsyncKnownRatioNode(
+            std::move(args), /*ratio=*/1,
+            {model::MakeParameter(
+                model::kParallelism,
+                std::make_shared<model::SharedState>(
+                    /*value=*/1, std::make_shared<mutex>(),
+                    std::make_shared<condition_variable>()),
+                /*min=*/1, /*max=*/8)});
+      },
+      "ParallelMapV2", /*parent=*/nullptr, &node);
+  node->record_element();
+  node->record_start(/*time_nanos=*/0);
+  node->record_stop(/*time_nanos=*/1000);
+  std::unique_ptr<DatasetBaseIterator> iterator;
+  TfDatazMetricsCollector collector(*Env::Default(), iterator.get(), model);
+  EXPECT_TRUE(collector.GetAutotuneDecisions().empty());
+
+  CancellationManager cancellation_manager;
+  model::RamBudgetManager ram_budget_manager(/*budget=*/0);
+  model->Optimize(model::AutotuneAlgorithm::CPU_BUDGET, [] { return 4; },
+                  /*ram_budget_share=*/1.0, /*fixed_ram_budget=*/1 << 30,
+                  /*model_input_time=*/0, ram_budget_manager,
+                  &cancellation_manager);
+  std::vector<AutotuneDecision> decisions = collector.GetAutotuneDecisions();
+  ASSERT_EQ(decisions.size(), 1);
+  EXPECT_EQ(decisions[0].parameter_name, model::kParallelism);
+  EXPECT_GE(decisions[0].value, 1);
+  EXPECT_LE(decisions[0].value, 4);
+  EXPECT_EQ(collector.GetAutotuneCpuBudget(), 4);
+}
+
 TEST(TfDatazMetricsRegistryTest, Register) {
   std::unique_ptr<DatasetBaseIterator> iterator;
   auto collector_one = std::make_shared<TfDatazMetricsCollector>(
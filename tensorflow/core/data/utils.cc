@@ -43,7 +43,9 @@ std::string LocalityOptimizedPath(const std::string& path) { return path; }
 
 absl::StatusOr<bool> DisableCompressionAtRuntime(
     const std::string& data_transfer_protocol, DeploymentMode deployment_mode) {
-  return false;
+  // The shared memory protocol builds tensors over the bytes the worker
+  // produced, which compressed elements would have to be copied out of.
+  return data_transfer_protocol == "shm";
 }
 
 void LogFilenames(const std::vector<std::string>& files) {}
@@ -69,6 +69,16 @@ auto* graph_run_input_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 14 (256MB)
     {tsl::monitoring::Buckets::Exponential(1, 4, 14)});
 
+auto* checkpoint_restore_bytes_read = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/checkpoint/read/restore_bytes_read",
+    "The number of bytes read from checkpoint data files by RestoreV2.");
+
+auto* checkpoint_restore_throughput = tsl::monitoring::Sampler<0>::New(
+    {"/tensorflow/core/checkpoint/read/restore_throughput_gbps",
+     "The read throughput of RestoreV2 in GB/s."},
+    // Power of 2 from 10MB/s with bucket count 16 (> 300GB/s)
+    {tsl::monitoring::Buckets::Exponential(0.01, 2, 16)});
+
 auto* graph_run_output_tensor_bytes = tsl::monitoring::Sampler<0>::New(
     {"/tensorflow/core/graph_run_output_tensor_bytes",
      "The size of output tensors in bytes."},
@@ -104,6 +114,18 @@ auto* tf_data_bytes_fetched_counter = tsl::monitoring::Counter<0>::New(
     "/tensorflow/data/bytes_fetched",
     "The number of bytes fetched from tf.data Dataset iterator.");
 
+auto* tf_data_cache_reads_counter = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/data/cache_reads",
+    "The number of elements read from completed tf.data in-memory caches. "
+    "The result is whether the element was held in memory or had been "
+    "spilled to disk.",
+    "in_memory");
+
+auto* tf_data_cache_spill_bytes_counter = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/data/cache_spill_bytes",
+    "The number of compressed bytes spilled to disk by tf.data in-memory "
+    "caches that exceeded their memory budget.");
+
 auto* tf_data_elements_counter = tsl::monitoring::Counter<1>::New(
     "/tensorflow/data/elements", "tf.data elements", "name");
 
@@ -530,6 +552,15 @@ void RecordTFDataBytesFetched(int64_t num_bytes) {
   tf_data_bytes_fetched_counter->GetCell()->IncrementBy(num_bytes);
 }
 
+void RecordTFDataCacheRead(bool in_memory) {
+  tf_data_cache_reads_counter->GetCell(in_memory ? "true" : "false")
+      ->IncrementBy(1);
+}
+
+void RecordTFDataCacheSpillBytes(int64_t num_bytes) {
+  tf_data_cache_spill_bytes_counter->GetCell()->IncrementBy(num_bytes);
+}
+
 void RecordTFDataExperiment(const string& name) {
   tf_data_experiment_counter->GetCell(name)->IncrementBy(1);
 }
@@ -780,6 +811,19 @@ void RecordGraphOutputTensors(const size_t size) {
   graph_run_output_tensor_bytes_cell->Add(size);
 }
 
+void RecordCheckpointRestoreRead(int64_t num_bytes, int64_t duration_us) {
+  static auto* checkpoint_restore_bytes_read_cell =
+      checkpoint_restore_bytes_read->GetCell();
+  static auto* checkpoint_restore_throughput_cell =
+      checkpoint_restore_throughput->GetCell();
+  checkpoint_restore_bytes_read_cell->IncrementBy(num_bytes);
+  if (duration_us > 0) {
+    // Bytes per microsecond is MB/s.
+    checkpoint_restore_throughput_cell->Add(
+        static_cast<double>(num_bytes) / duration_us / 1000.0);
+  }
+}
+
 void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica) {
   xla_tpu_spmd_cores_per_replica->GetCell(absl::StrCat(cores_per_replica))
       ->IncrementBy(1);
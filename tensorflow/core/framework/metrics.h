@@ -81,6 +81,14 @@ monitoring::GaugeCell<std::function<std::string()>>* GetTFDataModelGauge(
 // Records the number of bytes fetched from tf.data.Dataset iterator.
 void RecordTFDataBytesFetched(int64_t num_bytes);
 
+// Records a read from a completed tf.data in-memory cache, and whether the
+// element was held in memory or had been spilled to disk.
+void RecordTFDataCacheRead(bool in_memory);
+
+// Records the number of compressed bytes a tf.data in-memory cache spilled to
+// disk.
+void RecordTFDataCacheSpillBytes(int64_t num_bytes);
+
 // Records the number of times a tf.data experiment was applied.
 void RecordTFDataExperiment(const string& name);
 
@@ -263,6 +271,10 @@ void RecordParseRaggedFeature(int64_t num_features);
 void RecordGraphInputTensors(const size_t size);
 void RecordGraphOutputTensors(const size_t size);
 
+// Records `num_bytes` read from checkpoint data files by a restore that took
+// `duration_us`, along with the achieved read throughput.
+void RecordCheckpointRestoreRead(int64_t num_bytes, int64_t duration_us);
+
 // Records the number of cores requested by graphs with XLA SPMD enabled.
 void RecordTPUXlaSpmdCoresPerReplica(int64_t cores_per_replica);
 
@@ -49,6 +49,12 @@ namespace {
 constexpr int32_t kGapTimeWindow = 100;
 // Gap time upper threshold: any gap time over this duration will be dropped.
 constexpr absl::Duration kGapDurationUpperThreshold = absl::Seconds(10);
+// The `CPU_BUDGET` algorithm grows its CPU budget while the consumer spends
+// more than `kInputBoundWaitShare` of its time waiting for elements, and
+// shrinks it while the consumer spends less than `kIdleWaitShare` of its time
+// waiting.
+constexpr double kInputBoundWaitShare = 0.1;
+constexpr double kIdleWaitShare = 0.02;
 // In outlier computation, points that are larger than `kOutlierSigmas` standard
 // deviations are considered outliers.
 constexpr double kOutlierSigmas = 2.0;
@@ -1972,6 +1978,31 @@ void Node::SyncStateValuesToParameterValues(const std::string& parameter_name) {
   }
 }
 
+void Node::SetTunableParameterValues(
+    const absl::flat_hash_map<string, double>& values) {
+  // `parameter->state->mu` must be locked before the node mutex `mu_`.
+  std::vector<std::pair<Parameter*, double>> parameters;
+  {
+    tf_shared_lock l(mu_);
+    for (auto& [parameter_name, parameter] : parameters_) {
+      auto it = values.find(parameter_name);
+      if (it == values.end() || parameter->state == nullptr ||
+          !parameter->state->tunable) {
+        continue;
+      }
+      parameters.push_back(std::make_pair(
+          parameter.get(),
+          std::clamp(it->second, parameter->min, parameter->max)));
+    }
+  }
+  for (auto& [parameter, value] : parameters) {
+    mutex_lock l(*parameter->state->mu);
+    parameter->value = value;
+    parameter->state->value = value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 Node::NodeVector Node::CollectNodesLocked(
     TraversalOrder order, bool collect_node(const std::shared_ptr<Node>)) const
     TF_SHARED_LOCKS_REQUIRED(mu_) {
@@ -2288,17 +2319,37 @@ void Model::AddNode(Node::Factory factory, const string& name,
   // The name captures the sequence of iterators joined by `::`. We only use the
   // last element of the sequence as the name node.
   auto node_name = str_util::Split(name, ':', str_util::SkipEmpty()).back();
-  mutex_lock l(mu_);
-  std::shared_ptr<Node> node = factory({id_counter_++, node_name, parent});
-  if (!output_) {
-    output_ = node;
-  }
-  if (parent) {
-    VLOG(3) << "Adding " << node->long_name() << " as input for "
-            << parent->long_name();
-    parent->add_input(node);
-  } else {
-    VLOG(3) << "Adding " << node->long_name();
+  std::shared_ptr<Node> node;
+  absl::flat_hash_map<string, double> warm_start_values;
+  {
+    mutex_lock l(mu_);
+    node = factory({id_counter_++, node_name, parent});
+    if (!output_) {
+      output_ = node;
+    }
+    // Node ids differ between runs and for re-created iterators, so the
+    // warm-start values are keyed by the path of the node instead.
+    string path;
+    if (parent) {
+      VLOG(3) << "Adding " << node->long_name() << " as input for "
+              << parent->long_name();
+      path = strings::StrCat(node_paths_[parent->long_name()], "/", node_name,
+                             "[", parent->inputs().size(), "]");
+      parent->add_input(node);
+    } else {
+      VLOG(3) << "Adding " << node->long_name();
+      path = node_name;
+    }
+    auto it = warm_start_values_.find(path);
+    if (it != warm_start_values_.end()) {
+      warm_start_values = it->second;
+      warm_started_ = true;
+    }
+    node_paths_[node->long_name()] = std::move(path);
+  }
+  // The parameter state locks must be acquired before the model lock.
+  if (!warm_start_values.empty()) {
+    node->SetTunableParameterValues(warm_start_values);
   }
   *out_node = std::move(node);
   // TODO(jsimsa): Reset the optimization period when a node is added so that
@@ -2330,9 +2381,11 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
                      RamBudgetManager& ram_budget_manager,
                      CancellationManager* cancellation_manager) {
   std::shared_ptr<Node> snapshot;
+  bool warm_started;
   {
     tf_shared_lock l(mu_);
     snapshot = output_->Snapshot();
+    warm_started = warm_started_;
   }
   if (snapshot->num_elements() <= 0) {
     VLOG(2) << "The root node has not produced any element. Will start "
@@ -2343,6 +2396,14 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
                "sources when the pipeline starts initially.";
     return;
   }
+  if (warm_started && snapshot->num_elements() < kGapTimeWindow) {
+    VLOG(2) << "The parameters were warm-started from a previous run. Will "
+               "start optimizing only when the root node has produced "
+            << kGapTimeWindow
+            << " elements, so that the first optimization does not replace "
+               "them based on a few measurements.";
+    return;
+  }
   MaybeSyncStateValuesToValues(snapshot);
   int64_t total_ram_budget;
   if (fixed_ram_budget.has_value()) {
@@ -2369,7 +2430,11 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
   }
   OptimizationParams optimization_params;
   optimization_params.set_algorithm(algorithm);
-  optimization_params.set_cpu_budget(cpu_budget_func());
+  if (algorithm == AutotuneAlgorithm::CPU_BUDGET) {
+    optimization_params.set_cpu_budget(UpdateCpuBudget(cpu_budget_func()));
+  } else {
+    optimization_params.set_cpu_budget(cpu_budget_func());
+  }
   optimization_params.set_ram_budget(model_ram_budget);
   optimization_params.set_model_input_time(model_input_time);
   switch (algorithm) {
@@ -2395,6 +2460,10 @@ void Model::Optimize(AutotuneAlgorithm algorithm,
       OptimizeStageBased(snapshot, optimization_params, cancellation_manager,
                          ram_budget_manager);
       break;
+    case AutotuneAlgorithm::CPU_BUDGET:
+      OptimizeCpuBudget(snapshot, optimization_params, cancellation_manager,
+                        ram_budget_manager);
+      break;
     default:
       VLOG(2) << "Autotuning algorithm was not recognized. Aborting "
                  "optimization.";
@@ -2454,6 +2523,8 @@ void Model::RemoveNode(std::shared_ptr<Node> node) {
       }
     }
     VLOG(3) << "Removing " << node->long_name();
+    mutex_lock l(mu_);
+    node_paths_.erase(node->long_name());
   }
 }
 
@@ -2574,6 +2645,7 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm,
     }
     Optimize(algorithm, cpu_budget_func, ram_budget_share, fixed_ram_budget,
              model_input_time, ram_budget_manager, cancellation_manager);
+    MaybeSaveTunedParameters();
     int64_t end_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
     VLOG(2) << "Optimized for " << end_ms - start_ms << " ms.";
 
@@ -2764,6 +2836,17 @@ void Model::RecordIteratorGapTime(uint64_t duration_usec) {
   }
 }
 
+void Model::RecordIteratorWaitTime(uint64_t duration_usec) {
+  mutex_lock l(gap_mu_);
+  if (duration_usec >= absl::ToInt64Microseconds(kGapDurationUpperThreshold)) {
+    return;
+  }
+  wait_times_usec_.push_back(duration_usec);
+  while (wait_times_usec_.size() > kGapTimeWindow) {
+    wait_times_usec_.pop_front();
+  }
+}
+
 double Model::ComputeTargetTimeNsec() {
   tf_shared_lock l(gap_mu_);
   if (gap_times_usec_.size() < kGapTimeWindow) {
@@ -2814,6 +2897,23 @@ double Model::ComputeSnapshotProcessingTimeNsec() const {
   return critical_root_status->first;
 }
 
+Model::ModelParameters Model::GetTunedParameters() {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock l(mu_);
+    snapshot = snapshot_;
+  }
+  if (snapshot == nullptr) {
+    return {};
+  }
+  return CollectTunableParameters(snapshot);
+}
+
+Model::OptimizationParams Model::GetOptimizationParams() const {
+  tf_shared_lock l(mu_);
+  return optimization_params_;
+}
+
 void Model::OptimizeStageBased(std::shared_ptr<Node> snapshot,
                                const OptimizationParams& optimization_params,
                                CancellationManager* cancellation_manager,
@@ -3147,6 +3247,130 @@ void Model::OptimizeMaxParallelism(
                           should_stop);
 }
 
+int64_t Model::UpdateCpuBudget(int64_t max_cpu_budget) {
+  max_cpu_budget = std::max<int64_t>(max_cpu_budget, 1);
+  if (learned_cpu_budget_ <= 0 || learned_cpu_budget_ > max_cpu_budget) {
+    learned_cpu_budget_ = max_cpu_budget;
+  }
+  double wait_time_usec = 0.0;
+  double gap_time_usec = 0.0;
+  {
+    tf_shared_lock l(gap_mu_);
+    if (wait_times_usec_.size() < kGapTimeWindow ||
+        gap_times_usec_.size() < kGapTimeWindow) {
+      return learned_cpu_budget_;
+    }
+    wait_time_usec =
+        std::accumulate(wait_times_usec_.begin(), wait_times_usec_.end(), 0.0);
+    gap_time_usec =
+        std::accumulate(gap_times_usec_.begin(), gap_times_usec_.end(), 0.0);
+  }
+  if (wait_time_usec + gap_time_usec <= 0.0) {
+    return learned_cpu_budget_;
+  }
+  const double wait_share = wait_time_usec / (wait_time_usec + gap_time_usec);
+  if (wait_share > kInputBoundWaitShare) {
+    learned_cpu_budget_ =
+        std::min(max_cpu_budget,
+                 learned_cpu_budget_ +
+                     std::max<int64_t>(learned_cpu_budget_ / 4, 1));
+  } else if (wait_share < kIdleWaitShare) {
+    learned_cpu_budget_ = std::max<int64_t>(
+        learned_cpu_budget_ - std::max<int64_t>(learned_cpu_budget_ / 10, 1),
+        1);
+  }
+  VLOG(2) << "The consumer waits for " << wait_share * 100.0
+          << "% of its time. Using a CPU budget of " << learned_cpu_budget_
+          << " out of " << max_cpu_budget << " cores.";
+  return learned_cpu_budget_;
+}
+
+void Model::OptimizeCpuBudget(std::shared_ptr<Node> snapshot,
+                              const OptimizationParams& optimization_params,
+                              CancellationManager* cancellation_manager,
+                              RamBudgetManager& ram_budget_manager) {
+  VLOG(2) << "Starting optimization of tunable parameters with a CPU budget of "
+          << optimization_params.cpu_budget() << " cores.";
+  auto parameters = CollectTunableParameters(snapshot);
+  if (parameters.empty()) {
+    VLOG(2) << "There are no tunable parameters.";
+    return;
+  }
+  // Buffer size parameter will only be incremented if the output latency
+  // improvement is greater than this constant.
+  constexpr double kBufferSizeMinDelta = 1.0L;
+  const bool skip_buffer_sizes =
+      experiments_.contains("autotune_buffer_optimization");
+  int64_t parallelism = 0;
+  for (auto& pair : parameters) {
+    if (skip_buffer_sizes && pair.second->name == kBufferSize) {
+      continue;
+    }
+    pair.second->value = pair.second->min;
+    if (pair.second->name == kParallelism) {
+      parallelism += std::round(pair.second->value);
+    }
+  }
+
+  // There is no point in producing elements faster than the consumer asks
+  // for them, nor faster than the CPU budget allows.
+  const int64_t cpu_budget =
+      std::max<int64_t>(optimization_params.cpu_budget(), 1);
+  const double target_output_time =
+      std::max(TotalProcessingTime(snapshot) / cpu_budget,
+               ComputeExperimentalTargetTimeNsec());
+  while (!cancellation_manager->IsCancelled()) {
+    const double output_time = OutputTime(snapshot, /*model_input_time=*/0.0,
+                                          /*gradients=*/nullptr);
+    if (output_time <= target_output_time) {
+      metrics::RecordTFDataAutotuneStoppingCriteria("output_time");
+      break;
+    }
+    double best_delta = -1.0L;
+    Parameter* best_parameter = nullptr;
+    bool cpu_budget_reached = false;
+    for (auto& pair : parameters) {
+      Parameter& parameter = *pair.second;
+      if (parameter.value >= parameter.max ||
+          (skip_buffer_sizes && parameter.name == kBufferSize)) {
+        continue;
+      }
+      if (parameter.name == kParallelism && parallelism >= cpu_budget) {
+        cpu_budget_reached = true;
+        continue;
+      }
+      parameter.value++;
+      if (TotalMaximumBufferedBytes(snapshot) >
+          optimization_params.ram_budget()) {
+        parameter.value--;
+        continue;
+      }
+      const double delta =
+          output_time - OutputTime(snapshot, /*model_input_time=*/0.0,
+                                   /*gradients=*/nullptr);
+      if (delta > best_delta &&
+          (delta > kBufferSizeMinDelta || parameter.name != kBufferSize)) {
+        best_delta = delta;
+        best_parameter = &parameter;
+      }
+      parameter.value--;
+    }
+    if (!best_parameter) {
+      metrics::RecordTFDataAutotuneStoppingCriteria(
+          cpu_budget_reached ? "cpu_budget" : "local_maximum_reached");
+      break;
+    }
+    best_parameter->value++;
+    if (best_parameter->name == kParallelism) {
+      ++parallelism;
+    }
+  }
+  if (ram_budget_manager.RequestModelAllocation(
+          TotalMaximumBufferedBytes(snapshot))) {
+    UpdateStateValues(&parameters);
+  }
+}
+
 double Model::OutputTime(std::shared_ptr<Node> node, double model_input_time,
                          Model::ParameterGradients* gradients) {
   // To store the input time for each node.
@@ -3227,6 +3451,87 @@ Status Model::Load(const string& fname, std::unique_ptr<Model>* model,
   return OkStatus();
 }
 
+Status Model::SaveTunedParameters(const string& fname, uint64 fingerprint) {
+  TunedParameters tuned_parameters;
+  tuned_parameters.set_fingerprint(fingerprint);
+  ModelParameters parameters = GetTunedParameters();
+  {
+    tf_shared_lock l(mu_);
+    for (const auto& [node_name, parameter] : parameters) {
+      auto it = node_paths_.find(node_name);
+      // Skips the nodes removed since the latest optimization.
+      if (it == node_paths_.end()) continue;
+      TunedParameters::Parameter* parameter_proto =
+          tuned_parameters.add_parameters();
+      parameter_proto->set_node_path(it->second);
+      parameter_proto->set_parameter_name(parameter->name);
+      parameter_proto->set_value(parameter->value);
+    }
+  }
+  // Writes to a temporary file first, so that a job stopped while saving does
+  // not leave a truncated file behind for the next run.
+  Env* env = Env::Default();
+  string tmp_fname = fname;
+  if (!env->CreateUniqueFileName(&tmp_fname, ".tmp")) {
+    return errors::Internal("Failed to create a unique file name for ", fname);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_fname, tuned_parameters));
+  return env->RenameFile(tmp_fname, fname);
+}
+
+Status Model::LoadTunedParameters(const string& fname, uint64 fingerprint) {
+  TunedParameters tuned_parameters;
+  TF_RETURN_IF_ERROR(
+      ReadBinaryProto(Env::Default(), fname, &tuned_parameters));
+  if (tuned_parameters.fingerprint() != fingerprint) {
+    return errors::FailedPrecondition(
+        "The parameters in ", fname,
+        " were tuned for a dataset graph with fingerprint ",
+        tuned_parameters.fingerprint(), " rather than ", fingerprint, ".");
+  }
+  mutex_lock l(mu_);
+  for (const auto& parameter : tuned_parameters.parameters()) {
+    warm_start_values_[parameter.node_path()][parameter.parameter_name()] =
+        parameter.value();
+  }
+  return OkStatus();
+}
+
+void Model::SetTunedParametersFile(const string& fname, uint64 fingerprint) {
+  mutex_lock l(mu_);
+  tuned_parameters_file_ = fname;
+  tuned_parameters_fingerprint_ = fingerprint;
+}
+
+void Model::MaybeSaveTunedParameters() {
+  string fname;
+  uint64 fingerprint;
+  {
+    tf_shared_lock l(mu_);
+    if (tuned_parameters_file_.empty() || snapshot_ == nullptr) {
+      return;
+    }
+    fname = tuned_parameters_file_;
+    fingerprint = tuned_parameters_fingerprint_;
+  }
+  string tuned_parameters;
+  for (const auto& [node_name, parameter] : GetTunedParameters()) {
+    strings::StrAppend(&tuned_parameters, node_name, ":", parameter->name, "=",
+                       parameter->value, ";");
+  }
+  if (tuned_parameters.empty() ||
+      tuned_parameters == saved_tuned_parameters_) {
+    return;
+  }
+  Status s = SaveTunedParameters(fname, fingerprint);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to save the tuned parameters to " << fname << ": "
+                 << s;
+    return;
+  }
+  saved_tuned_parameters_ = std::move(tuned_parameters);
+}
+
 std::string Model::DebugString() {
   constexpr int64_t kMinSecondsBetweenCalls = 30;
   if (absl::Now() < cache_until_) return cached_debug_string_;
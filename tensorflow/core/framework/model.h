@@ -215,10 +215,12 @@ class RamBudgetManager {
   // prefetch autotuners.
   //
   // Returns whether there were enough bytes left in the budget to serve the
-  // request. If not, no bytes are allocated.
+  // request. If not, no bytes are allocated. Releasing bytes (a negative
+  // `delta_bytes`) always succeeds.
   bool RequestLegacyPrefetchBytes(int64_t delta_bytes) {
     mutex_lock l(mu_);
-    if (delta_bytes > budget_ - legacy_prefetch_allocated_ - model_allocated_) {
+    if (delta_bytes > 0 &&
+        delta_bytes > budget_ - legacy_prefetch_allocated_ - model_allocated_) {
       return false;
     }
     legacy_prefetch_allocated_ += delta_bytes;
@@ -630,6 +632,11 @@ class Node {
   // name matches `parameter_name`.
   void SyncStateValuesToParameterValues(const std::string& parameter_name);
 
+  // Sets the tunable parameters named in `values` and their state values to
+  // the given values, clamped to the parameters' bounds.
+  void SetTunableParameterValues(
+      const absl::flat_hash_map<string, double>& values);
+
  protected:
   // Used for (incrementally) recording metrics. The class is thread-safe.
   class Metrics {
@@ -1006,9 +1013,31 @@ class Model {
   static Status Load(const string& fname, std::unique_ptr<Model>* model,
                      OptimizationParams* optimization_params);
 
+  // Saves the tunable parameter values chosen by the latest optimization to a
+  // file, together with the `fingerprint` of the dataset graph they were tuned
+  // for.
+  Status SaveTunedParameters(const string& fname, uint64 fingerprint)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Loads the parameter values saved by `SaveTunedParameters` from a file. The
+  // parameters of nodes added afterwards start from the loaded values, and
+  // optimization leaves them alone until the pipeline has produced enough
+  // elements to measure its processing times. Returns `FailedPrecondition` if
+  // the values were tuned for a dataset graph with another fingerprint.
+  Status LoadTunedParameters(const string& fname, uint64 fingerprint)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Makes the optimization loop save the tuned parameter values to `fname`
+  // whenever an optimization changes them.
+  void SetTunedParametersFile(const string& fname, uint64 fingerprint)
+      TF_LOCKS_EXCLUDED(mu_);
+
   // Records gap time between consecutive `GetNext()` calls.
   void RecordIteratorGapTime(uint64_t duration_usec);
 
+  // Records the time the consumer waited in a `GetNext()` call.
+  void RecordIteratorWaitTime(uint64_t duration_usec);
+
   // Computes the target time in nsecs to use for `STAGE_BASED` autotune
   // algorithm. Returns 0 if there if there are not sufficient recorded iterator
   // gap times to produce a good estimate.
@@ -1025,6 +1054,13 @@ class Model {
   // having executed an optimization round before.
   double ComputeSnapshotProcessingTimeNsec() const;
 
+  // Returns the tunable parameters of the latest model snapshot, whose values
+  // are the ones chosen by the latest optimization.
+  ModelParameters GetTunedParameters() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the optimization parameters used by the latest optimization.
+  OptimizationParams GetOptimizationParams() const TF_LOCKS_EXCLUDED(mu_);
+
  private:
   // Determines whether optimization should stop given total processing time,
   // estimated output time, and estimated number of buffers bytes.
@@ -1065,6 +1101,10 @@ class Model {
   // Flushes metrics recorded by the model.
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
+  // Saves the tuned parameter values to the file set by
+  // `SetTunedParametersFile` if they changed since they were last saved.
+  void MaybeSaveTunedParameters() TF_LOCKS_EXCLUDED(mu_);
+
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then improves current parameters by
   // making a step in the direction opposite to the gradient of `OutputTime` and
@@ -1115,6 +1155,23 @@ class Model {
                           CancellationManager* cancellation_manager,
                           RamBudgetManager& ram_budget_manager);
 
+  // This optimization starts by setting all tunable parameters to their
+  // minimum values. It then repeatedly increases the parameter that decreases
+  // the output time the most, as long as the parallelism parameters add up to
+  // at most the CPU budget and the buffers fit in the RAM budget. It stops once
+  // the pipeline produces elements at least as fast as the consumer asks for
+  // them.
+  void OptimizeCpuBudget(std::shared_ptr<Node> snapshot,
+                         const OptimizationParams& optimization_params,
+                         CancellationManager* cancellation_manager,
+                         RamBudgetManager& ram_budget_manager);
+
+  // Returns the CPU budget for the `CPU_BUDGET` algorithm, which is at most
+  // `max_cpu_budget`. The budget grows while the consumer spends a large share
+  // of its time waiting for elements and shrinks while it hardly waits, so
+  // that the pipeline leaves the remaining cores to the consumer.
+  int64_t UpdateCpuBudget(int64_t max_cpu_budget);
+
   // This is the first part of the stage-based optimization that optimizes
   // tunable parallelism parameters for async interleave many nodes only. We
   // separately optimize async interleave many nodes more aggressively because
@@ -1194,12 +1251,35 @@ class Model {
   mutable mutex gap_mu_;
   // Stores the latest gap times between consecutive `GetNext()`.
   std::deque<uint64_t> gap_times_usec_ TF_GUARDED_BY(gap_mu_);
+  // Stores the latest times the consumer waited in `GetNext()`.
+  std::deque<uint64_t> wait_times_usec_ TF_GUARDED_BY(gap_mu_);
+  // The CPU budget learned by the `CPU_BUDGET` algorithm, or 0 before its
+  // first optimization. Only accessed by the optimization loop.
+  int64_t learned_cpu_budget_ = 0;
   // The experiment that this job is part of.
   absl::flat_hash_set<std::string> experiments_;
   // Stores the optimization snapshot of the Model.
   std::shared_ptr<Node> snapshot_ TF_GUARDED_BY(mu_);
   // Stores the optimization parameters used by autotune.
   OptimizationParams optimization_params_ TF_GUARDED_BY(mu_);
+  // Paths of the nodes in the model, keyed by their long names. The path of
+  // a node lists the names of the node and its ancestors with their positions
+  // among the inputs of their parents, e.g. `Root/ParallelMapV2[0]`, so it is
+  // the same for the nodes of a re-created iterator.
+  absl::flat_hash_map<string, string> node_paths_ TF_GUARDED_BY(mu_);
+  // Parameter values loaded by `LoadTunedParameters`, keyed by the path of
+  // their node and then by parameter name.
+  absl::flat_hash_map<string, absl::flat_hash_map<string, double>>
+      warm_start_values_ TF_GUARDED_BY(mu_);
+  // Whether loaded values were applied to any node.
+  bool warm_started_ TF_GUARDED_BY(mu_) = false;
+  // The file to which the optimization loop saves the tuned parameter values,
+  // or empty if they are not saved.
+  string tuned_parameters_file_ TF_GUARDED_BY(mu_);
+  uint64 tuned_parameters_fingerprint_ TF_GUARDED_BY(mu_) = 0;
+  // Describes the tuned parameter values last saved to
+  // `tuned_parameters_file_`. Only accessed by the optimization loop.
+  string saved_tuned_parameters_;
   // Stores the model id in the string format
   std::string model_id_;
 };
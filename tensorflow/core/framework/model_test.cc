@@ -1224,6 +1224,88 @@ TEST(SaveModelTest, Model) {
   EXPECT_TRUE(restored_current->inputs().empty());
 }
 
+TEST(TunedParametersTest, WarmStartsFromSavedParameters) {
+  auto make_node = [](std::shared_ptr<SharedState> parallelism) {
+    return [parallelism](Node::Args args) {
+      return model::MakeAsyncKnownRatioNode(
+          std::move(args), /*ratio=*/1,
+          {model::MakeParameter("parallelism", parallelism, /*min=*/1,
+                                /*max=*/8)});
+    };
+  };
+  auto make_root = [](Node::Args args) {
+    return model::MakeKnownRatioNode(std::move(args), /*ratio=*/1);
+  };
+  auto make_state = []() {
+    return std::make_shared<SharedState>(
+        /*value=*/model::kAutotune, std::make_shared<mutex>(),
+        std::make_shared<condition_variable>());
+  };
+  auto optimize = [](Model& model) {
+    CancellationManager cancellation_manager;
+    RamBudgetManager ram_budget_manager(0);
+    model.Optimize(AutotuneAlgorithm::HILL_CLIMB, [] { return 4; },
+                   /*ram_budget_share=*/1.0, /*fixed_ram_budget=*/1 << 30,
+                   /*model_input_time=*/0, ram_budget_manager,
+                   &cancellation_manager);
+  };
+
+  Model model;
+  std::shared_ptr<SharedState> parallelism = make_state();
+  std::shared_ptr<Node> root, node;
+  model.AddNode(make_root, "Root", nullptr, &root);
+  model.AddNode(make_node(parallelism), "ParallelMap", root, &node);
+  for (int i = 0; i < 100; ++i) {
+    root->record_element();
+    node->record_element();
+    node->add_processing_time(100000);
+  }
+  optimize(model);
+  const double tuned_parallelism = parallelism->value;
+  EXPECT_GT(tuned_parallelism, 1);
+
+  std::string fname;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&fname));
+  TF_ASSERT_OK(model.SaveTunedParameters(fname, /*fingerprint=*/42));
+
+  Model other_pipeline_model;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      other_pipeline_model.LoadTunedParameters(fname, /*fingerprint=*/43)));
+
+  // The values apply to the nodes of a re-created iterator, whose ids differ
+  // from those of the saved nodes.
+  Model restarted_model;
+  TF_ASSERT_OK(restarted_model.LoadTunedParameters(fname, /*fingerprint=*/42));
+  std::shared_ptr<Node> restarted_root, restarted_node;
+  restarted_model.AddNode(make_root, "Root", nullptr, &restarted_root);
+  restarted_model.AddNode(make_node(make_state()), "ParallelMap",
+                          restarted_root, &restarted_node);
+  restarted_model.RemoveNode(restarted_node);
+  std::shared_ptr<SharedState> restarted_parallelism = make_state();
+  restarted_model.AddNode(make_node(restarted_parallelism), "ParallelMap",
+                          restarted_root, &restarted_node);
+  EXPECT_NE(restarted_node->id(), node->id());
+  EXPECT_EQ(restarted_parallelism->value, tuned_parallelism);
+  EXPECT_EQ(restarted_node->parameter_value("parallelism"), tuned_parallelism);
+
+  // Values saved for other nodes do not hold off the first optimization.
+  Model changed_pipeline_model;
+  TF_ASSERT_OK(
+      changed_pipeline_model.LoadTunedParameters(fname, /*fingerprint=*/42));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(fname));
+  std::shared_ptr<SharedState> changed_parallelism = make_state();
+  std::shared_ptr<Node> changed_root, changed_node;
+  changed_pipeline_model.AddNode(make_root, "Root", nullptr, &changed_root);
+  changed_pipeline_model.AddNode(make_node(changed_parallelism),
+                                 "ParallelBatch", changed_root, &changed_node);
+  EXPECT_EQ(changed_parallelism->value, model::kAutotune);
+  changed_root->record_element();
+  changed_node->record_element();
+  changed_node->add_processing_time(100000);
+  optimize(changed_pipeline_model);
+  EXPECT_NE(changed_parallelism->value, model::kAutotune);
+}
+
 class ComputeWaitTimeTest
     : public ::testing::TestWithParam<std::tuple<double, double, double>> {};
 
@@ -2773,6 +2855,173 @@ TEST_F(ModelTimingTest, OptimizeStageBased_TwoStages) {
   EXPECT_EQ(5, GetNode(/*node_id=*/2)->parameter_value("parallelism"));
 }
 
+TEST_F(ModelTimingTest, OptimizeCpuBudget_TwoStages) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 25000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 1000
+        node_class: KNOWN_RATIO
+        ratio: 2
+      }
+    }
+    output: 1
+  )pb");
+
+  CancellationManager cancellation_manager;
+  RamBudgetManager ram_budget_manager(0);
+  model_->Optimize(AutotuneAlgorithm::CPU_BUDGET, CpuBudgetFunc(5),
+                   /*ram_budget_share=*/1.0,
+                   /*fixed_ram_budget=*/1 << 30,
+                   /*model_input_time=*/0, ram_budget_manager,
+                   &cancellation_manager);
+
+  const double parallelism_1 =
+      GetNode(/*node_id=*/1)->parameter_value("parallelism");
+  const double parallelism_2 =
+      GetNode(/*node_id=*/2)->parameter_value("parallelism");
+  EXPECT_GE(parallelism_1, 1);
+  EXPECT_GE(parallelism_2, 1);
+  EXPECT_LE(parallelism_1 + parallelism_2, 5);
+  EXPECT_EQ(model_->GetOptimizationParams().cpu_budget(), 5);
+  EXPECT_EQ(model_->GetTunedParameters().size(), 2);
+}
+
+TEST_F(ModelTimingTest, OptimizeCpuBudget_LearnsBudgetFromWaitTime) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 25000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 1000
+        node_class: KNOWN_RATIO
+        ratio: 2
+      }
+    }
+    output: 1
+  )pb");
+
+  CancellationManager cancellation_manager;
+  RamBudgetManager ram_budget_manager(0);
+  auto optimize = [&]() {
+    model_->Optimize(AutotuneAlgorithm::CPU_BUDGET, CpuBudgetFunc(20),
+                     /*ram_budget_share=*/1.0,
+                     /*fixed_ram_budget=*/1 << 30,
+                     /*model_input_time=*/0, ram_budget_manager,
+                     &cancellation_manager);
+    return model_->GetOptimizationParams().cpu_budget();
+  };
+
+  // The budget stays at its maximum until there are enough wait times.
+  EXPECT_EQ(optimize(), 20);
+
+  // The consumer does not wait, so the budget shrinks.
+  for (int i = 0; i < 100; ++i) {
+    model_->RecordIteratorGapTime(/*duration_usec=*/1000);
+    model_->RecordIteratorWaitTime(/*duration_usec=*/0);
+  }
+  EXPECT_EQ(optimize(), 18);
+  EXPECT_EQ(optimize(), 17);
+
+  // The consumer waits for half of its time, so the budget grows again, up to
+  // its maximum.
+  for (int i = 0; i < 100; ++i) {
+    model_->RecordIteratorWaitTime(/*duration_usec=*/1000);
+  }
+  EXPECT_EQ(optimize(), 20);
+}
+
 TEST_F(ModelTimingTest, OptimizeStageBased_ParallelInterleaveMaxParallelism) {
   BuildModelFromProto(R"pb(
     nodes: {
@@ -3572,6 +3821,17 @@ TEST(RamBudgetManagerTest, RequestAllocationsWithBudgetAdjustment) {
   EXPECT_TRUE(rbm.RequestLegacyPrefetchBytes(4));
 }
 
+TEST(RamBudgetManagerTest, ReleaseLegacyPrefetchBytesOverBudget) {
+  RamBudgetManager rbm(10);
+  EXPECT_TRUE(rbm.RequestLegacyPrefetchBytes(8));
+  rbm.UpdateBudget(4);
+  // Releasing bytes succeeds even though the allocation exceeds the budget.
+  EXPECT_TRUE(rbm.RequestLegacyPrefetchBytes(-2));
+  EXPECT_EQ(rbm.AvailableModelRam(), -2);
+  EXPECT_TRUE(rbm.RequestLegacyPrefetchBytes(-6));
+  EXPECT_EQ(rbm.AvailableModelRam(), 4);
+}
+
 TEST(NodeTest, OnlyCollectParametersThatHaveElementsProduced) {
   // Builds a graph:
   // root <- parallel_map <- parallel_interleave
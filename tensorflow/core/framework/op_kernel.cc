@@ -377,6 +377,9 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
     allocator = params_->device->GetScopedAllocator(attr, step_id());
     CHECK(allocator);
+  } else if (params_->step_arena_allocator != nullptr &&
+             !attr.gpu_compatible() && !attr.nic_compatible()) {
+    allocator = params_->step_arena_allocator;
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
@@ -619,6 +619,11 @@ class OpKernelContext {
     bool track_allocations = false;
     bool log_memory = false;
 
+    // If non-null, allocations with default-placement attributes are served
+    // from this step-scoped allocator instead of the device allocator. The
+    // executor only sets it for kernels whose outputs cannot outlive the step.
+    Allocator* step_arena_allocator = nullptr;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_var.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 
@@ -40,6 +42,55 @@ Status Var::AsGraphDef(GraphDefBuilder* builder, Node** out) const {
   return absl::OkStatus();
 }
 
+void Var::RecordDirtyRows(const Tensor& indices) {
+  if (!track_dirty_rows_.load(std::memory_order_acquire)) return;
+  if (indices.dtype() != DT_INT32 && indices.dtype() != DT_INT64) {
+    MarkAllRowsDirty();
+    return;
+  }
+  mutex_lock l(dirty_rows_mu_);
+  if (all_rows_dirty_) return;
+  if (indices.dtype() == DT_INT32) {
+    const auto rows = indices.flat<int32>();
+    for (int64_t i = 0; i < rows.size(); ++i) dirty_rows_.insert(rows(i));
+  } else {
+    const auto rows = indices.flat<int64_t>();
+    for (int64_t i = 0; i < rows.size(); ++i) dirty_rows_.insert(rows(i));
+  }
+}
+
+void Var::MarkAllRowsDirty() {
+  if (!track_dirty_rows_.load(std::memory_order_acquire)) return;
+  mutex_lock l(dirty_rows_mu_);
+  all_rows_dirty_ = true;
+  dirty_rows_.clear();
+}
+
+bool Var::TakeDirtyRows(std::vector<int64_t>* rows) {
+  mutex_lock l(dirty_rows_mu_);
+  const bool was_tracking =
+      track_dirty_rows_.exchange(true, std::memory_order_acq_rel);
+  // Rows taken before stay pending until they are committed, so that a failed
+  // save does not lose them.
+  all_rows_pending_ |= all_rows_dirty_ || !was_tracking;
+  if (all_rows_pending_) {
+    pending_rows_.clear();
+  } else {
+    pending_rows_.insert(dirty_rows_.begin(), dirty_rows_.end());
+  }
+  all_rows_dirty_ = false;
+  dirty_rows_.clear();
+  rows->assign(pending_rows_.begin(), pending_rows_.end());
+  std::sort(rows->begin(), rows->end());
+  return all_rows_pending_;
+}
+
+void Var::CommitDirtyRows() {
+  mutex_lock l(dirty_rows_mu_);
+  all_rows_pending_ = false;
+  pending_rows_.clear();
+}
+
 std::string Var::MakeRefCountingHandleName(int64_t resource_id) const {
   // Use the resource id to ensure uniqueness.
   std::string handle_name = absl::StrFormat("%s%d", debug_name_, resource_id);
@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <atomic>
 #include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
 
 #include "tensorflow/core/framework/resource_base.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -110,11 +114,36 @@ class Var : public ResourceBase {
   // so desired.
   std::atomic<bool> copy_on_read_mode{false};
 
+  // Dirty row tracking, for incremental checkpoints. Sparse updates record the
+  // rows (indices along dimension 0) they wrote with RecordDirtyRows() after
+  // the write, and dense updates call MarkAllRowsDirty() while holding mu()
+  // exclusively. Tracking starts with the first call to TakeDirtyRows(), so
+  // until then these are no-ops and the whole variable counts as dirty.
+  void RecordDirtyRows(const Tensor& indices);
+  void MarkAllRowsDirty();
+
+  // Returns true if the whole variable may have been written since the last
+  // call to CommitDirtyRows(). Otherwise sets "*rows" to the sorted rows
+  // written since then. The returned rows stay pending, and are returned again
+  // by later calls, until CommitDirtyRows() is called once they are saved.
+  bool TakeDirtyRows(std::vector<int64_t>* rows);
+
+  // Forgets the rows returned by previous calls to TakeDirtyRows().
+  void CommitDirtyRows();
+
  private:
   mutex mu_;
   Tensor tensor_;
   std::string debug_name_;
 
+  std::atomic<bool> track_dirty_rows_{false};
+  mutex dirty_rows_mu_;
+  bool all_rows_dirty_ TF_GUARDED_BY(dirty_rows_mu_) = true;
+  absl::flat_hash_set<int64_t> dirty_rows_ TF_GUARDED_BY(dirty_rows_mu_);
+  // Rows returned by TakeDirtyRows() that are not committed yet.
+  bool all_rows_pending_ TF_GUARDED_BY(dirty_rows_mu_) = false;
+  absl::flat_hash_set<int64_t> pending_rows_ TF_GUARDED_BY(dirty_rows_mu_);
+
   ~Var() override {}
   Var(const Var&) = delete;
   void operator=(const Var&) = delete;
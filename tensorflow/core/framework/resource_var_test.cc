@@ -34,5 +34,64 @@ TEST(ResourceVarTest, Uninitialize) {
   EXPECT_FALSE(var->is_initialized);
   EXPECT_TRUE(var->tensor()->data() == nullptr);
 }
+
+TEST(ResourceVarTest, DirtyRows) {
+  RefCountPtr<Var> var{new Var(DT_FLOAT)};
+  std::vector<int64_t> rows;
+
+  // Updates before tracking starts are not recorded, so the first call
+  // reports the whole variable as dirty.
+  Tensor indices(DT_INT32, TensorShape({3}));
+  indices.flat<int32>().setValues({5, 1, 5});
+  var->RecordDirtyRows(indices);
+  EXPECT_TRUE(var->TakeDirtyRows(&rows));
+  var->CommitDirtyRows();
+
+  var->RecordDirtyRows(indices);
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_EQ(rows, std::vector<int64_t>({1, 5}));
+  var->CommitDirtyRows();
+
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_TRUE(rows.empty());
+
+  var->RecordDirtyRows(indices);
+  var->MarkAllRowsDirty();
+  EXPECT_TRUE(var->TakeDirtyRows(&rows));
+}
+
+TEST(ResourceVarTest, UncommittedDirtyRowsAreKept) {
+  RefCountPtr<Var> var{new Var(DT_FLOAT)};
+  std::vector<int64_t> rows;
+  EXPECT_TRUE(var->TakeDirtyRows(&rows));
+  var->CommitDirtyRows();
+
+  Tensor indices(DT_INT64, TensorShape({2}));
+  indices.flat<int64_t>().setValues({3, 1});
+  var->RecordDirtyRows(indices);
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_EQ(rows, std::vector<int64_t>({1, 3}));
+
+  // The save of rows 1 and 3 failed, so they are returned again together with
+  // the rows written since.
+  indices.flat<int64_t>().setValues({4, 3});
+  var->RecordDirtyRows(indices);
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_EQ(rows, std::vector<int64_t>({1, 3, 4}));
+  var->CommitDirtyRows();
+
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_TRUE(rows.empty());
+
+  // A pending dense write is kept too, and committing it keeps the rows
+  // written after it was taken.
+  var->MarkAllRowsDirty();
+  EXPECT_TRUE(var->TakeDirtyRows(&rows));
+  EXPECT_TRUE(var->TakeDirtyRows(&rows));
+  var->RecordDirtyRows(indices);
+  var->CommitDirtyRows();
+  EXPECT_FALSE(var->TakeDirtyRows(&rows));
+  EXPECT_EQ(rows, std::vector<int64_t>({3, 4}));
+}
 }  // namespace core
 }  // namespace tensorflow
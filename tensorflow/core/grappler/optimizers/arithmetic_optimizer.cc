@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <unordered_map>
 #include <unordered_set>
@@ -55,6 +56,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/strided_slice_op.h"
 
@@ -3557,6 +3559,345 @@ class OptimizeMaxOrMinOfMonotonicStage : public ArithmeticOptimizerStage {
   }
 };
 
+// Replace a cluster of element-wise ops computing a float tensor with a single
+// '_FusedElementwise' node, that evaluates the cluster as a program in one
+// pass over its output without materializing intermediate tensors.
+//
+// Clusters are grown from a root node towards its inputs: an input node joins
+// the cluster if it is a supported op placed on the same device, and all of
+// its consumers are already in the cluster. Nodes are visited consumers-first,
+// so the root of a cluster is the last node of a maximal fusible subgraph.
+class FuseElementwiseOps : public ArithmeticOptimizerStage {
+ public:
+  explicit FuseElementwiseOps(const GraphOptimizerContext& ctx,
+                              const ArithmeticOptimizerContext& ctx_ext)
+      : ArithmeticOptimizerStage("FuseElementwiseOps", ctx, ctx_ext) {
+    // WARN: This should be consistent with fused_elementwise_op.cc.
+    // clang-format off
+    supported_ops_ = {// Unary ops.
+                      {"Abs",               {1, kFloat}},
+                      {"Cast",              {1, kCast}},
+                      {"Ceil",              {1, kFloat}},
+                      {"Exp",               {1, kFloat}},
+                      {"Expm1",             {1, kFloat}},
+                      {"Floor",             {1, kFloat}},
+                      {"Inv",               {1, kFloat}},
+                      {"Log",               {1, kFloat}},
+                      {"Log1p",             {1, kFloat}},
+                      {"LogicalNot",        {1, kLogical}},
+                      {"Neg",               {1, kFloat}},
+                      {"Reciprocal",        {1, kFloat}},
+                      {"Relu",              {1, kFloat}},
+                      {"Relu6",             {1, kFloat}},
+                      {"Rsqrt",             {1, kFloat}},
+                      {"Sigmoid",           {1, kFloat}},
+                      {"Sign",              {1, kFloat}},
+                      {"Sqrt",              {1, kFloat}},
+                      {"Square",            {1, kFloat}},
+                      {"Tanh",              {1, kFloat}},
+                      // Binary ops.
+                      {"Add",               {2, kFloat}},
+                      {"AddV2",             {2, kFloat}},
+                      {"Div",               {2, kFloat}},
+                      {"DivNoNan",          {2, kFloat}},
+                      {"Equal",             {2, kComparison}},
+                      {"Greater",           {2, kComparison}},
+                      {"GreaterEqual",      {2, kComparison}},
+                      {"Less",              {2, kComparison}},
+                      {"LessEqual",         {2, kComparison}},
+                      {"LogicalAnd",        {2, kLogical}},
+                      {"LogicalOr",         {2, kLogical}},
+                      {"Maximum",           {2, kFloat}},
+                      {"Minimum",           {2, kFloat}},
+                      {"Mul",               {2, kFloat}},
+                      {"NotEqual",          {2, kComparison}},
+                      {"RealDiv",           {2, kFloat}},
+                      {"SquaredDifference", {2, kFloat}},
+                      {"Sub",               {2, kFloat}},
+                      // Ternary ops.
+                      {"ClipByValue",       {3, kFloat}},
+                      {"SelectV2",          {3, kSelect}}};
+    // clang-format on
+  }
+  ~FuseElementwiseOps() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return OutputsFloat(*node) && CanFuse(*node, *node) &&
+           // Check that this node was not already a root of a fused cluster.
+           // If graph optimization runs twice without pruning in between,
+           // fused_nodes_ will not have this information.
+           !ctx().node_map->NodeExists(OptimizedNodeName(*node));
+  }
+
+  Status TrySimplify(NodeDef* root, string* simplified_node_name) override {
+    // Grow the cluster until none of the inputs of its nodes can be added.
+    std::vector<const NodeDef*> cluster = {root};
+    absl::flat_hash_set<string> cluster_nodes = {root->name()};
+    bool grown = true;
+    while (grown && cluster.size() < kMaxClusterSize) {
+      grown = false;
+      for (int i = 0; i < cluster.size() && cluster.size() < kMaxClusterSize;
+           ++i) {
+        const NodeDef* node = cluster[i];
+        for (int j = 0; j < Arity(*node); ++j) {
+          const NodeDef* input = ctx().node_map->GetNode(node->input(j));
+          if (input == nullptr || cluster_nodes.contains(input->name()) ||
+              !CanFuse(*input, *root)) {
+            continue;
+          }
+          const auto& consumers = ctx().node_map->GetOutputs(input->name());
+          if (!std::all_of(consumers.begin(), consumers.end(),
+                           [&](const NodeDef* consumer) {
+                             return cluster_nodes.contains(consumer->name());
+                           })) {
+            continue;
+          }
+          cluster.push_back(input);
+          cluster_nodes.insert(input->name());
+          grown = true;
+        }
+      }
+    }
+
+    // A single op gains nothing from fusion, and chains of unary ops are left
+    // to the UnaryOpsComposition stage.
+    if (cluster.size() < 2 ||
+        std::none_of(cluster.begin(), cluster.end(), [this](const NodeDef* n) {
+          return Arity(*n) > 1;
+        })) {
+      return absl::OkStatus();
+    }
+
+    // Order the ops of the cluster so that every op follows the ops that it
+    // reads, and collect the tensors read from outside of the cluster.
+    std::vector<const NodeDef*> ops;
+    std::vector<string> inputs;
+    DataTypeVector input_types;
+    absl::flat_hash_map<string, int> input_registers;
+    absl::flat_hash_set<string> visited;
+    std::function<void(const NodeDef*)> visit = [&](const NodeDef* node) {
+      if (!visited.insert(node->name()).second) return;
+      for (int i = 0; i < Arity(*node); ++i) {
+        const string& input = node->input(i);
+        if (cluster_nodes.contains(NodeName(input))) {
+          visit(ctx().node_map->GetNode(input));
+        } else if (input_registers
+                       .emplace(ParseTensorName(input).ToString(),
+                                inputs.size())
+                       .second) {
+          inputs.push_back(input);
+          input_types.push_back(InputType(*node, i));
+        }
+      }
+      ops.push_back(node);
+    };
+    visit(root);
+
+    // Inputs are registers [0, N), and the i-th op writes register N + i.
+    absl::flat_hash_map<string, int> op_registers;
+    std::vector<string> op_names;
+    std::vector<int> op_inputs;
+    for (const NodeDef* node : ops) {
+      for (int i = 0; i < Arity(*node); ++i) {
+        const string& input = node->input(i);
+        const auto it = op_registers.find(NodeName(input));
+        op_inputs.push_back(it != op_registers.end()
+                                ? it->second
+                                : input_registers.at(
+                                      ParseTensorName(input).ToString()));
+      }
+      op_registers[node->name()] = inputs.size() + op_names.size();
+      op_names.push_back(node->op());
+    }
+
+    // Do not add fused nodes to any other cluster.
+    for (const NodeDef* node : ops) AddToFusedNodes(node->name());
+
+    VLOG(2) << "Fuse elementwise ops: root=" << root->name() << " op_names=["
+            << absl::StrJoin(op_names, ", ") << "]";
+
+    NodeDef* fused_node = ctx().optimized_graph->add_node();
+    fused_node->set_name(OptimizedNodeName(*root));
+    fused_node->set_op("_FusedElementwise");
+    fused_node->set_device(root->device());
+    for (const string& input : inputs) {
+      fused_node->add_input(input);
+      ctx().node_map->AddOutput(NodeName(input), fused_node->name());
+    }
+
+    auto attr = fused_node->mutable_attr();
+    SetAttrValue(input_types, &(*attr)["Tin"]);
+    SetAttrValue(DT_FLOAT, &(*attr)["T"]);
+    SetAttrValue(op_names, &(*attr)["op_names"]);
+    SetAttrValue(op_inputs, &(*attr)["op_inputs"]);
+
+    ctx().node_map->AddNode(fused_node->name(), fused_node);
+    *simplified_node_name = fused_node->name();
+
+    return absl::OkStatus();
+  }
+
+ private:
+  // Types of the tensors that the supported ops read and write.
+  enum Kind {
+    // Float inputs and output.
+    kFloat,
+    // Float inputs and boolean output.
+    kComparison,
+    // Boolean inputs and output.
+    kLogical,
+    // Boolean, integer or float input and float output.
+    kCast,
+    // Boolean condition, float values and float output.
+    kSelect,
+  };
+
+  struct FusibleOp {
+    int arity;
+    Kind kind;
+  };
+
+  // Upper bound on the number of ops in a cluster, to keep the registers of
+  // the program in cache.
+  static constexpr int kMaxClusterSize = 64;
+
+  bool CanFuse(const NodeDef& node, const NodeDef& root) const {
+    const auto it = supported_ops_.find(node.op());
+    if (it == supported_ops_.end()) {
+      return false;
+    }
+    switch (it->second.kind) {
+      case kFloat:
+      case kComparison:
+      case kSelect:
+        if (GetDataTypeFromAttr(node, "T") != DT_FLOAT) return false;
+        break;
+      case kLogical:
+        break;
+      case kCast: {
+        const DataType src_type = GetDataTypeFromAttr(node, "SrcT");
+        if (GetDataTypeFromAttr(node, "DstT") != DT_FLOAT ||
+            (src_type != DT_BOOL && src_type != DT_INT32 &&
+             src_type != DT_INT64 && src_type != DT_FLOAT)) {
+          return false;
+        }
+        break;
+      }
+    }
+    // Equal and NotEqual can return a scalar for inputs of incompatible
+    // shapes.
+    if (node.attr().count("incompatible_shape_error") > 0 &&
+        !node.attr().at("incompatible_shape_error").b()) {
+      return false;
+    }
+    if (node.device() != root.device() || !NodeIsOnCpu(node)) {
+      return false;
+    }
+    if (IsInPreserveSet(node) || NodeIsAlreadyFused(node) ||
+        MayBeFusedByRemapper(node)) {
+      return false;
+    }
+    return !(IsDrivenByControlDependency(node) ||
+             DrivesControlDependency(node));
+  }
+
+  // Returns whether the remapper, which runs after this optimizer, may fuse
+  // `node` into a more specialized kernel: the epilogue of a contraction
+  // (BiasAdd, Add and activation), Mul and Maximum into LeakyRelu, or the Add
+  // of a masked Softmax. Other remapper patterns, such as GELU and layer
+  // normalization, are not recognized here.
+  bool MayBeFusedByRemapper(const NodeDef& node) const {
+    if (IsLeakyReluMaximum(node)) return true;
+    for (const string& input_name : node.input()) {
+      if (IsControlInput(input_name)) break;
+      const NodeDef* input = ctx().node_map->GetNode(input_name);
+      if (input == nullptr) continue;
+      if (IsContraction(*input)) return true;
+      // The activation that follows a contraction, BiasAdd and Add.
+      if (IsRemapperActivation(node) && IsAdd(*input) &&
+          ReadsContraction(*input)) {
+        return true;
+      }
+    }
+    for (const NodeDef* consumer : ctx().node_map->GetOutputs(node.name())) {
+      if (IsMul(node) && IsLeakyReluMaximum(*consumer)) return true;
+      if (IsAdd(node) && IsSoftmax(*consumer)) return true;
+    }
+    return false;
+  }
+
+  // Returns whether `node` is a contraction or a BiasAdd, whose consumers the
+  // remapper fuses into it.
+  static bool IsContraction(const NodeDef& node) {
+    return IsConv2D(node) || IsConv3D(node) || IsDepthwiseConv2dNative(node) ||
+           IsAnyMatMul(node) || IsBiasAdd(node) || IsFusedBatchNorm(node);
+  }
+
+  bool ReadsContraction(const NodeDef& node) const {
+    for (const string& input_name : node.input()) {
+      if (IsControlInput(input_name)) break;
+      const NodeDef* input = ctx().node_map->GetNode(input_name);
+      if (input != nullptr && IsContraction(*input)) return true;
+    }
+    return false;
+  }
+
+  static bool IsRemapperActivation(const NodeDef& node) {
+    return IsRelu(node) || IsRelu6(node) || IsElu(node) || IsLeakyRelu(node) ||
+           IsTanh(node) || IsSigmoid(node);
+  }
+
+  // Returns whether `node` is Maximum(Mul(x, alpha), x), which the remapper
+  // rewrites into LeakyRelu(x).
+  bool IsLeakyReluMaximum(const NodeDef& node) const {
+    if (!IsMaximum(node) || node.input_size() < 2) return false;
+    for (int i = 0; i < 2; ++i) {
+      const NodeDef* mul = ctx().node_map->GetNode(node.input(i));
+      if (mul == nullptr || !IsMul(*mul) || mul->input_size() < 2) continue;
+      const string& x = node.input(1 - i);
+      if (mul->input(0) == x || mul->input(1) == x) return true;
+    }
+    return false;
+  }
+
+  bool OutputsFloat(const NodeDef& node) const {
+    const auto it = supported_ops_.find(node.op());
+    return it != supported_ops_.end() && it->second.kind != kComparison &&
+           it->second.kind != kLogical;
+  }
+
+  int Arity(const NodeDef& node) const {
+    return supported_ops_.at(node.op()).arity;
+  }
+
+  // Returns the type of the i-th input of a supported op.
+  DataType InputType(const NodeDef& node, int i) const {
+    switch (supported_ops_.at(node.op()).kind) {
+      case kCast:
+        return GetDataTypeFromAttr(node, "SrcT");
+      case kLogical:
+        return DT_BOOL;
+      case kSelect:
+        return i == 0 ? DT_BOOL : DT_FLOAT;
+      default:
+        return DT_FLOAT;
+    }
+  }
+
+  bool NodeIsAlreadyFused(const NodeDef& node) const {
+    return fused_nodes_.count(node.name()) > 0;
+  }
+
+  string OptimizedNodeName(const NodeDef& node) const {
+    return strings::StrCat(node.name(), "/fused_elementwise");
+  }
+
+  void AddToFusedNodes(const string& name) { fused_nodes_.insert(name); }
+
+  std::unordered_map<string, FusibleOp> supported_ops_;
+  std::unordered_set<string> fused_nodes_;
+};
+
 // Replace a chain of type&shape preserving unary ops with a
 // '_UnaryOpsComposition' node.
 // TODO(ezhulenev): It should be a part of remapper optimizer because it doesn't
@@ -4292,6 +4633,16 @@ class RemoveCastIntoSegmentReductionStage : public ArithmeticOptimizerStage {
 
 }  // namespace
 
+/*static*/ ArithmeticOptimizer::ArithmeticOptimizerOptions
+ArithmeticOptimizer::ArithmeticOptimizerOptions::Default(
+    RewriterConfig::Toggle opt_level) {
+  ArithmeticOptimizerOptions options;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_ENABLE_FUSE_ELEMENTWISE_OPS",
+                                 /*default_val=*/false,
+                                 &options.fuse_elementwise_ops));
+  return options;
+}
+
 Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
   SetVector<NodeDef*> nodes_to_simplify;
   nodes_to_simplify.Reserve(optimized_graph_->node_size());
@@ -4364,6 +4715,8 @@ Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
     pipeline.AddStage<OptimizeMaxOrMinOfMonotonicStage>(ctx, ctx_ext);
   if (options_.convert_expm1)
     pipeline.AddStage<ConvertExpm1Stage>(ctx, ctx_ext);
+  if (options_.fuse_elementwise_ops)
+    pipeline.AddStage<FuseElementwiseOps>(ctx, ctx_ext);
   if (options_.unary_ops_composition)
     pipeline.AddStage<UnaryOpsComposition>(ctx, ctx_ext);
   if (options_.remove_stack_slice_same_axis)
@@ -4440,6 +4793,8 @@ Status ArithmeticOptimizer::Optimize(Cluster* /*cluster*/,
   // // Disable restricted graph rewrites.
   options_.unary_ops_composition &=
       item.optimization_options().allow_non_differentiable_rewrites;
+  options_.fuse_elementwise_ops &=
+      item.optimization_options().allow_non_differentiable_rewrites;
 
   // Perform topological sort on the graph in order to help DedupComputations
   // and AddOpsRewrite to optimize larger subgraphs starting from the roots
@@ -84,6 +84,11 @@ class ArithmeticOptimizer : public GraphOptimizer {
     bool convert_log_softmax = true;
     bool convert_expm1 = true;
     bool unary_ops_composition = true;
+    // Off by default: the remapper runs later and fuses some of the same ops,
+    // e.g. the epilogues of contractions, LeakyRelu, GELU, layer
+    // normalization and masked softmax, into more specialized kernels. Set
+    // TF_ENABLE_FUSE_ELEMENTWISE_OPS=true to enable it.
+    bool fuse_elementwise_ops = false;
     bool remove_stack_slice_same_axis = true;
     bool simplify_aggregation = true;
     bool simplify_embedding_lookup = true;
@@ -92,10 +97,7 @@ class ArithmeticOptimizer : public GraphOptimizer {
     // Choose which arithmetic optimizer stages will be enabled for a given
     // optimization level by default.
     static ArithmeticOptimizerOptions Default(
-        RewriterConfig::Toggle opt_level) {
-      ArithmeticOptimizerOptions options;
-      return options;
-    }
+        RewriterConfig::Toggle opt_level);
   };
 
   // Returns true if it is safe to dedup node from the graph.
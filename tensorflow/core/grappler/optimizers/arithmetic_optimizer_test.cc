@@ -4322,6 +4322,142 @@ TEST_F(ArithmeticOptimizerTest, UnaryOpsComposition) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(ArithmeticOptimizerTest, FuseElementwiseOps) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = ops::Const(s.WithOpName("x"),
+                      {-1.0f, 2.0f, -3.0f, 4.0f, 5.0f, -6.0f}, {2, 3});
+  auto scale = ops::Const(s.WithOpName("scale"), {0.5f, 1.0f, 2.0f}, {3});
+  auto offset = ops::Const(s.WithOpName("offset"), {1.0f, 0.0f, -1.0f}, {3});
+  auto zero = ops::Const(s.WithOpName("zero"), 0.0f);
+  Output mul = ops::Mul(s.WithOpName("mul"), x, scale);
+  Output add = ops::AddV2(s.WithOpName("add"), mul, offset);
+  Output sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), add);
+  Output greater = ops::Greater(s.WithOpName("greater"), x, zero);
+  Output neg = ops::Neg(s.WithOpName("neg"), x);
+  Output where = ops::SelectV2(s.WithOpName("where"), greater, sigmoid, neg);
+  Output final_out = ops::Identity(s.WithOpName("final_out"), where);
+  // `add` has a consumer outside of the cluster rooted at `where`, so it is
+  // the root of another cluster.
+  Output add_out = ops::Identity(s.WithOpName("add_out"), add);
+
+  GrapplerItem item;
+  item.fetch = {"final_out", "add_out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 2);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFuseElementwiseOps(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  EXPECT_EQ(output.node_size(), 8);
+
+  int required_node_count = 0;
+  for (int i = 0; i < output.node_size(); ++i) {
+    const NodeDef& node = output.node(i);
+    if (node.name() == "final_out") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "where/fused_elementwise");
+      ++required_node_count;
+    } else if (node.name() == "add_out") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "add/fused_elementwise");
+      ++required_node_count;
+    } else if (node.name() == "where/fused_elementwise") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "zero");
+      EXPECT_EQ(node.input(2), "add/fused_elementwise");
+
+      auto op_names = node.attr().at("op_names").list().s();
+      ASSERT_EQ(op_names.size(), 4);
+      EXPECT_EQ(op_names[0], "Greater");
+      EXPECT_EQ(op_names[1], "Sigmoid");
+      EXPECT_EQ(op_names[2], "Neg");
+      EXPECT_EQ(op_names[3], "SelectV2");
+      auto op_inputs = node.attr().at("op_inputs").list().i();
+      EXPECT_EQ(std::vector<int64_t>(op_inputs.begin(), op_inputs.end()),
+                std::vector<int64_t>({0, 1, 2, 0, 3, 4, 5}));
+      ++required_node_count;
+    } else if (node.name() == "add/fused_elementwise") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.input(2), "offset");
+
+      auto op_names = node.attr().at("op_names").list().s();
+      ASSERT_EQ(op_names.size(), 2);
+      EXPECT_EQ(op_names[0], "Mul");
+      EXPECT_EQ(op_names[1], "AddV2");
+      ++required_node_count;
+    }
+  }
+  EXPECT_EQ(required_node_count, 4);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectTensorNear<float>(tensors[1], tensors_expected[1], 1e-6);
+}
+
+TEST_F(ArithmeticOptimizerTest, FuseElementwiseOpsSkipsUnaryChains) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {1, 2});
+  Output sqrt = ops::Sqrt(s.WithOpName("sqrt"), x);
+  Output exp = ops::Exp(s.WithOpName("exp"), sqrt);
+  Output final_out = ops::Identity(s.WithOpName("final_out"), exp);
+
+  GrapplerItem item;
+  item.fetch = {"final_out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFuseElementwiseOps(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  // Chains of unary ops are left to the UnaryOpsComposition stage.
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+}
+
+TEST_F(ArithmeticOptimizerTest, FuseElementwiseOpsSkipsSingleOps) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {1, 2});
+  auto y = ops::Const(s.WithOpName("y"), {3.0f, 4.0f}, {1, 2});
+  Output mul = ops::Mul(s.WithOpName("mul"), x, y);
+  Output final_out = ops::Identity(s.WithOpName("final_out"), mul);
+
+  GrapplerItem item;
+  item.fetch = {"final_out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer;
+  EnableOnlyFuseElementwiseOps(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  // A single op gains nothing from fusion.
+  VerifyGraphsMatch(item.graph, output, __LINE__);
+}
+
 TEST_F(ArithmeticOptimizerTest, RemoveStackStridedSliceSameAxis) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto a_in =
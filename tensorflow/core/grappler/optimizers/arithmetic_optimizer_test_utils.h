@@ -233,6 +233,11 @@ class ArithmeticOptimizerTest : public GrapplerTest {
     optimizer->options_.unary_ops_composition = true;
   }
 
+  void EnableOnlyFuseElementwiseOps(ArithmeticOptimizer* optimizer) {
+    DisableAllStages(optimizer);
+    optimizer->options_.fuse_elementwise_ops = true;
+  }
+
   void EnableOnlyRemoveStackSliceSameAxis(ArithmeticOptimizer* optimizer) {
     DisableAllStages(optimizer);
     optimizer->options_.remove_stack_slice_same_axis = true;
@@ -277,6 +282,7 @@ class ArithmeticOptimizerTest : public GrapplerTest {
     options.replace_mul_with_square = false;
     options.simplify_aggregation = false;
     options.unary_ops_composition = false;
+    options.fuse_elementwise_ops = false;
     options.simplify_embedding_lookup = false;
     options.remove_cast_into_segment_reduction = false;
     optimizer->options_ = options;
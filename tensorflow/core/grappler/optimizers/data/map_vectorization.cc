@@ -0,0 +1,421 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDataset[] = "ParallelMapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+constexpr char kBatchDataset[] = "BatchDataset";
+constexpr char kBatchDatasetV2[] = "BatchDatasetV2";
+constexpr char kOutputShapes[] = "output_shapes";
+constexpr char kOutputShapesAttr[] = "_output_shapes";
+constexpr char kPrefix[] = "map_vectorization";
+
+// Element-wise ops whose result on operands with a leading batch dimension is
+// the batch of their results on the operands of each element, as long as the
+// operands broadcast the same way with and without the batch dimension.
+const auto* kElementwiseOps = new absl::flat_hash_set<string>{
+    "Abs",
+    "Acos",
+    "Add",
+    "AddV2",
+    "Asin",
+    "Atan",
+    "Cast",
+    "Ceil",
+    "Cos",
+    "Div",
+    "DivNoNan",
+    "Equal",
+    "Erf",
+    "Exp",
+    "Expm1",
+    "Floor",
+    "FloorDiv",
+    "FloorMod",
+    "Greater",
+    "GreaterEqual",
+    "Identity",
+    "IsFinite",
+    "IsInf",
+    "IsNan",
+    "Less",
+    "LessEqual",
+    "Log",
+    "Log1p",
+    "LogicalAnd",
+    "LogicalNot",
+    "LogicalOr",
+    "Maximum",
+    "Minimum",
+    "Mul",
+    "Neg",
+    "NotEqual",
+    "Pow",
+    "RealDiv",
+    "Reciprocal",
+    "Relu",
+    "Relu6",
+    "Round",
+    "Rsqrt",
+    "SelectV2",
+    "Sigmoid",
+    "Sign",
+    "Sin",
+    "Softplus",
+    "Sqrt",
+    "Square",
+    "SquaredDifference",
+    "Sub",
+    "Tan",
+    "Tanh",
+    "TruncateDiv",
+};
+
+// Describes a tensor of the map function when the function is applied to a
+// batch of elements.
+struct TensorInfo {
+  // Whether the tensor has a leading batch dimension.
+  bool batched;
+  // The rank of the tensor without its batch dimension.
+  int rank;
+};
+
+using TensorInfos = absl::flat_hash_map<string, std::optional<TensorInfo>>;
+
+bool IsMap(const NodeDef& node) {
+  return node.op() == kMapDataset || node.op() == kParallelMapDataset ||
+         node.op() == kParallelMapDatasetV2;
+}
+
+bool IsBatch(const NodeDef& node) {
+  return node.op() == kBatchDataset || node.op() == kBatchDatasetV2;
+}
+
+// Returns whether the map transformation has captured inputs.
+bool HasCapturedInputs(const NodeDef& map_node) {
+  const int num_inputs = map_node.op() == kMapDataset ? 1 : 2;
+  return map_node.input_size() != num_inputs;
+}
+
+// Returns the node name of a tensor of a function body, which is either the
+// name of a function argument or of the form `node:output:index`.
+absl::string_view NodeName(absl::string_view tensor) {
+  return tensor.substr(0, tensor.find(':'));
+}
+
+// Infers the batch dimension and rank of `tensor`, given those of the function
+// arguments in `infos`. Returns `std::nullopt` if the function cannot be
+// vectorized because of the node that produces `tensor`.
+std::optional<TensorInfo> InferTensorInfo(
+    absl::string_view tensor,
+    const absl::flat_hash_map<string, const NodeDef*>& nodes,
+    TensorInfos* infos) {
+  if (absl::StartsWith(tensor, "^")) {
+    return std::nullopt;
+  }
+  const string node_name(NodeName(tensor));
+  if (auto it = infos->find(node_name); it != infos->end()) {
+    return it->second;
+  }
+  const NodeDef* const* node = gtl::FindOrNull(nodes, node_name);
+  if (node == nullptr) {
+    return std::nullopt;
+  }
+  // Stops cycles, which element-wise function bodies never have.
+  (*infos)[node_name] = std::nullopt;
+
+  std::optional<TensorInfo> info;
+  if ((*node)->op() == "Const") {
+    const TensorShapeProto& shape =
+        (*node)->attr().at("value").tensor().tensor_shape();
+    if (!shape.unknown_rank()) {
+      info = TensorInfo{/*batched=*/false, shape.dim_size()};
+    }
+  } else if (kElementwiseOps->contains((*node)->op())) {
+    std::optional<int> batched_rank;
+    int unbatched_rank = 0;
+    bool vectorizable = true;
+    for (const string& input : (*node)->input()) {
+      std::optional<TensorInfo> input_info =
+          InferTensorInfo(input, nodes, infos);
+      if (!input_info.has_value()) {
+        vectorizable = false;
+        break;
+      }
+      if (!input_info->batched) {
+        unbatched_rank = std::max(unbatched_rank, input_info->rank);
+      } else if (!batched_rank.has_value()) {
+        batched_rank = input_info->rank;
+      } else if (*batched_rank != input_info->rank) {
+        // The batch dimensions of the operands would not line up.
+        vectorizable = false;
+        break;
+      }
+    }
+    if (vectorizable && !batched_rank.has_value()) {
+      info = TensorInfo{/*batched=*/false, unbatched_rank};
+    } else if (vectorizable && unbatched_rank <= *batched_rank) {
+      // Operands without a batch dimension broadcast against the trailing
+      // dimensions, so they must not reach the batch dimension.
+      info = TensorInfo{/*batched=*/true, *batched_rank};
+    }
+  } else if ((*node)->op() == "ClipByValue" && (*node)->input_size() == 3) {
+    // ClipByValue does not broadcast: its bounds must be scalars or have the
+    // shape of `t`. Only scalar bounds without a batch dimension still do once
+    // `t` is batched.
+    std::optional<TensorInfo> t_info =
+        InferTensorInfo((*node)->input(0), nodes, infos);
+    bool scalar_bounds = true;
+    for (int i = 1; i < 3; ++i) {
+      std::optional<TensorInfo> bound_info =
+          InferTensorInfo((*node)->input(i), nodes, infos);
+      if (!bound_info.has_value() || bound_info->batched ||
+          bound_info->rank != 0) {
+        scalar_bounds = false;
+      }
+    }
+    if (scalar_bounds) {
+      info = t_info;
+    }
+  }
+  (*infos)[node_name] = info;
+  return info;
+}
+
+// Returns whether applying `function` to a batch of elements gives the batch
+// of its results on each element, given the ranks of the element components.
+bool IsVectorizable(const FunctionDef& function,
+                    const std::vector<int>& component_ranks) {
+  const OpDef& signature = function.signature();
+  if (signature.input_arg_size() != component_ranks.size() ||
+      !function.control_ret().empty()) {
+    return false;
+  }
+  TensorInfos infos;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    infos[signature.input_arg(i).name()] =
+        TensorInfo{/*batched=*/true, component_ranks[i]};
+  }
+  absl::flat_hash_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : function.node_def()) {
+    nodes[node.name()] = &node;
+  }
+  for (const auto& output : signature.output_arg()) {
+    const string* tensor = gtl::FindOrNull(function.ret(), output.name());
+    if (tensor == nullptr) {
+      return false;
+    }
+    std::optional<TensorInfo> info = InferTensorInfo(*tensor, nodes, &infos);
+    // An output without a batch dimension would have to be tiled.
+    if (!info.has_value() || !info->batched) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the ranks of the components of the elements produced by `node`, or
+// `std::nullopt` unless their shapes are fully defined. Elements whose
+// components may change shape cannot be batched before the map function is
+// applied to them.
+std::optional<std::vector<int>> GetComponentRanks(const NodeDef& node) {
+  const AttrValue* shapes = gtl::FindOrNull(node.attr(), kOutputShapes);
+  if (shapes == nullptr) {
+    return std::nullopt;
+  }
+  std::vector<int> ranks;
+  for (const TensorShapeProto& shape : shapes->list().shape()) {
+    if (shape.unknown_rank()) {
+      return std::nullopt;
+    }
+    for (const auto& dim : shape.dim()) {
+      if (dim.size() < 0) {
+        return std::nullopt;
+      }
+    }
+    ranks.push_back(shape.dim_size());
+  }
+  return ranks;
+}
+
+// Returns a copy of `function` that runs on batches. The function body is
+// unchanged, but shape hints of its arguments and nodes are dropped as they
+// describe single elements.
+FunctionDef MakeVectorizedFunction(const FunctionDef& function,
+                                   FunctionDefLibrary* library) {
+  FunctionDef vectorized_function = function;
+  graph_utils::SetUniqueGraphFunctionName(
+      absl::StrCat(kPrefix, "/", function.signature().name()), library,
+      &vectorized_function);
+  for (auto& [index, arg_attr] : *vectorized_function.mutable_arg_attr()) {
+    arg_attr.mutable_attr()->erase(kOutputShapesAttr);
+  }
+  for (NodeDef& node : *vectorized_function.mutable_node_def()) {
+    node.mutable_attr()->erase(kOutputShapesAttr);
+  }
+  return vectorized_function;
+}
+
+// Makes the batch transformation that batches the input of `map_node`.
+NodeDef MakeBatchNode(const NodeDef& batch_node, const NodeDef& map_node,
+                      const NodeDef& input_node,
+                      const DataTypeVector& input_types,
+                      MutableGraphView* graph) {
+  NodeDef new_batch_node = batch_node;
+  graph_utils::SetUniqueGraphNodeName(
+      absl::StrCat(kPrefix, "/", batch_node.name()), graph->graph(),
+      &new_batch_node);
+  new_batch_node.set_input(0, map_node.input(0));
+
+  // All components share the batch dimension of the original batch.
+  int64_t batch_dim = -1;
+  const auto& batch_shapes = batch_node.attr().at(kOutputShapes).list();
+  if (batch_shapes.shape_size() > 0 &&
+      batch_shapes.shape(0).dim_size() > 0) {
+    batch_dim = batch_shapes.shape(0).dim(0).size();
+  }
+  AttrValue shapes;
+  for (const TensorShapeProto& shape :
+       input_node.attr().at(kOutputShapes).list().shape()) {
+    TensorShapeProto* batched_shape = shapes.mutable_list()->add_shape();
+    batched_shape->add_dim()->set_size(batch_dim);
+    for (const auto& dim : shape.dim()) {
+      *batched_shape->add_dim() = dim;
+    }
+  }
+  (*new_batch_node.mutable_attr())[kOutputShapes] = std::move(shapes);
+  SetAttrValue(input_types, &(*new_batch_node.mutable_attr())["output_types"]);
+  return new_batch_node;
+}
+
+// Makes the map transformation that applies `function` to the batches of
+// `new_batch_node`.
+NodeDef MakeMapNode(const NodeDef& map_node, const NodeDef& batch_node,
+                    const NodeDef& new_batch_node, const FunctionDef& function,
+                    MutableGraphView* graph) {
+  NodeDef new_map_node = map_node;
+  graph_utils::SetUniqueGraphNodeName(
+      absl::StrCat(kPrefix, "/", map_node.name()), graph->graph(),
+      &new_map_node);
+  new_map_node.set_input(0, new_batch_node.name());
+  (*new_map_node.mutable_attr())["f"].mutable_func()->set_name(
+      function.signature().name());
+  graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_map_node);
+  return new_map_node;
+}
+
+}  // namespace
+
+Status MapVectorization::OptimizeAndCollectStats(Cluster* cluster,
+                                                 const GrapplerItem& item,
+                                                 GraphDef* output,
+                                                 OptimizationStats* stats) {
+  GraphDef sorted_old_graph = item.graph;
+  TF_RETURN_IF_ERROR(TopologicalSort(&sorted_old_graph));
+  *output = sorted_old_graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+  const auto nodes_to_preserve = item.NodesToPreserve();
+
+  for (const NodeDef& node : sorted_old_graph.node()) {
+    if (!IsBatch(node)) continue;
+    // Looks the node up in the rewritten graph, as its input may have been
+    // rewritten already.
+    const NodeDef* batch_node = graph.GetNode(node.name());
+    NodeDef* map_node = graph_utils::GetInputNode(*batch_node, graph);
+    if (map_node == nullptr || !IsMap(*map_node) ||
+        HasCapturedInputs(*map_node) ||
+        nodes_to_preserve.count(map_node->name()) > 0 ||
+        graph.GetFanouts(*map_node, /*include_controlled_nodes=*/true).size() !=
+            1) {
+      continue;
+    }
+    NodeDef* input_node = graph_utils::GetInputNode(*map_node, graph);
+    if (input_node == nullptr) continue;
+    std::optional<std::vector<int>> component_ranks =
+        GetComponentRanks(*input_node);
+    DataTypeVector input_types;
+    if (!component_ranks.has_value() ||
+        !graph_utils::GetDatasetOutputTypesAttr(*input_node, &input_types)
+             .ok() ||
+        !batch_node->attr().contains(kOutputShapes)) {
+      continue;
+    }
+    const FunctionDef* function =
+        function_library.Find(map_node->attr().at("f").func().name());
+    if (function == nullptr || !IsVectorizable(*function, *component_ranks)) {
+      VLOG(2) << "Not vectorizing " << map_node->name()
+              << ", whose function runs per element.";
+      continue;
+    }
+
+    FunctionDef vectorized_function =
+        MakeVectorizedFunction(*function, output->mutable_library());
+    NodeDef* new_batch_node = graph.AddNode(MakeBatchNode(
+        *batch_node, *map_node, *input_node, input_types, &graph));
+    NodeDef* new_map_node =
+        graph.AddNode(MakeMapNode(*map_node, *batch_node, *new_batch_node,
+                                  vectorized_function, &graph));
+    TF_RETURN_IF_ERROR(
+        graph.UpdateFanouts(batch_node->name(), new_map_node->name()));
+    TF_RETURN_IF_ERROR(function_library.AddFunctionDef(vectorized_function));
+    *output->mutable_library()->add_function() = std::move(vectorized_function);
+
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node->name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // namespace grappler
+}  // namespace tensorflow
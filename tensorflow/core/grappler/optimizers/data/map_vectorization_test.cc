@@ -0,0 +1,279 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using graph_tests_utils::MakeBatchV2Node;
+using graph_tests_utils::MakeMapNode;
+using graph_tests_utils::MakeParallelMapV2Node;
+using test::function::NDef;
+
+// Returns a dataset node whose elements have components of the given shapes.
+NodeDef MakeInputNode(const std::vector<PartialTensorShape>& shapes) {
+  return NDef("input", "TensorSliceDataset", {},
+              {{"output_shapes", absl::Span<const PartialTensorShape>(shapes)},
+               {"output_types", DataTypeVector(shapes.size(), DT_INT64)}});
+}
+
+// Returns a function that adds its two arguments.
+FunctionDef XAddY() {
+  return FunctionDefHelper::Define(
+      // Name
+      "XAddY",
+      // Args
+      {"x: int64", "y: int64"},
+      // Return values
+      {"z: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"z"}, "AddV2", {"x", "y"}, {{"T", DT_INT64}}}});
+}
+
+TEST(MapVectorizationTest, VectorizesElementwiseFunction) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({3})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "XTimesTwo"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithOp("BatchDatasetV2", output));
+  EXPECT_EQ(batch_node.input(0), "input");
+  EXPECT_EQ(batch_node.input(1), "batch_size");
+  EXPECT_EQ(batch_node.input(2), "drop_remainder");
+  AttrValue batched_shapes;
+  SetAttrValue(std::vector<PartialTensorShape>{PartialTensorShape({-1, 3})},
+               &batched_shapes);
+  EXPECT_TRUE(
+      AreAttrValuesEqual(batch_node.attr().at("output_shapes"), batched_shapes));
+
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithOp("MapDataset", output));
+  EXPECT_EQ(map_node.input(0), batch_node.name());
+  const string& function_name = map_node.attr().at("f").func().name();
+  EXPECT_TRUE(absl::StartsWith(function_name, "map_vectorization/XTimesTwo"));
+  EXPECT_TRUE(
+      graph_utils::ContainsGraphFunctionWithName(function_name, output.library()));
+}
+
+TEST(MapVectorizationTest, VectorizesParallelMap) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       NDef("num_parallel_calls", "Const", {},
+            {{"value", -1}, {"dtype", DT_INT64}}),
+       MakeParallelMapV2Node("map", "input", "num_parallel_calls", "XTimesTwo",
+                             "default"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  const NodeDef& map_node = output.node(
+      graph_utils::FindGraphNodeWithOp("ParallelMapDatasetV2", output));
+  EXPECT_EQ(map_node.input(1), "num_parallel_calls");
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithName(map_node.input(0), output));
+  EXPECT_EQ(batch_node.op(), "BatchDatasetV2");
+  EXPECT_EQ(batch_node.input(0), "input");
+}
+
+TEST(MapVectorizationTest, KeepsStatefulFunctionPerElement) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "RandomUniformFn"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {test::function::RandomUniform()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, KeepsMapWithOtherConsumersPerElement) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "XTimesTwo"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false),
+       MakeBatchV2Node("other_batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+// Returns a function that clips its argument to [lo, hi].
+FunctionDef ClipX(FunctionDefHelper::Node lo, FunctionDefHelper::Node hi) {
+  return FunctionDefHelper::Define(
+      // Name
+      "ClipX",
+      // Args
+      {"x: int64"},
+      // Return values
+      {"y: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {std::move(lo), std::move(hi),
+       {{"y"}, "ClipByValue", {"x", "lo", "hi"}, {{"T", DT_INT64}}}});
+}
+
+TEST(MapVectorizationTest, VectorizesClipByScalars) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({3})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "ClipX"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {ClipX(FunctionDefHelper::Const<int64_t>("lo", 0),
+             FunctionDefHelper::Const<int64_t>("hi", 10))});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+}
+
+// ClipByValue does not broadcast, so a [3] bound would not match the [8, 3]
+// batches.
+TEST(MapVectorizationTest, KeepsClipByNonScalarPerElement) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode({PartialTensorShape({3})}),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "ClipX"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {ClipX(FunctionDefHelper::Const<int64_t>("lo", {0, 1, 2}),
+             FunctionDefHelper::Const<int64_t>("hi", 10))});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+struct BroadcastTestCase {
+  std::vector<PartialTensorShape> component_shapes;
+  bool vectorized;
+};
+
+class MapVectorizationBroadcastTest
+    : public ::testing::TestWithParam<BroadcastTestCase> {};
+
+TEST_P(MapVectorizationBroadcastTest, VectorizesWhenBatchDimensionsLineUp) {
+  const BroadcastTestCase& test_case = GetParam();
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {MakeInputNode(test_case.component_shapes),
+       NDef("batch_size", "Const", {}, {{"value", 8}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", true}, {"dtype", DT_BOOL}}),
+       MakeMapNode("map", "input", "XAddY"),
+       MakeBatchV2Node("batch", "map", "batch_size", "drop_remainder",
+                       /*parallel_copy=*/false)},
+      // FunctionLib
+      {XAddY()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(graph_utils::ContainsGraphNodeWithName("map", output),
+            !test_case.vectorized);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Test, MapVectorizationBroadcastTest,
+    ::testing::Values(
+        BroadcastTestCase{{PartialTensorShape({}), PartialTensorShape({})},
+                          /*vectorized=*/true},
+        BroadcastTestCase{{PartialTensorShape({3}), PartialTensorShape({1})},
+                          /*vectorized=*/true},
+        // Batching would line the scalars up with the vector dimension.
+        BroadcastTestCase{{PartialTensorShape({}), PartialTensorShape({3})},
+                          /*vectorized=*/false},
+        // Elements of different shapes cannot be batched before the map.
+        BroadcastTestCase{{PartialTensorShape({-1}), PartialTensorShape({-1})},
+                          /*vectorized=*/false},
+        BroadcastTestCase{{PartialTensorShape(), PartialTensorShape()},
+                          /*vectorized=*/false}));
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include <algorithm>
 #include <atomic>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -1033,7 +1035,99 @@ TEST_F(MetaOptimizerTest, CompressConstants) {
   }
 }
 
-TEST_F(MetaOptimizerTest, TestTFGRemoveDeadArguments) {
+// The elementwise fusion of the arithmetic optimizer runs before the
+// remapper, and must leave the ops that the remapper fuses alone.
+TEST_F(MetaOptimizerTest, FuseElementwiseOpsLeavesRemapperPatterns) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto placeholder = [&](const string& name, const TensorShape& shape) {
+    return ops::Placeholder(s.WithOpName(name), DT_FLOAT,
+                            ops::Placeholder::Shape(shape));
+  };
+
+  // MatMul + BiasAdd + Relu -> _FusedMatMul.
+  auto a = placeholder("a", {2, 3});
+  auto w = ops::Const(s.WithOpName("w"), 1.0f, {3, 4});
+  auto bias = ops::Const(s.WithOpName("bias"), 0.5f, {4});
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), a, w);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  auto relu_out = ops::Identity(s.WithOpName("relu_out"), relu);
+
+  // Maximum(Mul(x, alpha), x) -> LeakyRelu.
+  auto x = placeholder("x", {2, 4});
+  auto alpha = ops::Const(s.WithOpName("alpha"), 0.2f);
+  auto leaky_mul = ops::Mul(s.WithOpName("leaky_mul"), x, alpha);
+  auto leaky_max = ops::Maximum(s.WithOpName("leaky_max"), leaky_mul, x);
+  auto leaky_out = ops::Identity(s.WithOpName("leaky_out"), leaky_max);
+
+  // Softmax(Add(logits, mask)) -> _FusedMaskedSoftmax.
+  auto logits = placeholder("logits", {2, 4});
+  auto mask = placeholder("mask", {1, 4});
+  auto masked = ops::AddV2(s.WithOpName("masked"), logits, mask);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), masked);
+  auto softmax_out = ops::Identity(s.WithOpName("softmax_out"), softmax);
+
+  // Mul(AddV2(p, q), Sigmoid(p)) matches no remapper pattern.
+  auto p = placeholder("p", {2, 4});
+  auto q = placeholder("q", {2, 4});
+  auto sum = ops::AddV2(s.WithOpName("sum"), p, q);
+  auto sigmoid = ops::Sigmoid(s.WithOpName("sigmoid"), p);
+  auto product = ops::Mul(s.WithOpName("product"), sum, sigmoid);
+  auto product_out = ops::Identity(s.WithOpName("product_out"), product);
+
+  GrapplerItem item;
+  item.fetch = {"relu_out", "leaky_out", "softmax_out", "product_out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    node.set_device("/device:CPU:0");
+  }
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+
+  for (const bool fuse_elementwise_ops : {false, true}) {
+    SCOPED_TRACE(absl::StrCat("fuse_elementwise_ops=", fuse_elementwise_ops));
+    if (fuse_elementwise_ops) {
+      setenv("TF_ENABLE_FUSE_ELEMENTWISE_OPS", "true", 1 /* overwrite */);
+    }
+    MetaOptimizer optimizer(/*cpu_device=*/nullptr, config_proto);
+    GraphDef output;
+    TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+    unsetenv("TF_ENABLE_FUSE_ELEMENTWISE_OPS");
+
+    int num_fused_matmul = 0;
+    int num_leaky_relu = 0;
+    int num_masked_softmax = 0;
+    int num_fused_elementwise = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.op() == "_FusedMatMul") {
+        ++num_fused_matmul;
+      } else if (node.op() == "LeakyRelu") {
+        ++num_leaky_relu;
+      } else if (node.op() == "_FusedMaskedSoftmax") {
+        ++num_masked_softmax;
+      } else if (node.op() == "_FusedElementwise") {
+        ++num_fused_elementwise;
+        // The inputs of Mul may be reordered, so the order of the ops is not
+        // fixed.
+        const auto& op_names = node.attr().at("op_names").list().s();
+        std::vector<string> sorted_op_names(op_names.begin(), op_names.end());
+        std::sort(sorted_op_names.begin(), sorted_op_names.end());
+        EXPECT_EQ(sorted_op_names,
+                  std::vector<string>({"AddV2", "Mul", "Sigmoid"}));
+      }
+    }
+    EXPECT_EQ(num_fused_matmul, 1);
+    EXPECT_EQ(num_leaky_relu, 1);
+    EXPECT_EQ(num_masked_softmax, 1);
+    // The stage is off by default.
+    EXPECT_EQ(num_fused_elementwise, fuse_elementwise_ops ? 1 : 0);
+  }
+}
+
+
   using test::function::NDef;
 
   gtl::FlatMap<string, GrapplerItem::OptimizationOptions> optimization_options;
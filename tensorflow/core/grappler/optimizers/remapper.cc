@@ -74,6 +74,12 @@ namespace grappler {
 //
 // Sigmoid + Mul -> _MklSwish  // This fusion only works on Intel CPU.
 //
+// Layer normalization subgraph -> _FusedLayerNorm  // CPU without oneDNN.
+//
+// Add + Softmax -> _FusedMaskedSoftmax  // CPU only.
+//
+// _FusedMatMul siblings with the same input -> _FusedMatMul + SplitV
+//
 //
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
@@ -92,6 +98,8 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedLayerNorm[] = "_FusedLayerNorm";
+constexpr char kFusedMaskedSoftmax[] = "_FusedMaskedSoftmax";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMklFusedMish[] = "_MklFusedMish";
 constexpr char kRelu[] = "Relu";
@@ -301,6 +309,28 @@ struct ContractionWithBiasAndAddActivation {
   int bias_port = 1;
 };
 
+// Softmax of the sum of logits and a mask that is broadcast to the logits.
+struct MaskedSoftmax {
+  MaskedSoftmax() = default;
+  MaskedSoftmax(int add, int softmax, int logits_port)
+      : add(add), softmax(softmax), logits_port(logits_port) {}
+
+  int add = kMissingIndex;
+  int softmax = kMissingIndex;
+  int logits_port = 0;
+};
+
+// _FusedMatMul nodes with a BiasAdd that multiply the same input by different
+// constant weights, e.g. the query, key and value projections of an attention
+// layer.
+struct FusedMatMulSiblings {
+  FusedMatMulSiblings() = default;
+  explicit FusedMatMulSiblings(std::vector<int> matmuls)
+      : matmuls(std::move(matmuls)) {}
+
+  std::vector<int> matmuls;
+};
+
 bool IsInPreserveSet(const RemapperContext& ctx, const NodeDef* node) {
   return ctx.nodes_to_preserve.count(node->name()) > 0;
 }
@@ -1589,11 +1619,8 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
                               std::map<string, int>* matched_nodes_map,
                               std::set<int>* remove_node_indices,
                               bool* is_gelu_approximate) {
-  // Gelu fusion is enabled with oneDNN or cublasLt or cuDNN library.
-  if (!IsMKLEnabled() && !BlasLtMatmulEnabled() &&
-      !RuntimeFusionEnabled(cluster))
-    return false;
-
+  // Gelu fusion is enabled on CPU with oneDNN or Eigen, and on GPU with
+  // cublasLt or cuDNN library.
   using utils::MatchingDirection;
   using utils::NodeStatus;
 
@@ -1714,7 +1741,7 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
 
     DataType matmul_dtype = GetDataTypeFromAttr(*matmul_node, "T");
 
-    bool cpu_ok = IsMKLEnabled() && IsCpuCompatibleMatMul(*ctx, matmul_node);
+    bool cpu_ok = IsCpuCompatibleMatMul(*ctx, matmul_node);
     // Currently, the fusion is not supported on CPU for transpose_a in the
     // MatMul op.
     cpu_ok = cpu_ok && matmul_node->attr().contains("transpose_a") &&
@@ -1756,7 +1783,10 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
 
     // matmul_node is already the _FusedMatMul and we don't need to check its
     // data type again.
-    if (!IsMKLEnabled() && !NodeIsOnGpu(matmul_node)) return false;
+    if (NodeIsOnGpu(matmul_node) && !BlasLtMatmulEnabled() &&
+        !RuntimeFusionEnabled(cluster)) {
+      return false;
+    }
 
     // Currently, the fusion is not supported on CPU for transpose_a in the
     // MatMul op.
@@ -2098,13 +2128,20 @@ bool IsCommonNormPattern(RemapperContext* ctx, int node_index,
 
 // Keras LayerNormalization api uses multiple TensorFlow ops. Current fusion
 // pattern is only for the case, when LayerNormalization uses FusedBatcNormV3.
-// We further restrict it to only 2D or 3D tensor inputs to keras
-// LayerNormalization api.
-bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
-                      std::map<string, int>* matched_nodes_map,
-                      std::set<int>* remove_node_indices,
-                      std::vector<string>* input_node_names, float* epsilon) {
-  if (!IsMKLEnabled()) return false;
+// With oneDNN, we further restrict it to only 2D or 3D tensor inputs to keras
+// LayerNormalization api. Without oneDNN, the pattern is rewritten into the
+// Eigen based _FusedLayerNorm, which supports float on CPU.
+bool FindLayerNorm(RemapperContext* ctx, int node_index,
+                   std::map<string, int>* matched_nodes_map,
+                   std::set<int>* remove_node_indices,
+                   std::vector<string>* input_node_names, float* epsilon) {
+  if (!IsMKLEnabled()) {
+    const NodeDef* node_def = ctx->graph_view.GetNode(node_index)->node();
+    if (ctx->xla_cpu_jit_disable_fusion || !NodeIsOnCpu(node_def) ||
+        !IsAdd(*node_def) || GetDataTypeFromAttr(*node_def, "T") != DT_FLOAT) {
+      return false;
+    }
+  }
 
   // The following pattern will be searched in the graph with additional
   // contraints. Here * means any type of op.
@@ -2284,6 +2321,47 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
         if (static_cast<int64>(rank - 1) != mean_axis_tensor.flat<int64>()(0))
           return false;
       }
+      // The variance must be reduced along the same axis as the mean.
+      NodeDef* variance_axis_node =
+          ctx->graph_view.GetNode(matched_nodes_map->at("r_indices0"))->node();
+      Tensor variance_axis_tensor;
+      if (!variance_axis_tensor.FromProto(
+              variance_axis_node->attr().at("value").tensor()) ||
+          variance_axis_tensor.dtype() != dtype ||
+          variance_axis_tensor.NumElements() != expected_axis_count) {
+        return false;
+      }
+      if (dtype == DT_INT32) {
+        if (variance_axis_tensor.flat<int32>()(0) !=
+            mean_axis_tensor.flat<int32>()(0))
+          return false;
+      } else {
+        if (variance_axis_tensor.flat<int64>()(0) !=
+            mean_axis_tensor.flat<int64>()(0))
+          return false;
+      }
+      // Take epsilon from the matched constant instead of the default value.
+      NodeDef* epsilon_node =
+          ctx->graph_view.GetNode(matched_nodes_map->at("epsilon"))->node();
+      Tensor epsilon_tensor;
+      if (!epsilon_tensor.FromProto(
+              epsilon_node->attr().at("value").tensor()) ||
+          epsilon_tensor.NumElements() != 1) {
+        return false;
+      }
+      switch (epsilon_tensor.dtype()) {
+        case DT_FLOAT:
+          *epsilon = epsilon_tensor.flat<float>()(0);
+          break;
+        case DT_BFLOAT16:
+          *epsilon = static_cast<float>(epsilon_tensor.flat<bfloat16>()(0));
+          break;
+        case DT_HALF:
+          *epsilon = static_cast<float>(epsilon_tensor.flat<Eigen::half>()(0));
+          break;
+        default:
+          return false;
+      }
       auto* gamma_node =
           ctx->graph_view.GetNode(matched_nodes_map->at("gamma"))->node();
       auto* beta_node =
@@ -2308,14 +2386,170 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
     if (ShapesSymbolicallyEqual(input_props[0].shape(),
                                 output_props[0].shape())) {
       int rank = Rank(input_props[0].shape());
-      if (rank < 2 || rank > 3) return false;
+      if (IsMKLEnabled() ? rank < 2 || rank > 3 : rank < 1) return false;
     } else {
       return false;
     }
+
+    // _FusedLayerNorm requires scale and offset to be vectors of the size of
+    // the normalized dimension, whereas the matched subgraph may broadcast
+    // them.
+    if (!IsMKLEnabled()) {
+      const TensorShapeProto& input_shape = input_props[0].shape();
+      const auto is_depth_vector = [&](const string& node_name) -> bool {
+        const TensorId tensor_id = ParseTensorName(node_name);
+        const auto& props = ctx->graph_properties.GetOutputProperties(
+            string(tensor_id.node()));
+        if (tensor_id.index() < 0 || props.size() <= tensor_id.index()) {
+          return false;
+        }
+        const TensorShapeProto& shape = props[tensor_id.index()].shape();
+        return Rank(shape) == 1 && IsKnown(shape.dim(0)) &&
+               shape.dim(0).size() ==
+                   input_shape.dim(input_shape.dim_size() - 1).size();
+      };
+      if (!is_depth_vector(input_node_names->at(1)) ||
+          !is_depth_vector(input_node_names->at(2))) {
+        return false;
+      }
+    }
   }
   return found_op_type_match;
 }
 
+// Softmax(Add(logits, mask)), where the mask is broadcast to the logits, is
+// rewritten into _FusedMaskedSoftmax. This is how attention layers mask the
+// attention scores of padded positions.
+bool FindMaskedSoftmax(const RemapperContext& ctx, int node_index,
+                       MaskedSoftmax* matched) {
+  // Disable fusions on CPU when XLA JIT compilation enabled.
+  if (ctx.xla_cpu_jit_disable_fusion) return false;
+
+  // Root of the pattern must be a Softmax.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsSoftmax(*node_def) || !NodeIsOnCpu(node_def) ||
+      !HasDataType(node_def, DT_FLOAT) ||
+      node_view->NumRegularFanins() < 1) {
+    return false;
+  }
+
+  // Input to the Softmax must be an Add that has no other consumers.
+  const auto& regular_fanin_0 = node_view->GetRegularFanin(0);
+  const auto* add_node_view = regular_fanin_0.node_view();
+  const auto* add_node_def = add_node_view->node();
+  if (!IsAdd(*add_node_def) || !NodeIsOnCpu(add_node_def) ||
+      !HasDataType(add_node_def, DT_FLOAT) ||
+      add_node_view->NumRegularFanins() != 2 ||
+      HasControlFaninOrFanout(*add_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*add_node_view) ||
+      IsInPreserveSet(ctx, add_node_def)) {
+    return false;
+  }
+
+  // One of the Add inputs must have the shape of the Add output; that input
+  // holds the logits, and the other one the mask.
+  const auto& input_props =
+      ctx.graph_properties.GetInputProperties(add_node_def->name());
+  const auto& output_props =
+      ctx.graph_properties.GetOutputProperties(add_node_def->name());
+  if (input_props.size() != 2 || output_props.empty()) return false;
+  for (int logits_port : {0, 1}) {
+    const TensorShapeProto& logits_shape = input_props[logits_port].shape();
+    const TensorShapeProto& mask_shape = input_props[1 - logits_port].shape();
+    if (Rank(logits_shape) >= 1 && Rank(mask_shape) >= 0 &&
+        ShapesSymbolicallyEqual(logits_shape, output_props[0].shape())) {
+      const MaskedSoftmax pattern{add_node_view->node_index(), node_index,
+                                  logits_port};
+      *matched = pattern;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Finds the _FusedMatMul + BiasAdd nodes that multiply the same input as the
+// node at `node_index` by constant weights. Multiplying the input by the
+// concatenated weights of all of them reads the input once, and gives a
+// single larger matrix multiplication that uses the CPU more efficiently than
+// several small ones.
+bool FindFusedMatMulSiblings(const RemapperContext& ctx, int node_index,
+                             const std::vector<bool>& invalidated_nodes,
+                             const std::vector<bool>& nodes_to_delete,
+                             FusedMatMulSiblings* matched) {
+  // Disable fusions on CPU when XLA JIT compilation enabled.
+  if (ctx.xla_cpu_jit_disable_fusion) return false;
+
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (node_def->op() != kFusedMatMul || node_view->NumRegularFanins() != 3) {
+    return false;
+  }
+
+  // Returns the shape of a Const input of `matmul_view`, or an unknown rank
+  // shape if the input is not a Const.
+  const auto const_input_shape = [](const utils::MutableNodeView& matmul_view,
+                                    int port) -> TensorShapeProto {
+    const NodeDef* input =
+        matmul_view.GetRegularFanin(port).node_view()->node();
+    TensorShapeProto shape;
+    if (!IsConstant(*input) || !HasDataType(input, DT_FLOAT, "dtype")) {
+      shape.set_unknown_rank(true);
+    } else {
+      shape = input->attr().at("value").tensor().tensor_shape();
+    }
+    return shape;
+  };
+
+  const auto is_candidate = [&](const utils::MutableNodeView& matmul_view) {
+    const NodeDef* matmul = matmul_view.node();
+    if (matmul->op() != kFusedMatMul || !NodeIsOnCpu(matmul) ||
+        !HasDataType(matmul, DT_FLOAT) ||
+        invalidated_nodes[matmul_view.node_index()] ||
+        nodes_to_delete[matmul_view.node_index()] ||
+        matmul_view.NumRegularFanins() != 3 ||
+        matmul_view.NumControllingFanins() > 0) {
+      return false;
+    }
+    std::vector<string> fused_ops;
+    bool transpose_a = false;
+    bool transpose_b = false;
+    if (!TryGetNodeAttr(*matmul, "fused_ops", &fused_ops) ||
+        fused_ops != std::vector<string>{"BiasAdd"} ||
+        !TryGetNodeAttr(*matmul, "transpose_a", &transpose_a) ||
+        transpose_a != node_def->attr().at("transpose_a").b() ||
+        !TryGetNodeAttr(*matmul, "transpose_b", &transpose_b) ||
+        transpose_b) {
+      return false;
+    }
+    const TensorShapeProto weights_shape = const_input_shape(matmul_view, 1);
+    const TensorShapeProto bias_shape = const_input_shape(matmul_view, 2);
+    return Rank(weights_shape) == 2 && Rank(bias_shape) == 1 &&
+           weights_shape.dim(1).size() == bias_shape.dim(0).size();
+  };
+  if (!is_candidate(*node_view)) return false;
+
+  // All candidates must multiply the input by weights with the same number of
+  // rows.
+  const int64_t depth = const_input_shape(*node_view, 1).dim(0).size();
+  const auto& input = node_view->GetRegularFanin(0);
+  std::set<int> matmuls;
+  for (const auto& fanout :
+       input.node_view()->GetRegularFanout(input.index())) {
+    const auto* matmul_view = fanout.node_view();
+    if (fanout.index() == 0 && is_candidate(*matmul_view) &&
+        const_input_shape(*matmul_view, 1).dim(0).size() == depth) {
+      matmuls.insert(matmul_view->node_index());
+    }
+  }
+  if (matmuls.size() < 2) return false;
+
+  const FusedMatMulSiblings pattern{
+      std::vector<int>(matmuls.begin(), matmuls.end())};
+  *matched = pattern;
+  return true;
+}
+
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -3845,19 +4079,18 @@ Status AddFusedMatMulBiasAddAndGelu(
   return absl::OkStatus();
 }
 
-Status AddMklLayerNorm(RemapperContext* ctx,
-                       const std::map<string, int>& matched_nodes_map,
-                       const std::set<int>& remove_node_indices,
-                       const std::vector<string>& input_node_names,
-                       std::vector<bool>* invalidated_nodes,
-                       std::vector<bool>* nodes_to_delete,
-                       const float epsilon) {
+Status AddLayerNorm(RemapperContext* ctx,
+                    const std::map<string, int>& matched_nodes_map,
+                    const std::set<int>& remove_node_indices,
+                    const std::vector<string>& input_node_names,
+                    std::vector<bool>* invalidated_nodes,
+                    std::vector<bool>* nodes_to_delete, const float epsilon) {
   auto* output_node =
       ctx->graph_view.GetNode(matched_nodes_map.at("output"))->node();
 
   NodeDef fused_node;
   fused_node.set_name(output_node->name());
-  fused_node.set_op("_MklLayerNorm");
+  fused_node.set_op(IsMKLEnabled() ? "_MklLayerNorm" : kFusedLayerNorm);
   fused_node.set_device(output_node->device());
   for (const auto& name : input_node_names) fused_node.add_input(name);
   auto* attr = fused_node.mutable_attr();
@@ -3878,6 +4111,193 @@ Status AddMklLayerNorm(RemapperContext* ctx,
   return absl::OkStatus();
 }
 
+Status AddFusedMaskedSoftmaxNode(RemapperContext* ctx,
+                                 const MaskedSoftmax& matched,
+                                 std::vector<bool>* invalidated_nodes,
+                                 std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& add = graph->node(matched.add);
+  const NodeDef& softmax = graph->node(matched.softmax);
+  VLOG(2) << "Fuse Add with Softmax:" << " add=" << add.name()
+          << " softmax=" << softmax.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(softmax.name());
+  fused_op.set_op(kFusedMaskedSoftmax);
+  fused_op.set_device(softmax.device());
+  fused_op.add_input(add.input(matched.logits_port));      // 0: logits
+  fused_op.add_input(add.input(1 - matched.logits_port));  // 1: mask
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = softmax.attr().at("T");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.softmax] = true;
+  (*nodes_to_delete)[matched.add] = true;
+
+  return absl::OkStatus();
+}
+
+// Replaces the matched _FusedMatMul siblings with a single _FusedMatMul that
+// multiplies their input by the concatenated weights and adds the
+// concatenated biases, and a SplitV that slices the output of every sibling
+// from its result. Siblings are replaced with Identity nodes of the same
+// name, so that their consumers stay connected.
+Status AddConcatenatedFusedMatMulNodes(RemapperContext* ctx,
+                                       const FusedMatMulSiblings& matched,
+                                       std::vector<bool>* invalidated_nodes,
+                                       std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& first_matmul = graph->node(matched.matmuls.front());
+  VLOG(2) << "Concatenate the weights of " << matched.matmuls.size()
+          << " _FusedMatMul nodes with input " << first_matmul.input(0);
+
+  // Read the weights and biases of all siblings.
+  std::vector<Tensor> weights(matched.matmuls.size());
+  std::vector<Tensor> biases(matched.matmuls.size());
+  int64_t num_columns = 0;
+  for (int i = 0; i < matched.matmuls.size(); ++i) {
+    const auto* matmul_view = ctx->graph_view.GetNode(matched.matmuls[i]);
+    const NodeDef* weights_node =
+        matmul_view->GetRegularFanin(1).node_view()->node();
+    const NodeDef* bias_node =
+        matmul_view->GetRegularFanin(2).node_view()->node();
+    if (!weights[i].FromProto(weights_node->attr().at("value").tensor()) ||
+        !biases[i].FromProto(bias_node->attr().at("value").tensor())) {
+      return errors::InvalidArgument("Cannot parse the weights or the bias of ",
+                                     matmul_view->node()->name());
+    }
+    num_columns += weights[i].dim_size(1);
+  }
+
+  Tensor concat_weights(DT_FLOAT, {weights[0].dim_size(0), num_columns});
+  Tensor concat_bias(DT_FLOAT, {num_columns});
+  Tensor split_sizes(DT_INT32, {static_cast<int64_t>(weights.size())});
+  int64_t column = 0;
+  for (int i = 0; i < weights.size(); ++i) {
+    const int64_t rows = weights[i].dim_size(0);
+    const int64_t columns = weights[i].dim_size(1);
+    concat_weights.matrix<float>().slice(
+        Eigen::array<Eigen::Index, 2>{0, column},
+        Eigen::array<Eigen::Index, 2>{rows, columns}) =
+        weights[i].matrix<float>();
+    concat_bias.vec<float>().slice(Eigen::array<Eigen::Index, 1>{column},
+                                   Eigen::array<Eigen::Index, 1>{columns}) =
+        biases[i].vec<float>();
+    split_sizes.vec<int32>()(i) = static_cast<int32>(columns);
+    column += columns;
+  }
+
+  Tensor split_dim(DT_INT32, {});
+  split_dim.scalar<int32>()() = 1;
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+
+  const string& input = first_matmul.input(0);
+  const auto add_const_node = [&](const string& name, const Tensor& value) {
+    NodeDef const_node;
+    const_node.set_name(AddPrefixToNodeName(name, first_matmul.name()));
+    const_node.set_op("Const");
+    const_node.set_device(first_matmul.device());
+    // Anchor the constant to the input, so that it is in the same frame.
+    *const_node.add_input() = AsControlDependency(NodeName(input));
+    auto* attr = const_node.mutable_attr();
+    SetAttrValue(value.dtype(), &(*attr)["dtype"]);
+    value.AsProtoTensorContent((*attr)["value"].mutable_tensor());
+    const string const_name = const_node.name();
+    mutation->AddNode(std::move(const_node), &status);
+    return const_name;
+  };
+
+  const string weights_name = add_const_node("ConcatWeights", concat_weights);
+  TF_RETURN_IF_ERROR(status);
+  const string bias_name = add_const_node("ConcatBias", concat_bias);
+  TF_RETURN_IF_ERROR(status);
+  const string split_sizes_name = add_const_node("SplitSizes", split_sizes);
+  TF_RETURN_IF_ERROR(status);
+  const string split_dim_name = add_const_node("SplitDim", split_dim);
+  TF_RETURN_IF_ERROR(status);
+
+  // The concatenated _FusedMatMul keeps the attributes of the first sibling,
+  // which only differ from the others in the weights and bias.
+  NodeDef concat_matmul = first_matmul;
+  concat_matmul.set_name(
+      AddPrefixToNodeName("ConcatMatMul", first_matmul.name()));
+  concat_matmul.clear_input();
+  concat_matmul.add_input(input);         // 0: a
+  concat_matmul.add_input(weights_name);  // 1: b
+  concat_matmul.add_input(bias_name);     // 2: bias
+  const string concat_matmul_name = concat_matmul.name();
+  mutation->AddNode(std::move(concat_matmul), &status);
+  TF_RETURN_IF_ERROR(status);
+
+  NodeDef split;
+  split.set_name(AddPrefixToNodeName("Split", first_matmul.name()));
+  split.set_op("SplitV");
+  split.set_device(first_matmul.device());
+  split.add_input(concat_matmul_name);  // 0: value
+  split.add_input(split_sizes_name);    // 1: size_splits
+  split.add_input(split_dim_name);      // 2: axis
+  auto* split_attr = split.mutable_attr();
+  (*split_attr)["T"] = first_matmul.attr().at("T");
+  SetAttrValue(DT_INT32, &(*split_attr)["Tlen"]);
+  SetAttrValue(static_cast<int>(matched.matmuls.size()),
+               &(*split_attr)["num_split"]);
+  const string split_name = split.name();
+  mutation->AddNode(std::move(split), &status);
+  TF_RETURN_IF_ERROR(status);
+
+  // Replace every sibling with its slice of the concatenated result.
+  for (int i = 0; i < matched.matmuls.size(); ++i) {
+    const NodeDef& matmul = graph->node(matched.matmuls[i]);
+    NodeDef identity;
+    identity.set_name(matmul.name());
+    identity.set_op("Identity");
+    identity.set_device(matmul.device());
+    identity.add_input(absl::StrCat(split_name, ":", i));
+    (*identity.mutable_attr())["T"] = matmul.attr().at("T");
+    mutation->AddNode(std::move(identity), &status);
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  // Remove the original weights and biases when the siblings were their only
+  // consumers.
+  absl::flat_hash_set<int> const_nodes;
+  for (int matmul_index : matched.matmuls) {
+    const auto* matmul_view = ctx->graph_view.GetNode(matmul_index);
+    const_nodes.insert(matmul_view->GetRegularFanin(1).node_index());
+    const_nodes.insert(matmul_view->GetRegularFanin(2).node_index());
+  }
+  const absl::flat_hash_set<int> matmuls(matched.matmuls.begin(),
+                                         matched.matmuls.end());
+  for (int const_index : const_nodes) {
+    const auto* const_view = ctx->graph_view.GetNode(const_index);
+    const bool only_consumed_by_siblings =
+        absl::c_all_of(const_view->GetRegularFanout(0),
+                       [&](const utils::MutableFaninView& fanout) {
+                         return matmuls.contains(fanout.node_index());
+                       });
+    if (only_consumed_by_siblings && const_view->NumControlledFanouts() == 0 &&
+        !IsInPreserveSet(*ctx, const_view->node())) {
+      (*nodes_to_delete)[const_index] = true;
+    }
+  }
+
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  for (int matmul_index : matched.matmuls) {
+    (*invalidated_nodes)[matmul_index] = true;
+  }
+
+  return absl::OkStatus();
+}
+
 Status ReplaceMulMaximumWithLeakyRelu(
     RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
     const std::set<int>& remove_node_indices,
@@ -4780,6 +5200,14 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
                                               node_index);
   };
 
+  // Candidate for a Softmax fusion with an additive mask.
+  const auto is_masked_softmax_candidate = [&]() -> bool {
+    if (!IsSoftmax(*node_def) || !HasDataType(node_def, DT_FLOAT)) return false;
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto& softmax_fanin_0 = node_view->GetRegularFanin(0);
+    return IsAdd(*softmax_fanin_0.node_view()->node());
+  };
+
   // Candidate for a FusedMatmul fusion (MatMul + BiasAdd + Tanh/Sigmoid).
   const auto is_act_biasadd_matmul_candidate = [&]() -> bool {
     if (!IsTanh(*node_def) && !IsSigmoid(*node_def)) return false;
@@ -4819,7 +5247,7 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
          is_batch_norm_fusion_candidate() ||
          is_batch_norm_grad_fusion_candidate() ||
          is_matmul_gelu_exact_fusion_candidate() ||
-         is_act_biasadd_matmul_candidate();
+         is_act_biasadd_matmul_candidate() || is_masked_softmax_candidate();
 }
 
 inline bool IsXlaCpuGlobalJitOn() {
@@ -5048,9 +5476,9 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       remove_node_indices.clear();
       input_node_names.clear();
       float epsilon = 0.001;
-      if (FindMklLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices,
-                           &input_node_names, &epsilon)) {
-        TF_RETURN_IF_ERROR(AddMklLayerNorm(
+      if (FindLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices,
+                        &input_node_names, &epsilon)) {
+        TF_RETURN_IF_ERROR(AddLayerNorm(
             &ctx, matched_nodes_map, remove_node_indices, input_node_names,
             &invalidated_nodes, &nodes_to_delete, epsilon));
         continue;
@@ -5079,6 +5507,33 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       }
     }
 
+    // Remap the layer normalization subgraph into _FusedLayerNorm. With oneDNN
+    // it is remapped into _MklLayerNorm above.
+    if (allow_non_differentiable_rewrites && !IsMKLEnabled()) {
+      std::map<string, int> layer_norm_matched_nodes_map;
+      std::set<int> layer_norm_remove_node_indices;
+      std::vector<string> layer_norm_input_node_names;
+      float epsilon = 0.001;
+      if (FindLayerNorm(&ctx, i, &layer_norm_matched_nodes_map,
+                        &layer_norm_remove_node_indices,
+                        &layer_norm_input_node_names, &epsilon)) {
+        TF_RETURN_IF_ERROR(AddLayerNorm(
+            &ctx, layer_norm_matched_nodes_map, layer_norm_remove_node_indices,
+            layer_norm_input_node_names, &invalidated_nodes, &nodes_to_delete,
+            epsilon));
+        continue;
+      }
+    }
+
+    // Remap Softmax(Add(logits, mask)) into the _FusedMaskedSoftmax.
+    MaskedSoftmax masked_softmax;
+    if (allow_non_differentiable_rewrites &&
+        FindMaskedSoftmax(ctx, i, &masked_softmax)) {
+      TF_RETURN_IF_ERROR(AddFusedMaskedSoftmaxNode(
+          &ctx, masked_softmax, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     // Remap MatMul + BiasAdd + gelu-subgraph
     std::map<string, int> matched_nodes_map;
     std::set<int> remove_node_indices;
@@ -5174,6 +5629,19 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap _FusedMatMul nodes that share their input into one _FusedMatMul
+    // with concatenated weights followed by a SplitV. The siblings are
+    // _FusedMatMul nodes created by the first remapper pass, so this fusion
+    // happens in the second one.
+    FusedMatMulSiblings fused_matmul_siblings;
+    if (allow_non_differentiable_rewrites &&
+        FindFusedMatMulSiblings(ctx, i, invalidated_nodes, nodes_to_delete,
+                                &fused_matmul_siblings)) {
+      TF_RETURN_IF_ERROR(AddConcatenatedFusedMatMulNodes(
+          &ctx, fused_matmul_siblings, &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     TensorToHashBucket tensor_to_hash_bucket;
     if (allow_non_differentiable_rewrites &&
         FindTensorToHashBucket(ctx, i, &tensor_to_hash_bucket)) {
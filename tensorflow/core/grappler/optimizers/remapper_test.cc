@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include "absl/algorithm/container.h"
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/nn_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -1566,8 +1568,7 @@ TEST_F(RemapperFuseSoftplusTanhMul, BF16) {
 }
 #endif
 
-TEST_F(RemapperTest, FuseMklLayerNorm) {
-  if (!IsMKLEnabled()) GTEST_SKIP() << "Test only applicable to MKL.";
+TEST_F(RemapperTest, FuseLayerNorm) {
   using ::tensorflow::ops::Placeholder;
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
@@ -1613,7 +1614,8 @@ TEST_F(RemapperTest, FuseMklLayerNorm) {
   int found = 0;
   for (const NodeDef& node : output.node()) {
     if (node.name() == "add_2") {
-      EXPECT_EQ(node.op(), "_MklLayerNorm");
+      EXPECT_EQ(node.op(),
+                IsMKLEnabled() ? "_MklLayerNorm" : "_FusedLayerNorm");
       ASSERT_GE(node.input_size(), 3);
       EXPECT_EQ(node.input(0), "b_add");
       EXPECT_EQ(node.input(1), "g_const");
@@ -1629,11 +1631,10 @@ TEST_F(RemapperTest, FuseMklLayerNorm) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-4);
 }
 
-class FuseMklLayerNormPattern : public RemapperTest {
+class FuseLayerNormPattern : public RemapperTest {
  public:
   template <DataType DTYPE>
   void RunTest() {
-    if (!IsMKLEnabled()) GTEST_SKIP() << "Test only applicable to MKL.";
     using ::tensorflow::ops::Placeholder;
     tensorflow::Scope s = tensorflow::Scope::NewRootScope();
 
@@ -1679,7 +1680,8 @@ class FuseMklLayerNormPattern : public RemapperTest {
     int found = 0;
     for (const NodeDef& node : output.node()) {
       if (node.name() == "add_2") {
-        EXPECT_EQ(node.op(), "_MklLayerNorm");
+        EXPECT_EQ(node.op(),
+                  IsMKLEnabled() ? "_MklLayerNorm" : "_FusedLayerNorm");
         ASSERT_GE(node.input_size(), 3);
         EXPECT_EQ(node.input(0), "b_add");
         EXPECT_EQ(node.input(1), "g_const");
@@ -1697,7 +1699,331 @@ class FuseMklLayerNormPattern : public RemapperTest {
   }
 };
 
-TEST_F(FuseMklLayerNormPattern, F32) { RunTest<DT_FLOAT>(); }
+TEST_F(FuseLayerNormPattern, F32) { RunTest<DT_FLOAT>(); }
+
+TEST_F(RemapperTest, FuseLayerNormWithSmallEpsilon) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Layer normalization of BERT, which uses epsilon = 1e-12.
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                           ops::Placeholder::Shape({4, 16}));
+  auto r_indices = ops::Const(s.WithOpName("r_indices"), {1}, {1});
+  ops::Mean::Attrs attrs;
+  attrs = attrs.KeepDims(true);
+  auto mean = ops::Mean(s.WithOpName("mean"), input, r_indices, attrs);
+  auto s_diff = ops::SquaredDifference(s.WithOpName("s_diff"), input, mean);
+  auto variance = ops::Mean(s.WithOpName("variance"), s_diff, r_indices, attrs);
+  auto e_const = ops::Const(s.WithOpName("e_const"), {1e-12f}, {});
+  auto add_1 = ops::AddV2(s.WithOpName("add_1"), variance, e_const);
+  auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"), add_1);
+  auto g_const = ops::Const(s.WithOpName("g_const"), 2.0f, {16});
+  auto mul = ops::Mul(s.WithOpName("mul"), rsqrt, g_const);
+  auto mul_1 = ops::Mul(s.WithOpName("mul_1"), input, mul);
+  auto mul_2 = ops::Mul(s.WithOpName("mul_2"), mean, mul);
+  auto b_const = ops::Const(s.WithOpName("b_const"), 0.5f, {16});
+  auto sub = ops::Sub(s.WithOpName("sub"), b_const, mul_2);
+  auto add_2 = ops::AddV2(s.WithOpName("add_2"), mul_1, sub);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), add_2);
+
+  auto input_t = GenerateTensorWithSetRandom<DT_FLOAT>({4, 16});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"input", input_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "add_2") {
+      EXPECT_EQ(node.op(),
+                IsMKLEnabled() ? "_MklLayerNorm" : "_FusedLayerNorm");
+      ASSERT_GE(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(1), "g_const");
+      EXPECT_EQ(node.input(2), "b_const");
+      EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 1e-12f);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-4);
+}
+
+TEST_F(RemapperTest, FuseMaskedSoftmax) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Attention scores of shape [batch, heads, queries, keys] with a mask of
+  // shape [batch, 1, 1, keys].
+  auto logits = Placeholder(s.WithOpName("logits"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3, 5, 7}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          ops::Placeholder::Shape({2, 1, 1, 7}));
+  auto add = ops::AddV2(s.WithOpName("add"), mask, logits);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), softmax);
+
+  auto logits_t = GenerateTensorWithSetRandom<DT_FLOAT>({2, 3, 5, 7});
+  Tensor mask_t(DT_FLOAT, TensorShape({2, 1, 1, 7}));
+  test::FillFn<float>(&mask_t,
+                      [](int i) { return i % 3 == 2 ? -10000.0f : 0.0f; });
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"logits", logits_t}, {"mask", mask_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "add");
+    if (node.name() == "softmax") {
+      EXPECT_EQ(node.op(), "_FusedMaskedSoftmax");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "logits");
+      EXPECT_EQ(node.input(1), "mask");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, DoNotFuseMaskedSoftmaxWithoutLogits) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Neither input of the Add has the shape of its output, so there are no
+  // logits for the masked softmax.
+  auto a = Placeholder(s.WithOpName("a"), DT_FLOAT,
+                       ops::Placeholder::Shape({4, 1}));
+  auto b = Placeholder(s.WithOpName("b"), DT_FLOAT,
+                       ops::Placeholder::Shape({1, 8}));
+  auto add = ops::AddV2(s.WithOpName("add"), a, b);
+  auto softmax = ops::Softmax(s.WithOpName("softmax"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), softmax);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "softmax") EXPECT_EQ(node.op(), "Softmax");
+  }
+}
+
+class RemapperFuseMatMulWithBiasAndGeluExactTest : public RemapperTest {
+ public:
+  template <bool is_pattern2>
+  void RunTest() {
+    if (IsMKLEnabled())
+      GTEST_SKIP() << "Fusion with oneDNN is tested in mkl_remapper_test.";
+    using ::tensorflow::ops::Placeholder;
+
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                           ops::Placeholder::Shape({8, 32}));
+    auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                           ops::Placeholder::Shape({32, 64}));
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                            ops::Placeholder::Shape({64}));
+
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+    // Gelu exact with smaller ops.
+    auto square_root_one_half =
+        ops::Const(s.WithOpName("square_root_one_half"), {0.707106f}, {});
+    auto bias_add_times_square_root_one_half =
+        ops::Mul(s.WithOpName("bias_add_times_square_root_one_half"), bias_add,
+                 square_root_one_half);
+    auto erf =
+        ops::Erf(s.WithOpName("erf"), bias_add_times_square_root_one_half);
+    auto one = ops::Const(s.WithOpName("one"), {1.0f}, {});
+    auto erf_plus_one = ops::AddV2(s.WithOpName("one_plus_erf"), erf, one);
+    auto one_half = ops::Const(s.WithOpName("one_half"), {0.5f}, {});
+
+    Output gelu;
+    if (is_pattern2) {
+      auto bias_add_times_one_half = ops::Mul(
+          s.WithOpName("erf_plus_one_times_one_half"), bias_add, one_half);
+      gelu = ops::Mul(s.WithOpName("fusion_output"), erf_plus_one,
+                      bias_add_times_one_half);
+    } else {
+      auto erf_plus_one_times_one_half = ops::Mul(
+          s.WithOpName("erf_plus_one_times_one_half"), erf_plus_one, one_half);
+      gelu = ops::Mul(s.WithOpName("fusion_output"),
+                      erf_plus_one_times_one_half, bias_add);
+    }
+    auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+    auto lhs_t = GenerateTensorWithSetRandom<DT_FLOAT>({8, 32});
+    auto rhs_t = GenerateTensorWithSetRandom<DT_FLOAT>({32, 64});
+    auto bias_t = GenerateTensorWithSetRandom<DT_FLOAT>({64});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "fusion_output") {
+        EXPECT_EQ(node.op(), "_FusedMatMul");
+        ASSERT_GE(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), "lhs");
+        EXPECT_EQ(node.input(1), "rhs");
+        EXPECT_EQ(node.input(2), "bias");
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        ASSERT_EQ(fused_ops.size(), 2);
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], "GeluExact");
+        found++;
+      }
+    }
+    EXPECT_EQ(1, found);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectClose(tensors[0], tensors_expected[0], 1e-5, 1e-5);
+  }
+};
+
+TEST_F(RemapperFuseMatMulWithBiasAndGeluExactTest, F32) {
+  RunTest</*is_pattern2=*/false>();
+}
+
+TEST_F(RemapperFuseMatMulWithBiasAndGeluExactTest, F32Pattern2) {
+  RunTest</*is_pattern2=*/true>();
+}
+
+TEST_F(RemapperTest, FuseFusedMatMulSiblings) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Query, key and value projections of the same input.
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                           ops::Placeholder::Shape({8, 16}));
+  const std::vector<string> names = {"query", "key", "value"};
+  const std::vector<int64_t> widths = {4, 4, 8};
+  for (int i = 0; i < names.size(); ++i) {
+    auto weights = ops::Const(
+        s.WithOpName(names[i] + "_weights"),
+        Input::Initializer(
+            GenerateTensorWithSetRandom<DT_FLOAT>({16, widths[i]})));
+    auto bias = ops::Const(
+        s.WithOpName(names[i] + "_bias"),
+        Input::Initializer(GenerateTensorWithSetRandom<DT_FLOAT>({widths[i]})));
+    auto matmul =
+        ops::MatMul(s.WithOpName(names[i] + "_matmul"), input, weights);
+    auto bias_add = ops::BiasAdd(s.WithOpName(names[i]), matmul, bias);
+    ops::Identity(s.WithOpName(names[i] + "_fetch"), bias_add);
+  }
+
+  auto input_t = GenerateTensorWithSetRandom<DT_FLOAT>({8, 16});
+
+  GrapplerItem item;
+  item.fetch = {"query_fetch", "key_fetch", "value_fetch"};
+  item.feed = {{"input", input_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  // The first pass fuses every MatMul and BiasAdd into a _FusedMatMul, and the
+  // second one concatenates the _FusedMatMul siblings.
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef first_pass_output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &first_pass_output));
+  GrapplerItem first_pass_item = item.WithGraph(std::move(first_pass_output));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, first_pass_item, &output));
+
+  string split_name;
+  int num_fused_matmuls = 0;
+  for (const NodeDef& node : output.node()) {
+    // The original weights and biases are replaced with concatenated ones.
+    EXPECT_FALSE(absl::StrContains(node.name(), "_weights"));
+    EXPECT_FALSE(absl::StrContains(node.name(), "_bias"));
+    if (node.op() == "_FusedMatMul") {
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_TRUE(absl::StrContains(node.input(1), "ConcatWeights"));
+      EXPECT_TRUE(absl::StrContains(node.input(2), "ConcatBias"));
+      num_fused_matmuls++;
+    } else if (node.op() == "SplitV") {
+      EXPECT_EQ(node.attr().at("num_split").i(), 3);
+      split_name = node.name();
+    }
+  }
+  EXPECT_EQ(num_fused_matmuls, 1);
+  ASSERT_FALSE(split_name.empty());
+
+  for (const NodeDef& node : output.node()) {
+    if (absl::c_linear_search(names, node.name())) {
+      EXPECT_EQ(node.op(), "Identity");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_TRUE(absl::StartsWith(node.input(0), split_name + ":"));
+    }
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 3);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 3);
+  for (int i = 0; i < tensors.size(); ++i) {
+    test::ExpectClose(tensors[i], tensors_expected[i], 1e-5, 1e-5);
+  }
+}
 
 class RemapperTensorToHashBucketTest : public RemapperTest {
  public:
@@ -23,6 +23,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
@@ -64,6 +65,11 @@ constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
 constexpr char kFullBatchSchedulingBoostMicros[] =
     "_full_batch_scheduling_boost_micros";
+constexpr char kLengthBucketingInputIndexAttr[] =
+    "_length_bucketing_input_index";
+constexpr char kLengthBucketBoundariesAttr[] = "_length_bucket_boundaries";
+constexpr char kLengthBucketBatchTimeoutMicrosAttr[] =
+    "_length_bucket_batch_timeout_micros";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -121,6 +127,16 @@ int32 NumBatchThreadsFromEnvironmentWithDefault(int default_num_batch_threads) {
                                                    : default_num_batch_threads;
 }
 
+// Returns whether batch resources avoid copying tensors into and out of
+// batches where possible, see `BatchResourceBase::set_zero_copy_batching`.
+bool ZeroCopyBatchingFromEnvironment() {
+  bool zero_copy_batching;
+  const char* val = std::getenv("TF_ZERO_COPY_BATCHING");
+
+  return val && absl::SimpleAtob(val, &zero_copy_batching) &&
+         zero_copy_batching;
+}
+
 static thread::ThreadPool* GetOrCreateBatchThreadsPool() {
   static thread::ThreadPool* shared_thread_pool = [&]() -> thread::ThreadPool* {
     serving::BoundedExecutor::Options options;
@@ -314,6 +330,19 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     has_attribute_enable_large_batch_splitting_ = true;
   }
 
+  if (c->HasAttr(kLengthBucketingInputIndexAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kLengthBucketingInputIndexAttr,
+                                 &length_bucketing_input_index_));
+  }
+  if (c->HasAttr(kLengthBucketBoundariesAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kLengthBucketBoundariesAttr,
+                                 &length_bucket_boundaries_));
+  }
+  if (c->HasAttr(kLengthBucketBatchTimeoutMicrosAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kLengthBucketBatchTimeoutMicrosAttr,
+                                 &length_bucket_batch_timeout_micros_));
+  }
+
   // Helper function `SetAdaptiveBatchSchedulerOptions` calls
   // `OP_REQUIRES_OK`, which exits the current function upon error.
   // So validate status of `op-kernel-construction`.
@@ -342,6 +371,15 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
 
 bool BatchFunctionKernel::IsExpensive() { return false; }
 
+serving::LengthBucketingOptions BatchFunctionKernel::GetLengthBucketingOptions()
+    const {
+  serving::LengthBucketingOptions options;
+  options.length_input_index = length_bucketing_input_index_;
+  options.bucket_boundaries = length_bucket_boundaries_;
+  options.bucket_batch_timeout_micros = length_bucket_batch_timeout_micros_;
+  return options;
+}
+
 void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
   RecordBatchSplitUsage(has_attribute_enable_large_batch_splitting_
                             ? std::make_optional(enable_large_batch_splitting_)
@@ -420,6 +458,9 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_zero_copy_batching(ZeroCopyBatchingFromEnvironment());
+      TF_RETURN_IF_ERROR(
+          new_resource->SetLengthBucketingOptions(GetLengthBucketingOptions()));
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -442,6 +483,9 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      new_resource->set_zero_copy_batching(ZeroCopyBatchingFromEnvironment());
+      TF_RETURN_IF_ERROR(
+          new_resource->SetLengthBucketingOptions(GetLengthBucketingOptions()));
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -18,11 +18,13 @@ limitations under the License.
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tsl/platform/types.h"
@@ -98,6 +100,11 @@ class BatchFunctionKernel : public AsyncOpKernel {
   //   Read from corresponding attributes as long as they are set.
   void SetAdaptiveBatchSchedulerOptions(OpKernelConstruction* c,
                                         int32_t num_batch_threads);
+
+  // Returns the options for batching by sequence length, read from the
+  // corresponding attributes.
+  serving::LengthBucketingOptions GetLengthBucketingOptions() const;
+
   string container_;
   string shared_name_;
   string batcher_queue_;
@@ -117,6 +124,12 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool has_attribute_enable_large_batch_splitting_ = false;
   bool enable_adaptive_batch_threads_ = false;
 
+  // Options for batching by sequence length, see
+  // `serving::LengthBucketingOptions`.
+  int32 length_bucketing_input_index_ = -1;
+  std::vector<int64_t> length_bucket_boundaries_;
+  std::vector<int32> length_bucket_batch_timeout_micros_;
+
   mutex mu_;
 
   // Parameters for adaptive batch scheduler only.
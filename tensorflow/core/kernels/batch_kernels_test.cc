@@ -17,12 +17,14 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <numeric>
 #include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/framework/device_factory.h"
 #include "tensorflow/core/framework/function.h"
@@ -90,9 +92,16 @@ class BatchFunctionTestState : public SharedBatchFunctionTestState {
  public:
   // Init test fixture with a batch kernel instance. The caller guarantees that
   // the device pointer is valid throughout the life of this class.
-  absl::Status Init(Device *device, bool enable_low_priority_queue,
-                    absl::string_view mixed_priority_policy,
-                    int64_t expected_batch_size) {
+  // If `length_bucket_boundaries` is non-empty, batches by the sequence
+  // lengths held in the batched input, with the batch timeouts
+  // `length_bucket_batch_timeout_micros` if non-empty. The batched input has
+  // `row_size` columns.
+  absl::Status Init(
+      Device *device, bool enable_low_priority_queue,
+      absl::string_view mixed_priority_policy, int64_t expected_batch_size,
+      const std::vector<int64_t> &length_bucket_boundaries = {},
+      int64_t row_size = 2, int32_t batch_timeout_micros = 1000000,
+      const std::vector<int32_t> &length_bucket_batch_timeout_micros = {}) {
     // Override the per-test/per-op device with a given device so that it can
     // be shared between ops.
     device_ = device;
@@ -113,7 +122,7 @@ class BatchFunctionTestState : public SharedBatchFunctionTestState {
           "EnsureShape",
           {"x"},
           {{"T", DataType::DT_INT64},
-           {"shape", TensorShape({expected_batch_size, 2})}}}},
+           {"shape", TensorShape({expected_batch_size, row_size})}}}},
         // ret_def
         {{"o", "o:output"}});
     TF_RETURN_IF_ERROR(flib_def_->AddFunctionDef(func));
@@ -121,11 +130,19 @@ class BatchFunctionTestState : public SharedBatchFunctionTestState {
 
     std::vector<NodeDefBuilder::NodeOut> inputs(
         {NodeDefBuilder::NodeOut({"n1", 0, DataType::DT_INT64})});
-    TF_RETURN_IF_ERROR(NodeDefBuilder("BatchTPUInput", "BatchFunction")
-                           .Attr("max_batch_size", 8)
+    NodeDefBuilder builder("BatchTPUInput", "BatchFunction");
+    if (!length_bucket_boundaries.empty()) {
+      builder.Attr("_length_bucketing_input_index", 0)
+          .Attr("_length_bucket_boundaries", length_bucket_boundaries);
+    }
+    if (!length_bucket_batch_timeout_micros.empty()) {
+      builder.Attr("_length_bucket_batch_timeout_micros",
+                   length_bucket_batch_timeout_micros);
+    }
+    TF_RETURN_IF_ERROR(builder.Attr("max_batch_size", 8)
                            .Attr("num_batch_threads", 8)
                            .Attr("allowed_batch_sizes", {4, 8})
-                           .Attr("batch_timeout_micros", 1000000)
+                           .Attr("batch_timeout_micros", batch_timeout_micros)
                            .Attr("max_enqueued_batches", 10)
                            .Attr("enable_large_batch_splitting", true)
                            .Attr("low_priority_max_batch_size",
@@ -235,6 +252,61 @@ TEST_P(BatchFunctionTest, PaddingWorksWithoutCriticality) {
   }
 }
 
+TEST_P(BatchFunctionTest, LengthBucketingBatchesSimilarLengths) {
+  SessionMetadata session_metadata;
+  session_metadata.set_name("test_model");
+  session_metadata.set_version(123);
+
+  bool enable_low_priority_queue = GetParam();
+  {
+    tsl::BlockingCounter blocking_counter(8);
+    // 4 threads run the batch op with short sequences, and 4 with long ones.
+    // The short and long sequences are batched separately, to form two
+    // tensors with [4, 2] shape which are verified within the function.
+    for (int i = 0; i < 8; ++i) {
+      Env::Default()->SchedClosure([&, i]() {
+        const int64_t length = i % 2 == 0 ? 4 : 16;
+
+        BatchFunctionTestState test_state;
+        test_state.set_session_metadata(session_metadata);
+        TF_ASSERT_OK(test_state.Init(
+            cpu_device_.get(), enable_low_priority_queue,
+            serving::kLowPriorityPaddingWithMaxBatchSizeAttrValue,
+            /*expected_batch_size=*/4, /*length_bucket_boundaries=*/{8}));
+        test_state.AddInputFromList<int64_t>(TensorShape({1, 2}),
+                                             {length, length - 1});
+        TF_EXPECT_OK(test_state.RunOpKernel());
+
+        test::ExpectTensorEqual<int64_t>(
+            *test_state.GetOutput(0),
+            test::AsTensor<int64_t>({length, length - 1}, TensorShape({1, 2})));
+        blocking_counter.DecrementCount();
+      });
+    }
+
+    blocking_counter.Wait();
+  }
+}
+
+TEST_P(BatchFunctionTest, LengthBucketingUsesBucketBatchTimeout) {
+  bool enable_low_priority_queue = GetParam();
+  // The batch of the single task is only processed before the half-hour batch
+  // timeout of the op because its length bucket has a short batch timeout.
+  BatchFunctionTestState test_state;
+  TF_ASSERT_OK(test_state.Init(
+      cpu_device_.get(), enable_low_priority_queue,
+      serving::kLowPriorityPaddingWithMaxBatchSizeAttrValue,
+      /*expected_batch_size=*/4, /*length_bucket_boundaries=*/{8},
+      /*row_size=*/2, /*batch_timeout_micros=*/1800 * 1000000,
+      /*length_bucket_batch_timeout_micros=*/{1000, 1000}));
+  test_state.AddInputFromList<int64_t>(TensorShape({1, 2}), {4, 3});
+  TF_EXPECT_OK(test_state.RunOpKernel());
+
+  test::ExpectTensorEqual<int64_t>(
+      *test_state.GetOutput(0),
+      test::AsTensor<int64_t>({4, 3}, TensorShape({1, 2})));
+}
+
 #if defined(PLATFORM_GOOGLE)
 TEST_P(BatchFunctionTest,
        LowPriorityTaskPaddingHighPriorityBatchUptoMaxBatchSize) {
@@ -560,6 +632,66 @@ TEST_F(BatchFunctionTest, LowPriorityBatchPaddedToLowPriorityAllowedBatchSize) {
 }
 #endif
 
+// A batch made of a single task that needs no padding is processed on the
+// task's own inputs, and the task gets the batch output without a copy. The
+// function forwards its input, so the output aliases the input. The rows of
+// the input are too small to be aligned, so it isn't written into an input
+// slab.
+TEST_F(BatchFunctionTest, ZeroCopyBatchingSkipsConcatForSingleTask) {
+  tensorflow::setenv("TF_ZERO_COPY_BATCHING", "true", 1 /* overwrite */);
+  BatchFunctionTestState test_state;
+  TF_ASSERT_OK(
+      test_state.Init(cpu_device_.get(), /*enable_low_priority_queue=*/false,
+                      serving::kLowPriorityPaddingWithMaxBatchSizeAttrValue,
+                      /*expected_batch_size=*/4,
+                      /*length_bucket_boundaries=*/{}, /*row_size=*/1));
+  test_state.AddInputFromList<int64_t>(TensorShape({4, 1}), {1, 2, 3, 4});
+  const Tensor input = *test_state.mutable_input(0).tensor;
+  TF_EXPECT_OK(test_state.RunOpKernel());
+  tensorflow::unsetenv("TF_ZERO_COPY_BATCHING");
+
+  const Tensor& output = *test_state.GetOutput(0);
+  test::ExpectTensorEqual<int64_t>(output, input);
+  EXPECT_EQ(output.tensor_data().data(), input.tensor_data().data());
+}
+
+// Two tasks with aligned rows write their inputs into consecutive rows of an
+// input slab, and the batch is processed on those rows without a concat. The
+// function forwards its input, so the outputs alias the slab.
+TEST_F(BatchFunctionTest, ZeroCopyBatchingWritesInputsIntoSlabs) {
+  // Rows of 16 int64 values are aligned for any Eigen alignment.
+  constexpr int64_t kRowSize = 16;
+  constexpr int64_t kMaxBatchSize = 8;
+  // Each slab holds four batches of the largest size.
+  constexpr int64_t kSlabBytes = 4 * kMaxBatchSize * kRowSize * sizeof(int64_t);
+
+  tensorflow::setenv("TF_ZERO_COPY_BATCHING", "true", 1 /* overwrite */);
+  tsl::BlockingCounter blocking_counter(2);
+  for (int i = 0; i < 2; ++i) {
+    Env::Default()->SchedClosure([&, i]() {
+      BatchFunctionTestState test_state;
+      TF_ASSERT_OK(test_state.Init(
+          cpu_device_.get(), /*enable_low_priority_queue=*/false,
+          serving::kLowPriorityPaddingWithMaxBatchSizeAttrValue,
+          /*expected_batch_size=*/4, /*length_bucket_boundaries=*/{},
+          kRowSize));
+      std::vector<int64_t> values(2 * kRowSize);
+      std::iota(values.begin(), values.end(), 100 * i);
+      test_state.AddInputFromArray<int64_t>(TensorShape({2, kRowSize}), values);
+      const Tensor input = *test_state.mutable_input(0).tensor;
+      TF_EXPECT_OK(test_state.RunOpKernel());
+
+      Tensor output = *test_state.GetOutput(0);
+      test::ExpectTensorEqual<int64_t>(output, input);
+      EXPECT_NE(output.tensor_data().data(), input.tensor_data().data());
+      EXPECT_EQ(DMAHelper::buffer(&output)->root_buffer()->size(), kSlabBytes);
+      blocking_counter.DecrementCount();
+    });
+  }
+  blocking_counter.Wait();
+  tensorflow::unsetenv("TF_ZERO_COPY_BATCHING");
+}
+
 class BatchFunctionKernelParallelWarmupTestState
     : public SharedBatchFunctionTestState {
  public:
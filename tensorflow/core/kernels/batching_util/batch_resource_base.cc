@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
 #include <algorithm>
+#include <cstring>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -27,14 +28,17 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/bind_front.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/cost_constants.h"
@@ -269,6 +273,33 @@ void RecordBatchCosts(const std::string& model_name,
       ->Add(absl::ToDoubleMicroseconds(total_cost));
 }
 
+// Records the number of sequence elements of batches that are padding, when
+// batching by sequence length.
+void RecordPaddedSequenceElements(int64_t padded_elements,
+                                  const string& model_name,
+                                  const string& op_name) {
+  static auto* cell = monitoring::Counter<2>::New(
+      "/tensorflow/serving/batching/padded_sequence_elements",
+      "Tracks the number of sequence elements of batches that are padding by "
+      "model_name (if available), when batching by sequence length.",
+      "model_name", "op_name");
+  cell->GetCell(model_name, op_name)->IncrementBy(padded_elements);
+}
+
+void RecordSequencePaddingFraction(double padding_fraction,
+                                   const string& model_name,
+                                   const string& op_name) {
+  static auto* cell = monitoring::Sampler<2>::New(
+      {"/tensorflow/serving/batching/sequence_padding_fraction",
+       "Tracks the distribution of the fraction of the sequence elements of "
+       "batches that are padding by model_name (if available), when batching "
+       "by sequence length.",
+       "model_name", "op_name"},
+      monitoring::Buckets::Explicit(
+          {0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9}));
+  cell->GetCell(model_name, op_name)->Add(padding_fraction);
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -287,6 +318,40 @@ int GetTotalTaskSize(
   return tasks_size;
 }
 
+template <typename T>
+void GetRowMaxima(const Tensor& tensor, std::vector<int64_t>* row_maxima) {
+  const auto flat = tensor.unaligned_flat<T>();
+  const int64_t row_size = tensor.NumElements() / row_maxima->size();
+  for (int64_t i = 0; i < row_maxima->size(); ++i) {
+    for (int64_t j = 0; j < row_size; ++j) {
+      (*row_maxima)[i] =
+          std::max<int64_t>((*row_maxima)[i], flat(i * row_size + j));
+    }
+  }
+}
+
+// Returns the sequence length of each row of 'lengths', i.e. the largest value
+// of the row.
+StatusOr<std::vector<int64_t>> GetSequenceLengths(const Tensor& lengths) {
+  std::vector<int64_t> row_lengths(lengths.dim_size(0), 0);
+  if (row_lengths.empty()) {
+    return row_lengths;
+  }
+  switch (lengths.dtype()) {
+    case DT_INT32:
+      GetRowMaxima<int32>(lengths, &row_lengths);
+      break;
+    case DT_INT64:
+      GetRowMaxima<int64_t>(lengths, &row_lengths);
+      break;
+    default:
+      return errors::InvalidArgument(
+          "Sequence lengths for length bucketing must be int32 or int64; got ",
+          DataTypeString(lengths.dtype()), ".");
+  }
+  return row_lengths;
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -307,6 +372,8 @@ BatchResourceBase::BatchTask::CreateSplitTask(
   task->start_time = this->start_time;
   task->request_cost = this->request_cost;
   task->forced_warmup_batch_size = this->forced_warmup_batch_size;
+  task->input_slabs = this->input_slabs;
+  task->inputs_written = this->inputs_written;
 
   return task;
 }
@@ -470,9 +537,14 @@ Status BatchResourceBase::RegisterInput(
     batch_components->request_cost = request_cost_accessor->GetRequestCost();
   }
 
+  TF_ASSIGN_OR_RETURN(const int length_bucket,
+                      GetLengthBucket(*batch_components));
   BatcherQueueT* batcher_queue;
-  TF_RETURN_IF_ERROR(
-      LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+  TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(
+      length_bucket < 0
+          ? batcher_queue_name
+          : absl::StrCat(batcher_queue_name, "/length_bucket_", length_bucket),
+      length_bucket, &batcher_queue));
 
   if (!session_metadata().name().empty()) {
     absl::MutexLock lock(&outstanding_batch_mu_);
@@ -487,7 +559,194 @@ Status BatchResourceBase::RegisterInput(
     num_outstanding_batched_items_ += batch_components->size();
   }
 
-  return batcher_queue->Schedule(&batch_components);
+  if (!zero_copy_batching_ || forced_warmup_batch_size > 0) {
+    return batcher_queue->Schedule(&batch_components);
+  }
+
+  // Rows are reserved and the task is scheduled under the same lock, so that
+  // tasks are added to batches in the order of their rows. The inputs are
+  // written after scheduling, and batches wait for them.
+  const std::vector<Tensor> task_inputs = batch_components->inputs;
+  std::vector<Tensor> slab_rows;
+  std::shared_ptr<absl::Notification> inputs_written;
+  Status status;
+  {
+    mutex_lock l(input_slabs_mu_);
+    if (ReserveInputSlabRows(batcher_queue, context, batch_components.get())) {
+      slab_rows = batch_components->inputs;
+      inputs_written = batch_components->inputs_written;
+    }
+    status = batcher_queue->Schedule(&batch_components);
+  }
+  for (int i = 0; i < slab_rows.size(); ++i) {
+    std::memcpy(const_cast<char*>(slab_rows[i].tensor_data().data()),
+                task_inputs[i].tensor_data().data(),
+                task_inputs[i].tensor_data().size());
+  }
+  if (inputs_written != nullptr) {
+    inputs_written->Notify();
+  }
+  return status;
+}
+
+bool BatchResourceBase::ReserveInputSlabRows(const BatcherQueueT* batcher_queue,
+                                             OpKernelContext* context,
+                                             BatchTask* task) {
+  // Each slab holds the rows of a few full batches.
+  constexpr int64_t kBatchesPerSlab = 4;
+  // Slabs kept for reuse per batcher queue.
+  constexpr int kMaxRetiredSlabs = 4;
+
+  const int64_t num_rows = task->size();
+  const int64_t max_batch_size =
+      batcher_ ? batcher_queue_options_.max_execution_batch_size
+               : adaptive_batcher_queue_options_.max_batch_size;
+  const int64_t slab_num_rows = kBatchesPerSlab * max_batch_size;
+  if (num_rows > slab_num_rows) {
+    return false;
+  }
+  // Rows must be aligned, so that splitting the task slices its rows rather
+  // than copying them before they are written.
+  constexpr int64_t kRowAlignment = std::max(EIGEN_MAX_ALIGN_BYTES, 1);
+  for (const Tensor& input : task->inputs) {
+    if (!DataTypeCanUseMemcpy(input.dtype()) ||
+        input.shape().dim_size(0) != num_rows ||
+        (input.TotalBytes() / num_rows) % kRowAlignment != 0) {
+      return false;
+    }
+  }
+  // Returns whether `buffers` can hold rows of the inputs of `task`.
+  auto holds_rows = [task](const std::vector<Tensor>& buffers) {
+    if (buffers.size() != task->inputs.size()) return false;
+    for (int i = 0; i < buffers.size(); ++i) {
+      TensorShape row_shape = buffers[i].shape();
+      row_shape.RemoveDim(0);
+      TensorShape input_row_shape = task->inputs[i].shape();
+      input_row_shape.RemoveDim(0);
+      if (buffers[i].dtype() != task->inputs[i].dtype() ||
+          row_shape != input_row_shape) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  InputSlabs& slabs = input_slabs_[batcher_queue];
+  if (!holds_rows(slabs.buffers) ||
+      slabs.next_row + num_rows > slabs.num_rows) {
+    if (!slabs.buffers.empty()) {
+      slabs.retired.push_back(std::move(slabs.buffers));
+      if (slabs.retired.size() > kMaxRetiredSlabs) {
+        slabs.retired.erase(slabs.retired.begin());
+      }
+    }
+    slabs.buffers.clear();
+    for (auto it = slabs.retired.begin(); it != slabs.retired.end(); ++it) {
+      if (holds_rows(*it) && (*it)[0].dim_size(0) == slab_num_rows &&
+          absl::c_all_of(*it, [](const Tensor& buffer) {
+            return buffer.RefCountIsOne();
+          })) {
+        slabs.buffers = std::move(*it);
+        slabs.retired.erase(it);
+        break;
+      }
+    }
+    if (slabs.buffers.empty()) {
+      Allocator* allocator = context->get_allocator(AllocatorAttributes());
+      for (const Tensor& input : task->inputs) {
+        TensorShape shape = input.shape();
+        shape.set_dim(0, slab_num_rows);
+        Tensor buffer(allocator, input.dtype(), shape);
+        if (!buffer.IsInitialized()) {
+          slabs.buffers.clear();
+          slabs.num_rows = 0;
+          return false;
+        }
+        slabs.buffers.push_back(std::move(buffer));
+      }
+    }
+    slabs.num_rows = slab_num_rows;
+    slabs.next_row = 0;
+  }
+
+  const int64_t row = slabs.next_row;
+  slabs.next_row += num_rows;
+  task->input_slabs = slabs.buffers;
+  task->input_slab_row = row;
+  for (int i = 0; i < task->inputs.size(); ++i) {
+    task->inputs[i] = slabs.buffers[i].Slice(row, row + num_rows);
+  }
+  task->inputs_written = std::make_shared<absl::Notification>();
+  return true;
+}
+
+bool BatchResourceBase::TakeBatchInputsFromSlabs(
+    const BatchT& batch,
+    const std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks,
+    int padding_amount, std::vector<Tensor>* batch_inputs) const {
+  std::vector<const BatchTask*> tasks;
+  tasks.reserve(batch.num_tasks() + unbatched_tasks.size());
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    tasks.push_back(&batch.task(i));
+  }
+  for (const auto& task : unbatched_tasks) {
+    tasks.push_back(task.get());
+  }
+
+  const std::vector<Tensor>& slabs = tasks[0]->input_slabs;
+  if (slabs.empty()) {
+    return false;
+  }
+  const int64_t first_row = tasks[0]->input_slab_row;
+  int64_t end_row = first_row;
+  for (const BatchTask* task : tasks) {
+    if (task->input_slab_row != end_row ||
+        task->input_slabs.size() != slabs.size()) {
+      return false;
+    }
+    for (int i = 0; i < slabs.size(); ++i) {
+      const int64_t row_bytes = slabs[i].TotalBytes() / slabs[i].dim_size(0);
+      // Split tasks hold rows of the slabs only if their inputs were sliced.
+      if (task->input_slabs[i].tensor_data().data() !=
+              slabs[i].tensor_data().data() ||
+          task->inputs[i].tensor_data().data() !=
+              slabs[i].tensor_data().data() + end_row * row_bytes) {
+        return false;
+      }
+    }
+    end_row += task->size();
+  }
+
+  if (padding_amount > 0) {
+    {
+      mutex_lock l(input_slabs_mu_);
+      auto it = absl::c_find_if(input_slabs_, [&](const auto& entry) {
+        return !entry.second.buffers.empty() &&
+               entry.second.buffers[0].tensor_data().data() ==
+                   slabs[0].tensor_data().data();
+      });
+      if (it == input_slabs_.end() || it->second.next_row != end_row ||
+          end_row + padding_amount > it->second.num_rows) {
+        return false;
+      }
+      it->second.next_row += padding_amount;
+    }
+    // Pads with the first row of the batch, like the concatenation does.
+    for (const Tensor& slab : slabs) {
+      const int64_t row_bytes = slab.TotalBytes() / slab.dim_size(0);
+      char* data = const_cast<char*>(slab.tensor_data().data());
+      for (int64_t row = end_row; row < end_row + padding_amount; ++row) {
+        std::memcpy(data + row * row_bytes, data + first_row * row_bytes,
+                    row_bytes);
+      }
+    }
+  }
+
+  batch_inputs->clear();
+  for (const Tensor& slab : slabs) {
+    batch_inputs->push_back(slab.Slice(first_row, end_row + padding_amount));
+  }
+  return true;
 }
 
 /*static*/ BatchResourceBase::BatcherT::QueueOptions
@@ -652,6 +911,17 @@ Status BatchResourceBase::ConcatInputTensors(
   if (batch.num_tasks() == 0) {
     return errors::InvalidArgument("Empty batch.");
   }
+  // Waits for the tasks that write their inputs into input slabs.
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    if (batch.task(i).inputs_written != nullptr) {
+      batch.task(i).inputs_written->WaitForNotification();
+    }
+  }
+  for (const auto& task : unbatched_tasks) {
+    if (task->inputs_written != nullptr) {
+      task->inputs_written->WaitForNotification();
+    }
+  }
 
   int unbatched_tasks_size = GetTotalTaskSize(unbatched_tasks);
   const bool just_for_warmup = batch.task(0).forced_warmup_batch_size > 0;
@@ -684,6 +954,25 @@ Status BatchResourceBase::ConcatInputTensors(
                              context->op_kernel().name());
   RecordBatchSize(batch.size(), GetModelName(context),
                   context->op_kernel().name());
+  if (!just_for_warmup) {
+    RecordLengthPaddingWaste(
+        batch, unbatched_tasks, length_bucketing_options_.length_input_index,
+        padded_batch_size, GetModelName(context), context->op_kernel().name());
+  }
+
+  if (zero_copy_batching_ && !just_for_warmup &&
+      TakeBatchInputsFromSlabs(batch, unbatched_tasks, padding_amount,
+                               concatenated_tensors)) {
+    return absl::OkStatus();
+  }
+
+  // A single task without padding already holds the batch inputs. Its inputs
+  // are aligned, either as op inputs or as slices made by `SplitInputTask`.
+  if (zero_copy_batching_ && !just_for_warmup && padding_amount == 0 &&
+      batch.num_tasks() == 1 && unbatched_tasks.empty()) {
+    *concatenated_tensors = batch.task(0).inputs;
+    return absl::OkStatus();
+  }
 
   // All tasks should have the same number of input edges.
   const int num_inputs = batch.task(0).inputs.size();
@@ -798,8 +1087,11 @@ Status BatchResourceBase::ConcatInputTensors(
   }
 
   output_tasks->reserve(num_batches);
+  int64_t input_slab_row = input_task.input_slab_row;
   for (int i = 0; i < num_batches; i++) {
     output_tasks->push_back(input_task.CreateSplitTask(i, barrier.Inc()));
+    output_tasks->back()->input_slab_row = input_slab_row;
+    input_slab_row += output_task_sizes[i];
   }
 
   const int num_input_tensors = input_task.inputs.size();
@@ -887,8 +1179,9 @@ Status BatchResourceBase::SplitOutputTensors(
     }
 
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+    const Status split_status =
+        SplitOutputTensor(output_tensor, task_sizes_plus_optional_padding,
+                          zero_copy_batching_, &split_tensor);
     DCHECK(split_status.ok()) << split_status;
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
@@ -923,6 +1216,33 @@ Status BatchResourceBase::SplitOutputTensors(
   return absl::OkStatus();
 }
 
+/*static*/ Status BatchResourceBase::SplitOutputTensor(
+    const Tensor& output, absl::Span<const int64_t> sizes, bool zero_copy,
+    std::vector<Tensor>* split_tensors) {
+  int64_t total_size = 0;
+  for (const int64_t size : sizes) {
+    total_size += size;
+  }
+  if (zero_copy && output.dims() > 0 && total_size == output.dim_size(0)) {
+    std::vector<Tensor> slices;
+    slices.reserve(sizes.size());
+    int64_t position = 0;
+    for (const int64_t size : sizes) {
+      Tensor slice = output.Slice(position, position + size);
+      if (!slice.IsAligned()) {
+        break;
+      }
+      slices.push_back(std::move(slice));
+      position += size;
+    }
+    if (slices.size() == sizes.size()) {
+      *split_tensors = std::move(slices);
+      return absl::OkStatus();
+    }
+  }
+  return tensor::Split(output, sizes, split_tensors);
+}
+
 void BatchResourceBase::CleanUpFunctionHelper(BatchTask& task,
                                               const Status& status) const {
   WithContext wc(task.propagated_context);
@@ -1169,6 +1489,7 @@ void BatchResourceBase::ProcessBatchCallBack(
 // Looks up the batcher queue for 'queue_name'. If it didn't previously exist,
 // creates it.
 Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
+                                                     int length_bucket,
                                                      BatcherQueueT** queue) {
   mutex_lock l(batcher_queues_mu_);
 
@@ -1178,10 +1499,20 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
     return absl::OkStatus();
   }
 
+  const std::vector<int32_t>& bucket_batch_timeout_micros =
+      length_bucketing_options_.bucket_batch_timeout_micros;
+  const bool has_bucket_batch_timeout =
+      length_bucket >= 0 && !bucket_batch_timeout_micros.empty();
+
   std::unique_ptr<BatcherQueueT> new_queue;
   if (batcher_) {
+    BatcherT::QueueOptions queue_options = batcher_queue_options_;
+    if (has_bucket_batch_timeout) {
+      queue_options.batch_timeout_micros =
+          bucket_batch_timeout_micros[length_bucket];
+    }
     TF_RETURN_IF_ERROR(batcher_->AddQueue(
-        batcher_queue_options_,
+        queue_options,
         absl::bind_front(&BatchResourceBase::ProcessBatchCallBack, this),
         &new_queue));
   } else if (adaptive_batcher_) {
@@ -1189,9 +1520,14 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
         reduced_process_batch_callback = [this](std::unique_ptr<BatchT> batch) {
           ProcessBatchCallBack(std::move(batch), {});
         };
+    AdaptiveBatcherT::QueueOptions queue_options =
+        adaptive_batcher_queue_options_;
+    if (has_bucket_batch_timeout) {
+      queue_options.batch_timeout_micros =
+          bucket_batch_timeout_micros[length_bucket];
+    }
     TF_RETURN_IF_ERROR(adaptive_batcher_->AddQueue(
-        adaptive_batcher_queue_options_, reduced_process_batch_callback,
-        &new_queue));
+        queue_options, reduced_process_batch_callback, &new_queue));
   } else {
     return errors::Internal("No batcher defined.");
   }
@@ -1200,6 +1536,100 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
   return absl::OkStatus();
 }
 
+Status BatchResourceBase::SetLengthBucketingOptions(
+    const LengthBucketingOptions& options) {
+  const std::vector<int64_t>& boundaries = options.bucket_boundaries;
+  for (int i = 1; i < boundaries.size(); ++i) {
+    if (boundaries[i] <= boundaries[i - 1]) {
+      return errors::InvalidArgument(
+          "Length bucket boundaries must be strictly increasing; got [",
+          absl::StrJoin(boundaries, ","), "].");
+    }
+  }
+  const std::vector<int32_t>& timeouts = options.bucket_batch_timeout_micros;
+  if (!timeouts.empty() && timeouts.size() != boundaries.size() + 1) {
+    return errors::InvalidArgument(
+        "Expected a batch timeout for each of the ", boundaries.size() + 1,
+        " length buckets; got ", timeouts.size(), ".");
+  }
+  for (const int32_t timeout : timeouts) {
+    if (timeout < 0) {
+      return errors::InvalidArgument(
+          "Length bucket batch timeouts must be non-negative; got ", timeout,
+          ".");
+    }
+  }
+  length_bucketing_options_ = options;
+  return absl::OkStatus();
+}
+
+StatusOr<int> BatchResourceBase::GetLengthBucket(const BatchTask& task) const {
+  const int length_input_index = length_bucketing_options_.length_input_index;
+  if (length_input_index < 0) {
+    return -1;
+  }
+  if (length_input_index >= task.inputs.size()) {
+    return errors::InvalidArgument(
+        "The sequence length input index for length bucketing is ",
+        length_input_index, ", but there are only ", task.inputs.size(),
+        " batched inputs.");
+  }
+  TF_ASSIGN_OR_RETURN(const std::vector<int64_t> lengths,
+                      GetSequenceLengths(task.inputs[length_input_index]));
+  if (lengths.empty()) {
+    return 0;
+  }
+  const int64_t max_length = *std::max_element(lengths.begin(), lengths.end());
+  const std::vector<int64_t>& boundaries =
+      length_bucketing_options_.bucket_boundaries;
+  return std::lower_bound(boundaries.begin(), boundaries.end(), max_length) -
+         boundaries.begin();
+}
+
+void BatchResourceBase::RecordLengthPaddingWaste(
+    const BatchT& batch,
+    const std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks,
+    int length_input_index, int padded_batch_size, const string& model_name,
+    const string& op_name) {
+  if (length_input_index < 0) {
+    return;
+  }
+  int64_t max_length = 0;
+  int64_t total_length = 0;
+  auto add_task_lengths = [&](const BatchTask& task) {
+    if (length_input_index >= task.inputs.size()) {
+      return;
+    }
+    StatusOr<std::vector<int64_t>> lengths =
+        GetSequenceLengths(task.inputs[length_input_index]);
+    if (!lengths.ok()) {
+      return;
+    }
+    for (const int64_t length : *lengths) {
+      max_length = std::max(max_length, length);
+      total_length += length;
+    }
+  };
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    add_task_lengths(batch.task(i));
+  }
+  for (const auto& task : unbatched_tasks) {
+    add_task_lengths(*task);
+  }
+
+  // Every row of the batch, including padding rows, is processed at the
+  // length of its longest sequence.
+  const int64_t padded_length = padded_batch_size * max_length;
+  if (padded_length <= 0) {
+    return;
+  }
+  const int64_t padded_elements = padded_length - total_length;
+  RecordPaddedSequenceElements(padded_elements, model_name, op_name);
+  RecordSequencePaddingFraction(
+      static_cast<double>(padded_elements) / padded_length, model_name,
+      op_name);
+}
+
 void BatchResourceBase::SplitBatchCostsAndRecordMetrics(
     const std::string& model_name,
     const std::vector<std::unique_ptr<CostMeasurement>>&
@@ -24,8 +24,11 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/request_cost.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -59,6 +62,24 @@ struct BatchResourceOptions {
   MixedPriorityBatchingPolicy mixed_priority_batching_policy;
 };
 
+// Options for batching tasks by the length of their sequences, so that batches
+// are formed of sequences of similar lengths and waste less work on padding.
+struct LengthBucketingOptions {
+  // The index, among the batched inputs, of an integer input holding the
+  // sequence length of each row (the largest value of a row, if there are
+  // several). Length bucketing is disabled if negative.
+  int32_t length_input_index = -1;
+
+  // The increasing upper bounds of the sequence lengths of each bucket. A task
+  // goes to the first bucket whose bound is at least as large as its longest
+  // sequence, or to a last bucket if there is none.
+  std::vector<int64_t> bucket_boundaries;
+
+  // If non-empty, the batch timeout of each bucket, including the last one.
+  // Otherwise all buckets use the batch timeout of the batcher queue options.
+  std::vector<int32_t> bucket_batch_timeout_micros;
+};
+
 // Base class for resource that encapsulating the state and logic for batching
 // tensors.
 class BatchResourceBase : public ResourceBase {
@@ -138,6 +159,14 @@ class BatchResourceBase : public ResourceBase {
     // batch is processed, but is not propagated to the kernel outputs.
     int forced_warmup_batch_size = 0;
 
+    // Set if `inputs` are rows of input slabs shared with other tasks, see
+    // `set_zero_copy_batching`: the slabs, one per input, and the row of the
+    // slabs where `inputs` start. `inputs_written` is notified once the
+    // inputs have been written into the rows.
+    std::vector<Tensor> input_slabs;
+    int64_t input_slab_row = 0;
+    std::shared_ptr<absl::Notification> inputs_written;
+
    protected:
     virtual std::unique_ptr<BatchTask> CreateDerivedTask() {
       return std::make_unique<BatchTask>();
@@ -183,6 +212,35 @@ class BatchResourceBase : public ResourceBase {
 
   const SessionMetadata& session_metadata() const { return session_metadata_; }
 
+  // If true, batches avoid concatenating and splitting tensors:
+  //
+  // - When a task is enqueued, it reserves rows in preallocated input slabs of
+  //   its batcher queue and writes its inputs there. Tasks reserve their rows
+  //   in the order they are scheduled in, so the tasks of a batch usually hold
+  //   consecutive rows, and the batch inputs are a slice of the slabs. Padding
+  //   rows are claimed right after the batch, if no later task holds them yet.
+  //   Slabs are reused once no tensor refers to them anymore.
+  // - A batch made of a single task that needs no padding is processed on the
+  //   task's own inputs.
+  // - Tasks get their outputs as slices aliasing the batch outputs rather than
+  //   as copies. The slices keep the whole batch outputs alive until the
+  //   outputs of all of its tasks are released.
+  //
+  // Batches whose tasks do not hold consecutive rows, e.g. because a task's
+  // inputs can't be memcpy'd or have unaligned rows, or because a later task
+  // took the padding rows, fall back to concatenation.
+  //
+  // Must be called before any input is registered.
+  void set_zero_copy_batching(bool zero_copy_batching) {
+    zero_copy_batching_ = zero_copy_batching;
+  }
+
+  // Batches tasks of each length bucket in a separate batcher queue. Padding
+  // waste metrics are recorded for the batches.
+  //
+  // Must be called before any input is registered.
+  Status SetLengthBucketingOptions(const LengthBucketingOptions& options);
+
   using CreateBatchTaskFn =
       std::function<StatusOr<std::unique_ptr<BatchTask>>()>;
 
@@ -270,6 +328,25 @@ class BatchResourceBase : public ResourceBase {
           batch_cost_measurements,
       int64_t processed_size, BatchT& batch);
 
+  // Splits `output` along the 0th dimension into tensors whose 0th dimension
+  // sizes are `sizes`. If `zero_copy` is true and every split is suitably
+  // aligned, the splits are slices that alias the buffer of `output`;
+  // otherwise they are copies.
+  static Status SplitOutputTensor(const Tensor& output,
+                                  absl::Span<const int64_t> sizes,
+                                  bool zero_copy,
+                                  std::vector<Tensor>* split_tensors);
+
+  // Records how much of the batch is padding along the sequence length
+  // dimension, given the index of the input holding the sequence lengths and
+  // the batch size after padding. Records nothing if `length_input_index` is
+  // negative.
+  static void RecordLengthPaddingWaste(
+      const BatchT& batch,
+      const std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks,
+      int length_input_index, int padded_batch_size, const string& model_name,
+      const string& op_name);
+
  private:
   // Implementation of calling the process batch function.
   virtual void ProcessFuncBatchImpl(
@@ -333,12 +410,55 @@ class BatchResourceBase : public ResourceBase {
                                 int output_index);
 
   // Looks up the batcher queue for 'queue_name'. If it did't previously exist,
-  // creates it.
-  Status LookupOrCreateBatcherQueue(const string& queue_name,
+  // creates it. A non-negative 'length_bucket' selects the options of that
+  // length bucket for the new queue.
+  Status LookupOrCreateBatcherQueue(const string& queue_name, int length_bucket,
                                     BatcherQueueT** queue);
 
+  // Returns the length bucket of 'task', or -1 if length bucketing is
+  // disabled.
+  StatusOr<int> GetLengthBucket(const BatchTask& task) const;
+
+  // Reserves rows for the inputs of 'task' in the input slabs of
+  // 'batcher_queue', and points the inputs of 'task' at them. The caller
+  // writes the inputs into the rows and notifies `task->inputs_written`.
+  // Returns false, leaving 'task' unchanged, if the inputs can't be written
+  // into input slabs.
+  bool ReserveInputSlabRows(const BatcherQueueT* batcher_queue,
+                            OpKernelContext* context, BatchTask* task)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(input_slabs_mu_);
+
+  // If the inputs of the tasks of 'batch' and 'unbatched_tasks' are
+  // consecutive rows of the same input slabs, and 'padding_amount' more rows
+  // can be claimed after them, fills those rows with padding and sets
+  // 'batch_inputs' to the rows of the batch. Returns false otherwise.
+  bool TakeBatchInputsFromSlabs(
+      const BatchT& batch,
+      const std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks,
+      int padding_amount, std::vector<Tensor>* batch_inputs) const;
+
   SessionMetadata session_metadata_;
 
+  bool zero_copy_batching_ = false;
+
+  // Buffers that the tasks of a batcher queue write their inputs into when
+  // they are enqueued, see `set_zero_copy_batching`.
+  struct InputSlabs {
+    // One buffer per input, each with `num_rows` rows.
+    std::vector<Tensor> buffers;
+    int64_t num_rows = 0;
+    // The first row that is not reserved yet.
+    int64_t next_row = 0;
+    // The buffers of earlier slabs, reused once no tensor refers to them.
+    std::vector<std::vector<Tensor>> retired;
+  };
+
+  mutable mutex input_slabs_mu_;
+  mutable absl::flat_hash_map<const BatcherQueueT*, InputSlabs> input_slabs_
+      TF_GUARDED_BY(input_slabs_mu_);
+
+  LengthBucketingOptions length_bucketing_options_;
+
   absl::Mutex outstanding_batch_mu_;
   int num_outstanding_batched_items_ TF_GUARDED_BY(outstanding_batch_mu_) = 0;
 
@@ -16,25 +16,38 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
 #include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/request_cost.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/lib/monitoring/test_utils.h"
+#include "tensorflow/core/platform/refcount.h"
 #include "tsl/platform/criticality.h"
 
 namespace tensorflow {
 namespace serving {
 namespace {
 
+using ::tensorflow::monitoring::testing::CellReader;
+using ::tensorflow::monitoring::testing::Histogram;
+using ::testing::HasSubstr;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 
@@ -294,6 +307,180 @@ TEST(SplitBatchCostsAndRecordMetricsTest, SplitOnlyNonZeroCostTypes) {
           UnorderedElementsAre(Pair("test_tpu", absl::Milliseconds(100))))));
 }
 
+TEST(SplitOutputTensorTest, SplitsAlignedTensorsWithoutCopying) {
+  Tensor output(DT_FLOAT, TensorShape({4, 16}));
+  test::FillIota<float>(&output, 0);
+
+  std::vector<Tensor> split_tensors;
+  TF_ASSERT_OK(BatchResourceBase::SplitOutputTensor(
+      output, {1, 3}, /*zero_copy=*/true, &split_tensors));
+  ASSERT_EQ(split_tensors.size(), 2);
+  test::ExpectTensorEqual<float>(split_tensors[0], output.Slice(0, 1));
+  test::ExpectTensorEqual<float>(split_tensors[1], output.Slice(1, 4));
+  EXPECT_EQ(split_tensors[0].tensor_data().data(),
+            output.tensor_data().data());
+  EXPECT_EQ(split_tensors[1].tensor_data().data(),
+            output.tensor_data().data() + 16 * sizeof(float));
+}
+
+TEST(SplitOutputTensorTest, CopiesUnalignedTensors) {
+  Tensor output(DT_FLOAT, TensorShape({4, 3}));
+  test::FillIota<float>(&output, 0);
+
+  std::vector<Tensor> split_tensors;
+  TF_ASSERT_OK(BatchResourceBase::SplitOutputTensor(
+      output, {1, 3}, /*zero_copy=*/true, &split_tensors));
+  ASSERT_EQ(split_tensors.size(), 2);
+  test::ExpectTensorEqual<float>(split_tensors[0],
+                                 test::AsTensor<float>({0, 1, 2}, {1, 3}));
+  test::ExpectTensorEqual<float>(
+      split_tensors[1],
+      test::AsTensor<float>({3, 4, 5, 6, 7, 8, 9, 10, 11}, {3, 3}));
+  EXPECT_NE(split_tensors[1].tensor_data().data(),
+            output.tensor_data().data() + 3 * sizeof(float));
+}
+
+TEST(SplitOutputTensorTest, CopiesWithoutZeroCopy) {
+  Tensor output(DT_FLOAT, TensorShape({4, 16}));
+  test::FillIota<float>(&output, 0);
+
+  std::vector<Tensor> split_tensors;
+  TF_ASSERT_OK(BatchResourceBase::SplitOutputTensor(
+      output, {2, 2}, /*zero_copy=*/false, &split_tensors));
+  ASSERT_EQ(split_tensors.size(), 2);
+  test::ExpectTensorEqual<float>(split_tensors[0], output.Slice(0, 2));
+  test::ExpectTensorEqual<float>(split_tensors[1], output.Slice(2, 4));
+  EXPECT_NE(split_tensors[0].tensor_data().data(),
+            output.tensor_data().data());
+}
+
+TEST(SplitOutputTensorTest, RejectsSizesNotAddingUpToTheBatch) {
+  Tensor output(DT_FLOAT, TensorShape({4, 16}));
+  std::vector<Tensor> split_tensors;
+  EXPECT_FALSE(BatchResourceBase::SplitOutputTensor(output, {1, 2},
+                                                    /*zero_copy=*/true,
+                                                    &split_tensors)
+                   .ok());
+}
+
+// Returns a task whose only input holds the sequence length of each row.
+std::unique_ptr<BatchResourceBase::BatchTask> MakeSequenceTask(
+    std::initializer_list<int64_t> lengths) {
+  auto task = std::make_unique<BatchResourceBase::BatchTask>();
+  task->inputs.push_back(test::AsTensor<int64_t>(lengths));
+  return task;
+}
+
+TEST(RecordLengthPaddingWasteTest, RecordsPaddedSequenceElements) {
+  CellReader<int64_t> padded_elements(
+      "/tensorflow/serving/batching/padded_sequence_elements");
+  CellReader<Histogram> padding_fraction(
+      "/tensorflow/serving/batching/sequence_padding_fraction");
+
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeSequenceTask({2, 4}));
+  batch.AddTask(MakeSequenceTask({3}));
+  batch.Close();
+  std::vector<std::unique_ptr<BatchResourceBase::BatchTask>> unbatched_tasks;
+  unbatched_tasks.push_back(MakeSequenceTask({1}));
+
+  // The 4 rows holding 10 sequence elements are padded to 6 rows of the
+  // longest sequence length, i.e. 24 sequence elements.
+  BatchResourceBase::RecordLengthPaddingWaste(
+      batch, unbatched_tasks, /*length_input_index=*/0,
+      /*padded_batch_size=*/6, "model_name", "op_name");
+
+  EXPECT_EQ(padded_elements.Delta("model_name", "op_name"), 14);
+  const Histogram fraction = padding_fraction.Delta("model_name", "op_name");
+  EXPECT_FLOAT_EQ(fraction.num(), 1.0);
+  EXPECT_FLOAT_EQ(fraction.sum(), 14.0 / 24.0);
+}
+
+TEST(RecordLengthPaddingWasteTest, SkipWithoutLengthBucketing) {
+  CellReader<int64_t> padded_elements(
+      "/tensorflow/serving/batching/padded_sequence_elements");
+  CellReader<Histogram> padding_fraction(
+      "/tensorflow/serving/batching/sequence_padding_fraction");
+
+  BatchResourceBase::BatchT batch;
+  batch.AddTask(MakeSequenceTask({2, 4}));
+  batch.Close();
+
+  BatchResourceBase::RecordLengthPaddingWaste(
+      batch, /*unbatched_tasks=*/{}, /*length_input_index=*/-1,
+      /*padded_batch_size=*/4, "model_name", "op_name");
+
+  EXPECT_EQ(padded_elements.Delta("model_name", "op_name"), 0);
+  EXPECT_FLOAT_EQ(padding_fraction.Delta("model_name", "op_name").num(), 0.0);
+}
+
+class TestBatchResource : public BatchResourceBase {
+ public:
+  explicit TestBatchResource(std::shared_ptr<BatcherT> batcher)
+      : BatchResourceBase(/*has_process_batch_function=*/false,
+                          std::move(batcher), BatcherT::QueueOptions(),
+                          /*allowed_batch_sizes=*/{}) {}
+
+  string DebugString() const override { return "TestBatchResource"; }
+
+ private:
+  void ProcessFuncBatchImpl(
+      const BatchResourceBase::BatchTask& last_task,
+      absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+      std::function<void(const Status&)> done) const override {
+    done(absl::UnimplementedError("Batches are not processed in this test"));
+  }
+};
+
+class SetLengthBucketingOptionsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::shared_ptr<BatchResourceBase::BatcherT> batcher;
+    TF_ASSERT_OK(BatchResourceBase::BatcherT::Create(
+        BatchResourceBase::BatcherT::Options(), &batcher));
+    resource_.reset(new TestBatchResource(std::move(batcher)));
+  }
+
+  core::RefCountPtr<TestBatchResource> resource_;
+};
+
+TEST_F(SetLengthBucketingOptionsTest, AcceptsTimeoutForEachBucket) {
+  LengthBucketingOptions options;
+  options.length_input_index = 0;
+  options.bucket_boundaries = {8, 32};
+  options.bucket_batch_timeout_micros = {100, 1000, 10000};
+  TF_EXPECT_OK(resource_->SetLengthBucketingOptions(options));
+}
+
+TEST_F(SetLengthBucketingOptionsTest, RejectsNonIncreasingBoundaries) {
+  LengthBucketingOptions options;
+  options.length_input_index = 0;
+  options.bucket_boundaries = {8, 8};
+  const Status status = resource_->SetLengthBucketingOptions(options);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("strictly increasing"));
+}
+
+TEST_F(SetLengthBucketingOptionsTest, RejectsWrongNumberOfTimeouts) {
+  LengthBucketingOptions options;
+  options.length_input_index = 0;
+  options.bucket_boundaries = {8, 32};
+  options.bucket_batch_timeout_micros = {100, 1000};
+  const Status status = resource_->SetLengthBucketingOptions(options);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("3 length buckets"));
+}
+
+TEST_F(SetLengthBucketingOptionsTest, RejectsNegativeTimeout) {
+  LengthBucketingOptions options;
+  options.length_input_index = 0;
+  options.bucket_boundaries = {8};
+  options.bucket_batch_timeout_micros = {100, -1};
+  const Status status = resource_->SetLengthBucketingOptions(options);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_THAT(status.message(), HasSubstr("non-negative"));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,177 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_aware_batching_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The number of most recent batch latencies kept for each padded batch size.
+constexpr int kNumLatencySamples = 100;
+
+// The weight of the latest inter-arrival time in the moving average.
+constexpr double kArrivalSmoothing = 0.2;
+
+}  // namespace
+
+LatencyAwareBatchingPolicy::LatencyAwareBatchingPolicy(const Options& options)
+    : options_(options) {
+  if (!options_.disable_padding && !options_.allowed_batch_sizes.empty()) {
+    for (int32 allowed_batch_size : options_.allowed_batch_sizes) {
+      if (allowed_batch_size < options_.max_batch_size) {
+        padded_batch_sizes_.push_back(allowed_batch_size);
+      }
+    }
+  } else {
+    for (int64_t batch_size = 1; batch_size < options_.max_batch_size;
+         batch_size *= 2) {
+      padded_batch_sizes_.push_back(batch_size);
+    }
+  }
+  padded_batch_sizes_.push_back(std::max<int64_t>(options_.max_batch_size, 1));
+  latencies_.resize(padded_batch_sizes_.size());
+}
+
+void LatencyAwareBatchingPolicy::RecordTaskArrival(int64_t task_size,
+                                                   uint64 now_micros) {
+  if (task_size <= 0) {
+    return;
+  }
+  if (num_arrivals_ > 0) {
+    const double gap_micros =
+        now_micros > last_arrival_micros_ ? now_micros - last_arrival_micros_
+                                          : 0;
+    const double micros_per_unit = gap_micros / task_size;
+    micros_per_unit_ = num_arrivals_ == 1
+                           ? micros_per_unit
+                           : kArrivalSmoothing * micros_per_unit +
+                                 (1 - kArrivalSmoothing) * micros_per_unit_;
+  }
+  last_arrival_micros_ = std::max(last_arrival_micros_, now_micros);
+  ++num_arrivals_;
+}
+
+void LatencyAwareBatchingPolicy::RecordBatchLatency(int64_t batch_size,
+                                                    int64_t latency_micros) {
+  if (batch_size <= 0) {
+    return;
+  }
+  LatencySamples& latencies = latencies_[PaddedBatchSizeIndex(batch_size)];
+  if (latencies.samples.size() < kNumLatencySamples) {
+    latencies.samples.push_back(latency_micros);
+  } else {
+    latencies.samples[latencies.next] = latency_micros;
+    latencies.next = (latencies.next + 1) % kNumLatencySamples;
+  }
+  std::vector<int64_t> sorted_samples = latencies.samples;
+  const int p99_index = std::ceil(0.99 * sorted_samples.size()) - 1;
+  std::nth_element(sorted_samples.begin(), sorted_samples.begin() + p99_index,
+                   sorted_samples.end());
+  latencies.p99 = sorted_samples[p99_index];
+}
+
+bool LatencyAwareBatchingPolicy::ShouldCloseBatch(
+    int64_t batch_size, uint64 open_batch_start_micros,
+    uint64 now_micros) const {
+  if (batch_size <= 0) {
+    return false;
+  }
+  if (batch_size >= options_.max_batch_size) {
+    return true;
+  }
+  const int64_t waited_micros = now_micros > open_batch_start_micros
+                                    ? now_micros - open_batch_start_micros
+                                    : 0;
+  if (options_.max_batch_timeout_micros > 0 &&
+      waited_micros >= options_.max_batch_timeout_micros) {
+    return true;
+  }
+  const int index = PaddedBatchSizeIndex(batch_size);
+  if (EstimatedLatencyAtIndex(index) < 0 || num_arrivals_ < 2) {
+    // Nothing to base a decision on yet.
+    return waited_micros >= options_.max_batch_timeout_micros;
+  }
+
+  // Keeps the batch open if it can grow to a larger padded batch size in time
+  // for its first task to meet the target.
+  const double micros_per_unit = ExpectedMicrosPerUnit(now_micros);
+  for (int i = index; i < padded_batch_sizes_.size(); ++i) {
+    if (padded_batch_sizes_[i] <= batch_size) {
+      continue;
+    }
+    const double fill_micros =
+        (padded_batch_sizes_[i] - batch_size) * micros_per_unit;
+    if (waited_micros + fill_micros + EstimatedLatencyAtIndex(i) <=
+        options_.target_latency_micros) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64_t LatencyAwareBatchingPolicy::EstimatedBatchLatencyMicros(
+    int64_t batch_size) const {
+  return EstimatedLatencyAtIndex(PaddedBatchSizeIndex(batch_size));
+}
+
+int LatencyAwareBatchingPolicy::PaddedBatchSizeIndex(int64_t batch_size) const {
+  const auto it = std::lower_bound(padded_batch_sizes_.begin(),
+                                   padded_batch_sizes_.end(), batch_size);
+  if (it == padded_batch_sizes_.end()) {
+    return padded_batch_sizes_.size() - 1;
+  }
+  return it - padded_batch_sizes_.begin();
+}
+
+int64_t LatencyAwareBatchingPolicy::EstimatedLatencyAtIndex(int index) const {
+  if (latencies_[index].p99 >= 0) {
+    return latencies_[index].p99;
+  }
+  // Smaller batches are assumed to be no slower than larger ones.
+  for (int i = index + 1; i < latencies_.size(); ++i) {
+    if (latencies_[i].p99 >= 0) {
+      return latencies_[i].p99;
+    }
+  }
+  // Larger batches are assumed to be at most proportionally slower.
+  for (int i = index - 1; i >= 0; --i) {
+    if (latencies_[i].p99 >= 0) {
+      return latencies_[i].p99 * padded_batch_sizes_[index] /
+             padded_batch_sizes_[i];
+    }
+  }
+  return -1;
+}
+
+double LatencyAwareBatchingPolicy::ExpectedMicrosPerUnit(
+    uint64 now_micros) const {
+  // The time since the last arrival bounds the next inter-arrival time, which
+  // lets the estimate catch up when traffic stops.
+  const double micros_since_last_arrival =
+      now_micros > last_arrival_micros_ ? now_micros - last_arrival_micros_
+                                        : 0;
+  return std::max(micros_per_unit_, micros_since_last_arrival);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,131 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_AWARE_BATCHING_POLICY_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_AWARE_BATCHING_POLICY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Decides when a batch scheduler queue should close its open batch, so that
+// tasks complete within a latency target while batches stay as large as the
+// target allows.
+//
+// The policy tracks the 99th percentile processing latency of recent batches
+// of each padded batch size, and the rate at which task sizes arrive. The open
+// batch is kept open as long as waiting for it to grow to a larger padded
+// batch size would still let its oldest task complete within the target, and
+// is closed otherwise. Closing batches at padded batch sizes also avoids
+// processing padding.
+//
+// Batch sizes without latency measurements are estimated from the nearest
+// measured batch size, assuming that smaller batches are not slower and that
+// latency grows at most linearly with the batch size. Until both a latency
+// measurement and an arrival rate are available, the policy behaves like a
+// static batch timeout of `max_batch_timeout_micros`.
+//
+// The time it takes for a batch thread to become available is not modeled, so
+// queues should have enough batch threads to keep up with their traffic.
+//
+// This class is not thread-safe.
+class LatencyAwareBatchingPolicy {
+ public:
+  struct Options {
+    // The target for the 99th percentile of the time from the enqueueing of a
+    // task until its batch is processed. Must be positive.
+    int64_t target_latency_micros = 0;
+
+    // If positive, an upper bound on the time the first task of a batch waits
+    // for the batch to be closed.
+    int64_t max_batch_timeout_micros = 0;
+
+    // The maximum size of a batch.
+    int64_t max_batch_size = 0;
+
+    // The batch sizes that batches are padded to, if non-empty and
+    // `disable_padding` is false. Otherwise latencies are tracked for powers of
+    // two up to `max_batch_size`.
+    std::vector<int32> allowed_batch_sizes;
+    bool disable_padding = false;
+  };
+
+  explicit LatencyAwareBatchingPolicy(const Options& options);
+
+  // Records that a task of `task_size` was enqueued at `now_micros`.
+  void RecordTaskArrival(int64_t task_size, uint64 now_micros);
+
+  // Records that processing a batch of `batch_size` took `latency_micros`.
+  void RecordBatchLatency(int64_t batch_size, int64_t latency_micros);
+
+  // Returns whether an open batch of `batch_size` whose first task was
+  // enqueued at `open_batch_start_micros` should be closed at `now_micros`.
+  bool ShouldCloseBatch(int64_t batch_size, uint64 open_batch_start_micros,
+                        uint64 now_micros) const;
+
+  // Returns the estimated 99th percentile latency of processing a batch of
+  // `batch_size`, or -1 if no batch latency has been recorded yet.
+  int64_t EstimatedBatchLatencyMicros(int64_t batch_size) const;
+
+  // Returns the batch sizes for which latencies are tracked, in increasing
+  // order.
+  const std::vector<int64_t>& padded_batch_sizes() const {
+    return padded_batch_sizes_;
+  }
+
+ private:
+  // The latencies of the most recent batches of one padded batch size.
+  struct LatencySamples {
+    std::vector<int64_t> samples;
+    // Index of the sample to overwrite once `samples` is full.
+    int next = 0;
+    // The 99th percentile of `samples`, or -1 if there are none.
+    int64_t p99 = -1;
+  };
+
+  // Returns the index in `padded_batch_sizes_` of the size that a batch of
+  // `batch_size` is padded to.
+  int PaddedBatchSizeIndex(int64_t batch_size) const;
+
+  // Returns the estimated latency of processing a batch padded to
+  // `padded_batch_sizes_[index]`, or -1 if unknown.
+  int64_t EstimatedLatencyAtIndex(int index) const;
+
+  // Returns the expected time between the arrival of two units of task size,
+  // as of `now_micros`.
+  double ExpectedMicrosPerUnit(uint64 now_micros) const;
+
+  const Options options_;
+
+  std::vector<int64_t> padded_batch_sizes_;
+
+  // Indexed like `padded_batch_sizes_`.
+  std::vector<LatencySamples> latencies_;
+
+  // Exponential moving average of the time between task arrivals, divided by
+  // the size of the arriving task.
+  double micros_per_unit_ = 0;
+  uint64 last_arrival_micros_ = 0;
+  int64_t num_arrivals_ = 0;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_AWARE_BATCHING_POLICY_H_
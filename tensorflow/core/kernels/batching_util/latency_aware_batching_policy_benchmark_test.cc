@@ -0,0 +1,245 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks for task latency and throughput of batches closed by static batch
+// timeouts and by LatencyAwareBatchingPolicy, on replayed traffic whose rate
+// shifts over time.
+//
+// The benchmarks simulate a queue served by one batch thread on a fake clock,
+// so that they measure the batching decisions rather than the machine they
+// run on.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/kernels/batching_util/latency_aware_batching_policy.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::tensorflow::histogram::Histogram;
+
+constexpr int kMaxBatchSize = 64;
+constexpr int64_t kTickMicros = 10;
+
+// Batches take a fixed time plus a time per (padded) task to process.
+constexpr int64_t kFixedBatchLatencyMicros = 2000;
+constexpr int64_t kTaskLatencyMicros = 50;
+
+const std::vector<int32>& AllowedBatchSizes() {
+  static const auto* allowed_batch_sizes =
+      new std::vector<int32>{8, 16, 32, kMaxBatchSize};
+  return *allowed_batch_sizes;
+}
+
+// A period of traffic with Poisson arrivals.
+struct TrafficPhase {
+  int64_t duration_micros;
+  double tasks_per_second;
+};
+
+// Returns the arrival times of tasks going through `phases` in order.
+std::vector<uint64> MakeArrivals(const std::vector<TrafficPhase>& phases) {
+  std::mt19937 rng(/*seed=*/0);
+  std::vector<uint64> arrivals;
+  uint64 phase_start_micros = 0;
+  for (const TrafficPhase& phase : phases) {
+    std::exponential_distribution<double> interval_micros(
+        phase.tasks_per_second / 1e6);
+    double arrival_micros = phase_start_micros;
+    while (true) {
+      arrival_micros += interval_micros(rng);
+      if (arrival_micros >= phase_start_micros + phase.duration_micros) break;
+      arrivals.push_back(arrival_micros);
+    }
+    phase_start_micros += phase.duration_micros;
+  }
+  return arrivals;
+}
+
+// Replays arrivals against a simulated queue whose open batch is closed either
+// after `batch_timeout_micros`, or per a LatencyAwareBatchingPolicy if
+// `target_latency_micros` is positive.
+class ReplayBenchmark {
+ public:
+  ReplayBenchmark(int64_t batch_timeout_micros, int64_t target_latency_micros)
+      : env_(Env::Default()), batch_timeout_micros_(batch_timeout_micros) {
+    if (target_latency_micros > 0) {
+      LatencyAwareBatchingPolicy::Options options;
+      options.target_latency_micros = target_latency_micros;
+      options.max_batch_timeout_micros = batch_timeout_micros;
+      options.max_batch_size = kMaxBatchSize;
+      options.allowed_batch_sizes = AllowedBatchSizes();
+      policy_ = std::make_unique<LatencyAwareBatchingPolicy>(options);
+    }
+  }
+
+  ReplayBenchmark(const ReplayBenchmark&) = delete;
+  ReplayBenchmark& operator=(const ReplayBenchmark&) = delete;
+
+  void Replay(const std::vector<uint64>& arrivals);
+
+  // Returns latency, batch size and throughput stats.
+  string Report() const;
+
+ private:
+  bool ShouldCloseBatch(uint64 now_micros) const;
+
+  // Processes the batch at the front of `closed_batches_` at `now_micros`.
+  void ProcessBatch(uint64 now_micros);
+
+  test_util::FakeClockEnv env_;
+  const int64_t batch_timeout_micros_;
+  std::unique_ptr<LatencyAwareBatchingPolicy> policy_;
+
+  // The arrival times of the tasks of the open batch, and of closed batches.
+  std::vector<uint64> open_batch_;
+  uint64 open_batch_start_micros_ = 0;
+  std::vector<std::vector<uint64>> closed_batches_;
+  uint64 busy_until_micros_ = 0;
+
+  Histogram task_latency_millis_histogram_;
+  Histogram batch_size_histogram_;
+  int64_t num_tasks_ = 0;
+  int64_t num_padded_tasks_ = 0;
+};
+
+void ReplayBenchmark::Replay(const std::vector<uint64>& arrivals) {
+  size_t next_arrival = 0;
+  while (next_arrival < arrivals.size() || !open_batch_.empty() ||
+         !closed_batches_.empty()) {
+    const uint64 now_micros = env_.NowMicros();
+    for (; next_arrival < arrivals.size() &&
+           arrivals[next_arrival] <= now_micros;
+         ++next_arrival) {
+      if (open_batch_.size() == kMaxBatchSize) {
+        closed_batches_.push_back(std::move(open_batch_));
+        open_batch_.clear();
+      }
+      if (open_batch_.empty()) {
+        open_batch_start_micros_ = now_micros;
+      }
+      open_batch_.push_back(arrivals[next_arrival]);
+      if (policy_ != nullptr) {
+        policy_->RecordTaskArrival(1, now_micros);
+      }
+    }
+    if (now_micros >= busy_until_micros_) {
+      if (closed_batches_.empty() && ShouldCloseBatch(now_micros)) {
+        closed_batches_.push_back(std::move(open_batch_));
+        open_batch_.clear();
+      }
+      if (!closed_batches_.empty()) {
+        ProcessBatch(now_micros);
+      }
+    }
+    env_.AdvanceByMicroseconds(kTickMicros);
+  }
+}
+
+bool ReplayBenchmark::ShouldCloseBatch(uint64 now_micros) const {
+  if (open_batch_.empty()) {
+    return false;
+  }
+  if (policy_ != nullptr) {
+    return policy_->ShouldCloseBatch(open_batch_.size(),
+                                     open_batch_start_micros_, now_micros);
+  }
+  return open_batch_.size() >= kMaxBatchSize ||
+         now_micros >= open_batch_start_micros_ + batch_timeout_micros_;
+}
+
+void ReplayBenchmark::ProcessBatch(uint64 now_micros) {
+  const std::vector<uint64> batch = std::move(closed_batches_.front());
+  closed_batches_.erase(closed_batches_.begin());
+  const int padded_batch_size = GetNextAllowedBatchSize(
+      batch.size(), AllowedBatchSizes(), /*disable_padding=*/false);
+  const int64_t batch_latency_micros =
+      kFixedBatchLatencyMicros + kTaskLatencyMicros * padded_batch_size;
+  busy_until_micros_ = now_micros + batch_latency_micros;
+  if (policy_ != nullptr) {
+    policy_->RecordBatchLatency(batch.size(), batch_latency_micros);
+  }
+  for (uint64 arrival_micros : batch) {
+    task_latency_millis_histogram_.Add((busy_until_micros_ - arrival_micros) /
+                                       1000.0);
+  }
+  batch_size_histogram_.Add(batch.size());
+  num_tasks_ += batch.size();
+  num_padded_tasks_ += padded_batch_size - batch.size();
+}
+
+string ReplayBenchmark::Report() const {
+  return absl::StrCat(
+      "lat_p50=", task_latency_millis_histogram_.Percentile(50),
+      "ms,lat_p99=", task_latency_millis_histogram_.Percentile(99),
+      "ms,batchsz_p50=", batch_size_histogram_.Median(),
+      ",padding=", 1.0 * num_padded_tasks_ / (num_tasks_ + num_padded_tasks_),
+      ",qps=", num_tasks_ * 1e6 / busy_until_micros_);
+}
+
+// Replays 1s of low traffic, 1s of traffic close to the capacity of the
+// simulated batch thread, and 1s of low traffic again.
+//
+// Compares static batch timeouts (target_latency == 0) with the latency aware
+// policy, which should keep the 99th percentile latency under its target
+// across traffic shifts.
+void ReplayTrafficBM(::testing::benchmark::State& state) {
+  const std::vector<uint64> arrivals = MakeArrivals({
+      {/*duration_micros=*/1000 * 1000, /*tasks_per_second=*/1000},
+      {/*duration_micros=*/1000 * 1000, /*tasks_per_second=*/8000},
+      {/*duration_micros=*/1000 * 1000, /*tasks_per_second=*/1000},
+  });
+  std::unique_ptr<ReplayBenchmark> bm;
+  for (auto s : state) {
+    bm = std::make_unique<ReplayBenchmark>(state.range(0), state.range(1));
+    bm->Replay(arrivals);
+  }
+  state.SetItemsProcessed(state.iterations() * arrivals.size());
+  state.SetLabel(bm->Report());
+}
+BENCHMARK(ReplayTrafficBM)
+    ->Iterations(1)
+    ->ArgNames({"timeout", "target_latency"})
+    ->Args({0, 0})
+    ->Args({2000, 0})
+    ->Args({10000, 0})
+    ->Args({0, 10000})
+    ->Args({0, 20000})
+    ->Args({10000, 20000});
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  ::benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
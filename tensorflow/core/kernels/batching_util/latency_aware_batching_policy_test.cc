@@ -0,0 +1,145 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_aware_batching_policy.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+
+LatencyAwareBatchingPolicy::Options MakeOptions(
+    int64_t target_latency_micros, int64_t max_batch_timeout_micros,
+    int64_t max_batch_size) {
+  LatencyAwareBatchingPolicy::Options options;
+  options.target_latency_micros = target_latency_micros;
+  options.max_batch_timeout_micros = max_batch_timeout_micros;
+  options.max_batch_size = max_batch_size;
+  return options;
+}
+
+TEST(LatencyAwareBatchingPolicyTest, PaddedBatchSizes) {
+  EXPECT_THAT(LatencyAwareBatchingPolicy(MakeOptions(1000, 0, 10))
+                  .padded_batch_sizes(),
+              ElementsAre(1, 2, 4, 8, 10));
+
+  LatencyAwareBatchingPolicy::Options options = MakeOptions(1000, 0, 12);
+  options.allowed_batch_sizes = {2, 6, 12};
+  EXPECT_THAT(LatencyAwareBatchingPolicy(options).padded_batch_sizes(),
+              ElementsAre(2, 6, 12));
+
+  options.disable_padding = true;
+  EXPECT_THAT(LatencyAwareBatchingPolicy(options).padded_batch_sizes(),
+              ElementsAre(1, 2, 4, 8, 12));
+}
+
+TEST(LatencyAwareBatchingPolicyTest, UsesTimeoutWithoutMeasurements) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 100, 8));
+  policy.RecordTaskArrival(1, 0);
+  EXPECT_FALSE(policy.ShouldCloseBatch(1, 0, 99));
+  EXPECT_TRUE(policy.ShouldCloseBatch(1, 0, 100));
+  EXPECT_FALSE(policy.ShouldCloseBatch(0, 0, 100));
+
+  LatencyAwareBatchingPolicy no_timeout_policy(MakeOptions(1000, 0, 8));
+  EXPECT_TRUE(no_timeout_policy.ShouldCloseBatch(1, 0, 0));
+}
+
+TEST(LatencyAwareBatchingPolicyTest, ClosesFullBatches) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 100, 8));
+  EXPECT_TRUE(policy.ShouldCloseBatch(8, 0, 0));
+}
+
+TEST(LatencyAwareBatchingPolicyTest, EstimatesUnmeasuredBatchSizes) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 0, 8));
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(4), -1);
+
+  policy.RecordBatchLatency(4, 400);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(1), 400);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(3), 400);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(4), 400);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(8), 800);
+
+  // Batches of 3 are padded to 4.
+  policy.RecordBatchLatency(3, 200);
+  policy.RecordBatchLatency(2, 100);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(1), 100);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(4), 400);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(5), 800);
+}
+
+TEST(LatencyAwareBatchingPolicyTest, EstimatesP99OfRecentLatencies) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 0, 8));
+  for (int i = 0; i < 98; ++i) {
+    policy.RecordBatchLatency(8, 100);
+  }
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(8), 100);
+  policy.RecordBatchLatency(8, 1000);
+  policy.RecordBatchLatency(8, 1000);
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(8), 1000);
+
+  // Old latencies are forgotten.
+  for (int i = 0; i < 100; ++i) {
+    policy.RecordBatchLatency(8, 100);
+  }
+  EXPECT_EQ(policy.EstimatedBatchLatencyMicros(8), 100);
+}
+
+TEST(LatencyAwareBatchingPolicyTest, WaitsWhileALargerBatchMeetsTheTarget) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 0, 8));
+  policy.RecordBatchLatency(1, 100);
+  policy.RecordTaskArrival(1, 0);
+  policy.RecordTaskArrival(1, 100);
+
+  // A batch of 2 is expected in 100us, and to take 200us.
+  EXPECT_FALSE(policy.ShouldCloseBatch(1, 100, 100));
+  EXPECT_FALSE(policy.ShouldCloseBatch(1, 100, 400));
+  // After 600us without arrivals, a batch of 2 is no longer expected in time.
+  EXPECT_TRUE(policy.ShouldCloseBatch(1, 100, 700));
+
+  // A batch of 4 is expected in 160us, and to take 400us.
+  policy.RecordTaskArrival(1, 100);
+  EXPECT_FALSE(policy.ShouldCloseBatch(2, 100, 100));
+  EXPECT_TRUE(policy.ShouldCloseBatch(2, 100, 600));
+}
+
+TEST(LatencyAwareBatchingPolicyTest, ClosesBatchesThatWouldMissTheTarget) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 0, 8));
+  policy.RecordBatchLatency(2, 2000);
+  for (int i = 0; i < 10; ++i) {
+    policy.RecordTaskArrival(1, 0);
+  }
+  EXPECT_TRUE(policy.ShouldCloseBatch(1, 0, 0));
+}
+
+TEST(LatencyAwareBatchingPolicyTest, ObeysMaxTimeout) {
+  LatencyAwareBatchingPolicy policy(MakeOptions(1000, 50, 8));
+  policy.RecordBatchLatency(8, 100);
+  policy.RecordTaskArrival(1, 0);
+  policy.RecordTaskArrival(1, 10);
+  EXPECT_FALSE(policy.ShouldCloseBatch(1, 10, 59));
+  EXPECT_TRUE(policy.ShouldCloseBatch(1, 10, 60));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
+#include "tensorflow/core/kernels/batching_util/latency_aware_batching_policy.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -240,6 +241,17 @@ class SharedBatchScheduler
     // If true, the padding will not be appended.
     bool disable_padding = false;
 
+    // If positive, the queue decides when to close a batch based on the
+    // measured processing latency of each batch size and on the arrival rate
+    // of tasks, instead of a static timeout: batches grow towards the largest
+    // allowed batch size that still lets their tasks be processed within this
+    // target (see LatencyAwareBatchingPolicy). `batch_timeout_micros` then
+    // only bounds how long a batch is kept open, if positive.
+    //
+    // Processing latency is measured around the process-batch callback, which
+    // is expected to return once the batch has been processed.
+    int64_t target_latency_micros = 0;
+
     // If true, queue implementation would split high priority and low priority
     // inputs into two sub queues.
     bool enable_priority_queue = false;
@@ -476,6 +488,12 @@ class Queue {
   bool IsOpenBatchSchedulableAfterEagerSplit() const
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Determines whether a non-full open batch of `open_batch_size` has waited
+  // long enough to be closed, either per `batching_policy_` or per the batch
+  // timeout.
+  bool IsOpenBatchDue(size_t open_batch_size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Determines whether the low priority tasks in `low_priority_tasks_` can form
   // a batch on their own. If yes, returns a batch that is ready to be
   // processed. Otherwise, returns an empty unique_ptr.
@@ -594,6 +612,11 @@ class Queue {
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
 
+  // Decides when to close the open batch. Non-null iff
+  // `QueueOptions.target_latency_micros` is positive.
+  std::unique_ptr<LatencyAwareBatchingPolicy> batching_policy_
+      TF_GUARDED_BY(mu_);
+
   // The number of batches currently being processed by batch threads.
   // Incremented in ScheduleBatch() and decremented in ProcessBatch().
   int num_batches_being_processed_ TF_GUARDED_BY(mu_) = 0;
@@ -707,6 +730,11 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "max_enqueued_batches must be positive; was ",
         options.max_enqueued_batches);
   }
+  if (options.target_latency_micros < 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be non-negative; was ",
+        options.target_latency_micros);
+  }
 
   if (options.enable_large_batch_splitting &&
       options.split_input_task_func == nullptr) {
@@ -888,6 +916,16 @@ Queue<TaskType>::Queue(
   // the same traceme_context_id_counter_.
   traceme_context_id_counter_ = (absl::GetCurrentTimeNanos() & 0xFFFFFFFF)
                                 << 32;
+  if (options_.target_latency_micros > 0) {
+    LatencyAwareBatchingPolicy::Options policy_options;
+    policy_options.target_latency_micros = options_.target_latency_micros;
+    policy_options.max_batch_timeout_micros = options_.batch_timeout_micros;
+    policy_options.max_batch_size = max_execution_batch_size_;
+    policy_options.allowed_batch_sizes = options_.allowed_batch_sizes;
+    policy_options.disable_padding = options_.disable_padding;
+    batching_policy_ =
+        std::make_unique<LatencyAwareBatchingPolicy>(policy_options);
+  }
   // Create an initial, open batch.
   if (options_.enable_lazy_split) {
     task_handle_batches_.emplace_back(
@@ -935,6 +973,9 @@ Status Queue<TaskType>::ScheduleWithLazySplit(std::unique_ptr<TaskType>* task) {
     DCHECK(!closed_);
 
     TF_RETURN_IF_ERROR(ValidateBatchTaskQueueCapacity((*task).get()));
+    if (batching_policy_ != nullptr) {
+      batching_policy_->RecordTaskArrival((*task)->size(), env_->NowMicros());
+    }
 
     const int64 open_batch_capacity =
         max_execution_batch_size - this->tail_batch_task_size();
@@ -1016,6 +1057,9 @@ Status Queue<TaskType>::ScheduleWithoutOrEagerSplitImpl(
       max_execution_batch_size() - batches.back()->size();
 
   const int64_t input_task_size = (*task)->size();
+  if (batching_policy_ != nullptr) {
+    batching_policy_->RecordTaskArrival(input_task_size, env_->NowMicros());
+  }
 
   std::vector<std::unique_ptr<TaskType>> output_tasks;
 
@@ -1335,6 +1379,11 @@ void Queue<TaskType>::ProcessBatch(
       profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
 
+  size_t processed_batch_size = batch->size();
+  for (const std::unique_ptr<TaskType>& task : padding_task) {
+    processed_batch_size += task->size();
+  }
+  const uint64 start_time_micros = env_->NowMicros();
   if (std::holds_alternative<ProcessBatchCallbackWithoutPaddingTasks>(
           process_batch_callback_)) {
     std::get<ProcessBatchCallbackWithoutPaddingTasks>(process_batch_callback_)(
@@ -1344,8 +1393,14 @@ void Queue<TaskType>::ProcessBatch(
         std::move(batch), std::move(padding_task));
   }
 
+  const uint64 end_time_micros = env_->NowMicros();
+
   {
     mutex_lock l(mu_);
+    if (batching_policy_ != nullptr) {
+      batching_policy_->RecordBatchLatency(
+          processed_batch_size, end_time_micros - start_time_micros);
+    }
     --num_batches_being_processed_;
     if (empty_notification_ != nullptr && IsEmptyInternal()) {
       empty_notification_->Notify();
@@ -1418,8 +1473,7 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchDue(open_batch->size());
 }
 
 template <typename TaskType>
@@ -1433,8 +1487,17 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchDue(open_batch->size());
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchDue(size_t open_batch_size) const {
+  if (batching_policy_ != nullptr) {
+    return batching_policy_->ShouldCloseBatch(
+        open_batch_size, open_batch_start_time_micros_, env_->NowMicros());
+  }
+  return env_->NowMicros() >=
+         open_batch_start_time_micros_ + options_.batch_timeout_micros;
 }
 
 template <typename TaskType>
@@ -692,6 +692,66 @@ TEST_P(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   second_batch_processed.WaitForNotification();
 }
 
+TEST_P(SharedBatchSchedulerTest, ClosesBatchesPerTargetLatency) {
+  // Set up a fake clock, which only advances when we explicitly tell it to.
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<size_t> batch_sizes;
+    Notification first_batch_processed, second_batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      // Each batch takes 100us to process.
+      env.AdvanceByMicroseconds(100);
+      mutex_lock l(mu);
+      batch_sizes.push_back(batch->size());
+      if (batch_sizes.size() == 1) {
+        first_batch_processed.Notify();
+      } else if (batch_sizes.size() == 2) {
+        second_batch_processed.Notify();
+      }
+    };
+
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+
+    QueueOptions options =
+        CreateQueueOptions(/*max_execution_batch_size=*/8,
+                           /*input_batch_size_limit=*/8,
+                           /*batch_timeout_micros=*/0,
+                           /*max_enqueued_batches=*/10);
+    options.target_latency_micros = 1000;
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // Without latency measurements, the first batch is scheduled right away.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    first_batch_processed.WaitForNotification();
+    // Let the queue record the latency of the first batch.
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+
+    // Tasks arriving every 100us or less can form a batch of 4 before the
+    // target.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(second_batch_processed.HasBeenNotified());
+
+    // Once arrivals stop, the batch is closed in time for the target.
+    env.AdvanceByMicroseconds(500);
+    second_batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(batch_sizes, std::vector<size_t>({1, 2}));
+    }
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST_P(SharedBatchSchedulerTest,
        WithZeroTimeoutBatchesScheduledAsSoonAsThreadIsAvailable) {
   // Set up a fake clock, and never advance the time.
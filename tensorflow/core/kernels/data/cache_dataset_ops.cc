@@ -17,6 +17,9 @@ limitations under the License.
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -28,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/dataset_options.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -37,7 +41,9 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
@@ -70,6 +76,13 @@ constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
+// Upper bound on the bytes of elements an in-memory cache holds in memory.
+// Elements beyond it are spilled to a file in `kSpillDirectoryEnvVar`, which
+// defaults to the first local temporary directory. Zero means no limit.
+constexpr char kMemoryBudgetEnvVar[] = "TF_DATA_CACHE_MEMORY_BUDGET_BYTES";
+constexpr char kSpillDirectoryEnvVar[] = "TF_DATA_CACHE_SPILL_DIR";
+// Number of spilled elements a reader decompresses ahead of its position.
+constexpr size_t kSpillReadAheadElements = 8;
 constexpr char kIncompleteCacheErrorMessage[] =
     "The calling iterator did not fully read the dataset being cached. In "
     "order to avoid unexpected truncation of the dataset, the partially cached "
@@ -165,6 +178,110 @@ class IteratorRandomAccessCache {
   std::vector<std::vector<Tensor>> cache_;
 };
 
+// Accumulates the elements of a memory cache, holding them in memory until
+// they reach the memory budget and spilling the remaining ones to disk.
+class MemoryCacheBuilder {
+ public:
+  MemoryCacheBuilder(int64_t memory_budget_bytes,
+                     const std::string& spill_directory)
+      : memory_budget_bytes_(memory_budget_bytes),
+        spill_directory_(spill_directory) {}
+
+  // Appends `element` to the cache. `in_memory` is set to whether the element
+  // is held in memory.
+  Status Add(Env* env, const std::vector<Tensor>& element, bool* in_memory) {
+    *in_memory = false;
+    if (spill_ == nullptr) {
+      const int64_t bytes = GetTotalBytes(element);
+      if (memory_budget_bytes_ <= 0 ||
+          memory_bytes_ + bytes <= memory_budget_bytes_) {
+        elements_.push_back(element);
+        memory_bytes_ += bytes;
+        *in_memory = true;
+        return absl::OkStatus();
+      }
+      VLOG(2) << "Spilling cache elements after " << elements_.size()
+              << " elements (" << memory_bytes_ << " bytes) were cached in "
+              << "memory.";
+      TF_RETURN_IF_ERROR(
+          CacheSpillFile::Create(env, spill_directory_, &spill_));
+    }
+    return spill_->Append(element);
+  }
+
+  // Returns the number of elements added.
+  size_t size() const {
+    return elements_.size() + (spill_ ? spill_->size() : 0);
+  }
+
+  // Writes the elements added so far to a checkpoint.
+  Status Save(IteratorStateWriter* writer, StringPiece key_prefix) {
+    if (spill_ != nullptr) {
+      TF_RETURN_IF_ERROR(spill_->Flush());
+    }
+    return WriteCacheToCheckpoint(writer, key_prefix, elements_, spill_.get());
+  }
+
+  // Moves the elements added so far into `cache` and marks it completed.
+  Status Complete(MemoryCache* cache) {
+    if (spill_ != nullptr) {
+      TF_RETURN_IF_ERROR(spill_->Flush());
+      metrics::RecordTFDataCacheSpillBytes(spill_->bytes());
+    }
+    cache->Complete(std::move(elements_), std::move(spill_));
+    Clear();
+    return absl::OkStatus();
+  }
+
+  void Clear() {
+    elements_.clear();
+    memory_bytes_ = 0;
+    spill_.reset();
+  }
+
+  // Writes the elements of a memory cache to a checkpoint. Spilled elements
+  // are included so that the cache can be restored without its spill file.
+  // They are read back one at a time, so that they are never all in memory.
+  static Status WriteCacheToCheckpoint(
+      IteratorStateWriter* writer, StringPiece key_prefix,
+      const std::vector<std::vector<Tensor>>& in_memory,
+      const CacheSpillFile* spill) {
+    if (spill == nullptr) {
+      return WriteElementsToCheckpoint(writer, key_prefix, in_memory);
+    }
+    const int64_t num_in_memory = in_memory.size();
+    return WriteElementsToCheckpoint(
+        writer, key_prefix, num_in_memory + spill->size(),
+        [&](int64_t index, std::vector<Tensor>* element) {
+          if (index < num_in_memory) {
+            *element = in_memory[index];
+            return absl::OkStatus();
+          }
+          return spill->Read(index - num_in_memory, element);
+        });
+  }
+
+  // Reads the elements written by `WriteCacheToCheckpoint()` and adds them to
+  // the cache one at a time, so that the elements beyond the memory budget are
+  // spilled again as they are read.
+  Status Restore(IteratorContext* ctx, IteratorStateReader* reader,
+                 StringPiece key_prefix) {
+    Clear();
+    return ReadElementsFromCheckpoint(
+        ctx, reader, key_prefix, [&](std::vector<Tensor> element) {
+          bool in_memory;
+          return Add(ctx->env(), element, &in_memory);
+        });
+  }
+
+ private:
+  const int64_t memory_budget_bytes_;
+  const std::string spill_directory_;
+  std::vector<std::vector<Tensor>> elements_;
+  int64_t memory_bytes_ = 0;
+  std::unique_ptr<CacheSpillFile> spill_;
+};
+
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
   FileDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
@@ -766,6 +883,22 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         cache_(std::move(cache)) {
     input_->Ref();
     random_indexing_compatible_ = input_->RandomIndexingCompatible();
+    Status s = ReadInt64FromEnvVar(kMemoryBudgetEnvVar, /*default_val=*/0,
+                                   &memory_budget_bytes_);
+    if (s.ok()) {
+      s = ReadStringFromEnvVar(kSpillDirectoryEnvVar, /*default_val=*/"",
+                               &spill_directory_);
+    }
+    if (!s.ok()) {
+      LOG(WARNING) << "Ignoring the in-memory cache budget: " << s;
+      memory_budget_bytes_ = 0;
+    }
+    if (memory_budget_bytes_ > 0 && spill_directory_.empty()) {
+      std::vector<std::string> temp_directories;
+      Env::Default()->GetLocalTempDirectories(&temp_directories);
+      spill_directory_ =
+          temp_directories.empty() ? "/tmp" : temp_directories.front();
+    }
   }
 
   ~MemoryDatasetBase() override { input_->Unref(); }
@@ -877,8 +1010,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       if (cache_->IsCompleted()) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCacheCompleted, ""));
-        TF_RETURN_IF_ERROR(
-            WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
+        TF_RETURN_IF_ERROR(MemoryCacheBuilder::WriteCacheToCheckpoint(
+            writer, prefix(), cache_->data(), cache_->spill()));
       }
       return SaveInput(ctx, writer, iterator_);
     }
@@ -892,10 +1025,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       iterator_.reset();
       cache_->Reset();
       if (reader->Contains(prefix(), kCacheCompleted)) {
-        std::vector<std::vector<Tensor>> temp_cache;
-        TF_RETURN_IF_ERROR(
-            ReadElementsFromCheckpoint(ctx, reader, prefix(), &temp_cache));
-        cache_->Complete(std::move(temp_cache));
+        MemoryCacheBuilder builder(dataset()->memory_budget_bytes_,
+                                   dataset()->spill_directory_);
+        TF_RETURN_IF_ERROR(builder.Restore(ctx, reader, prefix()));
+        TF_RETURN_IF_ERROR(builder.Complete(cache_));
       }
       TF_RETURN_IF_ERROR(InitializeIterator(ctx));
       return RestoreInput(ctx, reader, iterator_);
@@ -905,11 +1038,14 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
     class MemoryWriterIterator : public DatasetIterator<MemoryDatasetBase> {
      public:
       explicit MemoryWriterIterator(const Params& params, MemoryCache* cache)
-          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {}
+          : DatasetIterator<MemoryDatasetBase>(params),
+            cache_(cache),
+            temp_cache_(params.dataset->memory_budget_bytes_,
+                        params.dataset->spill_directory_) {}
 
       ~MemoryWriterIterator() override {
         mutex_lock l(mu_);
-        if (!temp_cache_.empty() && !cache_->IsCompleted()) {
+        if (temp_cache_.size() > 0 && !cache_->IsCompleted()) {
           LOG(WARNING) << kIncompleteCacheErrorMessage;
           cache_->Reset();
         }
@@ -929,16 +1065,20 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           if (!cache_->IsCompleted()) {
             VLOG(2) << "Finalizing the cache because EOF has been reached.";
-            cache_->Complete(std::move(temp_cache_));
+            TF_RETURN_IF_ERROR(temp_cache_.Complete(cache_));
           }
           return absl::OkStatus();
         }
-        RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
+        bool in_memory;
+        TF_RETURN_IF_ERROR(
+            temp_cache_.Add(ctx->env(), *out_tensors, &in_memory));
+        if (in_memory) {
+          RecordBufferEnqueue(ctx, *out_tensors);
+        }
         if (temp_cache_.size() == dataset()->input_->Cardinality()) {
           VLOG(2) << "Finalizing the cache because its size matches the "
                      "expected input cardinality.";
-          cache_->Complete(std::move(temp_cache_));
+          TF_RETURN_IF_ERROR(temp_cache_.Complete(cache_));
         }
         return absl::OkStatus();
       }
@@ -954,8 +1094,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                           IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
         if (!cache_->IsCompleted()) {
-          TF_RETURN_IF_ERROR(
-              WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+          TF_RETURN_IF_ERROR(temp_cache_.Save(writer, prefix()));
         }
         return SaveInput(ctx, writer, input_impl_);
       }
@@ -963,9 +1102,9 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       Status RestoreInternal(IteratorContext* ctx,
                              IteratorStateReader* reader) override {
         mutex_lock l(mu_);
+        temp_cache_.Clear();
         if (!reader->Contains(prefix(), kCacheCompleted)) {
-          TF_RETURN_IF_ERROR(
-              ReadElementsFromCheckpoint(ctx, reader, prefix(), &temp_cache_));
+          TF_RETURN_IF_ERROR(temp_cache_.Restore(ctx, reader, prefix()));
         }
         return RestoreInput(ctx, reader, input_impl_);
       }
@@ -974,7 +1113,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
-      std::vector<std::vector<Tensor>> temp_cache_ TF_GUARDED_BY(mu_);
+      MemoryCacheBuilder temp_cache_ TF_GUARDED_BY(mu_);
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDatasetBase> {
@@ -984,16 +1123,22 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
             cache_(cache),
             index_(0) {}
 
+      ~MemoryReaderIterator() override {
+        mutex_lock l(mu_);
+        CancelSpillReads();
+      }
+
       Status Initialize(IteratorContext* ctx) override {
         // The memory allocated for the cache is owned by the parent
         // dataset but performance modeling uses the iterator abstraction and
         // thus we record the memory allocated for the cache here. The caveat
         // is that this is incorrect if there are concurrent instances of this
         // iterator.
-        tf_shared_lock l(mu_);
-        for (size_t i = 0; i < cache_->size(); ++i) {
+        mutex_lock l(mu_);
+        for (size_t i = 0; i < cache_->num_in_memory(); ++i) {
           RecordBufferEnqueue(ctx, cache_->at(i));
         }
+        runner_ = *ctx->runner();
         return absl::OkStatus();
       }
 
@@ -1001,11 +1146,18 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
-        if (index_ < cache_->size()) {
+        if (index_ < cache_->num_in_memory()) {
           const std::vector<Tensor>& cache_tensors = cache_->at(index_);
           out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
                               cache_tensors.end());
           index_++;
+          metrics::RecordTFDataCacheRead(/*in_memory=*/true);
+          *end_of_sequence = false;
+          return absl::OkStatus();
+        } else if (index_ < cache_->size()) {
+          TF_RETURN_IF_ERROR(GetNextSpilled(out_tensors));
+          index_++;
+          metrics::RecordTFDataCacheRead(/*in_memory=*/false);
           *end_of_sequence = false;
           return absl::OkStatus();
         } else {
@@ -1040,13 +1192,66 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
           }
           index_ = static_cast<size_t>(temp);
         }
+        CancelSpillReads();
         return absl::OkStatus();
       }
 
      private:
+      // A spilled element being read and decompressed in the background.
+      struct SpillRead {
+        size_t index;
+        Notification done;
+        Status status;
+        std::vector<Tensor> element;
+      };
+
+      // Produces the spilled element at `index_`, and starts reading the
+      // spilled elements that follow it.
+      Status GetNextSpilled(std::vector<Tensor>* out_tensors)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!spill_reads_.empty() && spill_reads_.front()->index != index_) {
+          CancelSpillReads();
+        }
+        size_t next = spill_reads_.empty() ? index_
+                                           : spill_reads_.back()->index + 1;
+        while (spill_reads_.size() < kSpillReadAheadElements &&
+               next < cache_->size()) {
+          StartSpillRead(next++);
+        }
+        std::shared_ptr<SpillRead> read = std::move(spill_reads_.front());
+        spill_reads_.pop_front();
+        read->done.WaitForNotification();
+        TF_RETURN_IF_ERROR(read->status);
+        out_tensors->insert(out_tensors->begin(),
+                            std::make_move_iterator(read->element.begin()),
+                            std::make_move_iterator(read->element.end()));
+        return absl::OkStatus();
+      }
+
+      void StartSpillRead(size_t index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        auto read = std::make_shared<SpillRead>();
+        read->index = index;
+        spill_reads_.push_back(read);
+        MemoryCache* cache = cache_;
+        runner_([cache, read]() {
+          read->status = cache->Get(read->index, &read->element);
+          read->done.Notify();
+        });
+      }
+
+      void CancelSpillReads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (const auto& read : spill_reads_) {
+          read->done.WaitForNotification();
+        }
+        spill_reads_.clear();
+      }
+
       mutex mu_;
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
       size_t index_ TF_GUARDED_BY(mu_);
+      std::deque<std::shared_ptr<SpillRead>> spill_reads_ TF_GUARDED_BY(mu_);
+      // Set by Initialize().
+      std::function<void(std::function<void()>)> runner_;
     };  // MemoryReaderIterator
 
     Status InitializeIterator(IteratorContext* ctx)
@@ -1080,6 +1285,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
   mutable std::unique_ptr<IteratorRandomAccessCache>
       iterator_random_access_cache_;
   absl::Status random_indexing_compatible_ = absl::OkStatus();
+  int64_t memory_budget_bytes_ = 0;
+  std::string spill_directory_;
 };  // MemoryDatasetBase
 
 // This version of memory dataset has an exclusive ownership of the memory cache
@@ -370,6 +370,62 @@ INSTANTIATE_TEST_CASE_P(CacheDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+TEST_F(CacheDatasetOpTest, SpillToDisk) {
+  // Each element takes 24 bytes, so only the first one fits in memory.
+  setenv("TF_DATA_CACHE_MEMORY_BUDGET_BYTES", "30", /*overwrite=*/1);
+  setenv("TF_DATA_CACHE_SPILL_DIR", testing::TmpDir().c_str(),
+         /*overwrite=*/1);
+  auto dataset_params = CacheDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  unsetenv("TF_DATA_CACHE_MEMORY_BUDGET_BYTES");
+  unsetenv("TF_DATA_CACHE_SPILL_DIR");
+  std::vector<Tensor> expected_outputs = CreateTensors<int64_t>(
+      TensorShape({3, 1}), {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+
+  // Write mode.
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  TF_EXPECT_OK(
+      ExpectEqual(out_tensors, expected_outputs, /*compare_order=*/true));
+
+  // Read mode, with a checkpoint taken while reading spilled elements.
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  out_tensors.clear();
+  for (int i = 0; i < 2; ++i) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                               dataset_params.iterator_prefix(), *dataset_,
+                               &iterator_));
+  end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  TF_EXPECT_OK(
+      ExpectEqual(out_tensors, expected_outputs, /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -14,11 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_ops.h"
 
+#include <utility>
+
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -28,15 +33,101 @@ namespace data {
 namespace {
 
 constexpr char kMemoryCache[] = "MemoryCache";
+constexpr char kSpillFilePrefix[] = "tf_data_cache_spill";
+constexpr char kSpillFileSuffix[] = ".spill";
+
+// Each record in a spill file is a fixed64 length followed by a serialized
+// `CompressedElement` of that length.
+constexpr size_t kRecordHeaderBytes = sizeof(uint64);
 
 }  // namespace
 
 string MemoryCacheManager::DebugString() const { return kMemoryCache; }
 
+CacheSpillFile::CacheSpillFile(Env* env, const std::string& filename,
+                               std::unique_ptr<WritableFile> file)
+    : env_(env), filename_(filename), file_(std::move(file)) {}
+
+CacheSpillFile::~CacheSpillFile() {
+  region_.reset();
+  Status s = file_->Close();
+  if (s.ok()) {
+    s = env_->DeleteFile(filename_);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to remove cache spill file " << filename_ << ": "
+                 << s;
+  }
+}
+
+Status CacheSpillFile::Create(Env* env, const std::string& directory,
+                              std::unique_ptr<CacheSpillFile>* out) {
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  std::string filename = io::JoinPath(directory, kSpillFilePrefix);
+  if (!env->CreateUniqueFileName(&filename, kSpillFileSuffix)) {
+    return errors::Internal("Failed to create a cache spill file name in ",
+                            directory);
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  out->reset(new CacheSpillFile(env, filename, std::move(file)));
+  return absl::OkStatus();
+}
+
+Status CacheSpillFile::Append(const std::vector<Tensor>& element) {
+  CompressedElement compressed;
+  TF_RETURN_IF_ERROR(CompressElement(element, &compressed));
+  const std::string serialized = compressed.SerializeAsString();
+  char header[kRecordHeaderBytes];
+  core::EncodeFixed64(header, serialized.size());
+  TF_RETURN_IF_ERROR(file_->Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(file_->Append(serialized));
+  offsets_.push_back(bytes_);
+  bytes_ += kRecordHeaderBytes + serialized.size();
+  return absl::OkStatus();
+}
+
+Status CacheSpillFile::Flush() {
+  TF_RETURN_IF_ERROR(file_->Flush());
+  region_.reset();
+  if (bytes_ == 0) {
+    return absl::OkStatus();
+  }
+  return env_->NewReadOnlyMemoryRegionFromFile(filename_, &region_);
+}
+
+Status CacheSpillFile::Read(int64_t index, std::vector<Tensor>* element) const {
+  if (index < 0 || index >= size()) {
+    return errors::OutOfRange("Index ", index, " is out of range [0, ", size(),
+                              ") in cache spill file ", filename_);
+  }
+  const uint64 offset = offsets_[index];
+  if (region_ == nullptr || offset + kRecordHeaderBytes > region_->length()) {
+    return errors::FailedPrecondition("Element ", index,
+                                      " of cache spill file ", filename_,
+                                      " has not been flushed.");
+  }
+  const char* record = static_cast<const char*>(region_->data()) + offset;
+  const uint64 length = core::DecodeFixed64(record);
+  CompressedElement compressed;
+  if (offset + kRecordHeaderBytes + length > region_->length() ||
+      !compressed.ParseFromArray(record + kRecordHeaderBytes, length)) {
+    return errors::DataLoss("Corrupted element ", index,
+                            " in cache spill file ", filename_);
+  }
+  return UncompressElement(compressed, element);
+}
+
 void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
+  Complete(std::move(cache), /*spill=*/nullptr);
+}
+
+void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache,
+                           std::unique_ptr<CacheSpillFile> spill) {
   mutex_lock l(mu_);
   if (!completed_) {
     cache_ = std::move(cache);
+    spill_ = std::move(spill);
     completed_ = true;
   }
 }
@@ -50,6 +141,7 @@ void MemoryCache::Reset() {
   mutex_lock l(mu_);
   completed_ = false;
   cache_.clear();
+  spill_.reset();
 }
 
 const std::vector<Tensor>& MemoryCache::at(int64_t index) {
@@ -58,7 +150,26 @@ const std::vector<Tensor>& MemoryCache::at(int64_t index) {
   return cache_[index];
 }
 
+Status MemoryCache::Get(int64_t index, std::vector<Tensor>* element) {
+  tf_shared_lock l(mu_);
+  const int64_t num_in_memory = cache_.size();
+  if (index >= 0 && index < num_in_memory) {
+    *element = cache_[index];
+    return absl::OkStatus();
+  }
+  if (index < 0 || spill_ == nullptr) {
+    return errors::OutOfRange("Index ", index, " is out of range [0, ",
+                              num_in_memory, ") in the memory cache.");
+  }
+  return spill_->Read(index - num_in_memory, element);
+}
+
 size_t MemoryCache::size() {
+  tf_shared_lock l(mu_);
+  return cache_.size() + (spill_ ? spill_->size() : 0);
+}
+
+size_t MemoryCache::num_in_memory() {
   tf_shared_lock l(mu_);
   return cache_.size();
 }
@@ -68,6 +179,11 @@ const std::vector<std::vector<Tensor>>& MemoryCache::data() {
   return cache_;
 }
 
+const CacheSpillFile* MemoryCache::spill() {
+  tf_shared_lock l(mu_);
+  return spill_.get();
+}
+
 AnonymousMemoryCacheHandleOp::AnonymousMemoryCacheHandleOp(
     OpKernelConstruction* ctx)
     : AnonymousResourceOp<MemoryCacheManager>(ctx,
@@ -16,17 +16,73 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_CACHE_OPS_H_
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
 
+// Holds the elements of a `MemoryCache` that do not fit within its memory
+// budget. Elements are compressed and appended to a local file in order. Once
+// flushed, the file is memory-mapped so that reads decompress straight from
+// the page cache.
+//
+// `Append()` and `Flush()` must not be called concurrently with any other
+// method. `Read()` may be called concurrently with itself.
+class CacheSpillFile {
+ public:
+  // Creates an empty spill file in `directory`.
+  static Status Create(Env* env, const std::string& directory,
+                       std::unique_ptr<CacheSpillFile>* out);
+
+  // Deletes the spill file.
+  ~CacheSpillFile();
+
+  // Compresses `element` and appends it to the file.
+  Status Append(const std::vector<Tensor>& element);
+
+  // Makes all elements appended so far readable.
+  Status Flush();
+
+  // Reads the element at the given index, which must have been flushed.
+  Status Read(int64_t index, std::vector<Tensor>* element) const;
+
+  // Returns the number of elements in the file.
+  int64_t size() const { return offsets_.size(); }
+
+  // Returns the size of the file in bytes.
+  uint64 bytes() const { return bytes_; }
+
+ private:
+  CacheSpillFile(Env* env, const std::string& filename,
+                 std::unique_ptr<WritableFile> file);
+
+  Env* const env_;
+  const std::string filename_;
+  std::unique_ptr<WritableFile> file_;
+  // Offset of each element's record in the file.
+  std::vector<uint64> offsets_;
+  uint64 bytes_ = 0;
+  // Mapping of the file as of the last call to `Flush()`.
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+
+  CacheSpillFile(const CacheSpillFile&) = delete;
+  void operator=(const CacheSpillFile&) = delete;
+};
+
 // A thread-safe data structure for caching dataset elements.
 //
 // The expected use is that a single `MemoryWriterIterator` populates the
 // cache with dataset elements. Once all elements are cached, the cache can
 // be used by one or more `MemoryReaderIterator`s.
+//
+// A cache may keep only its first elements in memory, with the remaining ones
+// in a `CacheSpillFile`.
 class MemoryCache {
  public:
   MemoryCache() = default;
@@ -34,27 +90,46 @@ class MemoryCache {
   // Marks the cache as completed.
   void Complete(std::vector<std::vector<Tensor>>&& cache);
 
+  // Marks the cache as completed. The elements in `spill`, if any, follow the
+  // elements in `cache`.
+  void Complete(std::vector<std::vector<Tensor>>&& cache,
+                std::unique_ptr<CacheSpillFile> spill);
+
   // Returns whether the cache is completed.
   bool IsCompleted();
 
   // Resets the cache.
   void Reset();
 
-  // Returns the element at the given index.
+  // Returns the element at the given index, which must be held in memory.
   const std::vector<Tensor>& at(int64_t index);
 
-  // Returns the size of the cache.
+  // Reads the element at the given index, either from memory or from the
+  // spill file.
+  Status Get(int64_t index, std::vector<Tensor>* element);
+
+  // Returns the size of the cache, including spilled elements.
   size_t size();
 
-  // Returns a reference to the cache's data. The returned reference will be
-  // invalidated by any call to Reset().
+  // Returns the number of elements held in memory. These are the first
+  // `num_in_memory()` elements of the cache.
+  size_t num_in_memory();
+
+  // Returns a reference to the cache's in-memory elements. The returned
+  // reference will be invalidated by any call to Reset().
   const std::vector<std::vector<Tensor>>& data();
 
+  // Returns the file holding the cache's spilled elements, or nullptr if
+  // there are none. The returned pointer will be invalidated by any call to
+  // Reset().
+  const CacheSpillFile* spill();
+
  private:
   mutex mu_;
   // Determines whether all elements of the dataset have been cached.
   bool completed_ TF_GUARDED_BY(mu_) = false;
   std::vector<std::vector<Tensor>> cache_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<CacheSpillFile> spill_ TF_GUARDED_BY(mu_);
 };
 
 // A resource wrapping a shared instance of a memory cache.
@@ -18,14 +18,34 @@ limitations under the License.
 #include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
 namespace experimental {
+namespace {
+
+// Selects the codec used by `CompressElement`, e.g. for elements sent by the
+// tf.data service. One of "SNAPPY" (the default) or "ZSTD".
+constexpr char kCompressionEnvVar[] = "TF_DATA_ELEMENT_COMPRESSION";
+
+}  // namespace
 
 CompressElementOp::CompressElementOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx) {}
+    : OpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ReadStringFromEnvVar(kCompressionEnvVar,
+                                           io::compression::kSnappy,
+                                           &compression_));
+  OP_REQUIRES(ctx,
+              compression_ == io::compression::kSnappy ||
+                  compression_ == io::compression::kZstd,
+              errors::InvalidArgument(kCompressionEnvVar,
+                                      " must be either 'SNAPPY' or 'ZSTD', "
+                                      "but got '",
+                                      compression_, "'."));
+}
 
 void CompressElementOp::Compute(OpKernelContext* ctx) {
   std::vector<Tensor> components;
@@ -33,7 +53,7 @@ void CompressElementOp::Compute(OpKernelContext* ctx) {
     components.push_back(ctx->input(i));
   }
   CompressedElement compressed;
-  OP_REQUIRES_OK(ctx, CompressElement(components, &compressed));
+  OP_REQUIRES_OK(ctx, CompressElement(components, compression_, &compressed));
 
   Tensor* output;
   OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COMPRESSION_OPS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COMPRESSION_OPS_H_
 
+#include <string>
+
 #include "tensorflow/core/framework/dataset.h"
 
 namespace tensorflow {
@@ -26,6 +28,9 @@ class CompressElementOp : public OpKernel {
   explicit CompressElementOp(OpKernelConstruction* ctx);
 
   void Compute(OpKernelContext* ctx) override;
+
+ private:
+  std::string compression_;
 };
 
 class UncompressElementOp : public OpKernel {
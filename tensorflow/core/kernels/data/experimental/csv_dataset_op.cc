@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/kernels/data/experimental/csv_scanner.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
@@ -402,6 +403,10 @@ class CSVDatasetOp : public DatasetOpKernel {
           pos_ = 0;
         }
 
+        if (out_tensors != nullptr) {
+          out_tensors->reserve(dataset()->out_type_.size());
+        }
+
         // The first character may be \n if this is the continuation of a
         // \r\n linebreak between this and the previous record. If so, skip it.
 
@@ -508,7 +513,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter skips to the next quote
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -520,8 +525,8 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
-          char ch = buffer_[pos_];
-          if (ch == '"') {
+          pos_ += FindQuote(buffer_.data() + pos_, buffer_.size() - pos_);
+          if (pos_ < buffer_.size()) {
             // When we encounter a quote, we look ahead to the next character to
             // decide what to do
             pos_++;
@@ -560,9 +565,6 @@ class CSVDatasetOp : public DatasetOpKernel {
               parse_result.Update(errors::InvalidArgument(
                   "Quote inside a string has to be escaped by another quote"));
             }
-
-          } else {
-            pos_++;
           }
         }
       }
@@ -641,7 +643,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter skips to the next delim, CR, LF or quote
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -657,6 +659,10 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          pos_ += FindUnquotedFieldEnd(buffer_.data() + pos_,
+                                       buffer_.size() - pos_, dataset()->delim_,
+                                       dataset()->use_quote_delim_);
+          if (pos_ >= buffer_.size()) continue;
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -677,12 +683,10 @@ class CSVDatasetOp : public DatasetOpKernel {
             if (ch == '\r') SkipNewLineIfNecessary();
             return parse_result;
           }
-          if (dataset()->use_quote_delim_ && ch == '"') {
-            // Take note of the error, but keep going to end of field.
-            parse_result.Update(errors::InvalidArgument(
-                "Unquoted fields cannot have quotes inside"));
-          }
-          // Otherwise, go to next character
+          // Otherwise this is a quote. Take note of the error, but keep going
+          // to end of field.
+          parse_result.Update(errors::InvalidArgument(
+              "Unquoted fields cannot have quotes inside"));
           pos_++;
         }
       }
@@ -789,7 +793,7 @@ class CSVDatasetOp : public DatasetOpKernel {
               component.scalar<tstring>()() =
                   dataset()->record_defaults_[output_idx].flat<tstring>()(0);
             } else {
-              component.scalar<tstring>()() = string(field);
+              component.scalar<tstring>()().assign(field.data(), field.size());
             }
             break;
           }
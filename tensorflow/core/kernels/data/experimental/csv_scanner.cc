@@ -0,0 +1,93 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/csv_scanner.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "absl/numeric/bits.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+size_t FindUnquotedFieldEnd(const char* data, size_t size, char delim,
+                            bool stop_at_quote) {
+  // Without quote handling, compare against `delim` twice so that the block
+  // loops stay branch-free.
+  const char quote = stop_at_quote ? '"' : delim;
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i delim_v = _mm256_set1_epi8(delim);
+  const __m256i quote_v = _mm256_set1_epi8(quote);
+  const __m256i lf_v = _mm256_set1_epi8('\n');
+  const __m256i cr_v = _mm256_set1_epi8('\r');
+  for (; i + 32 <= size; i += 32) {
+    const __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i matches = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, delim_v),
+                        _mm256_cmpeq_epi8(block, quote_v)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, lf_v),
+                        _mm256_cmpeq_epi8(block, cr_v)));
+    const uint32_t mask =
+        static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+    if (mask != 0) {
+      return i + absl::countr_zero(mask);
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i delim_v = _mm_set1_epi8(delim);
+  const __m128i quote_v = _mm_set1_epi8(quote);
+  const __m128i lf_v = _mm_set1_epi8('\n');
+  const __m128i cr_v = _mm_set1_epi8('\r');
+  for (; i + 16 <= size; i += 16) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i matches =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, delim_v),
+                                  _mm_cmpeq_epi8(block, quote_v)),
+                     _mm_or_si128(_mm_cmpeq_epi8(block, lf_v),
+                                  _mm_cmpeq_epi8(block, cr_v)));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+    if (mask != 0) {
+      return i + absl::countr_zero(mask);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    const char ch = data[i];
+    if (ch == delim || ch == quote || ch == '\n' || ch == '\r') {
+      return i;
+    }
+  }
+  return size;
+}
+
+size_t FindQuote(const char* data, size_t size) {
+  // memchr is vectorized by every libc we build against.
+  const void* quote = std::memchr(data, '"', size);
+  return quote == nullptr ? size : static_cast<const char*>(quote) - data;
+}
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
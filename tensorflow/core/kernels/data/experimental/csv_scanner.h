@@ -0,0 +1,42 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_CSV_SCANNER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_CSV_SCANNER_H_
+
+#include <cstddef>
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Returns the offset of the first character in `[data, data + size)` that
+// ends an unquoted CSV field: `delim`, '\n', '\r', or, if `stop_at_quote` is
+// true, '"'. Returns `size` if there is no such character.
+//
+// On x86 the buffer is scanned 16 (SSE2) or 32 (AVX2) bytes at a time, so
+// long fields cost a few instructions per block rather than several branches
+// per character.
+size_t FindUnquotedFieldEnd(const char* data, size_t size, char delim,
+                            bool stop_at_quote);
+
+// Returns the offset of the first '"' in `[data, data + size)`, or `size` if
+// there is none. This is the only character that can end a quoted field.
+size_t FindQuote(const char* data, size_t size);
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_CSV_SCANNER_H_
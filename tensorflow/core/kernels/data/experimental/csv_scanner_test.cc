@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/csv_scanner.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// The character-at-a-time loop that CSVDatasetOp used before the scanner.
+size_t FindUnquotedFieldEndByChar(const char* data, size_t size, char delim,
+                                  bool stop_at_quote) {
+  for (size_t i = 0; i < size; ++i) {
+    const char ch = data[i];
+    if (ch == delim || ch == '\n' || ch == '\r' ||
+        (stop_at_quote && ch == '"')) {
+      return i;
+    }
+  }
+  return size;
+}
+
+TEST(CsvScannerTest, FindUnquotedFieldEnd) {
+  EXPECT_EQ(FindUnquotedFieldEnd("", 0, ',', true), 0);
+  EXPECT_EQ(FindUnquotedFieldEnd("abc", 3, ',', true), 3);
+  EXPECT_EQ(FindUnquotedFieldEnd("abc,def", 7, ',', true), 3);
+  EXPECT_EQ(FindUnquotedFieldEnd("abc\ndef", 7, ',', true), 3);
+  EXPECT_EQ(FindUnquotedFieldEnd("abc\r\ndef", 8, ',', true), 3);
+  EXPECT_EQ(FindUnquotedFieldEnd("ab\"c,def", 8, ',', true), 2);
+  EXPECT_EQ(FindUnquotedFieldEnd("ab\"c,def", 8, ',', false), 4);
+  EXPECT_EQ(FindUnquotedFieldEnd("abc|def", 7, '|', true), 3);
+}
+
+// Places each special character at every offset of buffers that span several
+// SIMD blocks, so that both the block loop and the scalar tail are covered.
+TEST(CsvScannerTest, MatchesCharacterLoop) {
+  for (size_t size : {1, 15, 16, 17, 31, 32, 33, 64, 100}) {
+    for (char special : {',', ';', '\n', '\r', '"'}) {
+      for (size_t offset = 0; offset < size; ++offset) {
+        std::string data(size, 'x');
+        data[offset] = special;
+        for (bool stop_at_quote : {false, true}) {
+          EXPECT_EQ(FindUnquotedFieldEnd(data.data(), size, ',', stop_at_quote),
+                    FindUnquotedFieldEndByChar(data.data(), size, ',',
+                                               stop_at_quote))
+              << "size=" << size << " offset=" << offset
+              << " special=" << static_cast<int>(special);
+        }
+      }
+    }
+  }
+}
+
+TEST(CsvScannerTest, FindQuote) {
+  EXPECT_EQ(FindQuote("", 0), 0);
+  EXPECT_EQ(FindQuote("abc,def\n", 8), 8);
+  EXPECT_EQ(FindQuote("abc\"\"def", 8), 3);
+}
+
+// A CSV buffer with `num_columns` numeric columns per line.
+std::string MakeCsv(int num_lines, int num_columns) {
+  std::string csv;
+  for (int line = 0; line < num_lines; ++line) {
+    for (int column = 0; column < num_columns; ++column) {
+      absl::StrAppend(&csv, column == 0 ? "" : ",", line * 1000003 + column,
+                      ".", column * 7);
+    }
+    csv.push_back('\n');
+  }
+  return csv;
+}
+
+// Splits a 64K-line CSV buffer into fields with `find_field_end`, and reports
+// the throughput in bytes/s.
+template <typename FindFieldEnd>
+void SplitFields(::testing::benchmark::State& state,
+                 FindFieldEnd find_field_end) {
+  const std::string csv = MakeCsv(/*num_lines=*/1 << 16,
+                                  /*num_columns=*/state.range(0));
+  for (auto s : state) {
+    size_t num_fields = 0;
+    size_t pos = 0;
+    while (pos < csv.size()) {
+      pos += find_field_end(csv.data() + pos, csv.size() - pos, ',', true) + 1;
+      ++num_fields;
+    }
+    tensorflow::testing::DoNotOptimize(num_fields);
+  }
+  state.SetBytesProcessed(state.iterations() * csv.size());
+}
+
+void BM_SplitFieldsByChar(::testing::benchmark::State& state) {
+  SplitFields(state, FindUnquotedFieldEndByChar);
+}
+
+void BM_SplitFieldsScanner(::testing::benchmark::State& state) {
+  SplitFields(state, FindUnquotedFieldEnd);
+}
+
+BENCHMARK(BM_SplitFieldsByChar)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_SplitFieldsScanner)->Arg(1)->Arg(8)->Arg(64);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
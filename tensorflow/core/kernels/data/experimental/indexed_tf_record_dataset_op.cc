@@ -0,0 +1,458 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/global_shuffle_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tsl/lib/io/record_index.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// See documentation in ../../../ops/experimental_dataset_ops.cc for a
+// high-level description of the following ops.
+
+constexpr char kNextIndex[] = "next_index";
+
+string IndexFileName(const string& filename) {
+  return absl::StrCat(filename, tsl::io::kRecordIndexSuffix);
+}
+
+// Writes the index of each of `filenames` next to it, and outputs the number
+// of records in each file.
+class BuildTFRecordIndexOp : public OpKernel {
+ public:
+  explicit BuildTFRecordIndexOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& filenames = ctx->input(0);
+    OP_REQUIRES(
+        ctx, filenames.dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    Tensor* num_records = nullptr;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_output(0, filenames.shape(), &num_records));
+    for (int64_t i = 0; i < filenames.NumElements(); ++i) {
+      int64_t n = 0;
+      OP_REQUIRES_OK(ctx, BuildIndex(ctx->env(),
+                                     TranslateFileName(
+                                         filenames.flat<tstring>()(i)),
+                                     &n));
+      num_records->flat<int64_t>()(i) = n;
+    }
+  }
+
+ private:
+  static Status BuildIndex(Env* env, const string& filename,
+                           int64_t* num_records) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+    std::vector<tsl::io::RecordIndexEntry> entries;
+    TF_RETURN_IF_ERROR(tsl::io::BuildRecordIndex(file.get(), &entries));
+
+    // Write to a temporary file first so that readers never observe a
+    // partially written index.
+    const string index_filename = IndexFileName(filename);
+    const string tmp_filename = absl::StrCat(index_filename, ".tmp");
+    std::unique_ptr<WritableFile> index_file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_filename, &index_file));
+    TF_RETURN_IF_ERROR(tsl::io::WriteRecordIndex(entries, index_file.get()));
+    TF_RETURN_IF_ERROR(index_file->Close());
+    TF_RETURN_IF_ERROR(env->RenameFile(tmp_filename, index_filename));
+    *num_records = entries.size();
+    return absl::OkStatus();
+  }
+};
+
+// Reads uncompressed TFRecord files that have been indexed by
+// `BuildTFRecordIndex`. Unlike `TFRecordDataset`, this dataset knows its
+// cardinality, supports random access (and hence global shuffling), and
+// skips records by seeking to them rather than by reading past them.
+class IndexedTFRecordDatasetOp : public DatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "IndexedTFRecord";
+
+  explicit IndexedTFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {}
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<tstring>()(i));
+      metrics::RecordTFDataFilename(kDatasetType, filenames[i]);
+    }
+    LogFilenames(filenames);
+
+    int64_t buffer_size = -1;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64_t>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size >= 0,
+                errors::InvalidArgument(
+                    "`buffer_size` must be >= 0 (0 == no buffering)"));
+
+    // Only the index headers are read here; entries are read on demand.
+    std::vector<std::unique_ptr<RandomAccessFile>> index_files;
+    std::vector<std::unique_ptr<tsl::io::RecordIndexReader>> indices;
+    for (const string& filename : filenames) {
+      const string index_filename = IndexFileName(TranslateFileName(filename));
+      index_files.emplace_back();
+      OP_REQUIRES_OK(ctx, ctx->env()->NewRandomAccessFile(
+                              index_filename, &index_files.back()));
+      indices.emplace_back();
+      Status s = tsl::io::RecordIndexReader::Create(index_files.back().get(),
+                                                    &indices.back());
+      OP_REQUIRES(ctx, s.ok(),
+                  errors::CreateWithUpdatedMessage(
+                      s, absl::StrCat("Failed to read the index of ", filename,
+                                      " from ", index_filename, ": ",
+                                      s.message())));
+    }
+
+    *output = new Dataset(ctx, std::move(filenames), buffer_size,
+                          std::move(index_files), std::move(indices));
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            int64_t buffer_size,
+            std::vector<std::unique_ptr<RandomAccessFile>> index_files,
+            std::vector<std::unique_ptr<tsl::io::RecordIndexReader>> indices)
+        : DatasetBase(DatasetContext(ctx)),
+          filenames_(std::move(filenames)),
+          buffer_size_(buffer_size),
+          env_(ctx->env()),
+          index_files_(std::move(index_files)),
+          indices_(std::move(indices)),
+          files_(filenames_.size()) {
+      if (buffer_size > 0) {
+        options_.buffer_size = buffer_size;
+      }
+      int64_t num_records = 0;
+      record_limits_.reserve(indices_.size());
+      for (const auto& index : indices_) {
+        num_records += index->num_records();
+        record_limits_.push_back(num_records);
+      }
+    }
+
+    absl::Status RandomIndexingCompatible() const override {
+      return absl::OkStatus();
+    }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::make_unique<Iterator>(Iterator::Params{
+          this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{}});
+      return *shapes;
+    }
+
+    string DebugString() const override {
+      return name_utils::DatasetDebugString(kDatasetType);
+    }
+
+    int64_t CardinalityInternal(CardinalityOptions options) const override {
+      return num_records();
+    }
+
+    Status InputDatasets(
+        std::vector<const DatasetBase*>* inputs) const override {
+      return absl::OkStatus();
+    }
+
+    Status CheckExternalState() const override { return absl::OkStatus(); }
+
+    Status Get(OpKernelContext* ctx, int64 index,
+               std::vector<Tensor>* out_tensors) const override {
+      return Get(AnyContext(ctx), index, out_tensors);
+    }
+
+    Status Get(AnyContext ctx, int64 index,
+               std::vector<Tensor>* out_tensors) const override {
+      TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+      size_t file_index;
+      tsl::io::RecordIndexEntry entry;
+      TF_RETURN_IF_ERROR(LocateRecord(index, &file_index, &entry));
+      RandomAccessFile* file;
+      TF_RETURN_IF_ERROR(GetFile(file_index, &file));
+      out_tensors->clear();
+      out_tensors->emplace_back(ctx.allocator, DT_STRING, TensorShape({}));
+      return tsl::io::ReadIndexedRecord(
+          file, entry, &out_tensors->back().scalar<tstring>()());
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* buffer_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
+      TF_RETURN_IF_ERROR(
+          b->AddDataset(this, {filenames, buffer_size}, output));
+      return absl::OkStatus();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            global_shuffle_iterator_(dataset()) {}
+
+      bool SymbolicCheckpointCompatible() const override { return true; }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        if (ctx->index_mapper() != nullptr) {
+          return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                  end_of_sequence);
+        }
+        mutex_lock l(mu_);
+        if (next_index_ >= dataset()->num_records()) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        // Reading sequentially within a file needs no lookup. The reader is
+        // only positioned after a skip, a restore, an error, or when moving to
+        // the next file, and only seeks read the index.
+        if (needs_seek_ || !reader_ ||
+            next_index_ >= dataset()->record_limits_[current_file_index_]) {
+          TF_RETURN_IF_ERROR(PositionReaderLocked(ctx->env()));
+        }
+        out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
+                                  TensorShape({}));
+        Status s =
+            reader_->ReadRecord(&out_tensors->back().scalar<tstring>()());
+        // Move on to the next record even on errors, so that a corrupted
+        // record is skipped under `ignore_errors`.
+        ++next_index_;
+        if (!s.ok()) {
+          out_tensors->pop_back();
+          needs_seek_ = true;
+          if (errors::IsOutOfRange(s)) {
+            return errors::DataLoss("Record ", next_index_ - 1, " of ",
+                                    dataset()->filenames_[current_file_index_],
+                                    " is past the end of the file: ",
+                                    s.message());
+          }
+          return s;
+        }
+        static monitoring::CounterCell* bytes_counter =
+            metrics::GetTFDataBytesReadCounter(kDatasetType);
+        bytes_counter->IncrementBy(
+            out_tensors->back().scalar<tstring>()().size());
+        *end_of_sequence = false;
+        return absl::OkStatus();
+      }
+
+      Status SkipInternal(IteratorContext* ctx, int num_to_skip,
+                          bool* end_of_sequence, int* num_skipped) override {
+        mutex_lock l(mu_);
+        const int64_t num_left =
+            std::max<int64_t>(dataset()->num_records() - next_index_, 0);
+        *num_skipped = static_cast<int>(
+            std::min<int64_t>(num_to_skip, num_left));
+        next_index_ += *num_skipped;
+        needs_seek_ = needs_seek_ || *num_skipped > 0;
+        *end_of_sequence = *num_skipped < num_to_skip;
+        return absl::OkStatus();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kNextIndex, next_index_));
+        return absl::OkStatus();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        if (ctx->restored_element_count().has_value()) {
+          return global_shuffle_iterator_.Restore(ctx);
+        }
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(prefix(), kNextIndex, &next_index_));
+        needs_seek_ = true;
+        return absl::OkStatus();
+      }
+
+     private:
+      // Positions `reader_` at the record `next_index_`. Reads the record's
+      // index entry only if it is not the first record of its file.
+      Status PositionReaderLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const size_t file_index = dataset()->FileIndexOf(next_index_);
+        const int64_t record_number =
+            next_index_ - dataset()->FirstRecordOf(file_index);
+        uint64 offset = 0;
+        if (record_number > 0) {
+          tsl::io::RecordIndexEntry entry;
+          TF_RETURN_IF_ERROR(
+              dataset()->indices_[file_index]->GetEntry(record_number, &entry));
+          offset = entry.offset;
+        }
+        // The reader only seeks forward.
+        if (reader_ && file_index == current_file_index_ &&
+            offset < reader_->TellOffset()) {
+          reader_.reset();
+        }
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(env, file_index));
+        TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        needs_seek_ = false;
+        return absl::OkStatus();
+      }
+
+      // Sets up reader streams to read from the file at `file_index`.
+      Status SetupStreamsLocked(Env* env, size_t file_index)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (reader_ && file_index == current_file_index_) {
+          return absl::OkStatus();
+        }
+        reader_.reset();
+        file_.reset();
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            TranslateFileName(dataset()->filenames_[file_index]), &file_));
+        reader_ = std::make_unique<io::SequentialRecordReader>(
+            file_.get(), dataset()->options_);
+        current_file_index_ = file_index;
+        return absl::OkStatus();
+      }
+
+      mutex mu_;
+      // Position of the next record across all files.
+      int64_t next_index_ TF_GUARDED_BY(mu_) = 0;
+      // Whether `reader_` has to be repositioned before reading `next_index_`.
+      bool needs_seek_ TF_GUARDED_BY(mu_) = false;
+      size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
+      // `reader_` will borrow the object that `file_` points to, so
+      // we must destroy `reader_` before `file_`.
+      std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
+      std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+      GlobalShuffleIterator global_shuffle_iterator_;
+    };
+
+    int64_t num_records() const {
+      return record_limits_.empty() ? 0 : record_limits_.back();
+    }
+
+    // Returns the position of the file that holds the `index`-th record,
+    // which must be less than `num_records()`.
+    size_t FileIndexOf(int64_t index) const {
+      return std::upper_bound(record_limits_.begin(), record_limits_.end(),
+                              index) -
+             record_limits_.begin();
+    }
+
+    // Returns the index of the first record of the file at `file_index`.
+    int64_t FirstRecordOf(size_t file_index) const {
+      return file_index == 0 ? 0 : record_limits_[file_index - 1];
+    }
+
+    // Finds the file that holds the `index`-th record, and that record's
+    // index entry.
+    Status LocateRecord(int64_t index, size_t* file_index,
+                        tsl::io::RecordIndexEntry* entry) const {
+      if (index < 0 || index >= num_records()) {
+        return errors::OutOfRange("Index out of range [0, ", num_records(),
+                                  "):", index);
+      }
+      *file_index = FileIndexOf(index);
+      return indices_[*file_index]->GetEntry(index - FirstRecordOf(*file_index),
+                                             entry);
+    }
+
+    // Returns the file used for random access to `filenames_[file_index]`,
+    // opening it on first use.
+    Status GetFile(size_t file_index, RandomAccessFile** file) const {
+      mutex_lock l(files_mu_);
+      if (!files_[file_index]) {
+        TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+            TranslateFileName(filenames_[file_index]), &files_[file_index]));
+      }
+      *file = files_[file_index].get();
+      return absl::OkStatus();
+    }
+
+    const std::vector<string> filenames_;
+    const int64_t buffer_size_;
+    Env* const env_;
+    io::RecordReaderOptions options_;
+    // `indices_` borrow the objects that `index_files_` point to.
+    const std::vector<std::unique_ptr<RandomAccessFile>> index_files_;
+    const std::vector<std::unique_ptr<tsl::io::RecordIndexReader>> indices_;
+    // `record_limits_[i]` is the number of records in the first i + 1 files.
+    std::vector<int64_t> record_limits_;
+    mutable mutex files_mu_;
+    // Files read by `Get()`. Reads of a `RandomAccessFile` are thread safe, so
+    // `files_mu_` only guards opening them.
+    mutable std::vector<std::unique_ptr<RandomAccessFile>> files_
+        TF_GUARDED_BY(files_mu_);
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("BuildTFRecordIndex").Device(DEVICE_CPU),
+                        BuildTFRecordIndexOp);
+REGISTER_KERNEL_BUILDER(Name("IndexedTFRecordDataset").Device(DEVICE_CPU),
+                        IndexedTFRecordDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,241 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tsl/lib/io/record_index.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "indexed_tf_record_dataset";
+constexpr char kDatasetType[] = "IndexedTFRecord";
+// Size of the header of an index file, before its entries.
+constexpr int kIndexHeaderSize = 20;
+
+class IndexedTFRecordDatasetParams : public DatasetParams {
+ public:
+  IndexedTFRecordDatasetParams(std::vector<tstring> filenames,
+                               int64_t buffer_size, string node_name)
+      : DatasetParams({DT_STRING}, {PartialTensorShape({})},
+                      std::move(node_name)),
+        filenames_(std::move(filenames)),
+        buffer_size_(buffer_size) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    int num_files = filenames_.size();
+    return {CreateTensor<tstring>(TensorShape({num_files}), filenames_),
+            CreateTensor<int64_t>(TensorShape({}), {buffer_size_})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"filenames", "buffer_size"};
+    return absl::OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  std::vector<tstring> filenames_;
+  int64_t buffer_size_;
+};
+
+class IndexedTFRecordDatasetOpTest : public DatasetOpsTestBase {
+ protected:
+  // Runs `BuildTFRecordIndex` on `filenames`.
+  Status BuildIndices(const std::vector<tstring>& filenames,
+                      Tensor* num_records) {
+    NodeDef node_def = test::function::NDef(
+        "build_tf_record_index", "BuildTFRecordIndex", {"filenames"}, {});
+    std::unique_ptr<OpKernel> kernel;
+    TF_RETURN_IF_ERROR(CreateOpKernel(node_def, &kernel));
+    Tensor filenames_tensor = CreateTensor<tstring>(
+        TensorShape({static_cast<int64_t>(filenames.size())}), filenames);
+    gtl::InlinedVector<TensorValue, 4> inputs = {
+        TensorValue(&filenames_tensor)};
+    std::unique_ptr<OpKernelContext> context;
+    TF_RETURN_IF_ERROR(CheckOpKernelInput(*kernel, inputs));
+    TF_RETURN_IF_ERROR(CreateOpKernelContext(kernel.get(), &inputs, &context));
+    TF_RETURN_IF_ERROR(RunOpKernel(kernel.get(), context.get()));
+    *num_records = *context->mutable_output(0);
+    return absl::OkStatus();
+  }
+};
+
+// Writes `records` to a TFRecord file, without an index.
+string WriteRecords(const string& name, const std::vector<string>& records) {
+  const string filename = io::JoinPath(testing::TmpDir(), name);
+  CompressionParams params;
+  params.compression_type = CompressionType::UNCOMPRESSED;
+  std::vector<absl::string_view> views(records.begin(), records.end());
+  TF_CHECK_OK(WriteDataToTFRecordFile(filename, views, params));
+  return filename;
+}
+
+// Writes `records` to a TFRecord file and writes its index next to it.
+string WriteIndexedRecords(const string& name,
+                           const std::vector<string>& records) {
+  const string filename = WriteRecords(name, records);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+  std::vector<tsl::io::RecordIndexEntry> entries;
+  TF_CHECK_OK(tsl::io::BuildRecordIndex(file.get(), &entries));
+  std::unique_ptr<WritableFile> index_file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(
+      absl::StrCat(filename, tsl::io::kRecordIndexSuffix), &index_file));
+  TF_CHECK_OK(tsl::io::WriteRecordIndex(entries, index_file.get()));
+  TF_CHECK_OK(index_file->Close());
+  return filename;
+}
+
+// Three files holding "a0", "a1", "a2", then "b0", then "c0", "c1".
+IndexedTFRecordDatasetParams ThreeFilesParams(int64_t buffer_size) {
+  return IndexedTFRecordDatasetParams(
+      {WriteIndexedRecords("indexed_a", {"a0", "a1", "a2"}),
+       WriteIndexedRecords("indexed_b", {"b0"}),
+       WriteIndexedRecords("indexed_c", {"c0", "c1"})},
+      buffer_size, kNodeName);
+}
+
+std::vector<Tensor> Records(const std::vector<tstring>& records) {
+  std::vector<Tensor> tensors;
+  for (const tstring& record : records) {
+    tensors.push_back(CreateTensor<tstring>(TensorShape({}), {record}));
+  }
+  return tensors;
+}
+
+std::vector<GetNextTestCase<IndexedTFRecordDatasetParams>> GetNextTestCases() {
+  return {{ThreeFilesParams(/*buffer_size=*/0),
+           Records({"a0", "a1", "a2", "b0", "c0", "c1"})},
+          {ThreeFilesParams(/*buffer_size=*/10),
+           Records({"a0", "a1", "a2", "b0", "c0", "c1"})}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(IndexedTFRecordDatasetOpTest,
+                         IndexedTFRecordDatasetParams, GetNextTestCases())
+
+std::vector<SkipTestCase<IndexedTFRecordDatasetParams>> SkipTestCases() {
+  return {{ThreeFilesParams(0), /*num_to_skip=*/1, /*expected_num_skipped=*/1,
+           /*get_next=*/true, Records({"a1"})},
+          // Skips past the end of the first file into the middle of the third.
+          {ThreeFilesParams(0), /*num_to_skip=*/5, /*expected_num_skipped=*/5,
+           /*get_next=*/true, Records({"c1"})},
+          {ThreeFilesParams(0), /*num_to_skip=*/7,
+           /*expected_num_skipped=*/6}};
+}
+
+ITERATOR_SKIP_TEST_P(IndexedTFRecordDatasetOpTest,
+                     IndexedTFRecordDatasetParams, SkipTestCases())
+
+TEST_F(IndexedTFRecordDatasetOpTest, Cardinality) {
+  TF_ASSERT_OK(Initialize(ThreeFilesParams(0)));
+  TF_ASSERT_OK(CheckDatasetCardinality(6));
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, RandomAccess) {
+  TF_ASSERT_OK(Initialize(ThreeFilesParams(0)));
+  const std::vector<tstring> expected = {"a0", "a1", "a2", "b0", "c0", "c1"};
+  for (int64_t i : {5, 0, 3, 2, 4, 1}) {
+    std::vector<Tensor> out_tensors;
+    TF_ASSERT_OK(
+        dataset_->Get(AnyContext(iterator_ctx_.get()), i, &out_tensors));
+    TF_EXPECT_OK(ExpectEqual(out_tensors[0],
+                             CreateTensor<tstring>(TensorShape({}),
+                                                   {expected[i]})));
+  }
+  std::vector<Tensor> out_tensors;
+  EXPECT_EQ(dataset_->Get(AnyContext(iterator_ctx_.get()), 6, &out_tensors)
+                .code(),
+            absl::StatusCode::kOutOfRange);
+}
+
+// Sequential reads only use the record counts of the files, so they succeed
+// even though the index entries are corrupted. Seeking reads the entries.
+TEST_F(IndexedTFRecordDatasetOpTest, SequentialReadsDoNotReadIndexEntries) {
+  const string filename = WriteIndexedRecords("indexed_d", {"d0", "d1", "d2"});
+  TF_ASSERT_OK(Initialize(IndexedTFRecordDatasetParams(
+      {filename}, /*buffer_size=*/0, kNodeName)));
+
+  const string index_filename =
+      absl::StrCat(filename, tsl::io::kRecordIndexSuffix);
+  string index;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), index_filename, &index));
+  for (size_t i = kIndexHeaderSize; i < index.size(); ++i) index[i] ^= 0xff;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), index_filename, index));
+
+  TF_ASSERT_OK(CheckIteratorGetNext(Records({"d0", "d1", "d2"}),
+                                    /*compare_order=*/true));
+
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      "Iterator", &iterator));
+  bool end_of_sequence = false;
+  int num_skipped = 0;
+  TF_ASSERT_OK(iterator->Skip(iterator_ctx_.get(), /*num_to_skip=*/1,
+                              &end_of_sequence, &num_skipped));
+  std::vector<Tensor> out_tensors;
+  EXPECT_TRUE(errors::IsDataLoss(
+      iterator->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)));
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, MissingIndex) {
+  auto dataset_params = IndexedTFRecordDatasetParams(
+      {WriteRecords("not_indexed", {"x0"})}, /*buffer_size=*/0, kNodeName);
+  EXPECT_EQ(Initialize(dataset_params).code(), absl::StatusCode::kNotFound);
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, BuildTFRecordIndex) {
+  const std::vector<tstring> filenames = {
+      WriteRecords("to_index_a", {"a0", "a1"}),
+      WriteRecords("to_index_b", {}),
+      WriteRecords("to_index_c", {"c0", "c1", "c2"})};
+  auto dataset_params =
+      IndexedTFRecordDatasetParams(filenames, /*buffer_size=*/0, kNodeName);
+  TF_ASSERT_OK(InitializeRuntime(dataset_params));
+  Tensor num_records;
+  TF_ASSERT_OK(BuildIndices(filenames, &num_records));
+  TF_EXPECT_OK(ExpectEqual(
+      num_records, CreateTensor<int64_t>(TensorShape({3}), {2, 0, 3})));
+
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(5));
+  TF_ASSERT_OK(CheckIteratorGetNext(Records({"a0", "a1", "c0", "c1", "c2"}),
+                                    /*compare_order=*/true));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<IndexedTFRecordDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{ThreeFilesParams(0), /*breakpoints=*/{0, 2, 4, 7},
+           Records({"a0", "a1", "a2", "b0", "c0", "c1"})}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(IndexedTFRecordDatasetOpTest,
+                                 IndexedTFRecordDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
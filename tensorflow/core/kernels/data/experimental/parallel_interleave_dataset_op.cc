@@ -14,9 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/experimental/parallel_interleave_dataset_op.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -275,6 +277,18 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   //     union of `interleave_indices_` and `staging_indices_`.
   //  3. Unless `input_impl_` is empty, every `worker_` must be pointed to by
   //     an element in `interleave_indices_` or `staging_indices_`.
+  //
+  // When the iterator context has a RAM budget manager, the buffered elements
+  // are also bounded in bytes. The iterator allocates the bytes of each
+  // element from the shared budget when it is buffered and releases them when
+  // it is consumed. Like the legacy prefetch autotuner, it allocates them as
+  // legacy prefetch bytes, which the autotuner's model allocation leaves
+  // alone and takes into account. Each worker buffers at most
+  // `max_buffered_elements` elements: one while it is staged, then
+  // `block_length` once it is interleaved, growing by one (up to
+  // `buffer_output_elements`) whenever the consumer has to wait for it. A
+  // worker can always buffer one element, so the budget never deadlocks the
+  // iterator, and it does not affect the order of the produced elements.
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params, bool deterministic)
@@ -286,12 +300,17 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     ~Iterator() override {
       CancelThreads();
       if (deregister_fn_) deregister_fn_();
+      mutex_lock l(mu_);
+      if (ram_budget_manager_) {
+        ram_budget_manager_->RequestLegacyPrefetchBytes(-allocated_bytes_);
+      }
     }
 
     // TODO(jsimsa): Register cancellation callback once the implementation is
     // refactored not to hold mu_ while calling `GetNext` on the input.
     Status Initialize(IteratorContext* ctx) override {
       cancellation_manager_ = std::make_unique<CancellationManager>();
+      ram_budget_manager_ = ctx->ram_budget_manager();
       IteratorContext::Params params(ctx);
       params.cancellation_manager = cancellation_manager_.get();
       TF_RETURN_IF_ERROR(dataset()->input_->MakeIterator(
@@ -346,8 +365,13 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                   {{"element_id", current_worker->outputs.front().id}});
             });
             current_worker->outputs.front().output.swap(*out_tensors);
+            const int64_t element_bytes = current_worker->outputs.front().bytes;
             current_worker->outputs.pop_front();
             current_worker->cond_var.notify_one();
+            if (element_bytes > 0) {
+              ReleaseBytesLocked(element_bytes);
+              NotifyWorkersWaitingForMemoryLocked();
+            }
             return s;
           } else if (current_worker->is_producing && deterministic_) {
             // current_worker.outputs.empty(), and we must wait for this
@@ -370,6 +394,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                 input_impl_.reset();
               } else {
                 current_worker->SetInputs(s, std::move(args));
+                current_worker->max_buffered_elements = 1;
                 staging_indices_.emplace_back(current_worker_index);
               }
             }
@@ -379,6 +404,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               // `interleave_indices_`.
               interleave_indices_[index] = staging_indices_.front();
               staging_indices_.pop_front();
+              StartInterleavingLocked(interleave_indices_[index]);
               next_index_ = (index + 1) % interleave_indices_.size();
               block_count_ = 0;
               // Restart the inner [for] loop
@@ -396,7 +422,15 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
 
         if (must_wait_for_input) {
-          // Wait for elements to become available.
+          // Wait for elements to become available. The workers we wait for
+          // are not buffering enough elements, so let them buffer more.
+          if (deterministic_) {
+            GrowBufferLocked(interleave_indices_[next_index_]);
+          } else {
+            for (int64_t worker_index : interleave_indices_) {
+              if (worker_index >= 0) GrowBufferLocked(worker_index);
+            }
+          }
           RecordStop(ctx);
           if (deterministic_) {
             workers_[interleave_indices_[next_index_]].cond_var.wait(l);
@@ -536,6 +570,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           }
           if (temp >= 0) {
             all_indices.insert(temp);
+            workers_[temp].max_buffered_elements =
+                InitialMaxBufferedElements();
           }
           interleave_indices_.emplace_back(temp);
         }
@@ -589,6 +625,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // The buffered data element.
       std::vector<Tensor> output;
       int64_t id = -1;
+      // The bytes allocated for `output` from the RAM budget.
+      int64_t bytes = 0;
 
       explicit OutputElem(const Status& s) : status(s) {}
       OutputElem(const Status& s, int64_t id) : status(s), id(id) {}
@@ -607,6 +645,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // Concretely, all output elements will have been consumed only when:
       // is_producing == false && outputs.empty();
       bool is_producing = false;
+      // The maximum number of buffered elements when there is a RAM budget.
+      int64_t max_buffered_elements = 1;
+      // Whether the worker thread waits for space in `outputs`.
+      bool waiting_for_space = false;
       // Condition variable used to coordinate between threads. The worker
       // thread waits on this condition variable when it is either (1) waiting
       // for the main thread to add arguments to `input`, or (2) waiting for
@@ -667,6 +709,93 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Returns whether worker `index` has space to buffer an element of
+    // `bytes` bytes. If so, sets `*allocated_bytes` to the bytes allocated for
+    // the element from the RAM budget.
+    bool HasBufferSpaceLocked(int64_t index, int64_t bytes,
+                              int64_t* allocated_bytes)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      *allocated_bytes = 0;
+      const int64_t num_buffered = workers_[index].outputs.size();
+      if (num_buffered >= dataset()->buffer_output_elements_) {
+        return false;
+      }
+      if (!ram_budget_manager_) {
+        return true;
+      }
+      if (num_buffered >= workers_[index].max_buffered_elements) {
+        return false;
+      }
+      if (bytes > 0 && ram_budget_manager_->RequestLegacyPrefetchBytes(bytes)) {
+        *allocated_bytes = bytes;
+        allocated_bytes_ += bytes;
+        return true;
+      }
+      // A worker can always buffer one element, even without memory for it.
+      return bytes == 0 || num_buffered == 0;
+    }
+
+    // Waits until worker `index` has space to buffer an element of `bytes`
+    // bytes or the iterator is cancelled. Returns the bytes allocated for the
+    // element from the RAM budget.
+    int64_t WaitForBufferSpaceLocked(IteratorContext* ctx, int64_t index,
+                                     int64_t bytes, mutex_lock& l)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64_t allocated_bytes = 0;
+      while (!cancelled_ &&
+             !HasBufferSpaceLocked(index, bytes, &allocated_bytes)) {
+        workers_[index].waiting_for_space = true;
+        RecordStop(ctx);
+        workers_[index].cond_var.wait(l);
+        RecordStart(ctx);
+      }
+      workers_[index].waiting_for_space = false;
+      return allocated_bytes;
+    }
+
+    // Returns `bytes` allocated for a buffered element to the RAM budget.
+    void ReleaseBytesLocked(int64_t bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (bytes == 0) return;
+      ram_budget_manager_->RequestLegacyPrefetchBytes(-bytes);
+      allocated_bytes_ -= bytes;
+    }
+
+    // Wakes up the workers waiting for space, as consuming an element of one
+    // worker frees bytes of the budget for all of them.
+    void NotifyWorkersWaitingForMemoryLocked()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (WorkerState& worker : workers_) {
+        if (worker.waiting_for_space) {
+          worker.cond_var.notify_one();
+        }
+      }
+    }
+
+    // The number of elements an interleaved worker buffers before the
+    // consumer has had to wait for it.
+    int64_t InitialMaxBufferedElements() const {
+      return std::min(dataset()->block_length_,
+                      dataset()->buffer_output_elements_);
+    }
+
+    // Moves worker `index` from staging to the interleave, which lets it
+    // buffer more elements.
+    void StartInterleavingLocked(int64_t index)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      workers_[index].max_buffered_elements = InitialMaxBufferedElements();
+      workers_[index].cond_var.notify_one();
+    }
+
+    // Lets worker `index` buffer one more element, as the consumer waits
+    // for it.
+    void GrowBufferLocked(int64_t index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      WorkerState& worker = workers_[index];
+      if (worker.max_buffered_elements < dataset()->buffer_output_elements_) {
+        ++worker.max_buffered_elements;
+        worker.cond_var.notify_one();
+      }
+    }
+
     Status EnsureWorkerThreadsStarted(IteratorContext* ctx)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (worker_threads_.empty() && input_impl_) {
@@ -681,6 +810,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           }
           if (i < dataset()->cycle_length_) {
             interleave_indices_.push_back(i);
+            workers_[i].max_buffered_elements = InitialMaxBufferedElements();
           } else {
             staging_indices_.push_back(i);
           }
@@ -826,12 +956,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         if (!iterator_creation_status.ok()) {
           mutex_lock l(mu_);
           // Wait for space in the prefetch queue.
-          while (!cancelled_ && workers_[thread_index].outputs.size() ==
-                                    dataset()->buffer_output_elements_) {
-            RecordStop(ctx.get());
-            workers_[thread_index].cond_var.wait(l);
-            RecordStart(ctx.get());
-          }
+          WaitForBufferSpaceLocked(ctx.get(), thread_index, /*bytes=*/0, l);
           if (cancelled_) return;
           tf_shared_lock ckpt_l(ckpt_mu_);
           workers_[thread_index].outputs.emplace_back(iterator_creation_status);
@@ -849,6 +974,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         } else {
           bool end_of_sequence = false;
           while (!end_of_sequence) {
+            int64_t element_bytes = 0;
             if (thread_potentially_in_staging) {
               // Check whether we have left the staging state and reenable
               // auto tune modeling.
@@ -891,6 +1017,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                 end_of_sequence =
                     worker_thread_states_[thread_index].end_of_sequence;
               }
+              if (!end_of_sequence) {
+                element_bytes = GetTotalBytes(
+                    worker_thread_states_[thread_index].output_elem.output);
+              }
               // CHECKPOINT_MARKER_D
               // An element has been read or an error or end_of_sequence has
               // been received from the input iterator and is waiting to be
@@ -902,13 +1032,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               mutex_lock l(mu_);
 
               // Wait for space in the prefetch queue.
-              while (!cancelled_ && workers_[thread_index].outputs.size() ==
-                                        dataset()->buffer_output_elements_) {
-                RecordStop(ctx.get());
-                workers_[thread_index].cond_var.wait(l);
-                RecordStart(ctx.get());
+              const int64_t allocated_bytes = WaitForBufferSpaceLocked(
+                  ctx.get(), thread_index, element_bytes, l);
+              if (cancelled_) {
+                ReleaseBytesLocked(allocated_bytes);
+                return;
               }
-              if (cancelled_) return;
 
               tf_shared_lock ckpt_l(ckpt_mu_);
               workers_[thread_index].is_producing = !end_of_sequence;
@@ -927,6 +1056,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                     worker_thread_states_[thread_index].output_elem.id);
                 workers_[thread_index].outputs.back().output.swap(
                     worker_thread_states_[thread_index].output_elem.output);
+                workers_[thread_index].outputs.back().bytes = allocated_bytes;
               }
               worker_thread_states_[thread_index].output_elem.status =
                   absl::OkStatus();
@@ -990,9 +1120,16 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           reader->ReadScalar(worker_prefix, kOutputsSize, &outputs_size));
       for (int i = 0; i < outputs_size; ++i) {
         workers_[index].outputs.emplace_back(absl::OkStatus());
-        TF_RETURN_IF_ERROR(ReadOutputElemLocked(
-            ctx, reader, &workers_[index].outputs.back(), worker_prefix,
-            strings::StrCat(kOutputs, "_", i)));
+        OutputElem& output_elem = workers_[index].outputs.back();
+        TF_RETURN_IF_ERROR(
+            ReadOutputElemLocked(ctx, reader, &output_elem, worker_prefix,
+                                 strings::StrCat(kOutputs, "_", i)));
+        const int64_t bytes = GetTotalBytes(output_elem.output);
+        if (ram_budget_manager_ &&
+            ram_budget_manager_->RequestLegacyPrefetchBytes(bytes)) {
+          output_elem.bytes = bytes;
+          allocated_bytes_ += bytes;
+        }
       }
       if (reader->Contains(worker_prefix, kIsProducing)) {
         workers_[index].is_producing = true;
@@ -1198,6 +1335,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     size_t next_index_ TF_GUARDED_BY(mu_) = 0;
     // The number of items produced so far within the block
     size_t block_count_ TF_GUARDED_BY(mu_) = 0;
+    // The RAM budget that buffered elements are allocated from, if any.
+    std::shared_ptr<model::RamBudgetManager> ram_budget_manager_;
+    // The bytes allocated from `ram_budget_manager_` for the elements buffered
+    // by all workers.
+    int64_t allocated_bytes_ TF_GUARDED_BY(mu_) = 0;
     // Flag to instruct the worker threads to exit.
     bool cancelled_ TF_GUARDED_BY(mu_) = false;
     // The worker threads. This must be last to ensure the
@@ -250,6 +250,32 @@ ParallelInterleaveDatasetParams ParallelInterleaveDatasetParams5() {
       /*node_name=*/kNodeName);
 }
 
+// Test case 6: cycle_length = 2, block_length = 2, deterministic = true,
+// buffer_output_elements = 4, prefetch_input_elements = 1.
+ParallelInterleaveDatasetParams ParallelInterleaveDatasetParams6() {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(TensorShape{3, 3, 1},
+                                            {0, 1, 2, 3, 4, 5, 6, 7, 8})},
+      /*node_name=*/"tensor_slice");
+  return ParallelInterleaveDatasetParams(
+      tensor_slice_dataset_params,
+      /*other_arguments=*/{},
+      /*cycle_length=*/2,
+      /*block_length=*/2,
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*buffer_output_elements=*/4,
+      /*prefetch_input_elements=*/1,
+      /*func=*/
+      MakeTensorSliceDatasetFunc(
+          DataTypeVector({DT_INT64}),
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})),
+      /*func_lib=*/{test::function::MakeTensorSliceDataset()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*node_name=*/kNodeName);
+}
+
 ParallelInterleaveDatasetParams EmptyInputParams() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
       /*components=*/{Tensor{}},
@@ -512,6 +538,39 @@ ITERATOR_SAVE_AND_RESTORE_TEST_P(ParallelInterleaveDatasetOpTest,
                                  ParallelInterleaveDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+TEST_F(ParallelInterleaveDatasetOpTest, RamBudget) {
+  auto dataset_params = ParallelInterleaveDatasetParams6();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> expected_outputs;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    expected_outputs.insert(expected_outputs.end(), next.begin(), next.end());
+  }
+
+  // A budget of one int64 lets each worker buffer a single element, which
+  // must not change the order of the elements.
+  constexpr int64_t kBudget = sizeof(int64_t);
+  auto ram_budget_manager = std::make_shared<model::RamBudgetManager>(kBudget);
+  IteratorContext::Params params(iterator_ctx_.get());
+  params.ram_budget_manager = ram_budget_manager;
+  IteratorContext ctx(params);
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(&ctx, /*parent=*/nullptr, "Iterator",
+                                      &iterator));
+  TF_ASSERT_OK(CheckIteratorGetNext(iterator.get(), &ctx, expected_outputs,
+                                    /*compare_order=*/true));
+
+  // The bytes of the elements are returned as they are consumed, and the
+  // autotuner's model allocation does not change them.
+  EXPECT_EQ(ram_budget_manager->AvailableModelRam(), kBudget);
+  EXPECT_TRUE(ram_budget_manager->RequestModelAllocation(kBudget));
+  iterator.reset();
+  EXPECT_EQ(ram_budget_manager->AvailableModelRam(), kBudget);
+}
+
 TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
   std::vector<ParallelInterleaveDatasetParams> invalid_params = {
       InvalidCycleLengthParams(), InvalidBlockLengthParams(),
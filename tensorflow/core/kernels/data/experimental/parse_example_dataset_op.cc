@@ -650,13 +650,14 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                           std::vector<Tensor>* output) {
         thread::ThreadPool* device_threadpool =
             ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
-        std::vector<tstring> slice_vec;
+        // Parse views of the input strings rather than copies of them.
+        std::vector<StringPiece> serialized;
         for (const Tensor& t : input) {
           auto serialized_t = t.flat<tstring>();
-          absl::Span<const tstring> slice(serialized_t.data(),
-                                          serialized_t.size());
-          for (auto it = slice.begin(); it != slice.end(); it++)
-            slice_vec.push_back(*it);
+          serialized.reserve(serialized.size() + serialized_t.size());
+          for (int64_t i = 0; i < serialized_t.size(); ++i) {
+            serialized.emplace_back(serialized_t(i));
+          }
         }
         example::FastParseExampleConfig config = dataset()->config_;
         // local copy of config_ for modification.
@@ -666,7 +667,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         }
         example::Result example_result;
         TF_RETURN_IF_ERROR(FastParseExample(
-            config, slice_vec, {}, device_threadpool, &example_result));
+            config, absl::Span<const StringPiece>(serialized), {},
+            device_threadpool, &example_result));
         (*output).resize(dataset()->key_to_output_index_.size());
         for (int d = 0; d < dataset()->dense_keys_.size(); ++d) {
           int output_index =
@@ -0,0 +1,620 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/ragged_tensor_variant.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// See documentation in ../../../ops/experimental_dataset_ops.cc for a
+// high-level description of the following op.
+
+constexpr char kCurrentFileIndex[] = "current_file_index";
+constexpr char kOffset[] = "offset";
+constexpr char kNumRecords[] = "num_records";
+constexpr char kRecords[] = "records";
+
+// Reads batches of `tf.train.Example` records from TFRecord files and parses
+// each batch with `FastParseExample`, producing the same components as
+// `TFRecordDataset(...).batch(...).parse_example(...)`.
+//
+// The records of a batch are read into buffers that the iterator reuses from
+// one batch to the next, and are parsed in place through `StringPiece` views:
+// no string tensor is materialized between reading and parsing.
+// `FastParseExample` splits the batch into ranges of records that it parses in
+// parallel on the intra-op thread pool.
+//
+// When reading a file fails, the records already read for the batch are kept
+// and the error is returned. The next call completes the batch from the
+// following file, so that no record is dropped under `ignore_errors`.
+class ParseTFRecordExampleDatasetOp : public DatasetOpKernel {
+ public:
+  static constexpr const char* const kDatasetType = "ParseTFRecordExample";
+
+  explicit ParseTFRecordExampleDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_keys", &sparse_keys_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_keys", &dense_keys_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_types", &sparse_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("Tdense", &dense_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_shapes", &dense_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("ragged_keys", &ragged_keys_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("ragged_value_types", &ragged_value_types_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("ragged_split_types", &ragged_split_types_));
+    for (int i = 0; i < dense_shapes_.size(); ++i) {
+      bool shape_ok = true;
+      if (dense_shapes_[i].dims() == -1) {
+        shape_ok = false;
+      } else {
+        for (int d = 1; d < dense_shapes_[i].dims(); ++d) {
+          if (dense_shapes_[i].dim_size(d) == -1) {
+            shape_ok = false;
+          }
+        }
+      }
+      OP_REQUIRES(ctx, shape_ok,
+                  errors::InvalidArgument(
+                      "dense_shapes[", i,
+                      "] has unknown rank or unknown inner dimensions: ",
+                      dense_shapes_[i].DebugString()));
+      TensorShape dense_shape;
+      if (dense_shapes_[i].dims() > 0 && dense_shapes_[i].dim_size(0) == -1) {
+        variable_length_.push_back(true);
+        for (int d = 1; d < dense_shapes_[i].dims(); ++d) {
+          dense_shape.AddDim(dense_shapes_[i].dim_size(d));
+        }
+      } else {
+        variable_length_.push_back(false);
+        dense_shapes_[i].AsTensorShape(&dense_shape);
+      }
+      elements_per_stride_.push_back(dense_shape.num_elements());
+    }
+    metrics::RecordParseDenseFeature(dense_keys_.size());
+    metrics::RecordParseSparseFeature(sparse_keys_.size());
+  }
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<tstring>()(i));
+      metrics::RecordTFDataFilename(kDatasetType, filenames[i]);
+    }
+    LogFilenames(filenames);
+
+    tstring compression_type;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, "compression_type",
+                                                     &compression_type));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+
+    int64_t buffer_size = -1;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64_t>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size >= 0,
+                errors::InvalidArgument(
+                    "`buffer_size` must be >= 0 (0 == no buffering)"));
+    if (buffer_size > 0) {
+      options.buffer_size = buffer_size;
+    }
+
+    int64_t batch_size = 0;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64_t>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("Batch size must be greater than zero."));
+
+    bool drop_remainder = false;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<bool>(ctx, "drop_remainder",
+                                                  &drop_remainder));
+
+    OpInputList dense_default_tensors;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input_list("dense_defaults", &dense_default_tensors));
+    OP_REQUIRES(ctx, dense_default_tensors.size() == dense_keys_.size(),
+                errors::InvalidArgument(
+                    "Expected len(dense_defaults) == len(dense_keys) but got: ",
+                    dense_default_tensors.size(), " vs. ", dense_keys_.size()));
+    std::vector<Tensor> dense_defaults(dense_default_tensors.begin(),
+                                       dense_default_tensors.end());
+    for (int d = 0; d < dense_keys_.size(); ++d) {
+      const Tensor& def_value = dense_defaults[d];
+      if (variable_length_[d]) {
+        OP_REQUIRES(ctx, def_value.NumElements() == 1,
+                    errors::InvalidArgument(
+                        "dense_shape[", d, "] is a variable length shape: ",
+                        dense_shapes_[d].DebugString(),
+                        ", therefore def_value[", d,
+                        "] must contain a single element (the padding "
+                        "element).  But its shape is: ",
+                        def_value.shape().DebugString()));
+      } else if (def_value.NumElements() > 0) {
+        OP_REQUIRES(ctx, dense_shapes_[d].IsCompatibleWith(def_value.shape()),
+                    errors::InvalidArgument(
+                        "def_value[", d,
+                        "].shape() == ", def_value.shape().DebugString(),
+                        " is not compatible with dense_shapes_[", d,
+                        "] == ", dense_shapes_[d].DebugString()));
+      }
+      OP_REQUIRES(ctx, def_value.dtype() == dense_types_[d],
+                  errors::InvalidArgument(
+                      "dense_defaults[", d, "].dtype() == ",
+                      DataTypeString(def_value.dtype()), " != dense_types_[", d,
+                      "] == ", DataTypeString(dense_types_[d])));
+    }
+
+    example::FastParseExampleConfig config;
+    std::map<string, int> key_to_output_index;
+    for (int d = 0; d < dense_keys_.size(); ++d) {
+      config.dense.push_back({dense_keys_[d], dense_types_[d], dense_shapes_[d],
+                              dense_defaults[d], variable_length_[d],
+                              elements_per_stride_[d]});
+      auto result = key_to_output_index.insert({dense_keys_[d], 0});
+      OP_REQUIRES(ctx, result.second,
+                  errors::InvalidArgument("Duplicate key not allowed: ",
+                                          dense_keys_[d]));
+    }
+    for (int d = 0; d < sparse_keys_.size(); ++d) {
+      config.sparse.push_back({sparse_keys_[d], sparse_types_[d]});
+      auto result = key_to_output_index.insert({sparse_keys_[d], 0});
+      OP_REQUIRES(ctx, result.second,
+                  errors::InvalidArgument("Duplicate key not allowed: ",
+                                          sparse_keys_[d]));
+    }
+    for (int d = 0; d < ragged_keys_.size(); ++d) {
+      config.ragged.push_back(
+          {ragged_keys_[d], ragged_value_types_[d], ragged_split_types_[d]});
+      auto result = key_to_output_index.insert({ragged_keys_[d], 0});
+      OP_REQUIRES(ctx, result.second,
+                  errors::InvalidArgument("Duplicate key not allowed: ",
+                                          ragged_keys_[d]));
+    }
+    int i = 0;
+    for (auto& it : key_to_output_index) {
+      it.second = i++;
+    }
+    OP_REQUIRES(ctx, output_types_.size() == key_to_output_index.size(),
+                errors::InvalidArgument(
+                    "Expected one output type per feature but got: ",
+                    output_types_.size(), " vs. ", key_to_output_index.size()));
+
+    *output = new Dataset(ctx, std::move(filenames), compression_type,
+                          buffer_size, options, batch_size, drop_remainder,
+                          std::move(dense_defaults), std::move(config),
+                          std::move(key_to_output_index), this);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            const tstring& compression_type, int64_t buffer_size,
+            const io::RecordReaderOptions& options, int64_t batch_size,
+            bool drop_remainder, std::vector<Tensor> dense_defaults,
+            example::FastParseExampleConfig config,
+            std::map<string, int> key_to_output_index,
+            const ParseTFRecordExampleDatasetOp* op)
+        : DatasetBase(DatasetContext(ctx)),
+          filenames_(std::move(filenames)),
+          compression_type_(compression_type),
+          buffer_size_(buffer_size),
+          options_(options),
+          batch_size_(batch_size),
+          drop_remainder_(drop_remainder),
+          dense_defaults_(std::move(dense_defaults)),
+          config_(std::move(config)),
+          key_to_output_index_(std::move(key_to_output_index)),
+          sparse_keys_(op->sparse_keys_),
+          dense_keys_(op->dense_keys_),
+          ragged_keys_(op->ragged_keys_),
+          sparse_types_(op->sparse_types_),
+          dense_types_(op->dense_types_),
+          ragged_value_types_(op->ragged_value_types_),
+          ragged_split_types_(op->ragged_split_types_),
+          dense_shapes_(op->dense_shapes_),
+          output_types_(op->output_types_),
+          output_shapes_(op->output_shapes_) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return std::make_unique<Iterator>(Iterator::Params{
+          this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return name_utils::DatasetDebugString(kDatasetType);
+    }
+
+    Status InputDatasets(
+        std::vector<const DatasetBase*>* inputs) const override {
+      return absl::OkStatus();
+    }
+
+    Status CheckExternalState() const override { return absl::OkStatus(); }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* compression_type = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
+      Node* buffer_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
+      Node* batch_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+      Node* drop_remainder = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+      std::vector<Node*> dense_defaults_nodes;
+      dense_defaults_nodes.reserve(dense_defaults_.size());
+      for (const Tensor& dense_default : dense_defaults_) {
+        Node* node;
+        TF_RETURN_IF_ERROR(b->AddTensor(dense_default, &node));
+        dense_defaults_nodes.emplace_back(node);
+      }
+
+      std::vector<std::pair<StringPiece, AttrValue>> attrs;
+      AttrValue sparse_keys_attr;
+      b->BuildAttrValue(sparse_keys_, &sparse_keys_attr);
+      attrs.emplace_back("sparse_keys", sparse_keys_attr);
+      AttrValue dense_keys_attr;
+      b->BuildAttrValue(dense_keys_, &dense_keys_attr);
+      attrs.emplace_back("dense_keys", dense_keys_attr);
+      AttrValue sparse_types_attr;
+      b->BuildAttrValue(sparse_types_, &sparse_types_attr);
+      attrs.emplace_back("sparse_types", sparse_types_attr);
+      AttrValue dense_attr;
+      b->BuildAttrValue(dense_types_, &dense_attr);
+      attrs.emplace_back("Tdense", dense_attr);
+      AttrValue dense_shapes_attr;
+      b->BuildAttrValue(dense_shapes_, &dense_shapes_attr);
+      attrs.emplace_back("dense_shapes", dense_shapes_attr);
+      AttrValue ragged_keys_attr;
+      b->BuildAttrValue(ragged_keys_, &ragged_keys_attr);
+      attrs.emplace_back("ragged_keys", ragged_keys_attr);
+      AttrValue ragged_value_types_attr;
+      b->BuildAttrValue(ragged_value_types_, &ragged_value_types_attr);
+      attrs.emplace_back("ragged_value_types", ragged_value_types_attr);
+      AttrValue ragged_split_types_attr;
+      b->BuildAttrValue(ragged_split_types_, &ragged_split_types_attr);
+      attrs.emplace_back("ragged_split_types", ragged_split_types_attr);
+
+      TF_RETURN_IF_ERROR(b->AddDataset(this,
+                                       {{0, filenames},
+                                        {1, compression_type},
+                                        {2, buffer_size},
+                                        {3, batch_size},
+                                        {4, drop_remainder}},
+                                       {{5, dense_defaults_nodes}}, attrs,
+                                       output));
+      return absl::OkStatus();
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      bool SymbolicCheckpointCompatible() const override { return true; }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(ReadBatchLocked(ctx));
+        const int64_t num_records = num_records_;
+        num_records_ = 0;
+        if (num_records == 0 ||
+            (dataset()->drop_remainder_ &&
+             num_records < dataset()->batch_size_)) {
+          *end_of_sequence = true;
+          return absl::OkStatus();
+        }
+        *end_of_sequence = false;
+        return ParseBatchLocked(ctx, num_records, out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCurrentFileIndex,
+                                               current_file_index_));
+        if (reader_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(prefix(), kOffset, reader_->TellOffset()));
+        }
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kNumRecords, num_records_));
+        if (num_records_ > 0) {
+          Tensor records(DT_STRING, TensorShape({num_records_}));
+          for (int64_t i = 0; i < num_records_; ++i) {
+            records.vec<tstring>()(i) = records_[i];
+          }
+          TF_RETURN_IF_ERROR(writer->WriteTensor(prefix(), kRecords, records));
+        }
+        return absl::OkStatus();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        ResetStreamsLocked();
+        int64_t current_file_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(prefix(), kCurrentFileIndex,
+                                              &current_file_index));
+        current_file_index_ = size_t(current_file_index);
+        if (reader->Contains(prefix(), kOffset)) {
+          int64_t offset;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(prefix(), kOffset, &offset));
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+          TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        }
+        num_records_ = 0;
+        if (reader->Contains(prefix(), kNumRecords)) {
+          int64_t num_records;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(prefix(), kNumRecords, &num_records));
+          if (num_records > 0) {
+            Tensor records;
+            TF_RETURN_IF_ERROR(
+                reader->ReadTensor(prefix(), kRecords, &records));
+            if (records.NumElements() != num_records ||
+                num_records > dataset()->batch_size_) {
+              return errors::DataLoss("Expected ", num_records,
+                                      " buffered records but got ",
+                                      records.NumElements());
+            }
+            records_.resize(dataset()->batch_size_);
+            for (int64_t i = 0; i < num_records; ++i) {
+              records_[i] = records.vec<tstring>()(i);
+            }
+            num_records_ = num_records;
+          }
+        }
+        return absl::OkStatus();
+      }
+
+     private:
+      // Reads records into `records_` until it holds `batch_size` of them,
+      // moving on to the next file as each one is exhausted. On error, the
+      // records read so far stay in `records_` for the next call.
+      Status ReadBatchLocked(IteratorContext* ctx)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        static monitoring::CounterCell* bytes_counter =
+            metrics::GetTFDataBytesReadCounter(kDatasetType);
+        const int64_t batch_size = dataset()->batch_size_;
+        if (records_.size() < batch_size) {
+          records_.resize(batch_size);
+        }
+        while (num_records_ < batch_size) {
+          if (reader_) {
+            tstring& record = records_[num_records_];
+            Status s = reader_->ReadRecord(&record);
+            if (s.ok()) {
+              bytes_counter->IncrementBy(record.size());
+              ++num_records_;
+              continue;
+            }
+            // On errors other than end of file, still move on to the next file
+            // so that the same file does not repeat under `ignore_errors`.
+            ResetStreamsLocked();
+            ++current_file_index_;
+            if (!errors::IsOutOfRange(s)) {
+              return s;
+            }
+          }
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        }
+        return absl::OkStatus();
+      }
+
+      Status ParseBatchLocked(IteratorContext* ctx, int64_t num_records,
+                              std::vector<Tensor>* out_tensors)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        tsl::profiler::TraceMe traceme("ParseTFRecordExampleBatch");
+        thread::ThreadPool* device_threadpool =
+            ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
+        record_views_.clear();
+        for (int64_t i = 0; i < num_records; ++i) {
+          record_views_.emplace_back(records_[i].data(), records_[i].size());
+        }
+        example::Result example_result;
+        TF_RETURN_IF_ERROR(FastParseExample(
+            dataset()->config_, absl::Span<const StringPiece>(record_views_),
+            {}, device_threadpool, &example_result));
+
+        out_tensors->resize(dataset()->key_to_output_index_.size());
+        for (int d = 0; d < dataset()->dense_keys_.size(); ++d) {
+          int output_index =
+              dataset()->key_to_output_index_.at(dataset()->dense_keys_[d]);
+          TF_RETURN_IF_ERROR(CheckOutputTensor(example_result.dense_values[d],
+                                               d, output_index));
+          (*out_tensors)[output_index] =
+              std::move(example_result.dense_values[d]);
+        }
+        for (int d = 0; d < dataset()->sparse_keys_.size(); ++d) {
+          int output_index =
+              dataset()->key_to_output_index_.at(dataset()->sparse_keys_[d]);
+          Tensor serialized_sparse(ctx->allocator({}), DT_VARIANT, {3});
+          auto serialized_sparse_t = serialized_sparse.vec<Variant>();
+          serialized_sparse_t(0) = std::move(example_result.sparse_indices[d]);
+          serialized_sparse_t(1) = std::move(example_result.sparse_values[d]);
+          serialized_sparse_t(2) = std::move(example_result.sparse_shapes[d]);
+          TF_RETURN_IF_ERROR(
+              CheckOutputTensor(serialized_sparse, d, output_index));
+          (*out_tensors)[output_index] = std::move(serialized_sparse);
+        }
+        for (int d = 0; d < dataset()->ragged_keys_.size(); ++d) {
+          int output_index =
+              dataset()->key_to_output_index_.at(dataset()->ragged_keys_[d]);
+          RaggedTensorVariant serialized_ragged;
+          serialized_ragged.append_splits(example_result.ragged_splits[d]);
+          serialized_ragged.set_values(example_result.ragged_values[d]);
+          Tensor ragged_wrapper(ctx->allocator({}), DT_VARIANT, {});
+          ragged_wrapper.scalar<Variant>()() = std::move(serialized_ragged);
+          TF_RETURN_IF_ERROR(
+              CheckOutputTensor(ragged_wrapper, d, output_index));
+          (*out_tensors)[output_index] = std::move(ragged_wrapper);
+        }
+        return absl::OkStatus();
+      }
+
+      Status CheckOutputTensor(const Tensor& tensor, size_t value_index,
+                               size_t output_index) const {
+        if (tensor.dtype() != dataset()->output_dtypes()[output_index]) {
+          return errors::InvalidArgument(
+              "Got wrong type for FastParseExample return value ", value_index,
+              " (expected ",
+              DataTypeString(dataset()->output_dtypes()[output_index]),
+              ", got ", DataTypeString(tensor.dtype()), ").");
+        }
+        if (!dataset()->output_shapes()[output_index].IsCompatibleWith(
+                tensor.shape())) {
+          return errors::InvalidArgument(
+              "Got wrong shape for FastParseExample return value ", value_index,
+              " (expected ",
+              dataset()->output_shapes()[output_index].DebugString(), ", got ",
+              tensor.shape().DebugString(), ").");
+        }
+        return absl::OkStatus();
+      }
+
+      // Sets up reader streams to read from the file at `current_file_index_`.
+      Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_file_index_ >= dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "current_file_index_:", current_file_index_,
+              " >= filenames_.size():", dataset()->filenames_.size());
+        }
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            TranslateFileName(dataset()->filenames_[current_file_index_]),
+            &file_));
+        reader_ = std::make_unique<io::SequentialRecordReader>(
+            file_.get(), dataset()->options_);
+        return absl::OkStatus();
+      }
+
+      // Resets all reader streams.
+      void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        reader_.reset();
+        file_.reset();
+      }
+
+      mutex mu_;
+      size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
+      // `reader_` will borrow the object that `file_` points to, so
+      // we must destroy `reader_` before `file_`.
+      std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
+      std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+      // Serialized records of the current batch. Kept across batches so that
+      // their buffers are reused once they have grown to the record size.
+      std::vector<tstring> records_ TF_GUARDED_BY(mu_);
+      // Number of records of the next batch already read into `records_`.
+      int64_t num_records_ TF_GUARDED_BY(mu_) = 0;
+      // Views of the records being parsed.
+      std::vector<StringPiece> record_views_ TF_GUARDED_BY(mu_);
+    };
+
+    const std::vector<string> filenames_;
+    const tstring compression_type_;
+    const int64_t buffer_size_;
+    const io::RecordReaderOptions options_;
+    const int64_t batch_size_;
+    const bool drop_remainder_;
+    const std::vector<Tensor> dense_defaults_;
+    const example::FastParseExampleConfig config_;
+    const std::map<string, int> key_to_output_index_;
+    const std::vector<string> sparse_keys_;
+    const std::vector<string> dense_keys_;
+    const std::vector<string> ragged_keys_;
+    const DataTypeVector sparse_types_;
+    const DataTypeVector dense_types_;
+    const DataTypeVector ragged_value_types_;
+    const DataTypeVector ragged_split_types_;
+    const std::vector<PartialTensorShape> dense_shapes_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  std::vector<string> sparse_keys_;
+  std::vector<string> dense_keys_;
+  std::vector<string> ragged_keys_;
+  DataTypeVector sparse_types_;
+  DataTypeVector dense_types_;
+  DataTypeVector ragged_value_types_;
+  DataTypeVector ragged_split_types_;
+  std::vector<PartialTensorShape> dense_shapes_;
+  std::vector<bool> variable_length_;
+  std::vector<std::size_t> elements_per_stride_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("ParseTFRecordExampleDataset").Device(DEVICE_CPU),
+    ParseTFRecordExampleDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,253 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "parse_tfrecord_example_dataset";
+constexpr char kDatasetType[] = "ParseTFRecordExample";
+
+// Parses the int64 feature "a" of shape [1] and the float feature "b" of shape
+// [2]. Outputs are sorted by key, so "a" comes first.
+class ParseTFRecordExampleDatasetParams : public DatasetParams {
+ public:
+  ParseTFRecordExampleDatasetParams(std::vector<tstring> filenames,
+                                    CompressionType compression_type,
+                                    int64_t batch_size, bool drop_remainder,
+                                    string node_name)
+      : DatasetParams(
+            {DT_INT64, DT_FLOAT},
+            {PartialTensorShape({-1, 1}), PartialTensorShape({-1, 2})},
+            std::move(node_name)),
+        filenames_(std::move(filenames)),
+        compression_type_(compression_type),
+        batch_size_(batch_size),
+        drop_remainder_(drop_remainder) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    int num_files = filenames_.size();
+    return {
+        CreateTensor<tstring>(TensorShape({num_files}), filenames_),
+        CreateTensor<tstring>(TensorShape({}), {ToString(compression_type_)}),
+        CreateTensor<int64_t>(TensorShape({}), {/*buffer_size=*/0}),
+        CreateTensor<int64_t>(TensorShape({}), {batch_size_}),
+        CreateTensor<bool>(TensorShape({}), {drop_remainder_}),
+        // Empty defaults make both features required.
+        CreateTensor<int64_t>(TensorShape({0}), {}),
+        CreateTensor<float>(TensorShape({0}), {})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"filenames",      "compression_type", "buffer_size",
+                    "batch_size",     "drop_remainder",   "dense_defaults_0",
+                    "dense_defaults_1"};
+    return absl::OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {"sparse_keys", std::vector<string>()},
+        {"dense_keys", std::vector<string>({"a", "b"})},
+        {"sparse_types", DataTypeVector()},
+        {"Tdense", DataTypeVector({DT_INT64, DT_FLOAT})},
+        {"dense_shapes",
+         std::vector<PartialTensorShape>(
+             {PartialTensorShape({1}), PartialTensorShape({2})})},
+        {"output_types", output_dtypes_},
+        {"output_shapes", output_shapes_},
+        {"ragged_keys", std::vector<string>()},
+        {"ragged_value_types", DataTypeVector()},
+        {"ragged_split_types", DataTypeVector()}};
+    return absl::OkStatus();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  std::vector<tstring> filenames_;
+  CompressionType compression_type_;
+  int64_t batch_size_;
+  bool drop_remainder_;
+};
+
+class ParseTFRecordExampleDatasetOpTest : public DatasetOpsTestBase {};
+
+// Returns the serialized example with id `i`, which has a = [i] and
+// b = [i, i + 0.5].
+string MakeExample(int64_t i) {
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  features["a"].mutable_int64_list()->add_value(i);
+  features["b"].mutable_float_list()->add_value(i);
+  features["b"].mutable_float_list()->add_value(i + 0.5f);
+  return example.SerializeAsString();
+}
+
+// Writes the examples with ids `ids` to a TFRecord file.
+tstring WriteExamples(const string& name, const std::vector<int64_t>& ids,
+                      CompressionType compression_type) {
+  const tstring filename = io::JoinPath(testing::TmpDir(), name);
+  std::vector<string> examples;
+  for (int64_t id : ids) examples.push_back(MakeExample(id));
+  CompressionParams params;
+  params.compression_type = compression_type;
+  params.output_buffer_size = 10;
+  std::vector<absl::string_view> records(examples.begin(), examples.end());
+  TF_CHECK_OK(WriteDataToTFRecordFile(filename, records, params));
+  return filename;
+}
+
+// Returns the components of the batch of examples with ids `ids`.
+std::vector<Tensor> Batch(const std::vector<int64_t>& ids) {
+  const int64_t n = ids.size();
+  std::vector<float> b;
+  for (int64_t id : ids) {
+    b.push_back(id);
+    b.push_back(id + 0.5f);
+  }
+  return {CreateTensor<int64_t>(TensorShape({n, 1}), ids),
+          CreateTensor<float>(TensorShape({n, 2}), b)};
+}
+
+std::vector<Tensor> Batches(const std::vector<std::vector<int64_t>>& batches) {
+  std::vector<Tensor> outputs;
+  for (const auto& ids : batches) {
+    for (Tensor& component : Batch(ids)) outputs.push_back(component);
+  }
+  return outputs;
+}
+
+ParseTFRecordExampleDatasetParams TwoFilesParams(
+    CompressionType compression_type, int64_t batch_size,
+    bool drop_remainder) {
+  const string suffix = ToString(compression_type);
+  return ParseTFRecordExampleDatasetParams(
+      {WriteExamples(absl::StrCat("examples_1_", suffix), {0, 1, 2},
+                     compression_type),
+       WriteExamples(absl::StrCat("examples_2_", suffix), {3, 4},
+                     compression_type)},
+      compression_type, batch_size, drop_remainder, kNodeName);
+}
+
+std::vector<GetNextTestCase<ParseTFRecordExampleDatasetParams>>
+GetNextTestCases() {
+  return {
+      // Batches span files.
+      {TwoFilesParams(CompressionType::UNCOMPRESSED, /*batch_size=*/2,
+                      /*drop_remainder=*/false),
+       Batches({{0, 1}, {2, 3}, {4}})},
+      {TwoFilesParams(CompressionType::UNCOMPRESSED, /*batch_size=*/2,
+                      /*drop_remainder=*/true),
+       Batches({{0, 1}, {2, 3}})},
+      {TwoFilesParams(CompressionType::GZIP, /*batch_size=*/3,
+                      /*drop_remainder=*/false),
+       Batches({{0, 1, 2}, {3, 4}})},
+      {TwoFilesParams(CompressionType::ZLIB, /*batch_size=*/10,
+                      /*drop_remainder=*/false),
+       Batches({{0, 1, 2, 3, 4}})}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(ParseTFRecordExampleDatasetOpTest,
+                         ParseTFRecordExampleDatasetParams, GetNextTestCases())
+
+TEST_F(ParseTFRecordExampleDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = TwoFilesParams(CompressionType::UNCOMPRESSED, 2, false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64, DT_FLOAT}));
+}
+
+TEST_F(ParseTFRecordExampleDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = TwoFilesParams(CompressionType::UNCOMPRESSED, 2, false);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes(
+      {PartialTensorShape({-1, 1}), PartialTensorShape({-1, 2})}));
+}
+
+// A file that cannot be read fails the batch being read, but the records
+// already read for it are returned with the next batch.
+TEST_F(ParseTFRecordExampleDatasetOpTest, PartialBatchIsKeptOnError) {
+  const string corrupted =
+      io::JoinPath(testing::TmpDir(), "examples_corrupted");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), corrupted,
+                                 "not a TFRecord file, long enough"));
+  auto dataset_params = ParseTFRecordExampleDatasetParams(
+      {WriteExamples("examples_before_corrupted", {0, 1, 2},
+                     CompressionType::UNCOMPRESSED),
+       corrupted,
+       WriteExamples("examples_after_corrupted", {3, 4},
+                     CompressionType::UNCOMPRESSED)},
+      CompressionType::UNCOMPRESSED, /*batch_size=*/2,
+      /*drop_remainder=*/false, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors, Batch({0, 1}), /*compare_order=*/true));
+
+  out_tensors.clear();
+  EXPECT_TRUE(errors::IsDataLoss(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)));
+
+  // Record 2 was read before the error.
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors, Batch({2, 3}), /*compare_order=*/true));
+
+  out_tensors.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  TF_EXPECT_OK(ExpectEqual(out_tensors, Batch({4}), /*compare_order=*/true));
+
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+}
+
+TEST_F(ParseTFRecordExampleDatasetOpTest, InvalidBatchSize) {
+  auto dataset_params = TwoFilesParams(CompressionType::UNCOMPRESSED,
+                                       /*batch_size=*/0, false);
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<ParseTFRecordExampleDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{TwoFilesParams(CompressionType::UNCOMPRESSED, /*batch_size=*/2,
+                          /*drop_remainder=*/false),
+           /*breakpoints=*/{0, 1, 4},
+           Batches({{0, 1}, {2, 3}, {4}})},
+          {TwoFilesParams(CompressionType::GZIP, /*batch_size=*/2,
+                          /*drop_remainder=*/false),
+           /*breakpoints=*/{0, 2},
+           Batches({{0, 1}, {2, 3}, {4}})}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(ParseTFRecordExampleDatasetOpTest,
+                                 ParseTFRecordExampleDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
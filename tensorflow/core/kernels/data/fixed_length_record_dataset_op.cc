@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/fixed_length_record_dataset_op.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/data/global_shuffle_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -100,6 +104,66 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
 
   Status CheckExternalState() const override { return absl::OkStatus(); }
 
+  // Counting the records requires the size of every file, so the cardinality
+  // is only computed when the caller allows moderate effort.
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    if (!compression_type_.empty() ||
+        options.compute_level() <
+            CardinalityOptions::CARDINALITY_COMPUTE_MODERATE) {
+      return kUnknownCardinality;
+    }
+    mutex_lock l(mu_);
+    Status s = InitializeRecordIndex();
+    if (!s.ok()) {
+      VLOG(1) << "Failed to count the records of " << DebugString() << ": "
+              << s;
+      return kUnknownCardinality;
+    }
+    return file_end_records_.empty() ? 0 : file_end_records_.back();
+  }
+
+  Status Get(OpKernelContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    return Get(AnyContext(ctx), index, out_tensors);
+  }
+
+  Status Get(AnyContext ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    RandomAccessFile* file;
+    uint64 offset;
+    TF_RETURN_IF_ERROR(GetRecordLocation(index, &file, &offset));
+    Tensor record_tensor(ctx.allocator, DT_STRING, {});
+    tstring& record = record_tensor.scalar<tstring>()();
+    record.resize_uninitialized(record_bytes_);
+    StringPiece result;
+    TF_RETURN_IF_ERROR(
+        file->Read(offset, record_bytes_, &result, record.mdata()));
+    if (result.size() != record_bytes_) {
+      return errors::DataLoss("Record ", index, " of ", DebugString(),
+                              " is truncated: read ", result.size(), " of ",
+                              record_bytes_, " bytes.");
+    }
+    if (result.data() != record.data()) {
+      memmove(record.mdata(), result.data(), result.size());
+    }
+    static monitoring::CounterCell* bytes_counter =
+        metrics::GetTFDataBytesReadCounter(kDatasetType);
+    bytes_counter->IncrementBy(record_bytes_);
+    out_tensors->clear();
+    out_tensors->push_back(std::move(record_tensor));
+    return absl::OkStatus();
+  }
+
+  absl::Status RandomIndexingCompatible() const override {
+    if (!compression_type_.empty()) {
+      return absl::FailedPreconditionError(
+          absl::StrCat(DebugString(),
+                       " does not support random access to compressed files."));
+    }
+    return absl::OkStatus();
+  }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -128,11 +192,16 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
   class UncompressedIterator : public DatasetIterator<Dataset> {
    public:
     explicit UncompressedIterator(const Params& params)
-        : DatasetIterator<Dataset>(params) {}
+        : DatasetIterator<Dataset>(params),
+          global_shuffle_iterator_(dataset()) {}
 
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (ctx->index_mapper() != nullptr) {
+        return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                end_of_sequence);
+      }
       mutex_lock l(mu_);
       do {
         // We are currently processing a file, so try to read the next record.
@@ -213,6 +282,9 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
 
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      if (ctx->restored_element_count().has_value()) {
+        return global_shuffle_iterator_.Restore(ctx);
+      }
       mutex_lock l(mu_);
       int64_t current_file_index;
       TF_RETURN_IF_ERROR(
@@ -249,6 +321,7 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
         TF_GUARDED_BY(mu_);  // must outlive input_buffer_
     std::unique_ptr<io::InputBuffer> input_buffer_ TF_GUARDED_BY(mu_);
     int64_t file_pos_limit_ TF_GUARDED_BY(mu_) = -1;
+    GlobalShuffleIterator global_shuffle_iterator_;
   };
 
   class CompressedIterator : public DatasetIterator<Dataset> {
@@ -450,6 +523,61 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
     tstring lookahead_cache_ TF_GUARDED_BY(mu_);
   };
 
+  // Computes the number of records in each file, once.
+  Status InitializeRecordIndex() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (record_index_initialized_) return record_index_status_;
+    record_index_initialized_ = true;
+    std::vector<int64_t> file_end_records;
+    file_end_records.reserve(filenames_.size());
+    int64_t num_records = 0;
+    for (const string& filename : filenames_) {
+      uint64 file_size;
+      record_index_status_ = Env::Default()->GetFileSize(filename, &file_size);
+      if (!record_index_status_.ok()) return record_index_status_;
+      const int64_t body_size = file_size - (header_bytes_ + footer_bytes_);
+      if (body_size < 0 || body_size % record_bytes_ != 0) {
+        record_index_status_ = errors::InvalidArgument(
+            "Excluding the header (", header_bytes_, " bytes) and footer (",
+            footer_bytes_, " bytes), input file \"", filename,
+            "\" has body length ", body_size,
+            " bytes, which is not an exact multiple of the record length (",
+            record_bytes_, " bytes).");
+        return record_index_status_;
+      }
+      num_records += body_size / record_bytes_;
+      file_end_records.push_back(num_records);
+    }
+    file_end_records_ = std::move(file_end_records);
+    files_.resize(filenames_.size());
+    return absl::OkStatus();
+  }
+
+  // Returns the file holding record "index" and the record's offset in it.
+  // Files are opened on first access and kept open for the lifetime of the
+  // dataset.
+  Status GetRecordLocation(int64_t index, RandomAccessFile** file,
+                           uint64* offset) const {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(InitializeRecordIndex());
+    const size_t file_index =
+        std::upper_bound(file_end_records_.begin(), file_end_records_.end(),
+                         index) -
+        file_end_records_.begin();
+    if (file_index >= filenames_.size()) {
+      return errors::OutOfRange("Index out of range [0, ",
+                                file_end_records_.back(), "):", index);
+    }
+    if (files_[file_index] == nullptr) {
+      TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(
+          TranslateFileName(filenames_[file_index]), &files_[file_index]));
+    }
+    const int64_t first_record =
+        file_index == 0 ? 0 : file_end_records_[file_index - 1];
+    *file = files_[file_index].get();
+    *offset = header_bytes_ + (index - first_record) * record_bytes_;
+    return absl::OkStatus();
+  }
+
   const std::vector<string> filenames_;
   const int64_t header_bytes_;
   const int64_t record_bytes_;
@@ -457,6 +585,15 @@ class FixedLengthRecordDatasetOp::Dataset : public DatasetBase {
   const int64_t buffer_size_;
   const tstring compression_type_;
   const int op_version_;
+
+  // State for random access, which is only supported for uncompressed files.
+  mutable mutex mu_;
+  mutable bool record_index_initialized_ TF_GUARDED_BY(mu_) = false;
+  mutable Status record_index_status_ TF_GUARDED_BY(mu_);
+  // The number of records in the first i + 1 files.
+  mutable std::vector<int64_t> file_end_records_ TF_GUARDED_BY(mu_);
+  mutable std::vector<std::unique_ptr<RandomAccessFile>> files_
+      TF_GUARDED_BY(mu_);
 };
 
 FixedLengthRecordDatasetOp::FixedLengthRecordDatasetOp(
@@ -222,6 +222,37 @@ TEST_F(FixedLengthRecordDatasetOpTest, Cardinality) {
   TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
 }
 
+TEST_F(FixedLengthRecordDatasetOpTest, RandomAccess) {
+  auto dataset_params = FixedLengthRecordDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(dataset_->RandomIndexingCompatible());
+  CardinalityOptions options;
+  options.set_compute_level(CardinalityOptions::CARDINALITY_COMPUTE_MODERATE);
+  EXPECT_EQ(dataset_->Cardinality(options), 5);
+
+  std::vector<Tensor> out_tensors;
+  TF_ASSERT_OK(dataset_->Get(AnyContext(iterator_ctx_.get()), 3, &out_tensors));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<tstring>(TensorShape({}), {{"aaa"}}),
+                           /*compare_order=*/true));
+  TF_ASSERT_OK(dataset_->Get(AnyContext(iterator_ctx_.get()), 2, &out_tensors));
+  TF_EXPECT_OK(ExpectEqual(out_tensors,
+                           CreateTensors<tstring>(TensorShape({}), {{"333"}}),
+                           /*compare_order=*/true));
+  EXPECT_EQ(
+      dataset_->Get(AnyContext(iterator_ctx_.get()), 5, &out_tensors).code(),
+      absl::StatusCode::kOutOfRange);
+}
+
+TEST_F(FixedLengthRecordDatasetOpTest, NoRandomAccessWhenCompressed) {
+  auto dataset_params = FixedLengthRecordDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  EXPECT_FALSE(dataset_->RandomIndexingCompatible().ok());
+  CardinalityOptions options;
+  options.set_compute_level(CardinalityOptions::CARDINALITY_COMPUTE_MODERATE);
+  EXPECT_EQ(dataset_->Cardinality(options), kUnknownCardinality);
+}
+
 TEST_F(FixedLengthRecordDatasetOpTest, IteratorOutputDtypes) {
   auto dataset_params = FixedLengthRecordDatasetParams1();
   TF_ASSERT_OK(Initialize(dataset_params));
@@ -14,8 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -38,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/stringprintf.h"
 
 namespace tensorflow {
@@ -63,6 +66,9 @@ namespace data {
 
 const int64_t kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64_t kMaxEpochsInBuffer = 3;
+// When the shuffle buffer holds indices into the input, the number of
+// elements that are selected ahead of time and read concurrently.
+const int64_t kReadAheadElements = 16;
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kDataProduced[] = "data_produced";
@@ -80,6 +86,10 @@ constexpr char kShuffleDatasetV2[] = "ShuffleDatasetV2";
 constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
 constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
+constexpr char kHandles[] = "handles";
+constexpr char kPendingHandles[] = "pending_handles";
+constexpr char kNextHandle[] = "next_handle";
+constexpr char kShuffleHandlesExperiment[] = "shuffle_handles";
 
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx) {}
@@ -96,6 +106,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         buffer_size_(buffer_size),
         seed_generator_(std::move(seed_generator)),
         count_(count),
+        shuffle_handles_(input_->RandomIndexingCompatible().ok() &&
+                         GetExperiments().contains(kShuffleHandlesExperiment)),
         traceme_metadata_(
             {{"buffer_size",
               strings::Printf("%lld", static_cast<long long>(buffer_size))}}) {
@@ -190,13 +202,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         : DatasetIterator<ShuffleDatasetBase>(params),
           seed_generator_(seed_generator),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
-          generator_(&parent_generator_) {
-      if (params.dataset->buffer_size_ == kUnknownCardinality) {
-        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
-      } else {
-        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>(
-            params.dataset->buffer_size_);
-      }
+          generator_(&parent_generator_) {}
+
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      CancelPendingReads();
     }
 
     bool SymbolicCheckpointCompatible() const override { return true; }
@@ -205,6 +215,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
+      InitializeBuffer(ctx);
       // Initialize checkpoint_indices_ to the entire buffer.
       if (ctx->symbolic_checkpoint()) {
         for (int64_t i = 0; i < buffer_->size(); ++i) {
@@ -218,29 +229,23 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
       mutex_lock l(mu_);
+      if (use_handles_) {
+        return GetNextFromHandles(ctx, out_tensors, end_of_sequence);
+      }
       TF_RETURN_IF_ERROR(FillBuffer(ctx));
       if (num_elements_ == 0) {
-        DCHECK(input_impl_ == nullptr);
+        DCHECK(!HasInput());
         *end_of_sequence = true;
         return absl::OkStatus();
       }
 
       *end_of_sequence = false;
-      ClearEmptySlices();
-      DCHECK(!slices_.empty());
-      // Choose an element to produce uniformly at random from the first
-      // slice, and then remove the element from the slice.
-      int64_t offset =
-          Random() % (slices_.front()->end - slices_.front()->start);
-      int64_t index = (slices_.front()->start + offset) % buffer_->size();
+      int64_t index;
+      int64_t front;
+      RemoveRandomElement(&index, &front);
       *out_tensors = std::move(buffer_->at(index));
       this->RecordBufferDequeue(ctx, *out_tensors);
-      std::swap(buffer_->at(index),
-                buffer_->at(slices_.front()->start % buffer_->size()));
-      checkpoint_indices_.insert(index);
-      checkpoint_indices_.insert(slices_.front()->start % buffer_->size());
-      slices_.front()->start++;
-      num_elements_--;
+      std::swap(buffer_->at(index), buffer_->at(front));
       return absl::OkStatus();
     }
 
@@ -274,8 +279,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       // Save input iterator if it hasn't been exhausted else write
       // "end_of_input_sequence".
       TF_RETURN_IF_ERROR(writer->WriteScalar(
-          prefix(), kEndOfInputSequence, static_cast<int64_t>(!input_impl_)));
-      if (input_impl_) {
+          prefix(), kEndOfInputSequence, static_cast<int64_t>(!HasInput())));
+      if (use_handles_ && HasInput()) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kNextHandle, next_handle_));
+      } else if (input_impl_) {
         TF_RETURN_IF_ERROR(this->SaveInput(ctx, writer, input_impl_));
       }
 
@@ -284,7 +292,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(prefix(), kNumElements, num_elements_));
       const std::string key_prefix = absl::StrCat(prefix(), kColon, "buffer");
-      if (ctx->symbolic_checkpoint()) {
+      if (use_handles_) {
+        TF_RETURN_IF_ERROR(SaveHandles(writer));
+      } else if (ctx->symbolic_checkpoint()) {
         // When symbolic checkpointing is turned on, `writer`
         // already contains checkpoint of the shuffle buffer created by the
         // previous invocation of this instance and the indices that need to be
@@ -334,16 +344,30 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(reader->ReadScalar(prefix(), kSeed2, &seed2_));
       ResetRngs();
 
+      if (reader->Contains(prefix(), kHandles) != use_handles_) {
+        return errors::FailedPrecondition(
+            "The shuffle buffer was checkpointed ",
+            use_handles_ ? "with" : "without", " the ",
+            kShuffleHandlesExperiment, " experiment, which must be ",
+            use_handles_ ? "disabled" : "enabled",
+            " to restore it. Check the TF_DATA_EXPERIMENT_OPT_IN and "
+            "TF_DATA_EXPERIMENT_OPT_OUT environment variables.");
+      }
+
       // Restore the input iterator if it wasn't already exhausted.
       int64_t input_empty;
       TF_RETURN_IF_ERROR(
           reader->ReadScalar(prefix(), kEndOfInputSequence, &input_empty));
+      ResetInput();
       if (static_cast<bool>(!input_empty)) {
-        TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
-            ctx, this, this->prefix(), &input_impl_));
-        TF_RETURN_IF_ERROR(this->RestoreInput(ctx, reader, input_impl_));
-      } else {
-        input_impl_.reset();
+        if (use_handles_) {
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(prefix(), kNextHandle, &next_handle_));
+        } else {
+          TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+              ctx, this, this->prefix(), &input_impl_));
+          TF_RETURN_IF_ERROR(this->RestoreInput(ctx, reader, input_impl_));
+        }
       }
 
       // Restore the epoch counter, buffer, and buffer slices.
@@ -357,21 +381,25 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->prefix(), kSlicesSize, &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
-      TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(
-          ctx, reader, absl::StrCat(prefix(), kColon, "buffer"),
-          buffer_.get()));
-      if (ctx->symbolic_checkpoint()) {
-        DCHECK(checkpoint_indices_.empty());
-        for (size_t i = 0; i < buffer_->size(); ++i) {
-          checkpoint_indices_.insert(i);
+      if (use_handles_) {
+        TF_RETURN_IF_ERROR(RestoreHandles(ctx, reader));
+      } else {
+        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
+        TF_RETURN_IF_ERROR(ReadElementsFromCheckpoint(
+            ctx, reader, absl::StrCat(prefix(), kColon, "buffer"),
+            buffer_.get()));
+        if (ctx->symbolic_checkpoint()) {
+          DCHECK(checkpoint_indices_.empty());
+          for (size_t i = 0; i < buffer_->size(); ++i) {
+            checkpoint_indices_.insert(i);
+          }
+        }
+        for (const auto& element : *buffer_) {
+          RecordBufferEnqueue(ctx, element);
+        }
+        if (!IsShuffleAll()) {
+          buffer_->resize(dataset()->buffer_size_);
         }
-      }
-      for (const auto& element : *buffer_) {
-        RecordBufferEnqueue(ctx, element);
-      }
-      if (!IsShuffleAll()) {
-        buffer_->resize(dataset()->buffer_size_);
       }
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
@@ -417,6 +445,165 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       bool reached_end_of_sequence = false;
     };
 
+    // An element that has been removed from the buffer of handles and is
+    // being read from the input.
+    struct PendingRead {
+      explicit PendingRead(int64_t handle) : handle(handle) {}
+
+      const int64_t handle;
+      Notification done;
+      Status status;
+      std::vector<Tensor> element;
+    };
+
+    // Sizes the buffer. Unless the input is split among workers, the buffer
+    // holds the indices of the input elements rather than the elements
+    // themselves when the dataset allows it and the input's cardinality can be
+    // determined.
+    void InitializeBuffer(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (dataset()->shuffle_handles_ && ctx->split_providers().empty()) {
+        CardinalityOptions options;
+        options.set_compute_level(
+            CardinalityOptions::CARDINALITY_COMPUTE_MODERATE);
+        input_cardinality_ = dataset()->input_->Cardinality(options);
+        use_handles_ = input_cardinality_ >= 0;
+      }
+      const int64_t buffer_size = IsShuffleAll() ? 0 : dataset()->buffer_size_;
+      if (use_handles_) {
+        VLOG(1) << "Shuffling the indices of " << input_cardinality_
+                << " elements of " << dataset()->input_->DebugString();
+        runner_ = *ctx->runner();
+        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
+        handles_.resize(buffer_size);
+      } else {
+        buffer_ =
+            std::make_unique<std::vector<std::vector<Tensor>>>(buffer_size);
+      }
+    }
+
+    size_t BufferSize() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return use_handles_ ? handles_.size() : buffer_->size();
+    }
+
+    // Returns true if an epoch of the input is in progress.
+    bool HasInput() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return use_handles_ ? next_handle_ >= 0 : input_impl_ != nullptr;
+    }
+
+    void ResetInput() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      input_impl_.reset();
+      next_handle_ = -1;
+    }
+
+    // Chooses an element uniformly at random from the first slice and removes
+    // it from the slice. Sets `*index` to the element's position in the buffer
+    // and `*front` to the position of the slice's first element, which the
+    // caller moves into `*index` once it has taken the element.
+    void RemoveRandomElement(int64_t* index, int64_t* front)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      ClearEmptySlices();
+      DCHECK(!slices_.empty());
+      int64_t offset =
+          Random() % (slices_.front()->end - slices_.front()->start);
+      *index = (slices_.front()->start + offset) % BufferSize();
+      *front = slices_.front()->start % BufferSize();
+      if (!use_handles_) {
+        checkpoint_indices_.insert(*index);
+        checkpoint_indices_.insert(*front);
+      }
+      slices_.front()->start++;
+      num_elements_--;
+    }
+
+    // Selects elements in the same order as the buffer of elements would, but
+    // up to `kReadAheadElements` ahead of the consumer, so that they are read
+    // from the input concurrently.
+    Status GetNextFromHandles(IteratorContext* ctx,
+                              std::vector<Tensor>* out_tensors,
+                              bool* end_of_sequence)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (pending_reads_.size() < kReadAheadElements) {
+        TF_RETURN_IF_ERROR(FillBuffer(ctx));
+        if (num_elements_ == 0) {
+          DCHECK(!HasInput());
+          break;
+        }
+        int64_t index;
+        int64_t front;
+        RemoveRandomElement(&index, &front);
+        StartRead(ctx, handles_[index]);
+        handles_[index] = handles_[front];
+      }
+      if (pending_reads_.empty()) {
+        *end_of_sequence = true;
+        return absl::OkStatus();
+      }
+      std::shared_ptr<PendingRead> read = std::move(pending_reads_.front());
+      pending_reads_.pop_front();
+      read->done.WaitForNotification();
+      TF_RETURN_IF_ERROR(read->status);
+      *out_tensors = std::move(read->element);
+      *end_of_sequence = false;
+      return absl::OkStatus();
+    }
+
+    void StartRead(IteratorContext* ctx, int64_t handle)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      auto read = std::make_shared<PendingRead>(handle);
+      pending_reads_.push_back(read);
+      // The runner of `ctx` only lives for the duration of the call.
+      AnyContext any_ctx(ctx);
+      any_ctx.runner = &runner_;
+      const DatasetBase* input = dataset()->input_;
+      runner_([input, any_ctx, read]() {
+        read->status = input->Get(any_ctx, read->handle, &read->element);
+        read->done.Notify();
+      });
+    }
+
+    // Waits for the reads in flight and discards their results.
+    void CancelPendingReads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (const auto& read : pending_reads_) {
+        read->done.WaitForNotification();
+      }
+      pending_reads_.clear();
+    }
+
+    Status SaveHandles(IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Tensor handles(DT_INT64,
+                     TensorShape({static_cast<int64_t>(handles_.size())}));
+      std::copy(handles_.begin(), handles_.end(),
+                handles.flat<int64_t>().data());
+      TF_RETURN_IF_ERROR(writer->WriteTensor(prefix(), kHandles, handles));
+      // Elements that have been selected but not yet produced are read again
+      // after restoring.
+      const int64_t num_pending = pending_reads_.size();
+      Tensor pending(DT_INT64, TensorShape({num_pending}));
+      for (size_t i = 0; i < pending_reads_.size(); ++i) {
+        pending.flat<int64_t>()(i) = pending_reads_[i]->handle;
+      }
+      return writer->WriteTensor(prefix(), kPendingHandles, pending);
+    }
+
+    Status RestoreHandles(IteratorContext* ctx, IteratorStateReader* reader)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Tensor handles;
+      TF_RETURN_IF_ERROR(reader->ReadTensor(prefix(), kHandles, &handles));
+      const auto handles_flat = handles.flat<int64_t>();
+      handles_.assign(handles_flat.data(),
+                      handles_flat.data() + handles_flat.size());
+      Tensor pending;
+      TF_RETURN_IF_ERROR(
+          reader->ReadTensor(prefix(), kPendingHandles, &pending));
+      CancelPendingReads();
+      for (int64_t i = 0; i < pending.NumElements(); ++i) {
+        StartRead(ctx, pending.flat<int64_t>()(i));
+      }
+      return absl::OkStatus();
+    }
+
     random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       num_random_samples_++;
@@ -452,21 +639,29 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
               << "Filling up shuffle buffer (this may take a while): "
               << num_elements_ << " of " << BufferSizeString();
         }
-        if (!input_impl_) {
+        if (!HasInput()) {
           TF_RETURN_IF_ERROR(PrepareNextEpoch(ctx));
         }
         std::vector<Tensor> input_element;
         bool end_of_input_sequence = false;
-        TF_RETURN_IF_ERROR(
-            input_impl_->GetNext(ctx, &input_element, &end_of_input_sequence));
+        if (use_handles_) {
+          end_of_input_sequence = next_handle_ == input_cardinality_;
+        } else {
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &input_element,
+                                                  &end_of_input_sequence));
+        }
         if (end_of_input_sequence) {
           slices_.back()->reached_end_of_sequence = true;
         }
         if (!end_of_input_sequence) {
-          AddToShuffleBuffer(ctx, std::move(input_element));
+          if (use_handles_) {
+            AddHandleToShuffleBuffer(next_handle_++);
+          } else {
+            AddToShuffleBuffer(ctx, std::move(input_element));
+          }
           continue;
         }
-        input_impl_.reset();
+        ResetInput();
         // Reached end of input_impl_.
         if (ctx->split_providers().empty() && !data_produced_ &&
             this->dataset()->count_ == -1) {
@@ -483,7 +678,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     }
 
     bool ShouldFillBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-      if (!input_impl_ && dataset()->count_ != -1 &&
+      if (!HasInput() && dataset()->count_ != -1 &&
           epoch_ >= dataset()->count_) {
         return false;
       }
@@ -500,7 +695,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // we need to add to the buffer.
         return true;
       }
-      return num_elements_ < buffer_->size();
+      return num_elements_ < BufferSize();
     }
 
     Status PrepareNextEpoch(IteratorContext* ctx)
@@ -514,8 +709,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           TF_RETURN_IF_ERROR(provider->Reset());
         }
       }
-      TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
-          ctx, this, this->prefix(), &input_impl_));
+      if (use_handles_) {
+        next_handle_ = 0;
+      } else {
+        TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+            ctx, this, this->prefix(), &input_impl_));
+      }
       epoch_++;
       return absl::OkStatus();
     }
@@ -541,6 +740,19 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       slices_.back()->end++;
     }
 
+    void AddHandleToShuffleBuffer(int64_t handle)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      data_produced_ = true;
+      if (num_elements_ == handles_.size()) {
+        DCHECK(IsShuffleAll());
+        handles_.push_back(handle);
+      } else {
+        handles_[slices_.back()->end % handles_.size()] = handle;
+      }
+      num_elements_++;
+      slices_.back()->end++;
+    }
+
     void ClearEmptySlices() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       // Garbage collect all empty slices.
       while (slices_.front()->start == slices_.front()->end) {
@@ -560,6 +772,18 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
+    // If true, `handles_` stands in for `buffer_` and holds the indices of
+    // input elements, which are read with `DatasetBase::Get()` once selected.
+    bool use_handles_ TF_GUARDED_BY(mu_) = false;
+    std::vector<int64_t> handles_ TF_GUARDED_BY(mu_);
+    int64_t input_cardinality_ TF_GUARDED_BY(mu_) = kUnknownCardinality;
+    // The index of the next element of the current input epoch, or -1 if
+    // there is none. Stands in for `input_impl_` when `use_handles_` is true.
+    int64_t next_handle_ TF_GUARDED_BY(mu_) = -1;
+    // Selected elements in the order they are to be produced.
+    std::deque<std::shared_ptr<PendingRead>> pending_reads_ TF_GUARDED_BY(mu_);
+    // Runs the reads of selected elements. Set by Initialize().
+    std::function<void(std::function<void()>)> runner_;
     // Holds the indices of `buffer_` that have changed since the previous
     // `SaveInternal()` and need to be updated in the MemoryCheckpoint
     // (if symbolic checkpointing is used) in the next `SaveInternal()`.
@@ -588,6 +812,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   // fuse shuffle and repeat together, and make the shuffle dataset op
   // responsible for repeating as well.
   const int64_t count_;
+  // Whether the iterator may shuffle the indices of the input's elements, and
+  // read the elements once selected, rather than buffering the elements. This
+  // bounds the memory used by large buffers over inputs such as records in
+  // files, which support random access.
+  const bool shuffle_handles_;
   const TraceMeMetadata traceme_metadata_;
   mutable mutex mu_;
   mutable std::vector<std::int64_t> shuffled_indices_ TF_GUARDED_BY(mu_);
@@ -583,6 +583,62 @@ INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+// Shuffling the indices of a random-access input produces the same elements
+// in the same order as shuffling the elements themselves.
+class ParameterizedShuffleHandlesTest
+    : public ShuffleDatasetOpTest,
+      public ::testing::WithParamInterface<
+          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {
+ protected:
+  void SetUp() override {
+    setenv("TF_JOB_NAME", "test_job", /*overwrite=*/1);
+    setenv("TF_TASK_ID", "0", /*overwrite=*/1);
+    setenv("TF_DATA_EXPERIMENT_OPT_IN", "shuffle_handles", /*overwrite=*/1);
+  }
+
+  void TearDown() override {
+    unsetenv("TF_JOB_NAME");
+    unsetenv("TF_TASK_ID");
+    unsetenv("TF_DATA_EXPERIMENT_OPT_IN");
+  }
+};
+
+TEST_P(ParameterizedShuffleHandlesTest, IteratorSaveAndRestore) {
+  auto test_case = GetParam();
+  TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  int cur_iteration = 0;
+  for (int breakpoint : test_case.breakpoints) {
+    VariantTensorDataWriter writer;
+    TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+    std::vector<const VariantTensorData*> data;
+    writer.GetData(&data);
+    VariantTensorDataReader reader(data);
+    TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                 test_case.dataset_params.iterator_prefix(),
+                                 *dataset_, &iterator_));
+
+    while (cur_iteration <= breakpoint) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+      cur_iteration++;
+    }
+  }
+
+  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                           /*compare_order=*/true));
+}
+
+INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest, ParameterizedShuffleHandlesTest,
+                        ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
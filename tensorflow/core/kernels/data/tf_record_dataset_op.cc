@@ -263,8 +263,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
           TranslateFileName(dataset()->filenames_[current_file_index_]),
           &file_));
-      reader_ = std::make_unique<io::SequentialRecordReader>(
-          file_.get(), dataset()->options_);
+      // Keep a read in flight while the current buffer is parsed, so that
+      // e.g. the inputs of a parallel interleave overlap their I/O with
+      // parsing. This is only worth it when the file system does not tie up
+      // a thread for each read.
+      io::RecordReaderOptions options = dataset()->options_;
+      options.read_ahead = file_->HasNativeReadAsync();
+      reader_ =
+          std::make_unique<io::SequentialRecordReader>(file_.get(), options);
       if (!dataset()->byte_offsets_.empty()) {
         TF_RETURN_IF_ERROR(
             reader_->SeekOffset(dataset()->byte_offsets_[current_file_index_]));
@@ -21,7 +21,7 @@ limitations under the License.
 //   (1) {Conv2D/MatMul} + BiasAdd + <Activation>
 //   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
 //
-// Activation: Relu, Relu6, Elu, etc...
+// Activation: Relu, Relu6, Elu, Gelu etc...
 
 #ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
 #define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -151,6 +151,33 @@ struct LeakyRelu {
   };
 };
 
+// Applies the tanh approximation of `Gelu` to the passed input expression:
+//   0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtTwoOverPi = static_cast<Scalar>(0.7978845608028654);
+    const Scalar kCubeCoefficient = static_cast<Scalar>(0.044715);
+    return expr *
+           (((expr + expr.cube() * kCubeCoefficient) * kSqrtTwoOverPi).tanh() +
+            static_cast<Scalar>(1)) *
+           static_cast<Scalar>(0.5);
+  };
+};
+
+// Applies `Gelu` to the passed input expression:
+//   0.5 * x * (1 + erf(x / sqrt(2)))
+struct GeluExact {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar kSqrtOneHalf = static_cast<Scalar>(0.7071067811865476);
+    return expr * ((expr * kSqrtOneHalf).erf() + static_cast<Scalar>(1)) *
+           static_cast<Scalar>(0.5);
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -163,7 +190,9 @@ struct BiasAddArgs {
            fusion == FusedComputationType::kBiasAddWithTanh ||
            fusion == FusedComputationType::kBiasAddWithSigmoid ||
            fusion == FusedComputationType::kBiasAddWithElu ||
-           fusion == FusedComputationType::kBiasAddWithLeakyRelu;
+           fusion == FusedComputationType::kBiasAddWithLeakyRelu ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate ||
+           fusion == FusedComputationType::kBiasAddWithGeluExact;
   }
 };
 
@@ -398,6 +427,10 @@ using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
 using WithBiasAddAndLeakyRelu = BiasAddOutputKernel<T, LeakyRelu>;
 template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
+using WithBiasAddAndGeluExact = BiasAddOutputKernel<T, GeluExact>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -0,0 +1,514 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Number of output elements evaluated at once. Every op of the program writes
+// a register of this size, so that the registers of a few ops stay in L1
+// cache.
+constexpr int64_t kBlockSize = 512;
+
+enum class Opcode {
+  // Unary ops.
+  kAbs,
+  kCast,
+  kCeil,
+  kExp,
+  kExpm1,
+  kFloor,
+  kLog,
+  kLog1p,
+  kLogicalNot,
+  kNeg,
+  kReciprocal,
+  kRelu,
+  kRelu6,
+  kRsqrt,
+  kSigmoid,
+  kSign,
+  kSqrt,
+  kSquare,
+  kTanh,
+  // Binary ops.
+  kAdd,
+  kDiv,
+  kDivNoNan,
+  kEqual,
+  kGreater,
+  kGreaterEqual,
+  kLess,
+  kLessEqual,
+  kLogicalAnd,
+  kLogicalOr,
+  kMaximum,
+  kMinimum,
+  kMul,
+  kNotEqual,
+  kSquaredDifference,
+  kSub,
+  // Ternary ops.
+  kClipByValue,
+  kSelect,
+};
+
+struct OpcodeInfo {
+  Opcode opcode;
+  int arity;
+  // Approximate cost of the op per element in cycles.
+  int cost;
+};
+
+// WARN: This should be consistent with the FuseElementwiseOps stage of the
+// arithmetic optimizer.
+const std::unordered_map<string, OpcodeInfo>& GetOpcodes() {
+  // clang-format off
+  static const auto* opcodes = new std::unordered_map<string, OpcodeInfo>({
+      {"Abs",               {Opcode::kAbs,               1, 1}},
+      {"Cast",              {Opcode::kCast,              1, 1}},
+      {"Ceil",              {Opcode::kCeil,              1, 1}},
+      {"Exp",               {Opcode::kExp,               1, 10}},
+      {"Expm1",             {Opcode::kExpm1,             1, 10}},
+      {"Floor",             {Opcode::kFloor,             1, 1}},
+      {"Log",               {Opcode::kLog,               1, 10}},
+      {"Log1p",             {Opcode::kLog1p,             1, 10}},
+      {"LogicalNot",        {Opcode::kLogicalNot,        1, 1}},
+      {"Neg",               {Opcode::kNeg,               1, 1}},
+      {"Reciprocal",        {Opcode::kReciprocal,        1, 4}},
+      {"Inv",               {Opcode::kReciprocal,        1, 4}},
+      {"Relu",              {Opcode::kRelu,              1, 1}},
+      {"Relu6",             {Opcode::kRelu6,             1, 2}},
+      {"Rsqrt",             {Opcode::kRsqrt,             1, 4}},
+      {"Sigmoid",           {Opcode::kSigmoid,           1, 12}},
+      {"Sign",              {Opcode::kSign,              1, 2}},
+      {"Sqrt",              {Opcode::kSqrt,              1, 4}},
+      {"Square",            {Opcode::kSquare,            1, 1}},
+      {"Tanh",              {Opcode::kTanh,              1, 12}},
+      {"Add",               {Opcode::kAdd,               2, 1}},
+      {"AddV2",             {Opcode::kAdd,               2, 1}},
+      {"Div",               {Opcode::kDiv,               2, 4}},
+      {"RealDiv",           {Opcode::kDiv,               2, 4}},
+      {"DivNoNan",          {Opcode::kDivNoNan,          2, 5}},
+      {"Equal",             {Opcode::kEqual,             2, 1}},
+      {"Greater",           {Opcode::kGreater,           2, 1}},
+      {"GreaterEqual",      {Opcode::kGreaterEqual,      2, 1}},
+      {"Less",              {Opcode::kLess,              2, 1}},
+      {"LessEqual",         {Opcode::kLessEqual,         2, 1}},
+      {"LogicalAnd",        {Opcode::kLogicalAnd,        2, 1}},
+      {"LogicalOr",         {Opcode::kLogicalOr,         2, 1}},
+      {"Maximum",           {Opcode::kMaximum,           2, 1}},
+      {"Minimum",           {Opcode::kMinimum,           2, 1}},
+      {"Mul",               {Opcode::kMul,               2, 1}},
+      {"NotEqual",          {Opcode::kNotEqual,          2, 1}},
+      {"SquaredDifference", {Opcode::kSquaredDifference, 2, 2}},
+      {"Sub",               {Opcode::kSub,               2, 1}},
+      {"ClipByValue",       {Opcode::kClipByValue,       3, 2}},
+      {"SelectV2",          {Opcode::kSelect,            3, 1}}});
+  // clang-format on
+  return *opcodes;
+}
+
+struct Instruction {
+  Opcode opcode;
+  // Registers read by the op; only the first `arity` entries are used.
+  int operands[3] = {0, 0, 0};
+};
+
+// Returns the values of `size` elements of `input` starting at `offset`, or
+// of the element at `offset` repeated `size` times if `broadcast` is true.
+// Values are converted to float, with booleans as 0 or 1, in `buffer` when
+// they can't be read from `input` directly.
+template <typename T>
+const float* LoadInput(const Tensor& input, int64_t offset, int64_t size,
+                       bool broadcast, float* buffer) {
+  const T* data = input.flat<T>().data() + offset;
+  Eigen::Map<Eigen::ArrayXf> values(buffer, size);
+  if (broadcast) {
+    values.setConstant(static_cast<float>(*data));
+  } else {
+    values =
+        Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(data, size)
+            .template cast<float>();
+  }
+  return buffer;
+}
+
+template <>
+const float* LoadInput<float>(const Tensor& input, int64_t offset,
+                              int64_t size, bool broadcast, float* buffer) {
+  const float* data = input.flat<float>().data() + offset;
+  if (!broadcast) return data;
+  std::fill_n(buffer, size, *data);
+  return buffer;
+}
+
+// Evaluates `instruction` for `size` elements of its operand registers.
+void Evaluate(const Instruction& instruction,
+              const gtl::InlinedVector<const float*, 16>& registers,
+              int64_t size, float* out) {
+  using Array = Eigen::ArrayXf;
+  using MaxOp =
+      Eigen::internal::scalar_max_op<float, float, Eigen::PropagateNaN>;
+  using MinOp =
+      Eigen::internal::scalar_min_op<float, float, Eigen::PropagateNaN>;
+  const auto x = [&](int i) {
+    return Eigen::Map<const Array>(registers[instruction.operands[i]], size);
+  };
+  Eigen::Map<Array> y(out, size);
+
+  switch (instruction.opcode) {
+    case Opcode::kAbs:
+      y = x(0).abs();
+      break;
+    case Opcode::kCast:
+      // Inputs are converted to float when they are loaded, and all registers
+      // hold floats, so a Cast to float is a copy.
+      y = x(0);
+      break;
+    case Opcode::kCeil:
+      y = x(0).ceil();
+      break;
+    case Opcode::kExp:
+      y = x(0).exp();
+      break;
+    case Opcode::kExpm1:
+      y = x(0).expm1();
+      break;
+    case Opcode::kFloor:
+      y = x(0).floor();
+      break;
+    case Opcode::kLog:
+      y = x(0).log();
+      break;
+    case Opcode::kLog1p:
+      y = x(0).log1p();
+      break;
+    case Opcode::kLogicalNot:
+      y = (x(0) == 0.0f).cast<float>();
+      break;
+    case Opcode::kNeg:
+      y = -x(0);
+      break;
+    case Opcode::kReciprocal:
+      y = x(0).inverse();
+      break;
+    case Opcode::kRelu:
+      y = x(0).max(0.0f);
+      break;
+    case Opcode::kRelu6:
+      y = x(0).max(0.0f).min(6.0f);
+      break;
+    case Opcode::kRsqrt:
+      y = x(0).rsqrt();
+      break;
+    case Opcode::kSigmoid:
+      y = x(0).logistic();
+      break;
+    case Opcode::kSign:
+      y = x(0).sign();
+      break;
+    case Opcode::kSqrt:
+      y = x(0).sqrt();
+      break;
+    case Opcode::kSquare:
+      y = x(0).square();
+      break;
+    case Opcode::kTanh:
+      y = x(0).tanh();
+      break;
+    case Opcode::kAdd:
+      y = x(0) + x(1);
+      break;
+    case Opcode::kDiv:
+      y = x(0) / x(1);
+      break;
+    case Opcode::kDivNoNan:
+      y = (x(1) == 0.0f).select(0.0f, x(0) / x(1));
+      break;
+    case Opcode::kEqual:
+      y = (x(0) == x(1)).cast<float>();
+      break;
+    case Opcode::kGreater:
+      y = (x(0) > x(1)).cast<float>();
+      break;
+    case Opcode::kGreaterEqual:
+      y = (x(0) >= x(1)).cast<float>();
+      break;
+    case Opcode::kLess:
+      y = (x(0) < x(1)).cast<float>();
+      break;
+    case Opcode::kLessEqual:
+      y = (x(0) <= x(1)).cast<float>();
+      break;
+    case Opcode::kLogicalAnd:
+      y = ((x(0) != 0.0f) && (x(1) != 0.0f)).cast<float>();
+      break;
+    case Opcode::kLogicalOr:
+      y = ((x(0) != 0.0f) || (x(1) != 0.0f)).cast<float>();
+      break;
+    case Opcode::kMaximum:
+      // Maximum and Minimum propagate NaNs, like their cwise kernels.
+      y = x(0).binaryExpr(x(1), MaxOp());
+      break;
+    case Opcode::kMinimum:
+      y = x(0).binaryExpr(x(1), MinOp());
+      break;
+    case Opcode::kMul:
+      y = x(0) * x(1);
+      break;
+    case Opcode::kNotEqual:
+      y = (x(0) != x(1)).cast<float>();
+      break;
+    case Opcode::kSquaredDifference:
+      y = (x(0) - x(1)).square();
+      break;
+    case Opcode::kSub:
+      y = x(0) - x(1);
+      break;
+    case Opcode::kClipByValue:
+      y = x(0).min(x(2)).max(x(1));
+      break;
+    case Opcode::kSelect:
+      y = (x(0) != 0.0f).select(x(1), x(2));
+      break;
+  }
+}
+
+}  // namespace
+
+// Evaluates a cluster of element-wise ops, that the arithmetic optimizer
+// collected from the graph, in a single pass over the output. The output is
+// split into blocks of kBlockSize elements along its innermost dimension, and
+// the whole program runs on a block with vectorized Eigen expressions before
+// moving to the next one, so intermediate results stay in cache instead of
+// being materialized as tensors. Broadcast inputs are read through per
+// dimension strides and never expanded to the shape of the output.
+class FusedElementwiseOp : public OpKernel {
+ public:
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context), num_inputs_(context->num_inputs()) {
+    std::vector<string> op_names;
+    std::vector<int32> op_inputs;
+    OP_REQUIRES_OK(context, context->GetAttr("op_names", &op_names));
+    OP_REQUIRES_OK(context, context->GetAttr("op_inputs", &op_inputs));
+    OP_REQUIRES(context, !op_names.empty(),
+                errors::InvalidArgument("op_names must not be empty"));
+
+    int next_operand = 0;
+    for (int i = 0; i < op_names.size(); ++i) {
+      const auto it = GetOpcodes().find(op_names[i]);
+      OP_REQUIRES(context, it != GetOpcodes().end(),
+                  errors::InvalidArgument("Unsupported op: ", op_names[i]));
+      const OpcodeInfo& info = it->second;
+      OP_REQUIRES(context, next_operand + info.arity <= op_inputs.size(),
+                  errors::InvalidArgument(
+                      "op_inputs has too few registers for op_names"));
+      Instruction instruction;
+      instruction.opcode = info.opcode;
+      for (int j = 0; j < info.arity; ++j) {
+        const int reg = op_inputs[next_operand++];
+        // An op can only read the inputs and the results of preceding ops.
+        OP_REQUIRES(context, reg >= 0 && reg < num_inputs_ + i,
+                    errors::InvalidArgument("Op ", i, " (", op_names[i],
+                                            ") reads undefined register ",
+                                            reg));
+        instruction.operands[j] = reg;
+      }
+      program_.push_back(instruction);
+      cost_per_element_ += info.cost;
+    }
+    OP_REQUIRES(context, next_operand == op_inputs.size(),
+                errors::InvalidArgument(
+                    "op_inputs has more registers than op_names read"));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(context, context->input_list("inputs", &inputs));
+
+    // The output has the broadcast shape of all inputs.
+    int rank = 0;
+    for (const Tensor& input : inputs) rank = std::max(rank, input.dims());
+    gtl::InlinedVector<int64_t, 8> output_dims(rank, 1);
+    for (const Tensor& input : inputs) {
+      const int offset = rank - input.dims();
+      for (int d = 0; d < input.dims(); ++d) {
+        const int64_t dim = input.dim_size(d);
+        int64_t& output_dim = output_dims[offset + d];
+        OP_REQUIRES(context, dim == output_dim || dim == 1 || output_dim == 1,
+                    errors::InvalidArgument("Incompatible shapes: ",
+                                            input.shape().DebugString(),
+                                            " vs. output dimension ", d,
+                                            " of size ", output_dim));
+        if (output_dim == 1) output_dim = dim;
+      }
+    }
+    TensorShape output_shape;
+    OP_REQUIRES_OK(context,
+                   TensorShape::BuildTensorShape(output_dims, &output_shape));
+
+    // Inputs of the output type and shape can be forwarded, because every
+    // block of the output is written after the same block of the inputs is
+    // read.
+    gtl::InlinedVector<int, 4> forwardable_inputs;
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (inputs[i].dtype() == DT_FLOAT && inputs[i].shape() == output_shape) {
+        forwardable_inputs.push_back(i);
+      }
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                forwardable_inputs, 0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    // Collapse the output dimensions of size 1, and the adjacent dimensions
+    // that every input either broadcasts or not, so that the innermost
+    // dimension is as large as possible. An input dimension is broadcast iff
+    // its collapsed size is 1.
+    const int num_inputs = inputs.size();
+    gtl::InlinedVector<int64_t, 8> dims;
+    std::vector<gtl::InlinedVector<int64_t, 8>> input_dims(num_inputs);
+    const auto input_dim = [&](int i, int d) -> int64_t {
+      const int offset = rank - inputs[i].dims();
+      return d < offset ? 1 : inputs[i].dim_size(d - offset);
+    };
+    for (int d = 0; d < rank; ++d) {
+      if (output_dims[d] == 1) continue;
+      bool merge = !dims.empty();
+      for (int i = 0; i < num_inputs && merge; ++i) {
+        merge = (input_dim(i, d) == 1) == (input_dims[i].back() == 1);
+      }
+      if (merge) {
+        dims.back() *= output_dims[d];
+        for (int i = 0; i < num_inputs; ++i) {
+          input_dims[i].back() *= input_dim(i, d);
+        }
+      } else {
+        dims.push_back(output_dims[d]);
+        for (int i = 0; i < num_inputs; ++i) {
+          input_dims[i].push_back(input_dim(i, d));
+        }
+      }
+    }
+    if (dims.empty()) {
+      dims.push_back(1);
+      for (int i = 0; i < num_inputs; ++i) input_dims[i].push_back(1);
+    }
+
+    // Element strides of every input along the collapsed dimensions, with
+    // zero strides for the broadcast ones.
+    const int num_dims = dims.size();
+    std::vector<gtl::InlinedVector<int64_t, 8>> input_strides(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      input_strides[i].resize(num_dims);
+      int64_t stride = 1;
+      for (int k = num_dims - 1; k >= 0; --k) {
+        input_strides[i][k] = input_dims[i][k] == 1 ? 0 : stride;
+        stride *= input_dims[i][k];
+      }
+    }
+
+    const int64_t inner_size = dims.back();
+    const int64_t num_rows = output->NumElements() / inner_size;
+    const int64_t blocks_per_row = (inner_size + kBlockSize - 1) / kBlockSize;
+    const int num_registers = num_inputs + program_.size();
+    float* output_data = output->flat<float>().data();
+
+    auto evaluate_blocks = [&](int64_t begin, int64_t end) {
+      std::vector<float> scratch(num_registers * kBlockSize);
+      gtl::InlinedVector<const float*, 16> registers(num_registers);
+      for (int64_t block = begin; block < end; ++block) {
+        const int64_t row = block / blocks_per_row;
+        const int64_t column = (block % blocks_per_row) * kBlockSize;
+        const int64_t size = std::min(kBlockSize, inner_size - column);
+
+        for (int i = 0; i < num_inputs; ++i) {
+          int64_t offset = column * input_strides[i][num_dims - 1];
+          for (int64_t k = num_dims - 2, r = row; k >= 0 && r > 0; --k) {
+            offset += (r % dims[k]) * input_strides[i][k];
+            r /= dims[k];
+          }
+          const bool broadcast = input_strides[i][num_dims - 1] == 0;
+          float* buffer = scratch.data() + i * kBlockSize;
+          switch (inputs[i].dtype()) {
+            case DT_FLOAT:
+              registers[i] =
+                  LoadInput<float>(inputs[i], offset, size, broadcast, buffer);
+              break;
+            case DT_BOOL:
+              registers[i] =
+                  LoadInput<bool>(inputs[i], offset, size, broadcast, buffer);
+              break;
+            case DT_INT32:
+              registers[i] =
+                  LoadInput<int32>(inputs[i], offset, size, broadcast, buffer);
+              break;
+            default:
+              registers[i] = LoadInput<int64_t>(inputs[i], offset, size,
+                                                broadcast, buffer);
+              break;
+          }
+        }
+
+        for (int j = 0; j < program_.size(); ++j) {
+          // The last op writes the output block directly.
+          float* out = j == program_.size() - 1
+                           ? output_data + row * inner_size + column
+                           : scratch.data() + (num_inputs + j) * kBlockSize;
+          Evaluate(program_[j], registers, size, out);
+          registers[num_inputs + j] = out;
+        }
+      }
+    };
+
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/sizeof(float) * num_inputs * kBlockSize,
+        /*bytes_stored=*/sizeof(float) * kBlockSize,
+        /*compute_cycles=*/cost_per_element_ * kBlockSize);
+    context->eigen_device<CPUDevice>().parallelFor(num_rows * blocks_per_row,
+                                                   cost, evaluate_blocks);
+  }
+
+ private:
+  const int num_inputs_;
+  std::vector<Instruction> program_;
+  int cost_per_element_ = 0;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    FusedElementwiseOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,228 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status RunFused(const std::vector<Tensor>& inputs,
+                  const std::vector<string>& op_names,
+                  const std::vector<int>& op_inputs) {
+    DataTypeVector input_types;
+    for (const Tensor& input : inputs) input_types.push_back(input.dtype());
+    TF_CHECK_OK(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                    .Input(FakeInput(input_types))
+                    .Attr("T", DT_FLOAT)
+                    .Attr("op_names", op_names)
+                    .Attr("op_inputs", op_inputs)
+                    .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    for (const Tensor& input : inputs) {
+      switch (input.dtype()) {
+        case DT_FLOAT:
+          AddInputFromArray<float>(input.shape(), input.flat<float>());
+          break;
+        case DT_INT32:
+          AddInputFromArray<int32>(input.shape(), input.flat<int32>());
+          break;
+        case DT_BOOL:
+          AddInputFromArray<bool>(input.shape(), input.flat<bool>());
+          break;
+        default:
+          AddInputFromArray<int64_t>(input.shape(), input.flat<int64_t>());
+          break;
+      }
+    }
+    return RunOpKernel();
+  }
+
+  static Tensor RandomTensor(const TensorShape& shape) {
+    Tensor tensor(DT_FLOAT, shape);
+    tensor.flat<float>().setRandom();
+    return tensor;
+  }
+
+  static Tensor Evaluate(const Scope& root, const Output& output) {
+    ClientSession session(root);
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session.Run({output}, &outputs));
+    return outputs[0];
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, LayerNormTail) {
+  // (x - mean) * Rsqrt(variance + epsilon) * scale + offset, with `mean` and
+  // `variance` broadcast along the rows and `scale` and `offset` along the
+  // columns.
+  const Tensor x = RandomTensor(TensorShape({4, 3, 1000}));
+  const Tensor mean = RandomTensor(TensorShape({4, 3, 1}));
+  Tensor variance = RandomTensor(TensorShape({4, 3, 1}));
+  variance.flat<float>() = variance.flat<float>().abs();
+  Tensor epsilon(DT_FLOAT, TensorShape({}));
+  epsilon.scalar<float>()() = 0.001f;
+  const Tensor scale = RandomTensor(TensorShape({1000}));
+  const Tensor offset = RandomTensor(TensorShape({1000}));
+
+  Scope root = Scope::NewRootScope();
+  auto normalized = ops::Mul(
+      root, ops::Sub(root, x, mean),
+      ops::Rsqrt(root, ops::AddV2(root, variance, epsilon)));
+  auto y = ops::AddV2(root, ops::Mul(root, normalized, scale), offset);
+  const Tensor expected = Evaluate(root, y);
+
+  // Registers 0-5 are the inputs, and op i writes register 6 + i.
+  TF_ASSERT_OK(RunFused({x, mean, variance, epsilon, scale, offset},
+                        {"Sub", "AddV2", "Rsqrt", "Mul", "Mul", "AddV2"},
+                        {0, 1, 2, 3, 7, 6, 8, 9, 4, 10, 5}));
+  test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-5, /*rtol=*/1e-5);
+}
+
+TEST_F(FusedElementwiseOpTest, ClipAndSelect) {
+  const Tensor x = RandomTensor(TensorShape({2, 777}));
+  const Tensor y = RandomTensor(TensorShape({777}));
+  Tensor lo(DT_FLOAT, TensorShape({}));
+  lo.scalar<float>()() = -0.5f;
+  Tensor hi(DT_FLOAT, TensorShape({}));
+  hi.scalar<float>()() = 0.5f;
+
+  Scope root = Scope::NewRootScope();
+  auto clipped = ops::ClipByValue(root, x, lo, hi);
+  auto where = ops::SelectV2(root, ops::Greater(root, x, y),
+                             ops::Tanh(root, clipped), ops::Sigmoid(root, y));
+  const Tensor expected = Evaluate(root, where);
+
+  TF_ASSERT_OK(RunFused({x, y, lo, hi},
+                        {"ClipByValue", "Greater", "Tanh", "Sigmoid",
+                         "SelectV2"},
+                        {0, 2, 3, 0, 1, 4, 1, 5, 6, 7}));
+  test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-6, /*rtol=*/1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, CastInputs) {
+  Tensor indices(DT_INT32, TensorShape({3, 2}));
+  test::FillValues<int32>(&indices, {0, 1, 2, 3, 4, 5});
+  Tensor mask(DT_BOOL, TensorShape({2}));
+  test::FillValues<bool>(&mask, {true, false});
+  Tensor x(DT_FLOAT, TensorShape({3, 1}));
+  test::FillValues<float>(&x, {1, 2, 3});
+
+  // Cast(indices) * x + Cast(LogicalNot(mask)).
+  TF_ASSERT_OK(RunFused({indices, mask, x},
+                        {"Cast", "Mul", "LogicalNot", "Cast", "AddV2"},
+                        {0, 3, 2, 1, 5, 4, 6}));
+
+  Tensor expected(DT_FLOAT, TensorShape({3, 2}));
+  test::FillValues<float>(&expected, {0, 2, 4, 7, 12, 16});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, Empty) {
+  TF_ASSERT_OK(RunFused({RandomTensor(TensorShape({0, 5})),
+                         RandomTensor(TensorShape({5}))},
+                        {"Mul", "Exp"}, {0, 1, 2}));
+  EXPECT_EQ(TensorShape({0, 5}), GetOutput(0)->shape());
+}
+
+TEST_F(FusedElementwiseOpTest, IncompatibleShapes) {
+  Status status =
+      RunFused({RandomTensor(TensorShape({2, 4})),
+                RandomTensor(TensorShape({2, 3}))},
+               {"Mul", "Exp"}, {0, 1, 2});
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "Incompatible shapes"));
+}
+
+TEST_F(FusedElementwiseOpTest, UndefinedRegister) {
+  Status status = RunFused({RandomTensor(TensorShape({2}))}, {"Exp", "Neg"},
+                           {0, 2});
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "undefined register 2"));
+}
+
+// Performance benchmarks below.
+
+// Computes Sigmoid(x * scale + offset) * x, with `scale` and `offset`
+// broadcast along the rows of `x`.
+static Graph* ElementwiseChain(bool fused, int rows, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x_t(DT_FLOAT, TensorShape({rows, depth}));
+  x_t.flat<float>().setRandom();
+  Tensor scale_t(DT_FLOAT, TensorShape({depth}));
+  scale_t.flat<float>().setRandom();
+  Tensor offset_t(DT_FLOAT, TensorShape({depth}));
+  offset_t.flat<float>().setRandom();
+
+  Node* x = test::graph::Constant(g, x_t);
+  Node* scale = test::graph::Constant(g, scale_t);
+  Node* offset = test::graph::Constant(g, offset_t);
+  if (fused) {
+    Node* y;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedElementwise")
+                    .Input({x, scale, offset})
+                    .Attr("T", DT_FLOAT)
+                    .Attr("op_names", {"Mul", "AddV2", "Sigmoid", "Mul"})
+                    .Attr("op_inputs", {0, 1, 3, 2, 4, 5, 0})
+                    .Finalize(g, &y));
+    return g;
+  }
+
+  auto op = [&](const string& name, std::vector<Node*> inputs) {
+    NodeBuilder builder(g->NewName("n"), name);
+    for (Node* input : inputs) builder.Input(input);
+    Node* node;
+    TF_CHECK_OK(builder.Attr("T", DT_FLOAT).Finalize(g, &node));
+    return node;
+  };
+  Node* sigmoid =
+      op("Sigmoid", {op("AddV2", {op("Mul", {x, scale}), offset})});
+  op("Mul", {sigmoid, x});
+  return g;
+}
+
+#define BM_ElementwiseChain(FUSED, ROWS, DEPTH)                               \
+  static void BM_ElementwiseChain##_##FUSED##_##ROWS##_##DEPTH(               \
+      ::testing::benchmark::State& state) {                                   \
+    test::Benchmark("cpu", ElementwiseChain(FUSED, ROWS, DEPTH),              \
+                    /*old_benchmark_api*/ false)                              \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * ROWS * \
+                            DEPTH);                                           \
+  }                                                                           \
+  BENCHMARK(BM_ElementwiseChain##_##FUSED##_##ROWS##_##DEPTH)->UseRealTime();
+
+BM_ElementwiseChain(false, 128, 768);
+BM_ElementwiseChain(true, 128, 768);
+BM_ElementwiseChain(false, 4096, 3072);
+BM_ElementwiseChain(true, 4096, 3072);
+
+}  // namespace
+}  // namespace tensorflow
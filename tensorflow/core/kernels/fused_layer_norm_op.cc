@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Computes the layer normalization of every row of `x` along its innermost
+// dimension:
+//
+//   y = (x - mean(x)) / sqrt(variance(x) + epsilon) * scale + offset
+//
+// Remapper rewrites the Mean/SquaredDifference/Rsqrt/Mul/Sub/AddV2 subgraph of
+// a layer normalization into this op. Unlike the subgraph, which reads and
+// writes tensors of the size of `x` several times, the kernel reads each row
+// from memory once, and computes its statistics and normalized values with
+// vectorized Eigen expressions while the row is in cache.
+template <typename T>
+class FusedLayerNormOp : public OpKernel {
+ public:
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must be at least 1-dimensional: ",
+                                        x.shape().DebugString()));
+    const int64_t depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(
+        context, scale.dims() == 1 && scale.dim_size(0) == depth,
+        errors::InvalidArgument("scale must be a vector of size ", depth,
+                                ": ", scale.shape().DebugString()));
+    OP_REQUIRES(
+        context, offset.dims() == 1 && offset.dim_size(0) == depth,
+        errors::InvalidArgument("offset must be a vector of size ", depth,
+                                ": ", offset.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+
+    using Row = Eigen::Array<T, Eigen::Dynamic, 1>;
+    const T* x_data = x.flat<T>().data();
+    T* y_data = y->flat<T>().data();
+    const Eigen::Map<const Row> scale_row(scale.flat<T>().data(), depth);
+    const Eigen::Map<const Row> offset_row(offset.flat<T>().data(), depth);
+    const T epsilon = static_cast<T>(epsilon_);
+
+    auto normalize_rows = [&](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index i = begin; i < end; ++i) {
+        const Eigen::Map<const Row> x_row(x_data + i * depth, depth);
+        Eigen::Map<Row> y_row(y_data + i * depth, depth);
+        const T mean = x_row.mean();
+        const T variance = (x_row - mean).square().mean();
+        const T inv_stddev = Eigen::numext::rsqrt(variance + epsilon);
+        // `y` may alias `x`, which is fine for a coefficient-wise expression.
+        y_row = (x_row - mean) * inv_stddev * scale_row + offset_row;
+      }
+    };
+
+    const int64_t num_rows = x.NumElements() / depth;
+    const Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * depth * 3,
+                                   /*bytes_stored=*/sizeof(T) * depth,
+                                   /*compute_cycles=*/depth * 8);
+    context->eigen_device<CPUDevice>().parallelFor(num_rows, cost,
+                                                   normalize_rows);
+  }
+
+ private:
+  float epsilon_;
+};
+
+#define REGISTER_FUSED_LAYER_NORM(T)                                    \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedLayerNormOp<T>);
+
+TF_CALL_float(REGISTER_FUSED_LAYER_NORM);
+
+#undef REGISTER_FUSED_LAYER_NORM
+
+}  // namespace tensorflow
@@ -0,0 +1,238 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr float kEpsilon = 0.001;
+
+class FusedLayerNormOpTest : public OpsTestBase {
+ protected:
+  // Runs the layer normalization made of separate ops, the way it appears in
+  // graphs before remapping.
+  Tensor RunUnfused(const Tensor& x, const Tensor& scale,
+                    const Tensor& offset) {
+    Scope root = Scope::NewRootScope();
+    auto x_op = ops::Const(root, Input::Initializer(x));
+    auto axis = ops::Const(root, {x.dims() - 1});
+    auto mean = ops::Mean(root, x_op, axis, ops::Mean::Attrs().KeepDims(true));
+    auto variance =
+        ops::Mean(root, ops::SquaredDifference(root, x_op, mean), axis,
+                  ops::Mean::Attrs().KeepDims(true));
+    auto inv_stddev = ops::Rsqrt(root, ops::AddV2(root, variance, kEpsilon));
+    auto normalized = ops::Mul(root, ops::Sub(root, x_op, mean), inv_stddev);
+    auto y = ops::AddV2(
+        root, ops::Mul(root, normalized, Input::Initializer(scale)),
+        Input::Initializer(offset));
+
+    ClientSession session(root);
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session.Run({y}, &outputs));
+    return outputs[0];
+  }
+
+  void RunFused(const Tensor& x, const Tensor& scale, const Tensor& offset) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_layer_norm", "_FusedLayerNorm")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("epsilon", kEpsilon)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddInputFromArray<float>(x.shape(), x.flat<float>());
+    AddInputFromArray<float>(scale.shape(), scale.flat<float>());
+    AddInputFromArray<float>(offset.shape(), offset.flat<float>());
+    TF_ASSERT_OK(RunOpKernel());
+  }
+
+  void VerifyLayerNorm(const TensorShape& shape) {
+    const int64_t depth = shape.dim_size(shape.dims() - 1);
+    Tensor x(DT_FLOAT, shape);
+    x.flat<float>().setRandom();
+    // Offset rows from zero to exercise the numerical stability of the
+    // variance.
+    x.flat<float>() = x.flat<float>() * 4.0f + 100.0f;
+    Tensor scale(DT_FLOAT, {depth});
+    scale.flat<float>().setRandom();
+    Tensor offset(DT_FLOAT, {depth});
+    offset.flat<float>().setRandom();
+
+    const Tensor expected = RunUnfused(x, scale, offset);
+    RunFused(x, scale, offset);
+    test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-4,
+                      /*rtol=*/1e-4);
+  }
+};
+
+TEST_F(FusedLayerNormOpTest, Vector) { VerifyLayerNorm(TensorShape({7})); }
+
+TEST_F(FusedLayerNormOpTest, Matrix) {
+  VerifyLayerNorm(TensorShape({16, 768}));
+}
+
+TEST_F(FusedLayerNormOpTest, Rank3) {
+  VerifyLayerNorm(TensorShape({4, 3, 33}));
+}
+
+TEST_F(FusedLayerNormOpTest, Empty) { VerifyLayerNorm(TensorShape({0, 8})); }
+
+TEST_F(FusedLayerNormOpTest, ConstantRows) {
+  TF_ASSERT_OK(NodeDefBuilder("fused_layer_norm", "_FusedLayerNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("epsilon", kEpsilon)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 2}), {3, 3, -1, -1});
+  AddInputFromArray<float>(TensorShape({2}), {2, 2});
+  AddInputFromArray<float>(TensorShape({2}), {1, -1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {1, -1, 1, -1});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedLayerNormOpTest, InvalidScale) {
+  TF_ASSERT_OK(NodeDefBuilder("fused_layer_norm", "_FusedLayerNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2}), {1, 1});
+  AddInputFromArray<float>(TensorShape({3}), {0, 0, 0});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "scale must be a vector"));
+}
+
+// Performance benchmarks below.
+
+// Layer normalization made of separate ops, as rewritten by the remapper.
+static Graph* LayerNormUnfused(int rows, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x_t(DT_FLOAT, TensorShape({rows, depth}));
+  x_t.flat<float>().setRandom();
+  Tensor scale_t(DT_FLOAT, TensorShape({depth}));
+  scale_t.flat<float>().setRandom();
+  Tensor axis_t(DT_INT32, TensorShape({1}));
+  axis_t.flat<int32>()(0) = 1;
+  Tensor epsilon_t(DT_FLOAT, TensorShape({}));
+  epsilon_t.scalar<float>()() = kEpsilon;
+
+  Node* x = test::graph::Constant(g, x_t);
+  Node* scale = test::graph::Constant(g, scale_t);
+  Node* axis = test::graph::Constant(g, axis_t);
+  Node* epsilon = test::graph::Constant(g, epsilon_t);
+
+  auto binary = [&](const string& op, Node* a, Node* b) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), op)
+                    .Input(a)
+                    .Input(b)
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &node));
+    return node;
+  };
+  auto mean = [&](Node* a) {
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Mean")
+                    .Input(a)
+                    .Input(axis)
+                    .Attr("T", DT_FLOAT)
+                    .Attr("keep_dims", true)
+                    .Finalize(g, &node));
+    return node;
+  };
+
+  Node* x_mean = mean(x);
+  Node* variance = mean(binary("SquaredDifference", x, x_mean));
+  Node* inv_stddev;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Rsqrt")
+                  .Input(binary("AddV2", variance, epsilon))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &inv_stddev));
+  Node* normalized = binary("Mul", binary("Sub", x, x_mean),
+                            binary("Mul", inv_stddev, scale));
+  binary("AddV2", normalized, scale);
+  return g;
+}
+
+static Graph* LayerNormFused(int rows, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor x_t(DT_FLOAT, TensorShape({rows, depth}));
+  x_t.flat<float>().setRandom();
+  Tensor scale_t(DT_FLOAT, TensorShape({depth}));
+  scale_t.flat<float>().setRandom();
+
+  Node* x = test::graph::Constant(g, x_t);
+  Node* scale = test::graph::Constant(g, scale_t);
+  Node* y;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedLayerNorm")
+                  .Input(x)
+                  .Input(scale)
+                  .Input(scale)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("epsilon", kEpsilon)
+                  .Finalize(g, &y));
+  return g;
+}
+
+#define BM_LayerNorm(KIND, ROWS, DEPTH)                                       \
+  static void BM_LayerNorm##_##KIND##_##ROWS##_##DEPTH(                       \
+      ::testing::benchmark::State& state) {                                   \
+    test::Benchmark("cpu", LayerNorm##KIND(ROWS, DEPTH),                      \
+                    /*old_benchmark_api*/ false)                              \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * ROWS * \
+                            DEPTH);                                           \
+  }                                                                           \
+  BENCHMARK(BM_LayerNorm##_##KIND##_##ROWS##_##DEPTH)->UseRealTime();
+
+// BERT-base (hidden size 768) and BERT-large (hidden size 1024) activations
+// for a single sequence and for a batch of sequences of 128 tokens.
+BM_LayerNorm(Unfused, 128, 768);
+BM_LayerNorm(Fused, 128, 768);
+BM_LayerNorm(Unfused, 4096, 768);
+BM_LayerNorm(Fused, 4096, 768);
+BM_LayerNorm(Unfused, 128, 1024);
+BM_LayerNorm(Fused, 128, 1024);
+BM_LayerNorm(Unfused, 4096, 1024);
+BM_LayerNorm(Fused, 4096, 1024);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,142 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Computes `Softmax(logits + mask)` along the innermost dimension of `logits`,
+// where `mask` is broadcast to the shape of `logits`. Attention layers add a
+// mask of large negative values to the attention scores of padded positions
+// before their softmax.
+//
+// Remapper rewrites Softmax(AddV2(logits, mask)) into this op, so that the
+// masked logits, their exponentials and the normalized output of a row are
+// computed while the row is in cache, instead of materializing the masked
+// logits in memory. The mask is read through broadcast row offsets and never
+// expanded to the shape of `logits`.
+template <typename T>
+class FusedMaskedSoftmaxOp : public OpKernel {
+ public:
+  explicit FusedMaskedSoftmaxOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& logits = context->input(0);
+    const Tensor& mask = context->input(1);
+
+    OP_REQUIRES(context, logits.dims() >= 1,
+                errors::InvalidArgument(
+                    "logits must be at least 1-dimensional: ",
+                    logits.shape().DebugString()));
+    OP_REQUIRES(context, mask.dims() <= logits.dims(),
+                errors::InvalidArgument(
+                    "mask must not have more dimensions than logits: ",
+                    mask.shape().DebugString(), " vs. ",
+                    logits.shape().DebugString()));
+
+    // Dimensions of `mask` are aligned with the trailing dimensions of
+    // `logits`, and must either match them or be broadcast from size 1.
+    const int rank = logits.dims();
+    const int mask_offset = rank - mask.dims();
+    for (int d = 0; d < mask.dims(); ++d) {
+      const int64_t mask_dim = mask.dim_size(d);
+      OP_REQUIRES(context,
+                  mask_dim == 1 || mask_dim == logits.dim_size(mask_offset + d),
+                  errors::InvalidArgument(
+                      "mask is not broadcastable to logits: ",
+                      mask.shape().DebugString(), " vs. ",
+                      logits.shape().DebugString()));
+    }
+
+    Tensor* softmax = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, logits.shape(), &softmax));
+    if (logits.NumElements() == 0) return;
+
+    const int64_t depth = logits.dim_size(rank - 1);
+    const int64_t num_rows = logits.NumElements() / depth;
+
+    // Element strides of `mask` for every dimension of `logits`, with zero
+    // strides for dimensions that `mask` is broadcast along.
+    std::vector<int64_t> mask_strides(rank, 0);
+    int64_t stride = 1;
+    for (int d = mask.dims() - 1; d >= 0; --d) {
+      if (mask.dim_size(d) != 1) mask_strides[mask_offset + d] = stride;
+      stride *= mask.dim_size(d);
+    }
+    const bool broadcast_mask_row = mask_strides[rank - 1] == 0;
+
+    using Row = Eigen::Array<T, Eigen::Dynamic, 1>;
+    const T* logits_data = logits.flat<T>().data();
+    const T* mask_data = mask.flat<T>().data();
+    T* softmax_data = softmax->flat<T>().data();
+
+    auto softmax_rows = [&](Eigen::Index begin, Eigen::Index end) {
+      for (Eigen::Index i = begin; i < end; ++i) {
+        // Offset of the mask values of row `i` of `logits`.
+        int64_t mask_index = 0;
+        for (int64_t d = rank - 2, row = i; d >= 0 && row > 0; --d) {
+          mask_index += (row % logits.dim_size(d)) * mask_strides[d];
+          row /= logits.dim_size(d);
+        }
+
+        const Eigen::Map<const Row> logits_row(logits_data + i * depth, depth);
+        // `softmax` may alias `logits`, which is fine for the coefficient-wise
+        // expressions below.
+        Eigen::Map<Row> softmax_row(softmax_data + i * depth, depth);
+        if (broadcast_mask_row) {
+          softmax_row = logits_row + mask_data[mask_index];
+        } else {
+          softmax_row =
+              logits_row + Eigen::Map<const Row>(mask_data + mask_index, depth);
+        }
+        const T max_logit = softmax_row.maxCoeff();
+        softmax_row = (softmax_row - max_logit).exp();
+        softmax_row *= static_cast<T>(1) / softmax_row.sum();
+      }
+    };
+
+    const Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * depth * 4,
+                                   /*bytes_stored=*/sizeof(T) * depth * 2,
+                                   /*compute_cycles=*/depth * 24);
+    context->eigen_device<CPUDevice>().parallelFor(num_rows, cost,
+                                                   softmax_rows);
+  }
+};
+
+#define REGISTER_FUSED_MASKED_SOFTMAX(T)                                    \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_FusedMaskedSoftmax").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedMaskedSoftmaxOp<T>);
+
+TF_CALL_float(REGISTER_FUSED_MASKED_SOFTMAX);
+
+#undef REGISTER_FUSED_MASKED_SOFTMAX
+
+}  // namespace tensorflow
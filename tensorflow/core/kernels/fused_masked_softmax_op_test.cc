@@ -0,0 +1,172 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedMaskedSoftmaxOpTest : public OpsTestBase {
+ protected:
+  // Runs Softmax(AddV2(logits, mask)) as separate ops, the way it appears in
+  // graphs before remapping.
+  Tensor RunUnfused(const Tensor& logits, const Tensor& mask) {
+    Scope root = Scope::NewRootScope();
+    auto softmax = ops::Softmax(
+        root, ops::AddV2(root, Input::Initializer(logits),
+                         Input::Initializer(mask)));
+
+    ClientSession session(root);
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session.Run({softmax}, &outputs));
+    return outputs[0];
+  }
+
+  Status RunFused(const Tensor& logits, const Tensor& mask) {
+    TF_CHECK_OK(NodeDefBuilder("fused_masked_softmax", "_FusedMaskedSoftmax")
+                    .Input(FakeInput(DT_FLOAT))
+                    .Input(FakeInput(DT_FLOAT))
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(node_def()));
+    TF_CHECK_OK(InitOp());
+    AddInputFromArray<float>(logits.shape(), logits.flat<float>());
+    AddInputFromArray<float>(mask.shape(), mask.flat<float>());
+    return RunOpKernel();
+  }
+
+  void VerifyMaskedSoftmax(const TensorShape& logits_shape,
+                           const TensorShape& mask_shape) {
+    Tensor logits(DT_FLOAT, logits_shape);
+    logits.flat<float>().setRandom();
+    logits.flat<float>() = logits.flat<float>() * 10.0f;
+    // Attention masks are zero for positions to attend to, and a large
+    // negative value for padded positions.
+    Tensor mask(DT_FLOAT, mask_shape);
+    auto mask_values = mask.flat<float>();
+    for (int64_t i = 0; i < mask_values.size(); ++i) {
+      mask_values(i) = i % 3 == 2 ? -10000.0f : 0.0f;
+    }
+
+    const Tensor expected = RunUnfused(logits, mask);
+    TF_ASSERT_OK(RunFused(logits, mask));
+    test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-6,
+                      /*rtol=*/1e-5);
+  }
+};
+
+TEST_F(FusedMaskedSoftmaxOpTest, SameShape) {
+  VerifyMaskedSoftmax(TensorShape({8, 32}), TensorShape({8, 32}));
+}
+
+TEST_F(FusedMaskedSoftmaxOpTest, AttentionMask) {
+  // Attention scores of shape [batch, heads, queries, keys] with a mask of
+  // shape [batch, 1, 1, keys].
+  VerifyMaskedSoftmax(TensorShape({2, 4, 5, 37}), TensorShape({2, 1, 1, 37}));
+}
+
+TEST_F(FusedMaskedSoftmaxOpTest, LowerRankMask) {
+  VerifyMaskedSoftmax(TensorShape({3, 4, 9}), TensorShape({4, 9}));
+  VerifyMaskedSoftmax(TensorShape({3, 4, 9}), TensorShape({9}));
+}
+
+TEST_F(FusedMaskedSoftmaxOpTest, BroadcastAlongRow) {
+  VerifyMaskedSoftmax(TensorShape({3, 4, 9}), TensorShape({3, 1, 1}));
+  VerifyMaskedSoftmax(TensorShape({3, 4, 9}), TensorShape({}));
+}
+
+TEST_F(FusedMaskedSoftmaxOpTest, Empty) {
+  VerifyMaskedSoftmax(TensorShape({0, 9}), TensorShape({9}));
+}
+
+TEST_F(FusedMaskedSoftmaxOpTest, NotBroadcastable) {
+  Tensor logits(DT_FLOAT, TensorShape({2, 4}));
+  logits.flat<float>().setZero();
+  Tensor mask(DT_FLOAT, TensorShape({2, 2}));
+  mask.flat<float>().setZero();
+  Status status = RunFused(logits, mask);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "not broadcastable"));
+}
+
+// Performance benchmarks below.
+
+static Graph* MaskedSoftmaxGraph(bool fused, int batch, int heads,
+                                 int seq_len) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor logits_t(DT_FLOAT, TensorShape({batch, heads, seq_len, seq_len}));
+  logits_t.flat<float>().setRandom();
+  Tensor mask_t(DT_FLOAT, TensorShape({batch, 1, 1, seq_len}));
+  mask_t.flat<float>().setZero();
+
+  Node* logits = test::graph::Constant(g, logits_t);
+  Node* mask = test::graph::Constant(g, mask_t);
+  Node* softmax;
+  if (fused) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedMaskedSoftmax")
+                    .Input(logits)
+                    .Input(mask)
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &softmax));
+  } else {
+    Node* masked_logits;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "AddV2")
+                    .Input(logits)
+                    .Input(mask)
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &masked_logits));
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Softmax")
+                    .Input(masked_logits)
+                    .Attr("T", DT_FLOAT)
+                    .Finalize(g, &softmax));
+  }
+  return g;
+}
+
+#define BM_MaskedSoftmax(FUSED, B, H, S)                                      \
+  static void BM_MaskedSoftmax##_##FUSED##_##B##_##H##_##S(                   \
+      ::testing::benchmark::State& state) {                                   \
+    test::Benchmark("cpu", MaskedSoftmaxGraph(FUSED, B, H, S),                \
+                    /*old_benchmark_api*/ false)                              \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * B * H * \
+                            S * S);                                           \
+  }                                                                           \
+  BENCHMARK(BM_MaskedSoftmax##_##FUSED##_##B##_##H##_##S)->UseRealTime();
+
+// BERT-base attention (12 heads) for a single sequence and for a batch of
+// sequences.
+BM_MaskedSoftmax(false, 1, 12, 128);
+BM_MaskedSoftmax(true, 1, 12, 128);
+BM_MaskedSoftmax(false, 32, 12, 128);
+BM_MaskedSoftmax(true, 32, 12, 128);
+BM_MaskedSoftmax(false, 8, 12, 512);
+BM_MaskedSoftmax(true, 8, 12, 512);
+
+}  // namespace
+}  // namespace tensorflow
@@ -199,6 +199,13 @@ class InitializableLookupTable : public LookupInterface {
   virtual Status DoFind(const Tensor& keys, Tensor* values,
                         const Tensor& default_value) = 0;
 
+  // Same as above, but may use the intra-op thread pool of `ctx` to split
+  // large batches. `ctx` may be null. Defaults to the method above.
+  virtual Status DoFind(OpKernelContext* ctx, const Tensor& keys,
+                        Tensor* values, const Tensor& default_value) {
+    return DoFind(keys, values, default_value);
+  }
+
   virtual Status AreEntriesSame(const InitTableIterator& iter, bool* result);
 
   mutex mu_;
@@ -15,16 +15,25 @@ limitations under the License.
 
 // Tests kernels of lookup ops.
 
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -100,5 +109,222 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+TEST_F(LookupOpsTest, ShardedMutableHashTable_InsertFindRemove) {
+  TF_ASSERT_OK(NodeDefBuilder("table", "AnonymousMutableHashTable")
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_FLOAT)
+                   .Attr("_kernel", "sharded")
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+  auto table_or =
+      GetOutput(0)->scalar<ResourceHandle>()().GetResource<
+          lookup::LookupInterface>();
+  TF_ASSERT_OK(table_or.status());
+  lookup::LookupInterface* table = table_or.value();
+
+  const int64_t kNumKeys = 1000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_FLOAT, TensorShape({kNumKeys}));
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    keys.flat<int64_t>()(i) = i * 7919;
+    values.flat<float>()(i) = i;
+  }
+  TF_ASSERT_OK(table->Insert(context_.get(), keys, values));
+  EXPECT_EQ(table->size(), kNumKeys);
+
+  Tensor query = test::AsTensor<int64_t>({0, 7919, 5, 999 * 7919});
+  Tensor default_value = test::AsScalar<float>(-1.0f);
+  Tensor found(DT_FLOAT, TensorShape({4}));
+  TF_ASSERT_OK(table->Find(context_.get(), query, &found, default_value));
+  test::ExpectTensorEqual<float>(found,
+                                 test::AsTensor<float>({0, 1, -1, 999}));
+
+  TF_ASSERT_OK(table->Remove(context_.get(), test::AsTensor<int64_t>({7919})));
+  EXPECT_EQ(table->size(), kNumKeys - 1);
+  TF_ASSERT_OK(table->Find(context_.get(), query, &found, default_value));
+  test::ExpectTensorEqual<float>(found,
+                                 test::AsTensor<float>({0, -1, -1, 999}));
+}
+
+TEST_F(LookupOpsTest, ShardedMutableHashTable_ImportReplacesTable) {
+  TF_ASSERT_OK(NodeDefBuilder("table", "AnonymousMutableHashTable")
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_FLOAT)
+                   .Attr("_kernel", "sharded")
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+  auto table_or =
+      GetOutput(0)->scalar<ResourceHandle>()().GetResource<
+          lookup::LookupInterface>();
+  TF_ASSERT_OK(table_or.status());
+  lookup::LookupInterface* table = table_or.value();
+
+  // Large enough for the shards to split into several chunks.
+  const int64_t kNumKeys = 100000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_FLOAT, TensorShape({kNumKeys}));
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    keys.flat<int64_t>()(i) = 2 * i;
+    values.flat<float>()(i) = i;
+  }
+  TF_ASSERT_OK(table->Insert(context_.get(), keys, values));
+  EXPECT_EQ(table->size(), kNumKeys);
+
+  // Importing drops the keys that were inserted before.
+  Tensor import_keys(DT_INT64, TensorShape({kNumKeys / 2}));
+  Tensor import_values(DT_FLOAT, TensorShape({kNumKeys / 2}));
+  for (int64_t i = 0; i < kNumKeys / 2; ++i) {
+    import_keys.flat<int64_t>()(i) = 2 * i + 1;
+    import_values.flat<float>()(i) = -i;
+  }
+  TF_ASSERT_OK(
+      table->ImportValues(context_.get(), import_keys, import_values));
+  EXPECT_EQ(table->size(), kNumKeys / 2);
+
+  TF_ASSERT_OK(table->Insert(context_.get(), test::AsTensor<int64_t>({0}),
+                             test::AsTensor<float>({7.0f})));
+  EXPECT_EQ(table->size(), kNumKeys / 2 + 1);
+
+  Tensor query = test::AsTensor<int64_t>({0, 1, 2, 99999, 100001});
+  Tensor found(DT_FLOAT, TensorShape({5}));
+  TF_ASSERT_OK(table->Find(context_.get(), query, &found,
+                           test::AsScalar<float>(1.0f)));
+  test::ExpectTensorEqual<float>(
+      found, test::AsTensor<float>({7, 0, 1, -49999, 1}));
+}
+
+TEST_F(LookupOpsTest, MutableDenseHashTable_LargeBatchFind) {
+  TF_ASSERT_OK(NodeDefBuilder("table", "AnonymousMutableDenseHashTable")
+                   .Input(FakeInput(DT_INT64))
+                   .Input(FakeInput(DT_INT64))
+                   .Attr("key_dtype", DT_INT64)
+                   .Attr("value_dtype", DT_FLOAT)
+                   .Attr("initial_num_buckets", 1 << 18)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<int64_t>(TensorShape({}), {-1});
+  AddInputFromArray<int64_t>(TensorShape({}), {-2});
+  TF_ASSERT_OK(RunOpKernel());
+  auto table_or =
+      GetOutput(0)->scalar<ResourceHandle>()().GetResource<
+          lookup::LookupInterface>();
+  TF_ASSERT_OK(table_or.status());
+  lookup::LookupInterface* table = table_or.value();
+
+  // Large enough for the lookup to be split across the thread pool.
+  const int64_t kNumKeys = 100000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_FLOAT, TensorShape({kNumKeys}));
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    keys.flat<int64_t>()(i) = 2 * i;
+    values.flat<float>()(i) = i;
+  }
+  TF_ASSERT_OK(table->Insert(context_.get(), keys, values));
+
+  // Every other query key is missing from the table.
+  Tensor query(DT_INT64, TensorShape({2 * kNumKeys}));
+  Tensor expected(DT_FLOAT, TensorShape({2 * kNumKeys}));
+  for (int64_t i = 0; i < 2 * kNumKeys; ++i) {
+    query.flat<int64_t>()(i) = i;
+    expected.flat<float>()(i) = i % 2 == 0 ? i / 2 : -1.0f;
+  }
+  Tensor found(DT_FLOAT, TensorShape({2 * kNumKeys}));
+  TF_ASSERT_OK(table->Find(context_.get(), query, &found,
+                           test::AsScalar<float>(-1.0f)));
+  test::ExpectTensorEqual<float>(found, expected);
+
+  // Looking up the empty key is still an error.
+  Tensor bad_query = test::AsTensor<int64_t>({0, -1, 2});
+  Tensor bad_found(DT_FLOAT, TensorShape({3}));
+  EXPECT_TRUE(errors::IsInvalidArgument(table->Find(
+      context_.get(), bad_query, &bad_found, test::AsScalar<float>(-1.0f))));
+}
+
+// Builds a graph with `num_finds` LookupTableFindV2 nodes that look up every
+// key, and `num_inserts` LookupTableInsertV2 nodes that each update
+// `insert_size` keys, that all run concurrently against one MutableHashTableV2
+// of `table_size` int64 -> float entries.
+static Graph* MixedReadWriteGraph(const string& kernel_label,
+                                  int64_t table_size, int num_finds,
+                                  int num_inserts, int64_t insert_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* table;
+  TF_CHECK_OK(NodeBuilder(g->NewName("table"), "MutableHashTableV2")
+                  .Attr("key_dtype", DT_INT64)
+                  .Attr("value_dtype", DT_FLOAT)
+                  .Attr("_kernel", kernel_label)
+                  .Finalize(g, &table));
+
+  Tensor keys(DT_INT64, TensorShape({table_size}));
+  Tensor values(DT_FLOAT, TensorShape({table_size}));
+  for (int64_t i = 0; i < table_size; ++i) {
+    keys.flat<int64_t>()(i) = i;
+    values.flat<float>()(i) = i;
+  }
+  Node* keys_node = test::graph::Constant(g, keys);
+  Node* insert_keys_node = test::graph::Constant(g, keys.Slice(0, insert_size));
+  Node* insert_values_node =
+      test::graph::Constant(g, values.Slice(0, insert_size));
+  Node* default_node = test::graph::Constant(g, test::AsScalar<float>(0.0f));
+
+  for (int i = 0; i < num_finds; ++i) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("find"), "LookupTableFindV2")
+                    .Input(table)
+                    .Input(keys_node)
+                    .Input(default_node)
+                    .Finalize(g, nullptr));
+  }
+  for (int i = 0; i < num_inserts; ++i) {
+    TF_CHECK_OK(NodeBuilder(g->NewName("insert"), "LookupTableInsertV2")
+                    .Input(table)
+                    .Input(insert_keys_node)
+                    .Input(insert_values_node)
+                    .Finalize(g, nullptr));
+  }
+  return g;
+}
+
+static void BM_MutableHashTableMixedReadWrite(
+    ::testing::benchmark::State& state, const string& kernel_label) {
+  const int64_t table_size = 1 << 14;
+  const int num_finds = state.range(0);
+  const int num_inserts = state.range(1);
+  const int64_t insert_size = state.range(2);
+  test::Benchmark("cpu",
+                  MixedReadWriteGraph(kernel_label, table_size, num_finds,
+                                      num_inserts, insert_size),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          (table_size * num_finds + insert_size * num_inserts));
+}
+
+static void BM_MutableHashTable(::testing::benchmark::State& state) {
+  BM_MutableHashTableMixedReadWrite(state, "");
+}
+
+static void BM_ShardedMutableHashTable(::testing::benchmark::State& state) {
+  BM_MutableHashTableMixedReadWrite(state, "sharded");
+}
+
+// Args are (number of find nodes, number of insert nodes, keys per insert) per
+// step.
+BENCHMARK(BM_MutableHashTable)
+    ->UseRealTime()
+    ->Args({16, 0, 0})
+    ->Args({16, 1, 1 << 14})
+    ->Args({16, 4, 1 << 14})
+    ->Args({16, 16, 1 << 14})
+    ->Args({16, 16, 64});
+BENCHMARK(BM_ShardedMutableHashTable)
+    ->UseRealTime()
+    ->Args({16, 0, 0})
+    ->Args({16, 1, 1 << 14})
+    ->Args({16, 4, 1 << 14})
+    ->Args({16, 16, 1 << 14})
+    ->Args({16, 16, 64});
+
 }  // namespace
 }  // namespace tensorflow
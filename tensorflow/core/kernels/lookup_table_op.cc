@@ -16,16 +16,22 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/random.h"
 
 namespace tensorflow {
@@ -427,6 +433,624 @@ TensorShape MaybeVectorizeShape(const TensorShape& shape) {
 
 }  // namespace
 
+// Storage for the sharded mutable hash tables below.
+//
+// The key space is split into `kNumShards` shards. Each shard publishes an
+// immutable version of its entries through a reference-counted pointer.
+// Readers pin the current version of the shards they need by copying those
+// pointers, which only takes a short critical section per shard, and then probe
+// the versions without holding any lock. Lookups therefore never wait for an
+// update that is in progress.
+//
+// A version splits the entries of its shard into chunks of about
+// `kTargetChunkSize` entries by further bits of the key hash, each chunk an
+// immutable map shared between versions. Writers serialize per shard, and build
+// the next version by copying only the chunks a batch touches, so an update
+// batch costs O(number of keys * kTargetChunkSize) regardless of the size of
+// the table. When the shard grows, the number of chunks is doubled, which
+// copies the shard once per doubling.
+//
+// An import replaces every shard at once: lookups and exports see either the
+// old or the new contents of the table. Other update batches are atomic per
+// shard only, so a concurrent lookup may see the keys of one shard updated and
+// those of another not yet. Exports hold every writer lock, so they see all or
+// none of each update batch.
+template <class K, class ValueType>
+class ShardedTableStorage {
+ public:
+  typedef std::unordered_map<K, ValueType> Map;
+
+  static constexpr int kNumShardBits = 6;
+  static constexpr int kNumShards = 1 << kNumShardBits;
+
+  // Indices of a batch of keys, grouped by shard.
+  typedef std::array<std::vector<int64_t>, kNumShards> KeysByShard;
+
+  static uint64 Hash(const K& key) {
+    // Use the high bits of a multiplicative hash, since `HashScalar` is the
+    // identity for integral keys.
+    return HashScalar(key) * 0x9E3779B97F4A7C15ULL;
+  }
+
+  static int ShardIndex(const K& key) {
+    return Hash(key) >> (64 - kNumShardBits);
+  }
+
+  // An immutable version of a shard.
+  class ShardVersion {
+   public:
+    const ValueType* Find(const K& key) const {
+      return gtl::FindOrNull(*chunks_[ChunkIndex(Hash(key), chunk_bits_)], key);
+    }
+
+   private:
+    friend class ShardedTableStorage;
+
+    int chunk_bits_ = 0;
+    size_t size_ = 0;
+    std::vector<std::shared_ptr<const Map>> chunks_ = {
+        std::make_shared<const Map>()};
+  };
+
+  ShardedTableStorage() {
+    for (auto& shard : shards_) {
+      shard.version = std::make_shared<const ShardVersion>();
+    }
+  }
+
+  size_t size() const {
+    size_t ret = 0;
+    for (int i = 0; i < kNumShards; ++i) {
+      ret += Pin(i)->size_;
+    }
+    return ret;
+  }
+
+  int64_t MemoryUsed() const {
+    int64_t ret = 0;
+    for (int i = 0; i < kNumShards; ++i) {
+      auto version = Pin(i);
+      ret += version->chunks_.size() * sizeof(std::shared_ptr<const Map>);
+      for (const auto& chunk : version->chunks_) {
+        ret += chunk->bucket_count() * sizeof(void*) +
+               chunk->size() * sizeof(typename Map::value_type);
+      }
+    }
+    return ret;
+  }
+
+  // Calls `find(keys_by_shard[i], version)` on the current version of every
+  // shard `i` for which `keys_by_shard[i]` is non-empty. The versions are
+  // pinned so that they reflect all or none of each import.
+  template <typename FindFn>
+  void Find(const KeysByShard& keys_by_shard, FindFn find) const {
+    std::array<std::shared_ptr<const ShardVersion>, kNumShards> versions;
+    while (true) {
+      const int64_t generation = generation_.load(std::memory_order_acquire);
+      // An import is publishing its shards.
+      if (generation % 2 != 0) continue;
+      for (int i = 0; i < kNumShards; ++i) {
+        if (!keys_by_shard[i].empty()) versions[i] = Pin(i);
+      }
+      if (generation_.load(std::memory_order_acquire) == generation) break;
+    }
+    for (int i = 0; i < kNumShards; ++i) {
+      if (!keys_by_shard[i].empty()) find(keys_by_shard[i], *versions[i]);
+    }
+  }
+
+  // Calls `update(index, map)` for every index in `keys_by_shard`, where `map`
+  // is a private copy of the chunk that holds `key_of(index)`, and publishes
+  // the new versions of the affected shards. If `clear` is true, every shard
+  // starts out empty and the new versions are published at once.
+  template <typename KeyFn, typename UpdateFn>
+  void Update(bool clear, const KeysByShard& keys_by_shard, KeyFn key_of,
+              UpdateFn update) TF_NO_THREAD_SAFETY_ANALYSIS {
+    if (!clear) {
+      for (int i = 0; i < kNumShards; ++i) {
+        if (keys_by_shard[i].empty()) continue;
+        Shard& shard = shards_[i];
+        mutex_lock w(shard.write_mu);
+        auto version =
+            UpdateShard(*Pin(i), keys_by_shard[i], key_of, update);
+        mutex_lock l(shard.mu);
+        shard.version = std::move(version);
+      }
+      return;
+    }
+
+    // Writers of single shards lock only one shard, so locking every shard in
+    // order can't deadlock.
+    for (Shard& shard : shards_) {
+      shard.write_mu.lock();
+    }
+    std::array<std::shared_ptr<const ShardVersion>, kNumShards> versions;
+    const ShardVersion empty;
+    for (int i = 0; i < kNumShards; ++i) {
+      versions[i] = UpdateShard(empty, keys_by_shard[i], key_of, update);
+    }
+    // Readers that pin a shard while the generation is odd, or that see it
+    // change, pin their shards again.
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (int i = 0; i < kNumShards; ++i) {
+      mutex_lock l(shards_[i].mu);
+      shards_[i].version = std::move(versions[i]);
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (int i = kNumShards - 1; i >= 0; --i) {
+      shards_[i].write_mu.unlock();
+    }
+  }
+
+  // Calls `fn(maps)` with the chunks of the current version of every shard.
+  // The versions are pinned while holding every writer lock, so they reflect
+  // all or none of each update.
+  template <typename Fn>
+  void ReadAll(Fn fn) const TF_NO_THREAD_SAFETY_ANALYSIS {
+    std::vector<std::shared_ptr<const ShardVersion>> versions;
+    versions.reserve(kNumShards);
+    for (const Shard& shard : shards_) {
+      shard.write_mu.lock();
+    }
+    for (int i = 0; i < kNumShards; ++i) {
+      versions.push_back(Pin(i));
+    }
+    for (int i = kNumShards - 1; i >= 0; --i) {
+      shards_[i].write_mu.unlock();
+    }
+    std::vector<const Map*> maps;
+    for (const auto& version : versions) {
+      for (const auto& chunk : version->chunks_) {
+        maps.push_back(chunk.get());
+      }
+    }
+    fn(maps);
+  }
+
+ private:
+  // Average number of entries per chunk above which a shard doubles its number
+  // of chunks.
+  static constexpr size_t kTargetChunkSize = 256;
+  static constexpr int kMaxChunkBits = 16;
+
+  static int ChunkIndex(uint64 hash, int chunk_bits) {
+    // The top `kNumShardBits` bits select the shard.
+    return chunk_bits == 0 ? 0 : (hash << kNumShardBits) >> (64 - chunk_bits);
+  }
+
+  // Returns a new version of `base` with `update` applied to the keys at
+  // `indices`.
+  template <typename KeyFn, typename UpdateFn>
+  static std::shared_ptr<const ShardVersion> UpdateShard(
+      const ShardVersion& base, const std::vector<int64_t>& indices,
+      KeyFn key_of, UpdateFn update) {
+    auto version = std::make_shared<ShardVersion>(base);
+    // Chunks copied from `base`, which only `version` owns so far.
+    absl::flat_hash_map<int, Map*> copied_chunks;
+    for (int64_t index : indices) {
+      const int c = ChunkIndex(Hash(key_of(index)), version->chunk_bits_);
+      Map*& map = copied_chunks[c];
+      if (map == nullptr) {
+        auto chunk = std::make_shared<Map>(*version->chunks_[c]);
+        map = chunk.get();
+        version->size_ -= chunk->size();
+        version->chunks_[c] = std::move(chunk);
+      }
+      update(index, map);
+    }
+    for (const auto& copied_chunk : copied_chunks) {
+      version->size_ += copied_chunk.second->size();
+    }
+
+    int chunk_bits = version->chunk_bits_;
+    while (chunk_bits < kMaxChunkBits &&
+           version->size_ > (kTargetChunkSize << chunk_bits)) {
+      ++chunk_bits;
+    }
+    if (chunk_bits != version->chunk_bits_) {
+      std::vector<std::shared_ptr<Map>> chunks(1 << chunk_bits);
+      for (auto& chunk : chunks) {
+        chunk = std::make_shared<Map>();
+      }
+      for (const auto& chunk : version->chunks_) {
+        for (const auto& entry : *chunk) {
+          chunks[ChunkIndex(Hash(entry.first), chunk_bits)]->insert(entry);
+        }
+      }
+      version->chunk_bits_ = chunk_bits;
+      version->chunks_.assign(chunks.begin(), chunks.end());
+    }
+    return version;
+  }
+
+  // Returns the current version of shard `i`.
+  std::shared_ptr<const ShardVersion> Pin(int i) const {
+    tf_shared_lock l(shards_[i].mu);
+    return shards_[i].version;
+  }
+
+  struct Shard {
+    // Serializes writers of this shard.
+    mutable mutex write_mu;
+    // Guards the pointer to the current version only.
+    mutable mutex mu;
+    std::shared_ptr<const ShardVersion> version TF_GUARDED_BY(mu);
+  };
+
+  std::array<Shard, kNumShards> shards_;
+  // Odd while an import publishes its shards.
+  std::atomic<int64_t> generation_{0};
+};
+
+// Groups the indices of `keys` by the shard their key belongs to.
+template <class K, class ValueType>
+typename ShardedTableStorage<K, ValueType>::KeysByShard GroupKeysByShard(
+    const typename TTypes<K>::ConstFlat& keys) {
+  typename ShardedTableStorage<K, ValueType>::KeysByShard keys_by_shard;
+  for (int64_t i = 0; i < keys.size(); ++i) {
+    keys_by_shard[ShardedTableStorage<K, ValueType>::ShardIndex(
+                      SubtleMustCopyIfIntegral(keys(i)))]
+        .push_back(i);
+  }
+  return keys_by_shard;
+}
+
+// Alternative implementation of MutableHashTableOfScalars for concurrent
+// lookups and inserts. Lookups and updates lock only the shards their keys
+// belong to. See `ShardedTableStorage` for details.
+//
+// Selected with the "sharded" kernel label, e.g. through
+// `tf.Graph._kernel_label_map({"MutableHashTableV2": "sharded"})`.
+template <class K, class V>
+class ShardedMutableHashTableOfScalars final : public LookupInterface {
+ public:
+  ShardedMutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
+
+  size_t size() const override { return storage_.size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const auto default_flat = default_value.flat<V>();
+
+    int64_t total = value_values.size();
+    int64_t default_total = default_flat.size();
+    bool is_full_size_default = (total == default_total);
+
+    storage_.Find(GroupKeysByShard<K, V>(key_values),
+                  [&](const std::vector<int64_t>& indices,
+                      const typename Storage::ShardVersion& shard) {
+                    for (int64_t i : indices) {
+                      const V* found =
+                          shard.Find(SubtleMustCopyIfIntegral(key_values(i)));
+                      if (found != nullptr) {
+                        value_values(i) = *found;
+                      } else {
+                        value_values(i) = is_full_size_default
+                                              ? default_flat(i)
+                                              : default_flat(0);
+                      }
+                    }
+                  });
+
+    return absl::OkStatus();
+  }
+
+  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+
+    storage_.Update(
+        clear, GroupKeysByShard<K, V>(key_values),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, typename Storage::Map* map) {
+          gtl::InsertOrUpdate(map, SubtleMustCopyIfIntegral(key_values(i)),
+                              SubtleMustCopyIfIntegral(value_values(i)));
+        });
+    return absl::OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return DoInsert(false, keys, values);
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    storage_.Update(
+        /*clear=*/false, GroupKeysByShard<K, V>(key_values),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, typename Storage::Map* map) {
+          map->erase(SubtleMustCopyIfIntegral(key_values(i)));
+        });
+    return absl::OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return DoInsert(true, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    Status status;
+    storage_.ReadAll(
+        [&](const std::vector<const typename Storage::Map*>& maps) {
+          int64_t size = 0;
+          for (const auto* map : maps) size += map->size();
+
+          Tensor* keys;
+          Tensor* values;
+          status = ctx->allocate_output("keys", TensorShape({size}), &keys);
+          if (!status.ok()) return;
+          status = ctx->allocate_output("values", TensorShape({size}), &values);
+          if (!status.ok()) return;
+          ExportKeysAndValues(maps, keys, values);
+        });
+    return status;
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  int64_t MemoryUsed() const override {
+    return sizeof(ShardedMutableHashTableOfScalars) + storage_.MemoryUsed();
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    Tensor keys;
+    Tensor values;
+    storage_.ReadAll(
+        [&](const std::vector<const typename Storage::Map*>& maps) {
+          int64_t size = 0;
+          for (const auto* map : maps) size += map->size();
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(), TensorShape({size}));
+          ExportKeysAndValues(maps, &keys, &values);
+        });
+
+    Node* table = ops::SourceOp(
+        "MutableHashTableV2",
+        builder->opts()
+            .WithName(UniqueNodeName("MutableHashTableFromGraphDef"))
+            .WithAttr("use_node_name_sharing", true)
+            .WithAttr("key_dtype", key_dtype())
+            .WithAttr("value_dtype", value_dtype())
+            .WithAttr("_kernel", "sharded"));
+    Node* keys_node = ops::SourceOp(
+        "Const",
+        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
+    Node* values_node =
+        ops::SourceOp("Const", builder->opts()
+                                   .WithAttr("dtype", value_dtype())
+                                   .WithAttr("value", values));
+    Node* import_table =
+        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                       builder->opts()
+                           .WithAttr("Tin", key_dtype())
+                           .WithAttr("Tout", value_dtype()));
+    *out = ops::UnaryOp("Identity", table,
+                        builder->opts().WithControlInput(import_table));
+    return absl::OkStatus();
+  }
+
+ private:
+  typedef ShardedTableStorage<K, V> Storage;
+
+  // Writes all keys and values of `maps` into `keys` and `values`.
+  static void ExportKeysAndValues(
+      const std::vector<const typename Storage::Map*>& maps,
+      Tensor* keys, Tensor* values) {
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->flat<V>();
+    int64_t i = 0;
+    for (const auto& map : maps) {
+      for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+        keys_data(i) = it->first;
+        values_data(i) = it->second;
+      }
+    }
+  }
+
+  Storage storage_;
+};
+
+// Alternative implementation of MutableHashTableOfTensors for concurrent
+// lookups and inserts. Behaves like ShardedMutableHashTableOfScalars except
+// that each value must be a vector.
+template <class K, class V>
+class ShardedMutableHashTableOfTensors final : public LookupInterface {
+ public:
+  ShardedMutableHashTableOfTensors(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(value_shape_),
+        errors::InvalidArgument("Default value must be a vector, got shape ",
+                                value_shape_.DebugString()));
+  }
+
+  size_t size() const override { return storage_.size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat_inner_dims<V, 2>();
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat_inner_dims<V, 2>();
+    int64_t value_dim = value_shape_.dim_size(0);
+
+    int64_t total = value_values.size();
+    int64_t default_total = default_flat.size();
+    bool is_full_size_default = (total == default_total);
+
+    storage_.Find(
+        GroupKeysByShard<K, ValueArray>(key_values),
+        [&](const std::vector<int64_t>& indices,
+            const typename Storage::ShardVersion& shard) {
+          for (int64_t i : indices) {
+            const ValueArray* value_vec =
+                shard.Find(SubtleMustCopyIfIntegral(key_values(i)));
+            if (value_vec != nullptr) {
+              for (int64_t j = 0; j < value_dim; j++) {
+                value_values(i, j) = value_vec->at(j);
+              }
+            } else {
+              for (int64_t j = 0; j < value_dim; j++) {
+                value_values(i, j) = is_full_size_default ? default_flat(i, j)
+                                                          : default_flat(0, j);
+              }
+            }
+          }
+        });
+
+    return absl::OkStatus();
+  }
+
+  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat_inner_dims<V, 2>();
+    int64_t value_dim = value_shape_.dim_size(0);
+
+    storage_.Update(
+        clear, GroupKeysByShard<K, ValueArray>(key_values),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, typename Storage::Map* map) {
+          ValueArray value_vec;
+          for (int64_t j = 0; j < value_dim; j++) {
+            V value = value_values(i, j);
+            value_vec.push_back(value);
+          }
+          gtl::InsertOrUpdate(map, SubtleMustCopyIfIntegral(key_values(i)),
+                              value_vec);
+        });
+    return absl::OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return DoInsert(false, keys, values);
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+
+    storage_.Update(
+        /*clear=*/false, GroupKeysByShard<K, ValueArray>(key_values),
+        [&](int64_t i) { return SubtleMustCopyIfIntegral(key_values(i)); },
+        [&](int64_t i, typename Storage::Map* map) {
+          map->erase(SubtleMustCopyIfIntegral(key_values(i)));
+        });
+    return absl::OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return DoInsert(true, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const int64_t value_dim = value_shape_.dim_size(0);
+    Status status;
+    storage_.ReadAll(
+        [&](const std::vector<const typename Storage::Map*>& maps) {
+          int64_t size = 0;
+          for (const auto* map : maps) size += map->size();
+
+          Tensor* keys;
+          Tensor* values;
+          status = ctx->allocate_output("keys", TensorShape({size}), &keys);
+          if (!status.ok()) return;
+          status = ctx->allocate_output(
+              "values", TensorShape({size, value_dim}), &values);
+          if (!status.ok()) return;
+          ExportKeysAndValues(maps, keys, values);
+        });
+    return status;
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64_t MemoryUsed() const override {
+    return sizeof(ShardedMutableHashTableOfTensors) + storage_.MemoryUsed();
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    Tensor keys;
+    Tensor values;
+    storage_.ReadAll(
+        [&](const std::vector<const typename Storage::Map*>& maps) {
+          int64_t size = 0;
+          for (const auto* map : maps) size += map->size();
+          keys = Tensor(key_dtype(), TensorShape({size}));
+          values = Tensor(value_dtype(),
+                          TensorShape({size, value_shape_.dim_size(0)}));
+          ExportKeysAndValues(maps, &keys, &values);
+        });
+
+    Node* table =
+        ops::SourceOp("MutableHashTableOfTensorsV2",
+                      builder->opts()
+                          .WithName(UniqueNodeName("MutableHashTableOfTensors"))
+                          .WithAttr("use_node_name_sharing", true)
+                          .WithAttr("key_dtype", key_dtype())
+                          .WithAttr("value_dtype", value_dtype())
+                          .WithAttr("value_shape", value_shape_)
+                          .WithAttr("_kernel", "sharded"));
+    Node* keys_node = ops::SourceOp(
+        "Const",
+        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
+    Node* values_node =
+        ops::SourceOp("Const", builder->opts()
+                                   .WithAttr("dtype", value_dtype())
+                                   .WithAttr("value", values));
+    Node* import_table =
+        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                       builder->opts()
+                           .WithAttr("Tin", key_dtype())
+                           .WithAttr("Tout", value_dtype()));
+    *out = ops::UnaryOp("Identity", table,
+                        builder->opts().WithControlInput(import_table));
+    return absl::OkStatus();
+  }
+
+ private:
+  typedef gtl::InlinedVector<V, 4> ValueArray;
+  typedef ShardedTableStorage<K, ValueArray> Storage;
+
+  // Writes all keys and values of `maps` into `keys` and `values`.
+  void ExportKeysAndValues(
+      const std::vector<const typename Storage::Map*>& maps,
+      Tensor* keys, Tensor* values) const {
+    int64_t value_dim = value_shape_.dim_size(0);
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->matrix<V>();
+    int64_t i = 0;
+    for (const auto& map : maps) {
+      for (auto it = map->begin(); it != map->end(); ++it, ++i) {
+        keys_data(i) = it->first;
+        for (int64_t j = 0; j < value_dim; j++) {
+          values_data(i, j) = it->second[j];
+        }
+      }
+    }
+  }
+
+  TensorShape value_shape_;
+  Storage storage_;
+};
+
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
@@ -519,48 +1143,76 @@ class MutableDenseHashTable final : public LookupInterface {
         empty_key_.template shaped<K, 2>({1, key_size});
     const auto deleted_key_matrix =
         deleted_key_.template shaped<K, 2>({1, key_size});
-    const int64_t bit_mask = num_buckets_ - 1;
-    // TODO(andreasst): parallelize using work_sharder
-    for (int64_t i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
-      if (empty_key_hash_ == key_hash &&
-          IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the empty_key as a table key is not allowed");
-      }
-      if (deleted_key_hash_ == key_hash &&
-          IsEqualKey(deleted_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the deleted_key as a table key is not allowed");
-      }
-      int64_t bucket_index = key_hash & bit_mask;
-      int64_t num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64_t j = 0; j < value_size; ++j) {
-            // TODO(andreasst): check if we can get rid of SubtleMustCopy
-            // here and elsewhere in this file.
-            value_matrix(i, j) =
-                SubtleMustCopyIfIntegral(value_buckets_matrix(bucket_index, j));
-          }
-          break;
+    const int64_t num_buckets = num_buckets_;
+    const int64_t bit_mask = num_buckets - 1;
+
+    mutex status_mu;
+    Status status;
+    // Looks up the keys in [begin, end). Keys are processed in blocks: the
+    // buckets of all keys in a block are prefetched before any of them is
+    // probed, so that their cache misses overlap.
+    auto find_range = [&](int64_t begin, int64_t end) {
+      uint64 key_hashes[kLookupPrefetchDistance];
+      for (int64_t block = begin; block < end;
+           block += kLookupPrefetchDistance) {
+        const int64_t block_end =
+            std::min(block + kLookupPrefetchDistance, end);
+        for (int64_t i = block; i < block_end; ++i) {
+          const uint64 key_hash = HashKey(key_matrix, i);
+          key_hashes[i - block] = key_hash;
+          port::prefetch<port::PREFETCH_HINT_T0>(
+              &key_buckets_matrix(key_hash & bit_mask, 0));
         }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
-          for (int64_t j = 0; j < value_size; ++j) {
-            value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
+        for (int64_t i = block; i < block_end; ++i) {
+          const uint64 key_hash = key_hashes[i - block];
+          if (empty_key_hash_ == key_hash &&
+              IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
+            mutex_lock l(status_mu);
+            status.Update(errors::InvalidArgument(
+                "Using the empty_key as a table key is not allowed"));
+            return;
+          }
+          if (deleted_key_hash_ == key_hash &&
+              IsEqualKey(deleted_key_matrix, 0, key_matrix, i)) {
+            mutex_lock l(status_mu);
+            status.Update(errors::InvalidArgument(
+                "Using the deleted_key as a table key is not allowed"));
+            return;
+          }
+          int64_t bucket_index = key_hash & bit_mask;
+          int64_t num_probes = 0;
+          while (true) {
+            if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
+              for (int64_t j = 0; j < value_size; ++j) {
+                // TODO(andreasst): check if we can get rid of SubtleMustCopy
+                // here and elsewhere in this file.
+                value_matrix(i, j) = SubtleMustCopyIfIntegral(
+                    value_buckets_matrix(bucket_index, j));
+              }
+              break;
+            }
+            if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix,
+                           0)) {
+              for (int64_t j = 0; j < value_size; ++j) {
+                value_matrix(i, j) = SubtleMustCopyIfIntegral(default_flat(j));
+              }
+              break;
+            }
+            ++num_probes;
+            bucket_index =
+                (bucket_index + num_probes) & bit_mask;  // quadratic probing
+            if (num_probes >= num_buckets) {
+              mutex_lock l(status_mu);
+              status.Update(errors::Internal(
+                  "Internal error in MutableDenseHashTable lookup"));
+              return;
+            }
           }
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable lookup");
         }
       }
-    }
-    return absl::OkStatus();
+    };
+    ShardLookups(ctx, num_elements, kFindCostPerKey * key_size, find_range);
+    return status;
   }
 
   Status Insert(OpKernelContext* ctx, const Tensor& key,
@@ -864,6 +1516,9 @@ class MutableDenseHashTable final : public LookupInterface {
     return true;
   }
 
+  // Rough cost of probing for one scalar key in cycles.
+  static constexpr int64_t kFindCostPerKey = 200;
+
   TensorShape key_shape_;
   TensorShape value_shape_;
   float max_load_factor_;
@@ -1201,6 +1856,80 @@ REGISTER_KERNEL(tstring, int64_t);
 
 #undef REGISTER_KERNEL
 
+// Register the sharded implementations of the MutableHashTable and
+// MutableHashTableOfTensors ops under the "sharded" kernel label.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                             \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("MutableHashTable")                                              \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      LookupTableOp<                                                        \
+          lookup::ShardedMutableHashTableOfScalars<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("MutableHashTableV2")                                            \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      LookupTableOp<                                                        \
+          lookup::ShardedMutableHashTableOfScalars<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("AnonymousMutableHashTable")                                     \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      AnonymousLookupTableOp<                                               \
+          lookup::ShardedMutableHashTableOfScalars<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("MutableHashTableOfTensors")                                     \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      LookupTableOp<                                                        \
+          lookup::ShardedMutableHashTableOfTensors<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("MutableHashTableOfTensorsV2")                                   \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      LookupTableOp<                                                        \
+          lookup::ShardedMutableHashTableOfTensors<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)                                          \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("AnonymousMutableHashTableOfTensors")                            \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<key_dtype>("key_dtype")                           \
+          .TypeConstraint<value_dtype>("value_dtype")                       \
+          .Label("sharded"),                                                \
+      AnonymousLookupTableOp<                                               \
+          lookup::ShardedMutableHashTableOfTensors<key_dtype, value_dtype>, \
+          key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(int64_t, tstring);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64_t);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableDenseHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                             \
   REGISTER_KERNEL_BUILDER(                                                  \
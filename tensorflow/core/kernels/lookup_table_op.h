@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -202,6 +203,26 @@ inline const ResourceHandle& SubtleMustCopyIfIntegral(
 // Returns a unique node name starting with "base".
 std::string UniqueNodeName(const std::string& base);
 
+// Number of keys ahead of the current one whose buckets a batched lookup
+// prefetches.
+constexpr int64_t kLookupPrefetchDistance = 8;
+
+// Calls `fn(begin, end)` on disjoint ranges covering [0, num_keys). Large
+// batches are split across the intra-op thread pool of `ctx`; small batches,
+// or any batch when `ctx` is null, run on the calling thread. `cost_per_key`
+// is a rough estimate of the cycles needed to look up one key.
+template <typename Fn>
+void ShardLookups(OpKernelContext* ctx, int64_t num_keys, int64_t cost_per_key,
+                  Fn&& fn) {
+  if (ctx == nullptr) {
+    fn(0, num_keys);
+    return;
+  }
+  auto* worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, num_keys,
+        cost_per_key, std::forward<Fn>(fn));
+}
+
 // Lookup table that wraps an flat_hash_map, where the key and value data type
 // is specified.
 //
@@ -322,14 +343,29 @@ class HashTable : public InitializableLookupTable {
 
   Status DoFind(const Tensor& key, Tensor* value,
                 const Tensor& default_value) override {
+    return DoFind(/*ctx=*/nullptr, key, value, default_value);
+  }
+
+  Status DoFind(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+                const Tensor& default_value) override {
     const V default_val = default_value.flat<V>()(0);
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    for (int64_t i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
-    }
+    ShardLookups(
+        ctx, key_values.size(), kFindCostPerKey,
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            // Start loading the slot of an upcoming key, so that the cache
+            // misses of consecutive lookups overlap.
+            if (i + kLookupPrefetchDistance < end) {
+              table_.prefetch(SubtleMustCopyIfIntegral(
+                  key_values(i + kLookupPrefetchDistance)));
+            }
+            value_values(i) = gtl::FindWithDefault(
+                table_, SubtleMustCopyIfIntegral(key_values(i)), default_val);
+          }
+        });
     return absl::OkStatus();
   }
 
@@ -342,6 +378,10 @@ class HashTable : public InitializableLookupTable {
   }
 
  private:
+  // Rough cost of one lookup in cycles, dominated by cache misses on large
+  // tables.
+  static constexpr int64_t kFindCostPerKey = 200;
+
   absl::flat_hash_map<K, V> table_;
 };
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/match.h"
@@ -159,9 +160,20 @@ class FusedMatMulOpTest : public OpsTestBase {
       ops::Elu(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "LeakyRelu") {
       ops::internal::LeakyRelu(root.WithOpName("with_activation"), with_bias);
+    } else if (activation_type == "GeluApproximate") {
+      // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+      auto cube = ops::Mul(root, ops::Square(root, with_bias), with_bias);
+      auto inner = ops::Mul(
+          root, ops::AddV2(root, with_bias, ops::Mul(root, cube, 0.044715f)),
+          0.7978845608028654f);
+      ops::Mul(root.WithOpName("with_activation"),
+               ops::Mul(root, with_bias, 0.5f),
+               ops::AddV2(root, ops::Tanh(root, inner), 1.0f));
     } else if (activation_type == "GeluExact") {
-      VLOG(0) << "ERROR: GeluExact is yet not available!!";
-      ops::Identity(root.WithOpName("with_activation"), with_bias);
+      // 0.5 * x * (1 + erf(x / sqrt(2)))
+      auto erf = ops::Erf(root, ops::Mul(root, with_bias, 0.7071067811865476f));
+      ops::Mul(root.WithOpName("with_activation"),
+               ops::Mul(root, with_bias, 0.5f), ops::AddV2(root, erf, 1.0f));
     } else if (activation_type == "Sigmoid") {
       ops::Sigmoid(root.WithOpName("with_activation"), with_bias);
     } else if (activation_type == "Tanh") {
@@ -360,14 +372,15 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1) {
 }
 
 static auto GetActivations(DataType dtype) {
-  // "GeluExact", "Tanh", "Sigmoid" fusions are only supported for half-float
-  // datatype
+  // On GPU the "GeluExact", "Tanh" and "Sigmoid" fusions are only supported
+  // for half-float. The CPU kernels also support both Gelu fusions for float.
   switch (dtype) {
     case DT_HALF:
       // TODO: not sure how to add GeluExact op ??
       return std::vector{/*"GeluExact",*/ "Tanh", "Sigmoid"};
     default:
-      return std::vector{"Relu", "Relu6", "Elu", "LeakyRelu"};
+      return std::vector{"Relu",      "Relu6",           "Elu",
+                         "LeakyRelu", "GeluApproximate", "GeluExact"};
   }
 }
 
@@ -545,6 +558,111 @@ BM_Matmul(2000, 1, 2000, true, true);
 
 // LINT.ThenChange(//tensorflow/core/kernels/mkl/mkl_matmul_op_benchmark.cc)
 
+// Benchmarks for the _FusedMatMul rewrites of the remapper against the graphs
+// they replace.
+static Node* FusedMatMul(Graph* g, Node* a, Node* b, Node* bias,
+                         const std::vector<string>& fused_ops) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedMatMul")
+                  .Input(a)
+                  .Input(b)
+                  .Input(std::vector<NodeBuilder::NodeOut>{bias})
+                  .Attr("T", DT_FLOAT)
+                  .Attr("fused_ops", fused_ops)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+static Node* RandomConstant(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return test::graph::Constant(g, t);
+}
+
+// MatMul + BiasAdd + GeluExact, where GeluExact is the subgraph
+// 0.5 * x * (1 + erf(x / sqrt(2))) that the remapper matches.
+static Graph* MatmulBiasAddGelu(int m, int k, int n, bool fused) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* a = RandomConstant(g, TensorShape({m, k}));
+  Node* b = RandomConstant(g, TensorShape({k, n}));
+  Node* bias = RandomConstant(g, TensorShape({n}));
+  if (fused) {
+    FusedMatMul(g, a, b, bias, {"BiasAdd", "GeluExact"});
+    return g;
+  }
+  Node* x = test::graph::Binary(g, "BiasAdd",
+                                test::graph::Matmul(g, a, b, false, false),
+                                bias);
+  auto scalar = [g](float value) {
+    return test::graph::Constant(g, test::AsScalar<float>(value));
+  };
+  Node* erf = test::graph::Unary(
+      g, "Erf", test::graph::Binary(g, "Mul", x, scalar(0.7071067811865476f)));
+  test::graph::Binary(g, "Mul", test::graph::Binary(g, "Mul", x, scalar(0.5f)),
+                      test::graph::Binary(g, "AddV2", erf, scalar(1.0f)));
+  return g;
+}
+
+// Three MatMul + BiasAdd projections of the same input, as separate
+// _FusedMatMul nodes or as one _FusedMatMul over the concatenated weights
+// followed by a SplitV.
+static Graph* MatmulBiasAddQkv(int m, int k, int n, bool concatenated) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* a = RandomConstant(g, TensorShape({m, k}));
+  if (!concatenated) {
+    for (int i = 0; i < 3; ++i) {
+      FusedMatMul(g, a, RandomConstant(g, TensorShape({k, n})),
+                  RandomConstant(g, TensorShape({n})), {"BiasAdd"});
+    }
+    return g;
+  }
+  Node* product =
+      FusedMatMul(g, a, RandomConstant(g, TensorShape({k, 3 * n})),
+                  RandomConstant(g, TensorShape({3 * n})), {"BiasAdd"});
+  Node* split;
+  TF_CHECK_OK(
+      NodeBuilder(g->NewName("n"), "SplitV")
+          .Input(product)
+          .Input(test::graph::Constant(g, test::AsTensor<int32>({n, n, n})))
+          .Input(test::graph::Constant(g, test::AsScalar<int32>(1)))
+          .Attr("num_split", 3)
+          .Finalize(g, &split));
+  return g;
+}
+
+#define BM_MatmulBiasAddGelu(M, K, N, FUSED)                                 \
+  static void BM_MatmulBiasAddGelu##_##M##_##K##_##N##_##FUSED(              \
+      ::testing::benchmark::State& state) {                                  \
+    test::Benchmark("cpu", MatmulBiasAddGelu(M, K, N, FUSED),                \
+                    /*old_benchmark_api*/ false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(state.iterations() * M * K * N * 2);             \
+  }                                                                          \
+  BENCHMARK(BM_MatmulBiasAddGelu##_##M##_##K##_##N##_##FUSED)->UseRealTime();
+
+#define BM_MatmulBiasAddQkv(M, K, N, CONCAT)                                 \
+  static void BM_MatmulBiasAddQkv##_##M##_##K##_##N##_##CONCAT(              \
+      ::testing::benchmark::State& state) {                                  \
+    test::Benchmark("cpu", MatmulBiasAddQkv(M, K, N, CONCAT),                \
+                    /*old_benchmark_api*/ false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(state.iterations() * M * K * N * 3 * 2);         \
+  }                                                                          \
+  BENCHMARK(BM_MatmulBiasAddQkv##_##M##_##K##_##N##_##CONCAT)->UseRealTime();
+
+// The feed-forward expansion and the attention projections of BERT-base
+// (hidden size 768) for a single sequence and a batch of sequences of 128
+// tokens.
+BM_MatmulBiasAddGelu(128, 768, 3072, false);
+BM_MatmulBiasAddGelu(128, 768, 3072, true);
+BM_MatmulBiasAddGelu(4096, 768, 3072, false);
+BM_MatmulBiasAddGelu(4096, 768, 3072, true);
+
+BM_MatmulBiasAddQkv(128, 768, 768, false);
+BM_MatmulBiasAddQkv(128, 768, 768, true);
+BM_MatmulBiasAddQkv(4096, 768, 768, false);
+BM_MatmulBiasAddQkv(4096, 768, 768, true);
+
 // Benchmarks for batched matmul with broadcasting.
 Node* BroadcastTo(Graph* g, Node* input, Node* shape) {
   Node* ret;
@@ -57,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stream_executor.h"
 #endif
 
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -349,6 +350,48 @@ REGISTER_KERNEL_BUILDER(Name("VariableShape")
                             .HostMemory("input"),
                         VariableShapeOp<int64_t>);
 
+void TakeVariableDirtyRowsOp::Compute(OpKernelContext* ctx) {
+  core::RefCountPtr<Var> variable;
+  OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+  std::vector<int64_t> rows;
+  bool all_rows_dirty;
+  {
+    tf_shared_lock ml(*variable->mu());
+    all_rows_dirty = variable->TakeDirtyRows(&rows);
+  }
+  Tensor* output;
+  if (all_rows_dirty) {
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    output->scalar<int64_t>()() = -1;
+    return;
+  }
+  OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                          0, TensorShape({static_cast<int64_t>(rows.size())}),
+                          &output));
+  std::copy(rows.begin(), rows.end(), output->flat<int64_t>().data());
+}
+
+REGISTER_KERNEL_BUILDER(Name("TakeVariableDirtyRows").Device(DEVICE_CPU),
+                        TakeVariableDirtyRowsOp);
+REGISTER_KERNEL_BUILDER(Name("TakeVariableDirtyRows")
+                            .Device(DEVICE_DEFAULT)
+                            .HostMemory("row_indices")
+                            .HostMemory("resource"),
+                        TakeVariableDirtyRowsOp);
+
+void CommitVariableDirtyRowsOp::Compute(OpKernelContext* ctx) {
+  core::RefCountPtr<Var> variable;
+  OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+  variable->CommitDirtyRows();
+}
+
+REGISTER_KERNEL_BUILDER(Name("CommitVariableDirtyRows").Device(DEVICE_CPU),
+                        CommitVariableDirtyRowsOp);
+REGISTER_KERNEL_BUILDER(Name("CommitVariableDirtyRows")
+                            .Device(DEVICE_DEFAULT)
+                            .HostMemory("resource"),
+                        CommitVariableDirtyRowsOp);
+
 DestroyResourceOp::DestroyResourceOp(OpKernelConstruction* ctx)
     : OpKernel(ctx) {
   OP_REQUIRES_OK(ctx,
@@ -475,6 +518,7 @@ class AssignVariableOp : public OpKernel {
       *variable->tensor() = value;
     }
     variable->is_initialized = true;
+    variable->MarkAllRowsDirty();
   }
 
  private:
@@ -627,6 +671,7 @@ class AssignUpdateVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
                    value.flat<T>());
+    variable->MarkAllRowsDirty();
   }
 };
 
@@ -1183,6 +1228,7 @@ class ResourceScatterUpdateOp : public OpKernel {
     if (N > 0) {
       OP_REQUIRES_OK(
           c, DoScatter<Device, T, Index, op>(c, params, indices, updates, N));
+      RecordSparseVariableUpdate<Device>(v.get(), indices);
     }
   }
 };
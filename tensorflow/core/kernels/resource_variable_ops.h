@@ -94,6 +94,18 @@ class VariableShapeOp : public OpKernel {
   }
 };
 
+class TakeVariableDirtyRowsOp : public OpKernel {
+ public:
+  explicit TakeVariableDirtyRowsOp(OpKernelConstruction* c) : OpKernel(c) {}
+  void Compute(OpKernelContext* ctx) override;
+};
+
+class CommitVariableDirtyRowsOp : public OpKernel {
+ public:
+  explicit CommitVariableDirtyRowsOp(OpKernelConstruction* c) : OpKernel(c) {}
+  void Compute(OpKernelContext* ctx) override;
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_RESOURCE_VARIABLE_OPS_H_
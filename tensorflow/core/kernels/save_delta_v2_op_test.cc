@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Sparse training ops update the same rows of a variable and of its slot
+// variables, so a delta checkpoint must include the rows of both.
+TEST(SaveDeltaV2OpTest, SparseApplyUpdatesSlotVariables) {
+  const string base_prefix = io::JoinPath(testing::TmpDir(), "delta_base");
+  const string delta_prefix = io::JoinPath(testing::TmpDir(), "delta_delta");
+
+  Scope root = Scope::NewRootScope();
+  auto var = ops::VarHandleOp(root, DT_FLOAT, TensorShape({4, 2}));
+  auto accum = ops::VarHandleOp(root, DT_FLOAT, TensorShape({4, 2}));
+  auto init_var = ops::AssignVariableOp(
+      root, var, ops::Const(root, {{1.f, 2.f}, {3.f, 4.f}, {5.f, 6.f},
+                                   {7.f, 8.f}}));
+  auto init_accum =
+      ops::AssignVariableOp(root, accum, ops::Fill(root, {4, 2}, 0.1f));
+
+  auto take_var = ops::TakeVariableDirtyRows(root, var);
+  auto take_accum = ops::TakeVariableDirtyRows(root, accum);
+  const std::vector<Operation> commit = {
+      ops::CommitVariableDirtyRows(root, var).operation,
+      ops::CommitVariableDirtyRows(root, accum).operation};
+  auto read_var = ops::ReadVariableOp(root, var, DT_FLOAT);
+  auto read_accum = ops::ReadVariableOp(root, accum, DT_FLOAT);
+  auto names = ops::Const<tstring>(root, {"var", "accum"});
+  auto slices = ops::Const<tstring>(root, {"", ""});
+
+  auto save_base = ops::SaveV2(root, ops::Const<tstring>(root, base_prefix),
+                               names, slices, {read_var, read_accum});
+  auto apply = ops::ResourceSparseApplyAdagrad(
+      root, var, accum, ops::Const(root, 0.5f),
+      ops::Const(root, {{1.f, 1.f}, {2.f, 2.f}}), ops::Const(root, {3, 1}));
+  auto save_delta = ops::SaveDeltaV2(
+      root, ops::Const<tstring>(root, delta_prefix),
+      ops::Const<tstring>(root, base_prefix), names, slices,
+      {take_var, take_accum}, {read_var, read_accum});
+  auto restore = ops::RestoreV2(root, ops::Const<tstring>(root, delta_prefix),
+                                names, slices, {DT_FLOAT, DT_FLOAT});
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({}, {}, {init_var, init_accum}, nullptr));
+
+  // The first take reports both variables as fully dirty, and the full save
+  // becomes the base of the delta.
+  TF_ASSERT_OK(session.Run({take_var, take_accum}, &outputs));
+  EXPECT_EQ(0, outputs[0].dims());
+  EXPECT_EQ(0, outputs[1].dims());
+  TF_ASSERT_OK(session.Run({}, {}, {save_base}, nullptr));
+  TF_ASSERT_OK(session.Run({}, {}, commit, nullptr));
+
+  TF_ASSERT_OK(session.Run({}, {}, {apply}, nullptr));
+  TF_ASSERT_OK(session.Run({take_var, take_accum}, &outputs));
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({1, 3}),
+                                   outputs[0]);
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({1, 3}),
+                                   outputs[1]);
+
+  // Saving the delta takes the rows again, since they are not committed yet.
+  TF_ASSERT_OK(session.Run({}, {}, {save_delta}, nullptr));
+  TF_ASSERT_OK(session.Run({}, {}, commit, nullptr));
+  std::vector<Tensor> expected;
+  TF_ASSERT_OK(session.Run({read_var, read_accum}, &expected));
+  TF_ASSERT_OK(session.Run(restore.tensors, &outputs));
+  test::ExpectTensorEqual<float>(expected[0], outputs[0]);
+  test::ExpectTensorEqual<float>(expected[1], outputs[1]);
+
+  // Committed rows are not returned again.
+  TF_ASSERT_OK(session.Run({take_var, take_accum}, &outputs));
+  EXPECT_EQ(0, outputs[0].NumElements());
+  EXPECT_EQ(0, outputs[1].NumElements());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/bounds_check.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -258,13 +260,14 @@ const int64_t kLargeShapeThreshold = 16 << 20;  // 16M
 struct RestoreOp {
   RestoreOp(OpKernelContext* context, int idx, const string& tensor_name,
             const string& shape_and_slice, const string& reader_prefix,
-            DataType dtype)
+            DataType dtype, bool zero_copy)
       : context(context),
         idx(idx),
         tensor_name(tensor_name),
         shape_and_slice(shape_and_slice),
         reader_prefix(reader_prefix),
-        dtype(dtype) {}
+        dtype(dtype),
+        zero_copy(zero_copy) {}
 
   // Move-only. It does not make sense to "run()" a copied RestoreOp.
   RestoreOp(const RestoreOp&) = delete;
@@ -302,7 +305,13 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    Tensor mapped_tensor;
+    if (shape_and_slice.empty() && zero_copy) {
+      // Lookup the full tensor, aliasing the mapped data file if possible.
+      TF_RETURN_IF_ERROR(reader->LookupZeroCopy(tensor_name, &mapped_tensor));
+      context->set_output(idx, mapped_tensor);
+      restored_tensor = &mapped_tensor;
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -356,10 +365,65 @@ struct RestoreOp {
   string shape_and_slice;
   string reader_prefix;
   DataType dtype;
+  // Whether to return tensors backed by the memory-mapped checkpoint.
+  bool zero_copy;
 
   ::tensorflow::Status status;
 };
 
+// Restores all full tensors with a single BundleReader::LookupMany() call,
+// which coalesces and parallelizes reads across shards. Slices are restored
+// one by one afterwards.
+Status RunRestoreOpsWithParallelReads(OpKernelContext* context,
+                                      BundleReader* reader,
+                                      std::vector<RestoreOp>& restore_ops) {
+  std::vector<string> keys;
+  std::vector<Tensor*> vals;
+  for (const RestoreOp& restore_op : restore_ops) {
+    if (!restore_op.shape_and_slice.empty()) continue;
+    TensorShape restored_full_shape;
+    TF_RETURN_IF_ERROR(reader->LookupTensorShape(restore_op.tensor_name,
+                                                 &restored_full_shape));
+    Tensor* restored_tensor;
+    TF_RETURN_IF_ERROR(context->allocate_output(
+        restore_op.idx, restored_full_shape, &restored_tensor));
+    keys.push_back(restore_op.tensor_name);
+    vals.push_back(restored_tensor);
+  }
+
+  BundleReader::ParallelReadOptions options;
+  if (context->session_config() != nullptr &&
+      context->session_config()->intra_op_parallelism_threads() > 0) {
+    options.num_threads =
+        context->session_config()->intra_op_parallelism_threads();
+  }
+  BundleReader::ParallelReadStats stats;
+  TF_RETURN_IF_ERROR(reader->LookupMany(keys, vals, options, &stats));
+  metrics::RecordCheckpointRestoreRead(stats.bytes_read, stats.duration_us);
+  VLOG(1) << "Restored " << keys.size() << " tensors with " << stats.num_reads
+          << " reads of " << stats.bytes_read << " bytes in "
+          << stats.duration_us << "us";
+
+  for (RestoreOp& restore_op : restore_ops) {
+    if (restore_op.shape_and_slice.empty()) continue;
+    TF_RETURN_IF_ERROR(restore_op.run(reader));
+  }
+  return absl::OkStatus();
+}
+
+Status CheckRestoredDtypes(OpKernelContext* context,
+                           const std::vector<RestoreOp>& restore_ops) {
+  for (const RestoreOp& restore_op : restore_ops) {
+    if (restore_op.dtype != context->mutable_output(restore_op.idx)->dtype()) {
+      return errors::InvalidArgument(
+          "tensor_name = ", restore_op.tensor_name, "; expected dtype ",
+          DataTypeString(restore_op.dtype), " does not equal restored dtype ",
+          DataTypeString(context->mutable_output(restore_op.idx)->dtype()));
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -371,11 +435,23 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   const auto& tensor_names_flat = tensor_names.flat<tstring>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
+  // Restoring from a memory-mapped checkpoint avoids holding a second copy of
+  // every tensor. Restored tensors are read-only and copied on first write, so
+  // this suits checkpoints of constants and read-mostly variables that were
+  // saved with TF_CHECKPOINT_ALIGN_FOR_MMAP.
+  bool zero_copy = false;
+  TF_RETURN_IF_ERROR(
+      ReadBoolFromEnvVar("TF_RESTORE_V2_USE_MMAP", false, &zero_copy));
+  bool parallel_reads = false;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RESTORE_V2_PARALLEL_READS", false,
+                                        &parallel_reads));
+
   std::vector<RestoreOp> restore_ops;
   restore_ops.reserve(tensor_names_flat.size());
   for (int i = 0; i < tensor_names_flat.size(); ++i) {
     restore_ops.push_back({context, i, tensor_names_flat(i),
-                           shape_and_slices_flat(i), prefix_string, dtypes[i]});
+                           shape_and_slices_flat(i), prefix_string, dtypes[i],
+                           zero_copy});
   }
 
   tsl::Env* const env = tsl::Env::Default();
@@ -405,6 +481,12 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  if (parallel_reads && !zero_copy) {
+    TF_RETURN_IF_ERROR(
+        RunRestoreOpsWithParallelReads(context, &default_reader, restore_ops));
+    return CheckRestoredDtypes(context, restore_ops);
+  }
+
   // Split restore ops into two groups: large and small. We schedule
   // large ops first, to prevent them from waiting on the small op.
   std::vector<RestoreOp*> large_restore_ops;
@@ -469,16 +551,7 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     }
   }
 
-  for (const RestoreOp& restore_op : restore_ops) {
-    if (restore_op.dtype != context->mutable_output(restore_op.idx)->dtype()) {
-      return errors::InvalidArgument(
-          "tensor_name = ", restore_op.tensor_name, "; expected dtype ",
-          DataTypeString(restore_op.dtype), " does not equal restored dtype ",
-          DataTypeString(context->mutable_output(restore_op.idx)->dtype()));
-    }
-  }
-
-  return absl::OkStatus();
+  return CheckRestoredDtypes(context, restore_ops);
 }
 
 }  // namespace tensorflow
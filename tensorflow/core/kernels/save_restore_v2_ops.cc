@@ -16,6 +16,7 @@ limitations under the License.
 // See docs in ../ops/io_ops.cc.
 
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <vector>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"  // IWYU pragma: keep
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -111,7 +113,16 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    // Aligning tensor data lets RestoreV2 map tensors without copying them
+    // when TF_RESTORE_V2_USE_MMAP is set.
+    bool align_for_mmap = false;
+    OP_REQUIRES_OK(context, ReadBoolFromEnvVar("TF_CHECKPOINT_ALIGN_FOR_MMAP",
+                                               false, &align_for_mmap));
+    BundleWriter::Options writer_options;
+    if (align_for_mmap) {
+      writer_options.data_alignment = kMappedDataAlignment;
+    }
+    BundleWriter writer(Env::Default(), prefix_string, writer_options);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
 
@@ -185,6 +196,128 @@ class SaveV2 : public OpKernel {
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+// Saves a delta bundle over the bundle at "base_prefix". For each tensor,
+// "row_indices" is a scalar if the whole tensor is to be saved, or a vector of
+// the rows of dimension 0 that changed since the base was written, as returned
+// by TakeVariableDirtyRows. Tensors with no changed rows are inherited from the
+// base. The caller runs CommitVariableDirtyRows only after this op succeeds.
+class SaveDeltaV2 : public OpKernel {
+ public:
+  explicit SaveDeltaV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_tensors_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& base_prefix = context->input(1);
+    const Tensor& tensor_names = context->input(2);
+    const Tensor& shape_and_slices = context->input(3);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsScalar(prefix.shape()) &&
+                    TensorShapeUtils::IsScalar(base_prefix.shape()),
+                errors::InvalidArgument(
+                    "Inputs prefix and base_prefix should be scalars, got ",
+                    prefix.shape().DebugString(), " and ",
+                    base_prefix.shape().DebugString(), " instead."));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(tensor_names.shape()) &&
+                    tensor_names.NumElements() == num_tensors_ &&
+                    shape_and_slices.shape() == tensor_names.shape(),
+                errors::InvalidArgument(
+                    "Inputs tensor_names and shape_and_slices should have ",
+                    num_tensors_, " elements, got ",
+                    tensor_names.shape().DebugString(), " and ",
+                    shape_and_slices.shape().DebugString(), " instead."));
+    OP_REQUIRES(context, context->num_inputs() == 4 + 2 * num_tensors_,
+                errors::InvalidArgument("Expected ", num_tensors_,
+                                        " tensors, got ",
+                                        context->num_inputs() - 4 -
+                                            num_tensors_));
+
+    const string& prefix_string = prefix.scalar<tstring>()();
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+    const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
+
+    BundleWriter::Options writer_options;
+    writer_options.base_prefix = base_prefix.scalar<tstring>()();
+    BundleWriter writer(Env::Default(), prefix_string, writer_options);
+    OP_REQUIRES_OK(context, writer.status());
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string
+            << ", base_prefix: " << writer_options.base_prefix;
+
+    for (int i = 0; i < num_tensors_; ++i) {
+      const string& tensor_name = tensor_names_flat(i);
+      const Tensor& row_indices = context->input(4 + i);
+      const Tensor& tensor = context->input(4 + num_tensors_ + i);
+      OP_REQUIRES(context, row_indices.dims() <= 1,
+                  errors::InvalidArgument(
+                      "row_indices for ", tensor_name,
+                      " should be a scalar or a vector, got ",
+                      row_indices.shape().DebugString()));
+
+      if (!shape_and_slices_flat(i).empty()) {
+        // Slices of partitioned tensors are always saved in full, since the
+        // rows of a slice do not map onto rows of the full tensor.
+        const string& shape_spec = shape_and_slices_flat(i);
+        TensorShape shape;
+        TensorSlice slice(tensor.dims());
+        TensorShape slice_shape;
+        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
+                                    shape_spec, &shape, &slice, &slice_shape));
+        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
+                    errors::InvalidArgument("Slice in shape_and_slice "
+                                            "specification does not match the "
+                                            "shape of the tensor to save: ",
+                                            shape_spec, ", tensor: ",
+                                            tensor.shape().DebugString()));
+        OP_REQUIRES_OK(context,
+                       writer.AddSlice(tensor_name, shape, slice, tensor));
+      } else if (row_indices.dims() == 0 || tensor.dims() == 0 ||
+                 !DataTypeCanUseMemcpy(tensor.dtype())) {
+        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
+      } else if (row_indices.NumElements() > 0) {
+        Tensor rows;
+        OP_REQUIRES_OK(context, GatherRows(context, tensor, row_indices, &rows));
+        OP_REQUIRES_OK(context, writer.AddRows(tensor_name, tensor.shape(),
+                                               row_indices, rows));
+      }
+      VLOG(2) << "Done save of " << tensor_name;
+    }
+    OP_REQUIRES_OK(context, writer.Finish());
+    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
+  }
+
+ private:
+  // Copies the rows "row_indices" of "tensor" into "*rows".
+  static Status GatherRows(OpKernelContext* context, const Tensor& tensor,
+                           const Tensor& row_indices, Tensor* rows) {
+    const auto indices = row_indices.flat<int64_t>();
+    const int64_t num_rows = tensor.dim_size(0);
+    TensorShape rows_shape = tensor.shape();
+    rows_shape.set_dim(0, indices.size());
+    TF_RETURN_IF_ERROR(
+        context->allocate_temp(tensor.dtype(), rows_shape, rows));
+    for (int64_t i = 0; i < indices.size(); ++i) {
+      if (!FastBoundsCheck(indices(i), num_rows)) {
+        return errors::InvalidArgument("Row index ", indices(i),
+                                       " is out of range for shape ",
+                                       tensor.shape().DebugString());
+      }
+    }
+    if (rows->NumElements() == 0) return absl::OkStatus();
+    const size_t row_bytes = tensor.TotalBytes() / num_rows;
+    const char* src = tensor.tensor_data().data();
+    char* dst = const_cast<char*>(rows->tensor_data().data());
+    for (int64_t i = 0; i < indices.size(); ++i) {
+      memcpy(dst + i * row_bytes, src + indices(i) * row_bytes, row_bytes);
+    }
+    return absl::OkStatus();
+  }
+
+  int num_tensors_;
+};
+REGISTER_KERNEL_BUILDER(Name("SaveDeltaV2").Device(DEVICE_CPU), SaveDeltaV2);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
@@ -257,6 +257,8 @@ class ScatterNdUpdateOp : public OpKernel {
       OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
       mutex_lock m(*v->mu());
       DoCompute(c);
+      // N-dimensional indices are not tracked row by row.
+      v->MarkAllRowsDirty();
     } else if (use_exclusive_lock_) {
       // If we're here, it means the input type is a ref.
       DCHECK(IsRefType(c->input_dtype(0)));
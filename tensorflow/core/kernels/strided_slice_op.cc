@@ -339,6 +339,9 @@ class StridedSliceAssignOp : public OpKernel {
                         "l-value dtype ", DataTypeString(old_lhs->dtype()),
                         " does not match r-value dtype ",
                         DataTypeString(DataTypeToEnum<T>::value)));
+        // The slice can cover any rows, so the whole variable must be saved
+        // by the next incremental checkpoint.
+        v->MarkAllRowsDirty();
       } else {
         context->forward_ref_input_to_ref_output(0, 0);
         tmp = context->mutable_input(0, true);
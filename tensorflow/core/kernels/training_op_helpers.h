@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_TRAINING_OP_HELPERS_H_
 #define TENSORFLOW_CORE_KERNELS_TRAINING_OP_HELPERS_H_
 
+#include <initializer_list>
 #include <optional>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -252,6 +253,35 @@ Status PrepareToUpdateVariable(OpKernelContext* ctx, Tensor* tensor,
   return absl::OkStatus();
 }
 
+// Records the rows of the resource variable `var` written by a sparse update
+// with `indices`, for incremental checkpoints. Indices that live in device
+// memory cannot be read here, so the whole variable is marked dirty instead.
+template <typename Device>
+void RecordSparseVariableUpdate(Var* var, const Tensor& indices) {
+  if (std::is_same<Device, Eigen::ThreadPoolDevice>::value) {
+    var->RecordDirtyRows(indices);
+  } else {
+    var->MarkAllRowsDirty();
+  }
+}
+
+// As above, for each of the variables passed as input indices `inputs` in
+// `ctx`. Sparse training ops update the same rows of the variable and of each
+// of its slot variables, so `inputs` must list all of them. Does nothing for
+// reference variables.
+template <typename Device>
+void RecordSparseVariableUpdate(OpKernelContext* ctx,
+                                std::initializer_list<int> inputs,
+                                const Tensor& indices) {
+  for (const int input : inputs) {
+    if (ctx->input_dtype(input) != DT_RESOURCE) continue;
+    core::RefCountPtr<Var> var;
+    if (LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) {
+      RecordSparseVariableUpdate<Device>(var.get(), indices);
+    }
+  }
+}
+
 // This gives you `*out`, a tensor you can update, corresponding to a variable
 // passed as input index `input`.  This handles the differences between
 // reference and resource variables. For reference variables we can just grab
@@ -273,6 +303,7 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     }
     TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(
         ctx, var->tensor(), var->copy_on_read_mode.load()));
+    var->MarkAllRowsDirty();
     *out = *var->tensor();
     return absl::OkStatus();
   }
@@ -83,6 +83,39 @@ REGISTER_OP("SaveV2")
       return absl::OkStatus();
     });
 
+REGISTER_OP("SaveDeltaV2")
+    .Input("prefix: string")
+    .Input("base_prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("row_indices: N * int64")
+    .Input("tensors: dtypes")
+    .Attr("N: int >= 0")
+    .Attr("dtypes: list(type)")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+
+      // Validate prefix and base_prefix.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+
+      // Validate tensor_names and shapes_and_slices.
+      for (int i = 2; i <= 3; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(c->WithValue(c->Dim(s, 0), n, &unused_dim));
+      }
+      // Validate row_indices.
+      for (int i = 4; i < 4 + n; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(i), 1, &unused));
+      }
+      return absl::OkStatus();
+    });
+
 REGISTER_OP("RestoreV2")
     .Input("prefix: string")
     .Input("tensor_names: string")
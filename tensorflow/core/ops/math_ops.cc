@@ -352,6 +352,31 @@ REGISTER_OP("_UnaryOpsComposition")
 expected to create these operators.
 )doc");
 
+// Evaluates a cluster of element-wise ops as a program over its inputs. Inputs
+// are registers [0, N), and the i-th op in `op_names` reads the registers
+// listed for it in `op_inputs` and writes register N + i. The last op computes
+// the output, which has the broadcast shape of all inputs.
+REGISTER_OP("_FusedElementwise")
+    .Input("inputs: Tin")
+    .Output("y: T")
+    .Attr("Tin: list({bool, int32, int64, float}) >= 1")
+    .Attr("T: {float}")
+    .Attr("op_names: list(string)")
+    .Attr("op_inputs: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle out = c->input(0);
+      for (int i = 1; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
+            c, out, c->input(i), /*incompatible_shape_error=*/true, &out));
+      }
+      c->set_output(0, out);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 #undef UNARY
 #undef UNARY_REAL
 #undef UNARY_COMPLEX
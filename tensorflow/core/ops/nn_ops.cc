@@ -260,6 +260,35 @@ Do not invoke this operator directly in Python. A fusion optimization is
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i < 3; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      c->set_output(0, x);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Internal LayerNorm operation: reserved for internal use.
+
+Normalizes `x` along its innermost dimension, then multiplies the result by
+`scale` and adds `offset`.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("FusedBatchNormGrad")
     .Input("y_backprop: T")
     .Input("x: T")
@@ -1289,6 +1318,24 @@ REGISTER_OP("Softmax")
       return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
     });
 
+REGISTER_OP("_FusedMaskedSoftmax")
+    .Input("logits: T")
+    .Input("mask: T")
+    .Output("softmax: T")
+    .Attr("T: {float}")
+    .SetShapeFn([](InferenceContext* c) {
+      return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
+    })
+    .Doc(R"doc(
+Internal Softmax operation: reserved for internal use.
+
+Computes `Softmax(logits + mask)`, where `mask` is broadcast to the shape of
+`logits`.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 REGISTER_OP("LogSoftmax")
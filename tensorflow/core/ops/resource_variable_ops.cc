@@ -251,6 +251,21 @@ REGISTER_OP("VariableShape")
     .Attr("out_type: {int32, int64} = DT_INT32")
     .SetShapeFn(VariableShapeShapeFn);
 
+REGISTER_OP("TakeVariableDirtyRows")
+    .Input("resource: resource")
+    .Output("row_indices: int64")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      // A scalar when every row is dirty, a vector of row indices otherwise.
+      c->set_output(0, c->UnknownShape());
+      return absl::OkStatus();
+    });
+
+REGISTER_OP("CommitVariableDirtyRows")
+    .Input("resource: resource")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::NoOutputs);
+
 REGISTER_OP("ResourceGather")
     .Input("resource: resource")
     .Input("indices: Tindices")
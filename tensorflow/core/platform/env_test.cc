@@ -17,10 +17,13 @@ limitations under the License.
 
 #include <sys/stat.h>
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/null_file_system.h"
 #include "tensorflow/core/platform/path.h"
@@ -92,6 +95,81 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadAsync) {
+  const int length = 1 << 20;
+  const string filename = io::JoinPath(BaseDir(), "read_async");
+  const string input = CreateTestFile(env_, filename, length);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // Keep many reads in flight at once, the last of which runs past EOF.
+  const int num_reads = 1000;
+  const int read_size = 4096;
+  std::vector<string> scratch(num_reads, string(read_size, 0));
+  std::vector<Status> statuses(num_reads);
+  std::vector<StringPiece> results(num_reads);
+  BlockingCounter counter(num_reads);
+  for (int i = 0; i < num_reads; ++i) {
+    const uint64 offset =
+        i == num_reads - 1 ? length - 100 : (i * 7919) % (length - read_size);
+    f->ReadAsync(offset, read_size, &scratch[i][0],
+                 [&, i](const Status& s, StringPiece result) {
+                   statuses[i] = s;
+                   results[i] = result;
+                   counter.DecrementCount();
+                 });
+  }
+  counter.Wait();
+
+  for (int i = 0; i < num_reads - 1; ++i) {
+    TF_EXPECT_OK(statuses[i]);
+    EXPECT_EQ(results[i],
+              StringPiece(input).substr((i * 7919) % (length - read_size),
+                                        read_size));
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, statuses.back().code());
+  EXPECT_EQ(results.back(), StringPiece(input).substr(length - 100));
+}
+
+// Callbacks may start further reads, even when as many reads are in flight
+// as the file system allows.
+TEST_F(DefaultEnvTest, ReadAsyncFromCallback) {
+  const int length = 1 << 20;
+  const string filename = io::JoinPath(BaseDir(), "read_async_from_callback");
+  const string input = CreateTestFile(env_, filename, length);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  const int num_chains = 1000;
+  const int reads_per_chain = 4;
+  const int read_size = 4096;
+  std::vector<string> scratch(num_chains, string(read_size, 0));
+  std::vector<int> num_ok(num_chains, 0);
+  BlockingCounter counter(num_chains);
+  std::function<void(int, int)> read_next = [&](int chain, int read) {
+    const uint64 offset = (chain * 7919 + read * 104729) % (length - read_size);
+    f->ReadAsync(offset, read_size, &scratch[chain][0],
+                 [&, chain, read, offset](const Status& s,
+                                          StringPiece result) {
+                   if (s.ok() &&
+                       result == StringPiece(input).substr(offset, read_size)) {
+                     ++num_ok[chain];
+                   }
+                   if (read + 1 < reads_per_chain) {
+                     read_next(chain, read + 1);
+                   } else {
+                     counter.DecrementCount();
+                   }
+                 });
+  };
+  for (int i = 0; i < num_chains; ++i) read_next(i, 0);
+  counter.Wait();
+
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_EQ(reads_per_chain, num_ok[i]);
+  }
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
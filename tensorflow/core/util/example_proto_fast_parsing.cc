@@ -588,7 +588,7 @@ void LogSparseFeatureDataLoss(StringPiece feature_name) {
 }
 
 Status FastParseSerializedExample(
-    const tstring& serialized_example, const tstring& example_name,
+    StringPiece serialized_example, StringPiece example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
     SeededHasher hasher, std::vector<Tensor>* output_dense,
@@ -1129,12 +1129,13 @@ void CopySparseBufferToTensor(DataType dtype, size_t offset, SparseBuffer* src,
   }
 }
 
-}  // namespace
-
-Status FastParseExample(const Config& config,
-                        absl::Span<const tstring> serialized,
-                        absl::Span<const tstring> example_names,
-                        thread::ThreadPool* thread_pool, Result* result) {
+// Parses each element of `serialized`, which may be any string type that
+// converts to a StringPiece.
+template <typename T>
+Status FastParseExampleImpl(const Config& config,
+                            absl::Span<const T> serialized,
+                            absl::Span<const tstring> example_names,
+                            thread::ThreadPool* thread_pool, Result* result) {
   DCHECK(result != nullptr);
   // Check config so we can safely CHECK(false) in switches on config.*.dtype
   TF_RETURN_IF_ERROR(CheckConfigDataTypes(config));
@@ -1242,8 +1243,9 @@ Status FastParseExample(const Config& config,
       }
       status_of_minibatch[minibatch] = FastParseSerializedExample(
           serialized[e],
-          (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
-          config_index, hasher, &fixed_dense_values,
+          (!example_names.empty() ? StringPiece(example_names[e])
+                                  : StringPiece("<unknown>")),
+          e, config, config_index, hasher, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch],
           &ragged_buffers[minibatch], stats);
       if (!status_of_minibatch[minibatch].ok()) break;
@@ -1445,6 +1447,24 @@ Status FastParseExample(const Config& config,
   return absl::OkStatus();
 }
 
+}  // namespace
+
+Status FastParseExample(const Config& config,
+                        absl::Span<const tstring> serialized,
+                        absl::Span<const tstring> example_names,
+                        thread::ThreadPool* thread_pool, Result* result) {
+  return FastParseExampleImpl(config, serialized, example_names, thread_pool,
+                              result);
+}
+
+Status FastParseExample(const Config& config,
+                        absl::Span<const StringPiece> serialized,
+                        absl::Span<const tstring> example_names,
+                        thread::ThreadPool* thread_pool, Result* result) {
+  return FastParseExampleImpl(config, serialized, example_names, thread_pool,
+                              result);
+}
+
 Status FastParseSingleExample(const Config& config, StringPiece serialized,
                               Result* result) {
   DCHECK(result != nullptr);
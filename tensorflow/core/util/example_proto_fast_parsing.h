@@ -139,6 +139,13 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         absl::Span<const tstring> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
+// Like above, but parses examples that are not stored in a string tensor, e.g.
+// records read straight into a caller-owned buffer.
+Status FastParseExample(const FastParseExampleConfig& config,
+                        absl::Span<const StringPiece> serialized,
+                        absl::Span<const tstring> example_names,
+                        thread::ThreadPool* thread_pool, Result* result);
+
 // TODO(mrry): Move the hash table construction into the config object.
 typedef FastParseExampleConfig FastParseSingleExampleConfig;
 
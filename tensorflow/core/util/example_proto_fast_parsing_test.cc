@@ -327,6 +327,46 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+TEST(FastParse, StringPieceInput) {
+  const size_t kNumExamples = 13;
+  std::vector<tstring> serialized(kNumExamples, ExampleWithSomeFeatures());
+  // Back the views with a single buffer, the way a record reader would.
+  string arena;
+  std::vector<size_t> offsets;
+  for (const tstring& example : serialized) {
+    offsets.push_back(arena.size());
+    arena.append(example.data(), example.size());
+  }
+  std::vector<StringPiece> views;
+  for (size_t i = 0; i < kNumExamples; ++i) {
+    views.emplace_back(arena.data() + offsets[i], serialized[i].size());
+  }
+
+  FastParseExampleConfig config;
+  AddDenseFeature("bytes_list", DT_STRING, {2}, false, 2, &config);
+  AddDenseFeature("float_list", DT_FLOAT, {-1}, true, 1, &config);
+  AddSparseFeature("int64_list", DT_INT64, &config);
+
+  Result expected;
+  TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &expected));
+  Result result;
+  TF_CHECK_OK(FastParseExample(config, absl::Span<const StringPiece>(views),
+                               {}, nullptr, &result));
+
+  ASSERT_EQ(expected.dense_values.size(), result.dense_values.size());
+  for (size_t i = 0; i < expected.dense_values.size(); ++i) {
+    EXPECT_EQ(expected.dense_values[i].DebugString(/*num_values=*/100),
+              result.dense_values[i].DebugString(/*num_values=*/100));
+  }
+  ASSERT_EQ(expected.sparse_values.size(), result.sparse_values.size());
+  for (size_t i = 0; i < expected.sparse_values.size(); ++i) {
+    EXPECT_EQ(expected.sparse_indices[i].DebugString(/*num_values=*/100),
+              result.sparse_indices[i].DebugString(/*num_values=*/100));
+    EXPECT_EQ(expected.sparse_values[i].DebugString(/*num_values=*/100),
+              result.sparse_values[i].DebugString(/*num_values=*/100));
+  }
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
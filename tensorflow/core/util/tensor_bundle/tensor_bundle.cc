@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
@@ -23,6 +25,7 @@ limitations under the License.
 #include "absl/base/call_once.h"
 #include "absl/synchronization/mutex.h"
 #include "xla/tsl/util/byte_swap_array.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -65,7 +68,11 @@ namespace tensorflow {
 // Versioning of the tensor bundle format.
 const int kTensorBundleMinProducer = 0;
 const int kTensorBundleMinConsumer = 0;
-const int kTensorBundleVersion = 1;
+const int kTensorBundleVersion = 2;
+
+// Delta bundles cannot be read correctly by consumers older than version 2,
+// which would not resolve their entries against the base bundle.
+static const int kTensorBundleDeltaMinConsumer = 2;
 
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
@@ -75,6 +82,10 @@ static const int kBufferSize = 1024 * 1024;
 // bundle.
 const char* const kHeaderEntryKey = "";
 
+const int kMappedDataAlignment = 64;
+static_assert(64 % EIGEN_MAX_ALIGN_BYTES == 0,
+              "kMappedDataAlignment must satisfy Eigen's alignment");
+
 // The size threshold for multi-threaded tensor loading.
 const int64_t kLargeTensorThreshold = static_cast<int64_t>(1) << 32;
 // Maximum number of threads to load the tensor from the file.
@@ -84,6 +95,34 @@ const int64_t kMinSectionSize = static_cast<int64_t>(1) << 31;
 
 namespace {
 
+// A TensorBuffer over a range of a memory-mapped data file. Holding a
+// reference to the mapping keeps it alive for as long as the buffer is.
+//
+// The mapping is read-only, so the buffer reports that it does not own its
+// memory: Tensor::RefCountIsOne() is then always false, which stops kernels
+// from forwarding it to an output or updating it in place.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     uint64 offset, size_t size)
+      : TensorBuffer(const_cast<char*>(
+                         static_cast<const char*>(region->data()) + offset)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 // Reads "num_elements" string elements from file[offset, offset+size) into the
 // length-N "destination".  Discards the original content of "destination".
 //
@@ -531,6 +570,94 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   return status_;
 }
 
+Status BundleWriter::AddRows(StringPiece key,
+                             const TensorShape& full_tensor_shape,
+                             const Tensor& row_indices, const Tensor& rows) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  if (options_.base_prefix.empty()) {
+    status_ = errors::FailedPrecondition(
+        "AddRows() requires a delta bundle; key: ", key);
+    return status_;
+  }
+  if (full_tensor_shape.dims() < 1 || row_indices.dtype() != DT_INT64 ||
+      row_indices.dims() != 1 || !DataTypeCanUseMemcpy(rows.dtype()) ||
+      rows.dims() != full_tensor_shape.dims() ||
+      rows.dim_size(0) != row_indices.NumElements()) {
+    status_ = errors::InvalidArgument(
+        "Invalid rows for key ", key, ": full shape ",
+        full_tensor_shape.DebugString(), ", row indices ",
+        row_indices.DebugString(), ", rows ", rows.DebugString());
+    return status_;
+  }
+  for (int d = 1; d < full_tensor_shape.dims(); ++d) {
+    if (rows.dim_size(d) != full_tensor_shape.dim_size(d)) {
+      status_ = errors::InvalidArgument(
+          "Rows for key ", key, " have shape ", rows.shape().DebugString(),
+          " but the full tensor has shape ", full_tensor_shape.DebugString());
+      return status_;
+    }
+  }
+  const auto indices = row_indices.flat<int64_t>();
+  for (int64_t i = 0; i < indices.size(); ++i) {
+    if (indices(i) < 0 || indices(i) >= full_tensor_shape.dim_size(0)) {
+      status_ = errors::InvalidArgument("Row index ", indices(i), " for key ",
+                                        key, " is out of range for shape ",
+                                        full_tensor_shape.DebugString());
+      return status_;
+    }
+  }
+  const string key_string(key);
+  if (entries_.find(key_string) != entries_.end()) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+    return status_;
+  }
+
+  BundleEntryProto* entry = &entries_[key_string];
+  entry->set_dtype(rows.dtype());
+  full_tensor_shape.AsProto(entry->mutable_shape());
+  entry->set_shard_id(0);
+  entry->set_offset(size_);
+  entry->set_delta_kind(BundleEntryProto::ROWS);
+  entry->set_num_delta_rows(indices.size());
+
+  // The row indices and the rows are checksummed together.
+  size_t indices_bytes = 0;
+  size_t rows_bytes = 0;
+  out_->reset_crc32();
+  status_ = WriteTensor(row_indices, out_.get(), &indices_bytes);
+  if (status_.ok()) {
+    status_ = WriteTensor(rows, out_.get(), &rows_bytes);
+  }
+  if (status_.ok()) {
+    entry->set_size(indices_bytes + rows_bytes);
+    entry->set_crc32c(crc32c::Mask(out_->crc32()));
+    size_ += indices_bytes + rows_bytes;
+    status_ = PadAlignment(out_.get(), options_.data_alignment, &size_);
+  }
+  return status_;
+}
+
+Status BundleWriter::AddBaseEntries() {
+  BundleReader base(env_, options_.base_prefix);
+  TF_RETURN_IF_ERROR(base.status());
+  base.Seek(kHeaderEntryKey);
+  for (base.Next(); base.Valid(); base.Next()) {
+    const string key(base.key());
+    if (entries_.find(key) != entries_.end()) continue;
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(ParseEntryProto(base.key(), base.value(), &entry));
+    entry.clear_shard_id();
+    entry.clear_offset();
+    entry.clear_size();
+    entry.clear_crc32c();
+    entry.set_delta_kind(BundleEntryProto::BASE);
+    entry.clear_num_delta_rows();
+    entries_[key] = std::move(entry);
+  }
+  return absl::OkStatus();
+}
+
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
@@ -547,6 +674,10 @@ Status BundleWriter::Finish() {
     }
   }
   if (!status_.ok()) return status_;
+  if (!options_.base_prefix.empty()) {
+    status_ = AddBaseEntries();
+    if (!status_.ok()) return status_;
+  }
   // Build key -> BundleEntryProto table.
   std::unique_ptr<WritableFile> file;
   status_ = env_->NewWritableFile(metadata_path_, &file);
@@ -565,6 +696,10 @@ Status BundleWriter::Finish() {
     VersionDef* version = header.mutable_version();
     version->set_producer(kTensorBundleVersion);
     version->set_min_consumer(kTensorBundleMinConsumer);
+    if (!options_.base_prefix.empty()) {
+      header.set_base_prefix(options_.base_prefix);
+      version->set_min_consumer(kTensorBundleDeltaMinConsumer);
+    }
 
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
 
@@ -599,6 +734,7 @@ struct MergeState {
   bool seen_first_bundle = false;
   BundleHeaderProto_Endianness endianness;
   VersionDef version;
+  std::string base_prefix;
 
   // Tensor key -> BundleEntryProto.
   std::map<string, BundleEntryProto> entries;
@@ -640,6 +776,7 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
       merge_state->seen_first_bundle = true;
       merge_state->endianness = header.endianness();
       merge_state->version = header.version();
+      merge_state->base_prefix = header.base_prefix();
     } else {
       // Validates "endianness".
       if (merge_state->endianness != header.endianness()) {
@@ -655,6 +792,12 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
             "Merging bundles with different format versions: merged ",
             merge_version, " vs. curr ", curr_version);
       }
+      // Validates "base_prefix".
+      if (merge_state->base_prefix != header.base_prefix()) {
+        return errors::InvalidArgument(
+            "Merging bundles with different base bundles: merged ",
+            merge_state->base_prefix, " vs. curr ", header.base_prefix());
+      }
     }
     num_shards = header.num_shards();
     iter->Next();
@@ -666,6 +809,26 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     const string key(iter->key());
     const auto entry_iter = merge_state->entries.find(key);
 
+    // Each of the delta bundles written for a sharded save points at the base
+    // for all the tensors it did not write itself. Any other entry for the
+    // same key takes precedence.
+    if (entry_iter != merge_state->entries.end() &&
+        !merge_state->base_prefix.empty()) {
+      TF_RETURN_IF_ERROR(
+          ParseEntryProto(iter->key(), iter->value(), &to_merge_entry));
+      if (to_merge_entry.delta_kind() == BundleEntryProto::BASE ||
+          entry_iter->second.delta_kind() == BundleEntryProto::BASE) {
+        auto result = merge_state->shard_ids.insert(
+            {DataFilename(prefix, to_merge_entry.shard_id(), num_shards),
+             merge_state->shard_ids.size()});
+        if (to_merge_entry.delta_kind() != BundleEntryProto::BASE) {
+          to_merge_entry.set_shard_id(result.first->second);
+          entry_iter->second = to_merge_entry;
+        }
+        continue;
+      }
+    }
+
     // Illegal: the duplicated entry is a non-slice tensor.
     if (entry_iter != merge_state->entries.end() &&
         entry_iter->second.slices().empty()) {
@@ -749,6 +912,7 @@ Status MergeBundles(Env* env, absl::Span<const tstring> prefixes,
     header.set_num_shards(merge.num_shards);
     header.set_endianness(merge.endianness);
     *header.mutable_version() = merge.version;
+    header.set_base_prefix(merge.base_prefix);
     builder.Add(kHeaderEntryKey, header.SerializeAsString());
     // All others.
     for (const auto& p : merge.entries) {
@@ -835,6 +999,7 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
        !port::kLittleEndian)) {
     need_to_swap_bytes_ = true;
   }
+  base_prefix_ = header.base_prefix();
   status_ = CheckVersions(header.version(), kTensorBundleVersion,
                           kTensorBundleMinProducer, "Checkpoint", "checkpoint");
 }
@@ -878,6 +1043,9 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
 }
 
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (entry.delta_kind() != BundleEntryProto::FULL) {
+    return GetDeltaValue(key(), entry, val);
+  }
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
@@ -1019,6 +1187,103 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return absl::OkStatus();
 }
 
+Status BundleReader::GetBaseReader(BundleReader** base) {
+  if (base_prefix_.empty() || base_prefix_ == prefix_) {
+    return errors::DataLoss("TensorBundle at ", prefix_,
+                            " has an invalid base bundle: '", base_prefix_,
+                            "'");
+  }
+  if (base_reader_ == nullptr) {
+    base_reader_ = std::make_unique<BundleReader>(
+        env_, base_prefix_,
+        Options{cache_, enable_multi_threading_for_testing_});
+  }
+  TF_RETURN_IF_ERROR(base_reader_->status());
+  *base = base_reader_.get();
+  return absl::OkStatus();
+}
+
+Status BundleReader::GetDeltaValue(StringPiece key,
+                                   const BundleEntryProto& entry,
+                                   Tensor* val) {
+  const string key_string(key);
+  BundleReader* base;
+  TF_RETURN_IF_ERROR(GetBaseReader(&base));
+  if (val->NumElements() == 0) {
+    *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+  }
+  // Resolves the rest of the chain first.
+  TF_RETURN_IF_ERROR(base->Lookup(key_string, val));
+  if (entry.delta_kind() == BundleEntryProto::BASE) {
+    return absl::OkStatus();
+  }
+  if (entry.delta_kind() != BundleEntryProto::ROWS) {
+    return errors::Unimplemented("Unknown delta kind ", entry.delta_kind(),
+                                 " for key ", key_string);
+  }
+
+  // Patches the rows stored in this bundle.
+  const TensorShape full_shape(entry.shape());
+  const int64_t num_rows = entry.num_delta_rows();
+  const int64_t row_bytes =
+      full_shape.dim_size(0) == 0
+          ? 0
+          : full_shape.num_elements() / full_shape.dim_size(0) *
+                DataTypeSize(entry.dtype());
+  if (!DataTypeCanUseMemcpy(entry.dtype()) ||
+      entry.size() != num_rows * (sizeof(int64_t) + row_bytes)) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key_string,
+                            "; stored size ", entry.size(), " for ", num_rows,
+                            " rows of ", full_shape.DebugString());
+  }
+  Tensor indices(DT_INT64, TensorShape({num_rows}));
+  TensorShape rows_shape = full_shape;
+  rows_shape.set_dim(0, num_rows);
+  Tensor rows(entry.dtype(), rows_shape);
+
+  RandomAccessFile* file = nullptr;
+  TF_RETURN_IF_ERROR(cache_->GetFile(
+      DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
+  char* indices_buffer = const_cast<char*>(indices.tensor_data().data());
+  char* rows_buffer = const_cast<char*>(rows.tensor_data().data());
+  StringPiece sp;
+  const size_t indices_bytes = num_rows * sizeof(int64_t);
+  TF_RETURN_IF_ERROR(
+      file->Read(entry.offset(), indices_bytes, &sp, indices_buffer));
+  if (sp.data() != indices_buffer) memmove(indices_buffer, sp.data(), sp.size());
+  uint32 actual_crc32c = crc32c::Value(indices_buffer, indices_bytes);
+  TF_RETURN_IF_ERROR(file->Read(entry.offset() + indices_bytes,
+                                entry.size() - indices_bytes, &sp,
+                                rows_buffer));
+  if (sp.data() != rows_buffer) memmove(rows_buffer, sp.data(), sp.size());
+  actual_crc32c = crc32c::Extend(actual_crc32c, rows_buffer,
+                                 entry.size() - indices_bytes);
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  if (need_to_swap_bytes_) {
+    TF_RETURN_IF_ERROR(ByteSwapTensor(&indices));
+    TF_RETURN_IF_ERROR(ByteSwapTensor(&rows));
+  }
+
+  char* dst = const_cast<char*>(val->tensor_data().data());
+  const auto row_ids = indices.flat<int64_t>();
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (row_ids(i) < 0 || row_ids(i) >= full_shape.dim_size(0)) {
+      return errors::DataLoss("Row index ", row_ids(i), " for key ",
+                              key_string, " is out of range for shape ",
+                              full_shape.DebugString());
+    }
+    memcpy(dst + row_ids(i) * row_bytes, rows_buffer + i * row_bytes,
+           row_bytes);
+  }
+  return absl::OkStatus();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1033,6 +1298,356 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                                    bool* mapped) {
+  *mapped = false;
+  if (entry.delta_kind() != BundleEntryProto::FULL ||
+      !DataTypeCanUseMemcpy(entry.dtype()) || need_to_swap_bytes_ ||
+      entry.offset() % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return absl::OkStatus();
+  }
+  const TensorShape stored_shape(entry.shape());
+  const size_t expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  const string fname = DataFilename(prefix_, entry.shard_id(), num_shards_);
+  if (Status s = cache_->GetMappedFile(fname, &region); !s.ok()) {
+    // Not every file system supports memory-mapped files.
+    VLOG(1) << "Not mapping " << fname << ": " << s;
+    return absl::OkStatus();
+  }
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("TensorBundle at ", prefix_, " shard ",
+                            entry.shard_id(), " is truncated: entry at offset ",
+                            entry.offset(), " of ", entry.size(),
+                            " bytes exceeds file size ", region->length());
+  }
+
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the mapped bytes ", actual_crc32c);
+  }
+
+  core::RefCountPtr<MappedTensorBuffer> buf(
+      new MappedTensorBuffer(std::move(region), entry.offset(), entry.size()));
+  *val = Tensor(entry.dtype(), stored_shape, buf.get());
+  *mapped = true;
+  return absl::OkStatus();
+}
+
+Status BundleReader::LookupZeroCopy(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+
+  if (entry.delta_kind() == BundleEntryProto::BASE) {
+    BundleReader* base;
+    TF_RETURN_IF_ERROR(GetBaseReader(&base));
+    return base->LookupZeroCopy(key, val);
+  }
+  if (entry.slices().empty()) {
+    bool mapped;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &mapped));
+    if (mapped) return absl::OkStatus();
+  }
+  *val = Tensor(entry.dtype(), TensorShape(entry.shape()));
+  return Lookup(key, val);
+}
+
+namespace {
+
+// A tensor read by BundleReader::LookupMany().
+struct ParallelReadTarget {
+  BundleEntryProto entry;
+  Tensor* val;
+  // For tensors read straight into "val" in several sections, the number of
+  // sections that have not completed yet.
+  std::atomic<int> sections_left{0};
+};
+
+// One read from a data file. A read either covers a section of a single
+// tensor, which is read straight into its buffer, or several neighboring
+// tensors, which are read into a staging buffer and then copied out.
+struct ParallelRead {
+  int32 shard_id;
+  int64_t offset;
+  int64_t size;
+  ParallelReadTarget* direct = nullptr;
+  std::vector<ParallelReadTarget*> staged;
+};
+
+// Bounds a resource held by in-flight reads: staging memory or the number of
+// reads.
+class InFlightBudget {
+ public:
+  explicit InFlightBudget(int64_t limit) : limit_(limit) {}
+
+  // Blocks until "amount" fits in the budget. A request larger than the whole
+  // budget proceeds once nothing else is in flight.
+  void Acquire(int64_t amount) {
+    absl::MutexLock l(&mu_);
+    while (in_use_ > 0 && in_use_ + amount > limit_) {
+      cv_.Wait(&mu_);
+    }
+    in_use_ += amount;
+  }
+
+  void Release(int64_t amount) {
+    absl::MutexLock l(&mu_);
+    in_use_ -= amount;
+    cv_.SignalAll();
+  }
+
+  // Blocks until everything acquired has been released.
+  void WaitUntilIdle() {
+    absl::MutexLock l(&mu_);
+    while (in_use_ > 0) {
+      cv_.Wait(&mu_);
+    }
+  }
+
+ private:
+  const int64_t limit_;
+  absl::Mutex mu_;
+  absl::CondVar cv_;
+  int64_t in_use_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+Status BundleReader::LookupMany(absl::Span<const std::string> keys,
+                                absl::Span<Tensor* const> vals,
+                                const ParallelReadOptions& options,
+                                ParallelReadStats* stats) {
+  if (keys.size() != vals.size()) {
+    return errors::InvalidArgument("Got ", keys.size(), " keys but ",
+                                   vals.size(), " tensors");
+  }
+  const uint64 start_us = env_->NowMicros();
+
+  // Parse all entries up front: the pool threads below never touch iter_.
+  std::vector<std::unique_ptr<ParallelReadTarget>> targets;
+  std::vector<size_t> serial;
+  absl::flat_hash_map<int32, std::vector<ParallelReadTarget*>> by_shard;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype()) ||
+        entry.delta_kind() != BundleEntryProto::FULL ||
+        vals[i]->NumElements() == 0) {
+      serial.push_back(i);
+      continue;
+    }
+    if (entry.size() != vals[i]->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", vals[i]->TotalBytes());
+    }
+    auto target = std::make_unique<ParallelReadTarget>();
+    target->entry.Swap(&entry);
+    target->val = vals[i];
+    by_shard[target->entry.shard_id()].push_back(target.get());
+    targets.push_back(std::move(target));
+  }
+
+  // Plan the reads of each shard in file order.
+  const int64_t max_read_bytes = std::max<int64_t>(options.max_read_bytes, 1);
+  std::vector<std::vector<ParallelRead>> shard_reads;
+  for (auto& [shard_id, shard_targets] : by_shard) {
+    absl::c_sort(shard_targets,
+                 [](const ParallelReadTarget* a, const ParallelReadTarget* b) {
+                   return a->entry.offset() < b->entry.offset();
+                 });
+    std::vector<ParallelRead>& reads = shard_reads.emplace_back();
+    ParallelRead* open = nullptr;  // Staged read that may still grow.
+    for (ParallelReadTarget* target : shard_targets) {
+      const int64_t offset = target->entry.offset();
+      const int64_t size = target->entry.size();
+      if (size >= max_read_bytes) {
+        const int num_sections = (size + max_read_bytes - 1) / max_read_bytes;
+        target->sections_left = num_sections;
+        for (int64_t start = 0; start < size; start += max_read_bytes) {
+          ParallelRead& read = reads.emplace_back();
+          read.shard_id = shard_id;
+          read.offset = offset + start;
+          read.size = std::min(max_read_bytes, size - start);
+          read.direct = target;
+        }
+        open = nullptr;
+        continue;
+      }
+      if (open != nullptr) {
+        const int64_t end = open->offset + open->size;
+        if (offset >= end && offset - end <= options.max_gap_bytes &&
+            offset + size - open->offset <= max_read_bytes) {
+          open->size = offset + size - open->offset;
+          open->staged.push_back(target);
+          continue;
+        }
+      }
+      open = &reads.emplace_back();
+      open->shard_id = shard_id;
+      open->offset = offset;
+      open->size = size;
+      open->staged.push_back(target);
+    }
+    // A staged read of a single tensor can go straight into its buffer.
+    for (ParallelRead& read : reads) {
+      if (read.staged.size() == 1) {
+        read.direct = read.staged.front();
+        read.direct->sections_left = 1;
+        read.staged.clear();
+      }
+    }
+  }
+
+  // Interleave the shards so that all of them are read concurrently.
+  std::vector<ParallelRead*> schedule;
+  for (size_t i = 0, added = 1; added > 0; ++i) {
+    added = 0;
+    for (std::vector<ParallelRead>& reads : shard_reads) {
+      if (i < reads.size()) {
+        schedule.push_back(&reads[i]);
+        ++added;
+      }
+    }
+  }
+
+  absl::Mutex mu;
+  Status status;
+  std::atomic<bool> failed{false};
+  auto update_status = [&](const Status& s) {
+    if (s.ok()) return;
+    absl::MutexLock l(&mu);
+    status.Update(s);
+    failed = true;
+  };
+
+  // Validates the checksum of a fully read tensor whose file bytes start at
+  // "data", copies them into the tensor unless they are already there, and
+  // fixes up the byte order.
+  auto finish_target = [this](ParallelReadTarget* target,
+                              const char* data) -> Status {
+    const BundleEntryProto& entry = target->entry;
+    char* backing_buffer =
+        const_cast<char*>(target->val->tensor_data().data());
+    if (data != backing_buffer) {
+      memcpy(backing_buffer, data, entry.size());
+    }
+    const uint32 actual_crc32c = crc32c::Value(backing_buffer, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+    if (need_to_swap_bytes_) {
+      TF_RETURN_IF_ERROR(ByteSwapTensor(target->val));
+    }
+    return absl::OkStatus();
+  };
+
+  // Moves the bytes of a completed read into place and finishes the tensors
+  // it completes. "dst" is the scratch buffer the read was issued with.
+  auto complete_read = [&](const ParallelRead& read, char* dst,
+                           StringPiece sp) -> Status {
+    if (sp.data() != dst) {
+      memmove(dst, sp.data(), read.size);
+    }
+    if (read.direct != nullptr) {
+      if (read.direct->sections_left.fetch_sub(1) == 1) {
+        return finish_target(read.direct,
+                             read.direct->val->tensor_data().data());
+      }
+      return absl::OkStatus();
+    }
+    for (ParallelReadTarget* target : read.staged) {
+      TF_RETURN_IF_ERROR(
+          finish_target(target, dst + (target->entry.offset() - read.offset)));
+    }
+    return absl::OkStatus();
+  };
+
+  int64_t bytes_read = 0;
+  {
+    // The budgets outlive the pool, whose closures release the staging
+    // budget.
+    InFlightBudget staging(options.max_staging_bytes);
+    InFlightBudget in_flight(std::max(options.max_reads_in_flight, 1));
+    thread::ThreadPool pool(env_, "restore_bundle",
+                            std::max(options.num_threads, 1));
+    for (ParallelRead* read : schedule) {
+      if (failed) break;
+      RandomAccessFile* file = nullptr;
+      Status s = cache_->GetFile(
+          DataFilename(prefix_, read->shard_id, num_shards_), &file);
+      if (!s.ok()) {
+        update_status(s);
+        break;
+      }
+      const int64_t staging_bytes = read->direct == nullptr ? read->size : 0;
+      staging.Acquire(staging_bytes);
+      in_flight.Acquire(1);
+      bytes_read += read->size;
+      std::shared_ptr<char[]> staging_buffer;
+      char* dst;
+      if (read->direct != nullptr) {
+        dst = const_cast<char*>(read->direct->val->tensor_data().data()) +
+              (read->offset - read->direct->entry.offset());
+      } else {
+        staging_buffer.reset(new char[read->size]);
+        dst = staging_buffer.get();
+      }
+      file->ReadAsync(
+          read->offset, read->size, dst,
+          [&, read, dst, staging_buffer, staging_bytes](
+              const Status& read_status, StringPiece sp) {
+            // Leave the file system's completion thread right away: the
+            // checksums are validated on the pool.
+            pool.Schedule([&, read, dst, staging_buffer, staging_bytes,
+                           read_status, sp]() {
+              if (!failed) {
+                update_status(read_status.ok() ? complete_read(*read, dst, sp)
+                                               : read_status);
+              }
+              staging.Release(staging_bytes);
+            });
+            // The read stays in flight until Schedule() has returned, so that
+            // the pool is not destroyed while this thread is still using it.
+            // The pool's destructor waits for the scheduled validation.
+            in_flight.Release(1);
+          });
+    }
+
+    // Read the remaining tensors on this thread while the reads are in flight.
+    for (size_t i : serial) {
+      if (failed) break;
+      update_status(Lookup(keys[i], vals[i]));
+    }
+    // Destroying the pool then waits for the validations still running.
+    in_flight.WaitUntilIdle();
+  }
+
+  if (stats != nullptr) {
+    stats->bytes_read = bytes_read;
+    stats->num_reads = schedule.size();
+    stats->duration_us = env_->NowMicros() - start_us;
+  }
+  return status;
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1225,17 +1840,18 @@ string BundleReader::DebugString() {
 
 BundleCache::BundleCache(Env* env) : env_(env) {}
 
+BundleCache::FileState* BundleCache::GetFileState(const std::string& name) {
+  absl::MutexLock l(&mu_);
+  auto& slot = opened_files_[name];
+  if (slot == nullptr) {
+    slot = std::make_unique<FileState>();
+  }
+  return slot.get();
+}
+
 BundleCache::FileState* BundleCache::EnsureOpened(std::string name) {
   // Get the file, opening it if necessary.
-  FileState* f;
-  {
-    absl::MutexLock l(&mu_);
-    auto& slot = opened_files_[name];
-    if (slot == nullptr) {
-      slot = std::make_unique<FileState>();
-    }
-    f = slot.get();
-  }
+  FileState* f = GetFileState(name);
 
   // Open the file or wait for a concurrent open to complete. We do not hold
   // mu_ here to avoid blocking threads reading from other files.
@@ -1252,6 +1868,18 @@ Status BundleCache::GetFile(const std::string& fname, RandomAccessFile** file) {
   return f->open_status;
 }
 
+Status BundleCache::GetMappedFile(
+    const std::string& fname, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  FileState* f = GetFileState(fname);
+  absl::call_once(f->map_once, [this, &fname, f] {
+    std::unique_ptr<ReadOnlyMemoryRegion> mapped;
+    f->map_status = env_->NewReadOnlyMemoryRegionFromFile(fname, &mapped);
+    f->region = std::move(mapped);
+  });
+  *region = f->region;
+  return f->map_status;
+}
+
 namespace {
 inline char* AlignedMalloc(size_t size) {
   char* buffer = static_cast<char*>(port::AlignedMalloc(size, 64));
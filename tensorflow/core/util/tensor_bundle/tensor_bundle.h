@@ -72,6 +72,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
@@ -98,6 +99,7 @@ namespace tensorflow {
 // History:
 // 0. Any tensor bundles produced before this field was added.
 // 1. Added this field (2016-09-14).
+// 2. Added delta bundles. Only delta bundles require this version.
 extern const int kTensorBundleMinProducer;
 extern const int kTensorBundleMinConsumer;
 extern const int kTensorBundleVersion;
@@ -106,6 +108,11 @@ extern const int kTensorBundleVersion;
 // corresponding value is a BundleHeaderProto.
 extern const char* const kHeaderEntryKey;
 
+// Data alignment, in bytes, that makes every fixed-size tensor in a bundle
+// eligible for BundleReader::LookupZeroCopy(). It is a multiple of the largest
+// alignment Eigen may require of a Tensor's buffer.
+extern const int kMappedDataAlignment;
+
 // Builds a string-string table of tensor names to BundleEntryProto (metadata).
 //
 // On construction, attempts to create a directory given by the dirname of
@@ -117,8 +124,16 @@ class BundleWriter {
   struct Options {
     Options() {}
     // Alignment, in bytes, for tensor data.
-    // Must be >= 1. The default size of 1 densely packs tensors.
+    // Must be >= 1. The default size of 1 densely packs tensors. Set it to
+    // kMappedDataAlignment to allow readers to map tensors without copying.
     int data_alignment{1};
+
+    // If non-empty, writes a delta bundle over the bundle at this prefix.
+    // Tensors added with Add() or AddSlice() replace the base's value, rows
+    // added with AddRows() patch it, and any tensor of the base that is not
+    // added is inherited unchanged. A partitioned tensor must either be added
+    // with all of its slices or not at all.
+    std::string base_prefix;
   };
   BundleWriter(Env* env, absl::string_view prefix,
                const Options& options = Options());
@@ -147,12 +162,26 @@ class BundleWriter {
                   const TensorShape& full_tensor_shape,
                   const TensorSlice& slice_spec, const Tensor& slice_tensor);
 
+  // Delta bundles support. Records that only the rows "row_indices" (a 1-D
+  // int64 tensor of indices along dimension 0) of the tensor "key", of shape
+  // "full_tensor_shape", changed since the base bundle, and that their new
+  // values are "rows". The base bundle must contain "key" as an unpartitioned
+  // tensor of the same dtype and shape.
+  //
+  // REQUIRES: !Options::base_prefix.empty()
+  Status AddRows(absl::string_view key, const TensorShape& full_tensor_shape,
+                 const Tensor& row_indices, const Tensor& rows);
+
   // Finishes the writer and flushes.
   Status Finish() TF_MUST_USE_RESULT;
 
   Status status() const { return status_; }
 
  private:
+  // For delta bundles, adds an entry referring to the base bundle for every
+  // tensor of the base that was not added.
+  Status AddBaseEntries();
+
   Env* const env_;  // Not owned.
   const Options options_;
   const std::string prefix_;
@@ -260,12 +289,82 @@ class BundleReader {
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
+  // If this is a delta bundle, tensors that are unchanged or only partially
+  // stored are resolved against the chain of base bundles.
+  //
   // Validates the stored crc32c checksum against the restored bytes.
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like Lookup(), but where possible "*val" is replaced by a read-only tensor
+  // that aliases the memory-mapped data file instead of a copy of its bytes.
+  // The mapping stays alive for as long as any such tensor does, even after
+  // this reader is destroyed.
+  //
+  // A tensor is mapped if its dtype can be memcpy-ed, it is not partitioned,
+  // the bundle has the same endianness as this machine, its offset in the data
+  // file is suitably aligned (see kMappedDataAlignment) and the file system
+  // supports memory-mapped files. Otherwise "*val" is allocated and filled as
+  // by Lookup().
+  //
+  // Mapped tensors do not own their memory, so ops that would write into them
+  // in place (including resource variable updates) copy them first. This makes
+  // the mode a good fit for constants and read-mostly variables.
+  //
+  // Validates the stored crc32c checksum against the mapped bytes.
+  // REQUIRES: status().ok()
+  Status LookupZeroCopy(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
+
+  // Options for LookupMany().
+  struct ParallelReadOptions {
+    // Number of threads that validate checksums and copy tensors out of
+    // staging buffers.
+    int num_threads = 8;
+
+    // Number of reads kept in flight with RandomAccessFile::ReadAsync().
+    // These do not occupy threads on file systems with asynchronous I/O.
+    int max_reads_in_flight = 64;
+
+    // Neighboring tensors in a data file are coalesced into reads of up to
+    // "max_read_bytes", as long as they are at most "max_gap_bytes" apart.
+    // Larger tensors are split into reads of this size.
+    int64_t max_read_bytes = 16 << 20;
+    int64_t max_gap_bytes = 64 << 10;
+
+    // Upper bound on the staging memory held by coalesced reads. Reads of a
+    // single tensor go straight into its buffer and do not count towards it.
+    int64_t max_staging_bytes = 256 << 20;
+  };
+
+  // Statistics reported by LookupMany().
+  struct ParallelReadStats {
+    int64_t bytes_read = 0;  // Including gaps between coalesced tensors.
+    int64_t num_reads = 0;
+    int64_t duration_us = 0;
+  };
+
+  // Looks up the tensors keyed by "keys[i]" into "vals[i]", as if by calling
+  // Lookup() on each of them, but with all reads from data files issued up
+  // front. Tensors are grouped by shard and sorted by offset, neighbors are
+  // coalesced into large reads, and the reads are issued asynchronously across
+  // all shards. Checksums are validated on pool threads as soon as each read
+  // completes, overlapping with the remaining I/O.
+  //
+  // Tensors that cannot be read this way (strings, variants and partitioned
+  // tensors) are read with Lookup() on the calling thread while the parallel
+  // reads are in flight.
+  //
+  // On error, "vals" may contain nonsense data. "stats" may be null.
+  // REQUIRES: status().ok()
+  Status LookupMany(absl::Span<const std::string> keys,
+                    absl::Span<Tensor* const> vals,
+                    const ParallelReadOptions& options,
+                    ParallelReadStats* stats) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
+  // Like Lookup(), resolves entries of delta bundles against their bases.
+  //
   // On error, "val" may contain nonsense data.
   //
   // Validates the stored crc32c checksum against the restored bytes.
@@ -322,6 +421,22 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Points "*val" at the bytes described by "entry" in the memory-mapped data
+  // file. Sets "*mapped" to false, without touching "*val", if "entry" cannot
+  // be mapped.
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* mapped) TF_MUST_USE_RESULT;
+
+  // Reads the value of the delta bundle entry "entry" for "key", resolving
+  // it against the base bundle.
+  // REQUIRES: entry.delta_kind() != BundleEntryProto::FULL
+  Status GetDeltaValue(absl::string_view key, const BundleEntryProto& entry,
+                       Tensor* val) TF_MUST_USE_RESULT;
+
+  // Returns the reader of the base bundle of a delta bundle, opening it on
+  // first use.
+  Status GetBaseReader(BundleReader** base) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -356,6 +471,10 @@ class BundleReader {
   // differs from that of the current system's processor architecture.
   bool need_to_swap_bytes_;
 
+  // For delta bundles, the prefix and (lazily opened) reader of the base.
+  std::string base_prefix_;
+  std::unique_ptr<BundleReader> base_reader_;
+
   friend class TensorBundleAlignmentTest;  // For testing data alignment.
 
   bool enable_multi_threading_for_testing_ = false;
@@ -401,6 +520,11 @@ class BundleCache {
   // while the BundleCache lives.
   Status GetFile(const std::string& fname, RandomAccessFile** file);
 
+  // Get a read-only memory mapping of fname. The mapping is shared by all
+  // callers and stays valid while any of them holds on to it.
+  Status GetMappedFile(const std::string& fname,
+                       std::shared_ptr<ReadOnlyMemoryRegion>* region);
+
  private:
   // State for each opened file (opened on first read).
   struct FileState {
@@ -408,8 +532,14 @@ class BundleCache {
 
     std::unique_ptr<RandomAccessFile> file;
     Status open_status;  // Records any error encountered on open
+
+    absl::once_flag map_once;  // Ensures file is mapped at most once.
+
+    std::shared_ptr<ReadOnlyMemoryRegion> region;
+    Status map_status;  // Records any error encountered on mapping
   };
 
+  FileState* GetFileState(const std::string& name);
   FileState* EnsureOpened(std::string name);
 
   Env* const env_;
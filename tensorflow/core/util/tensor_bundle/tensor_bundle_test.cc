@@ -1270,6 +1270,212 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, LookupZeroCopy) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = kMappedDataAlignment;
+    BundleWriter writer(Env::Default(), Prefix("mapped"), opts);
+    TF_EXPECT_OK(writer.Add("flag", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("ints", Constant_100x100<int32>(7)));
+    TF_EXPECT_OK(writer.Add("strings", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor floats, ints, strings;
+  {
+    BundleReader reader(Env::Default(), Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.LookupZeroCopy("floats", &floats));
+    TF_ASSERT_OK(reader.LookupZeroCopy("ints", &ints));
+    TF_ASSERT_OK(reader.LookupZeroCopy("strings", &strings));
+
+    // Looking a mapped tensor up again aliases the same bytes.
+    Tensor again;
+    TF_ASSERT_OK(reader.LookupZeroCopy("ints", &again));
+    EXPECT_EQ(again.tensor_data().data(), ints.tensor_data().data());
+    EXPECT_FALSE(ints.RefCountIsOne());
+    EXPECT_TRUE(ints.IsAligned());
+
+    // Strings cannot be mapped and are copied out of the file.
+    EXPECT_TRUE(strings.RefCountIsOne());
+  }
+  // The mapping outlives the reader.
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(1.5));
+  test::ExpectTensorEqual<int32>(ints, Constant_100x100<int32>(7));
+  test::ExpectTensorEqual<tstring>(strings, Constant_2x3<tstring>("foo"));
+}
+
+TEST(TensorBundleTest, LookupZeroCopyFallsBackForUnalignedData) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("flag", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(2.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("unaligned"));
+  TF_ASSERT_OK(reader.status());
+  Tensor floats;
+  TF_ASSERT_OK(reader.LookupZeroCopy("floats", &floats));
+  EXPECT_TRUE(floats.RefCountIsOne());
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(2.5));
+}
+
+TEST(TensorBundleTest, LookupMany) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("many_foo"));
+    TF_EXPECT_OK(writer.Add("foo_small_0", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("foo_small_1", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("foo_large", Constant_100x100<float>(2)));
+    TF_EXPECT_OK(writer.Add("foo_strings", Constant_2x3<tstring>("foo")));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("many_bar"));
+    TF_EXPECT_OK(writer.Add("bar_small", Constant_2x3<int32>(3)));
+    TF_EXPECT_OK(writer.Add("bar_large", Constant_100x100<int32>(4)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(Env::Default(),
+                            {Prefix("many_foo"), Prefix("many_bar")},
+                            Prefix("many_merged")));
+
+  BundleReader reader(Env::Default(), Prefix("many_merged"));
+  TF_ASSERT_OK(reader.status());
+  const std::vector<string> keys = {"bar_large",   "bar_small",  "foo_large",
+                                    "foo_small_0", "foo_small_1", "foo_strings"};
+  std::vector<Tensor> tensors;
+  for (const string& key : keys) {
+    DataType dtype;
+    TensorShape shape;
+    TF_ASSERT_OK(reader.LookupDtypeAndShape(key, &dtype, &shape));
+    tensors.emplace_back(dtype, shape);
+  }
+  std::vector<Tensor*> vals;
+  for (Tensor& t : tensors) vals.push_back(&t);
+
+  BundleReader::ParallelReadOptions options;
+  options.num_threads = 4;
+  options.max_read_bytes = 4096;
+  options.max_gap_bytes = 64;
+  options.max_staging_bytes = 64;
+  BundleReader::ParallelReadStats stats;
+  TF_ASSERT_OK(reader.LookupMany(keys, vals, options, &stats));
+
+  test::ExpectTensorEqual<int32>(tensors[0], Constant_100x100<int32>(4));
+  test::ExpectTensorEqual<int32>(tensors[1], Constant_2x3<int32>(3));
+  test::ExpectTensorEqual<float>(tensors[2], Constant_100x100<float>(2));
+  test::ExpectTensorEqual<float>(tensors[3], Constant_2x3<float>(0));
+  test::ExpectTensorEqual<float>(tensors[4], Constant_2x3<float>(1));
+  test::ExpectTensorEqual<tstring>(tensors[5], Constant_2x3<tstring>("foo"));
+
+  // The two small floats share one read and each large tensor is split into
+  // ten; the strings are read separately.
+  EXPECT_EQ(stats.num_reads, 22);
+  EXPECT_EQ(stats.bytes_read, 2 * 24 + 24 + 2 * 40000);
+}
+
+TEST(TensorBundleTest, DeltaBundles) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_base"));
+    TF_EXPECT_OK(writer.Add(
+        "a", test::AsTensor<float>({0, 1, 2, 3, 4, 5}, TensorShape({3, 2}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<int32>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options opts;
+    opts.base_prefix = Prefix("delta_base");
+    BundleWriter writer(Env::Default(), Prefix("delta_1"), opts);
+    TF_EXPECT_OK(writer.AddRows("a", TensorShape({3, 2}),
+                                test::AsTensor<int64_t>({0, 2}),
+                                test::AsTensor<float>({10, 11, 14, 15},
+                                                      TensorShape({2, 2}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(3)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter::Options opts;
+    opts.base_prefix = Prefix("delta_1");
+    BundleWriter writer(Env::Default(), Prefix("delta_2"), opts);
+    TF_EXPECT_OK(writer.AddRows(
+        "a", TensorShape({3, 2}), test::AsTensor<int64_t>({1}),
+        test::AsTensor<float>({22, 23}, TensorShape({1, 2}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader reader(Env::Default(), Prefix("delta_2"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(AllTensorKeys(&reader), std::vector<string>({"a", "b", "c"}));
+  Expect<float>(&reader, "a",
+                test::AsTensor<float>({10, 11, 22, 23, 14, 15},
+                                      TensorShape({3, 2})));
+  Expect<float>(&reader, "b", Constant_2x3<float>(3));
+  Expect<int32>(&reader, "c", Constant_2x3<int32>(2));
+
+  // Row indices must be within the full tensor.
+  {
+    BundleWriter::Options opts;
+    opts.base_prefix = Prefix("delta_base");
+    BundleWriter writer(Env::Default(), Prefix("delta_bad"), opts);
+    EXPECT_TRUE(errors::IsInvalidArgument(writer.AddRows(
+        "a", TensorShape({3, 2}), test::AsTensor<int64_t>({3}),
+        test::AsTensor<float>({0, 0}, TensorShape({1, 2})))));
+  }
+}
+
+TEST(TensorBundleTest, MergeDeltaBundles) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_base"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<float>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Each shard of a sharded save writes the tensors it owns; the others are
+  // inherited from the base until the shards are merged.
+  BundleWriter::Options opts;
+  opts.base_prefix = Prefix("merge_delta_base");
+  {
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_0"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(10)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_1"), opts);
+    TF_EXPECT_OK(writer.AddRows("b", TensorShape({2, 3}),
+                                test::AsTensor<int64_t>({1}),
+                                Constant(11.0f, TensorShape({1, 3}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(MergeBundles(Env::Default(),
+                            {Prefix("merge_delta_0"), Prefix("merge_delta_1")},
+                            Prefix("merge_delta")));
+
+  BundleReader reader(Env::Default(), Prefix("merge_delta"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(AllTensorKeys(&reader), std::vector<string>({"a", "b", "c"}));
+  Expect<float>(&reader, "a", Constant_2x3<float>(10));
+  Expect<float>(&reader, "b",
+                test::AsTensor<float>({1, 1, 1, 11, 11, 11},
+                                      TensorShape({2, 3})));
+  Expect<float>(&reader, "c", Constant_2x3<float>(2));
+
+  // Delta bundles of different bases cannot be merged.
+  {
+    BundleWriter::Options other_opts;
+    other_opts.base_prefix = Prefix("merge_delta_0");
+    BundleWriter writer(Env::Default(), Prefix("merge_delta_other"),
+                        other_opts);
+    TF_ASSERT_OK(writer.Finish());
+  }
+  EXPECT_FALSE(MergeBundles(Env::Default(),
+                            {Prefix("merge_delta_0"),
+                             Prefix("merge_delta_other")},
+                            Prefix("merge_delta_bad"))
+                   .ok());
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
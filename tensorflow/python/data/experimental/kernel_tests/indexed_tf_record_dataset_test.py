@@ -0,0 +1,119 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the indexed TFRecord dataset."""
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import global_shuffle_op
+from tensorflow.python.data.experimental.ops import random_access
+from tensorflow.python.data.experimental.ops import readers
+from tensorflow.python.data.kernel_tests import checkpoint_test_base
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.kernel_tests import tf_record_test_base
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+
+
+class IndexedTFRecordDatasetTest(tf_record_test_base.TFRecordTestBase,
+                                 parameterized.TestCase):
+
+  def _build_index(self):
+    # pylint: disable=protected-access
+    return self.evaluate(readers._build_tf_record_index(self._filenames))
+
+  def _expected(self):
+    return [
+        self._record(f, r)
+        for f in range(self._num_files)
+        for r in range(self._num_records)
+    ]
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testBuildIndex(self):
+    self.assertAllEqual([self._num_records] * self._num_files,
+                        self._build_index())
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(buffer_size=[None, 0, 10])))
+  def testRead(self, buffer_size):
+    self._build_index()
+    # pylint: disable=protected-access
+    dataset = readers._IndexedTFRecordDataset(
+        self._filenames, buffer_size=buffer_size)
+    self.assertDatasetProduces(dataset, self._expected())
+    self.assertEqual(self._num_records * self._num_files,
+                     self.evaluate(dataset.cardinality()))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testSkip(self):
+    self._build_index()
+    # pylint: disable=protected-access
+    dataset = readers._IndexedTFRecordDataset(self._filenames)
+    num_to_skip = self._num_records + 2
+    self.assertDatasetProduces(
+        dataset.skip(num_to_skip), self._expected()[num_to_skip:])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testRandomAccess(self):
+    self._build_index()
+    # pylint: disable=protected-access
+    dataset = readers._IndexedTFRecordDataset(self._filenames)
+    expected = self._expected()
+    for i in reversed(range(len(expected))):
+      self.assertEqual(expected[i],
+                       self.evaluate(random_access.at(dataset, i)))
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(random_access.at(dataset, len(expected)))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testGlobalShuffle(self):
+    self._build_index()
+    # pylint: disable=protected-access
+    dataset = global_shuffle_op._global_shuffle(
+        readers._IndexedTFRecordDataset(self._filenames), seed=42)
+    output = self.getDatasetOutput(dataset, requires_initialization=True)
+    self.assertCountEqual(self._expected(), output)
+    self.assertNotEqual(self._expected(), output)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testMissingIndex(self):
+    filename = self._writeFile("not_indexed", [1, 2, 3])
+    with self.assertRaises(errors.NotFoundError):
+      # pylint: disable=protected-access
+      dataset = readers._IndexedTFRecordDataset([filename])
+      self.evaluate(self.getNext(dataset)())
+
+
+class IndexedTFRecordDatasetCheckpointTest(
+    tf_record_test_base.TFRecordTestBase,
+    checkpoint_test_base.CheckpointTestBase, parameterized.TestCase):
+
+  def _build_dataset(self):
+    # pylint: disable=protected-access
+    return readers._IndexedTFRecordDataset(self._filenames)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         checkpoint_test_base.default_test_combinations()))
+  def test(self, verify_fn):
+    # pylint: disable=protected-access
+    self.evaluate(readers._build_tf_record_index(self._filenames))
+    verify_fn(self, self._build_dataset,
+              self._num_records * self._num_files)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,107 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the `MapVectorization` optimization."""
+import functools
+
+from absl.testing import parameterized
+import numpy as np
+
+from tensorflow.python.data.experimental.ops import testing
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import options as options_lib
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import random_ops
+from tensorflow.python.platform import test
+
+
+def _test_combinations():
+  cases = [
+      ("Increment", lambda x: x + 1, True),
+      ("Polynomial", lambda x: 3 * x * x - 2 * x + 1, True),
+      ("Clip", lambda x: math_ops.minimum(math_ops.maximum(x, 2), 7), True),
+      ("Cast", lambda x: math_ops.cast(x, dtypes.float32) * 0.5, True),
+      # Reductions and shape-changing ops do not run per element on batches.
+      ("ReduceSum", math_ops.reduce_sum, False),
+      ("Fill", lambda x: array_ops.fill([3], x), False),
+  ]
+
+  def reduce_fn(x, y):
+    name, function, should_optimize = y
+    return x + combinations.combine(
+        function=combinations.NamedObject(name, function),
+        should_optimize=should_optimize)
+
+  return functools.reduce(reduce_fn, cases, [])
+
+
+class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def _with_map_vectorization(self, dataset):
+    options = options_lib.Options()
+    options.experimental_optimization.apply_default_optimizations = False
+    options.experimental_optimization.map_vectorization = True
+    return dataset.with_options(options)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         _test_combinations()))
+  def testMapVectorization(self, function, should_optimize):
+    next_nodes = ["Batch", "Map"] if should_optimize else ["Map", "Batch"]
+    dataset = dataset_ops.Dataset.range(10).apply(
+        testing.assert_next(next_nodes)).map(function).batch(4)
+    dataset = self._with_map_vectorization(dataset)
+    expected_output = [
+        np.stack([self.evaluate(function(x)) for x in range(i, min(i + 4, 10))])
+        for i in range(0, 10, 4)
+    ]
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testMultipleComponents(self):
+    dataset = dataset_ops.Dataset.range(10).map(lambda x: (x, 2 * x))
+    dataset = dataset.apply(testing.assert_next(["Batch", "Map"])).map(
+        lambda x, y: (x + y, x * y)).batch(3, drop_remainder=True)
+    dataset = self._with_map_vectorization(dataset)
+    expected_output = [([3 * x for x in range(i, i + 3)],
+                        [2 * x * x for x in range(i, i + 3)])
+                       for i in range(0, 9, 3)]
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testStatefulFunctionRunsPerElement(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        testing.assert_next(["Map", "Batch"])).map(
+            lambda x: x + random_ops.random_uniform([], 0, 1, "int64")).batch(4)
+    dataset = self._with_map_vectorization(dataset)
+    self.assertDatasetProduces(
+        dataset, expected_output=[[0, 1, 2, 3], [4, 5, 6, 7], [8, 9]])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testVaryingElementShapes(self):
+    dataset = dataset_ops.Dataset.range(1, 4).map(
+        lambda x: array_ops.fill([x], x))
+    dataset = dataset.apply(testing.assert_next(["Map", "PaddedBatch"])).map(
+        lambda x: x + 1).padded_batch(3)
+    dataset = self._with_map_vectorization(dataset)
+    self.assertDatasetProduces(
+        dataset, expected_output=[[[2, 0, 0], [3, 3, 0], [4, 4, 4]]])
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,133 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the fused TFRecord reading and `Example` parsing dataset."""
+import os
+
+from absl.testing import parameterized
+
+from tensorflow.python.data.experimental.ops import parsing_ops as contrib_parsing_ops
+from tensorflow.python.data.kernel_tests import checkpoint_test_base
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.kernel_tests import tf_record_test_base
+from tensorflow.python.data.ops import readers
+from tensorflow.python.framework import combinations
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.lib.io import python_io
+from tensorflow.python.ops import parsing_ops
+from tensorflow.python.platform import test
+
+
+class ParseTFRecordExampleDatasetTest(tf_record_test_base.FeaturesTestBase,
+                                      parameterized.TestCase):
+
+  def _features(self):
+    return {
+        "file": parsing_ops.FixedLenFeature([], dtypes.int64),
+        "record": parsing_ops.FixedLenFeature([], dtypes.int64),
+        "keywords": parsing_ops.VarLenFeature(dtypes.string),
+        "label": parsing_ops.FixedLenFeature([], dtypes.string),
+    }
+
+  def _fused_dataset(self, filenames, batch_size, drop_remainder):
+    # pylint: disable=protected-access
+    return contrib_parsing_ops._ParseTFRecordExampleDataset(
+        filenames,
+        self._features(),
+        batch_size=batch_size,
+        drop_remainder=drop_remainder)
+
+  def _unfused_dataset(self, filenames, batch_size, drop_remainder):
+    return readers.TFRecordDataset(filenames).batch(
+        batch_size, drop_remainder=drop_remainder).apply(
+            contrib_parsing_ops.parse_example_dataset(self._features()))
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(
+              batch_size=[1, 3, 7, 20], drop_remainder=[False, True])))
+  def testMatchesBatchAndParse(self, batch_size, drop_remainder):
+    self.assertDatasetsEqual(
+        self._fused_dataset(self._filenames, batch_size, drop_remainder),
+        self._unfused_dataset(self._filenames, batch_size, drop_remainder))
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testPartialBatchIsKeptOnReadError(self):
+    corrupted = os.path.join(self.get_temp_dir(), "corrupted.txt")
+    with open(corrupted, "wb") as f:
+      f.write(b"not a TFRecord file, long enough")
+    dataset = self._fused_dataset(
+        [self._filenames[0], corrupted, self._filenames[1]],
+        batch_size=self._num_records - 1,
+        drop_remainder=False)
+    get_next = self.getNext(dataset)
+
+    self.assertAllEqual(
+        list(range(self._num_records - 1)),
+        self.evaluate(get_next())["record"])
+    with self.assertRaises(errors.DataLossError):
+      self.evaluate(get_next())
+    # The last record of the first file was read before the error.
+    element = self.evaluate(get_next())
+    self.assertAllEqual([0, 1, 1, 1, 1, 1], element["file"])
+    self.assertAllEqual([self._num_records - 1, 0, 1, 2, 3, 4],
+                        element["record"])
+    self.assertAllEqual([5, 6], self.evaluate(get_next())["record"])
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(get_next())
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testCompressed(self):
+    filenames = []
+    for i in range(self._num_files):
+      fn = os.path.join(self.get_temp_dir(), "tf_record.%d.gz" % i)
+      filenames.append(fn)
+      options = python_io.TFRecordOptions(
+          python_io.TFRecordCompressionType.GZIP)
+      with python_io.TFRecordWriter(fn, options=options) as writer:
+        for j in range(self._num_records):
+          writer.write(self._record(i, j, "fake-label"))
+    # pylint: disable=protected-access
+    dataset = contrib_parsing_ops._ParseTFRecordExampleDataset(
+        filenames, self._features(), batch_size=4, compression_type="GZIP")
+    self.assertDatasetsEqual(
+        dataset, self._unfused_dataset(self._filenames, 4, False))
+
+
+class ParseTFRecordExampleDatasetCheckpointTest(
+    tf_record_test_base.FeaturesTestBase,
+    checkpoint_test_base.CheckpointTestBase, parameterized.TestCase):
+
+  def _build_dataset(self, batch_size):
+    # pylint: disable=protected-access
+    return contrib_parsing_ops._ParseTFRecordExampleDataset(
+        self._filenames, {
+            "file": parsing_ops.FixedLenFeature([], dtypes.int64),
+            "record": parsing_ops.FixedLenFeature([], dtypes.int64),
+        },
+        batch_size=batch_size)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         checkpoint_test_base.default_test_combinations()))
+  def test(self, verify_fn):
+    batch_size = 2
+    num_outputs = -(-self._num_records * self._num_files // batch_size)
+    verify_fn(self, lambda: self._build_dataset(batch_size), num_outputs)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -14,9 +14,12 @@
 # ==============================================================================
 """Experimental `dataset` API for parsing example."""
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import convert
 from tensorflow.python.data.util import structure
 from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
 from tensorflow.python.framework import sparse_tensor
+from tensorflow.python.framework import tensor_shape
 from tensorflow.python.framework import tensor_spec
 from tensorflow.python.ops import gen_experimental_dataset_ops
 from tensorflow.python.ops import parsing_ops
@@ -102,6 +105,85 @@ class _ParseExampleDataset(dataset_ops.UnaryDataset):
     return self._element_spec
 
 
+class _ParseTFRecordExampleDataset(dataset_ops.DatasetSource):
+  """A `Dataset` that reads and parses batches of `Example` records.
+
+  Equivalent to `TFRecordDataset(filenames).batch(batch_size)` followed by
+  `parse_example_dataset(features)`, but parses each batch directly from the
+  read buffers, without materializing it as a string tensor.
+  """
+
+  def __init__(self,
+               filenames,
+               features,
+               batch_size,
+               drop_remainder=False,
+               compression_type=None,
+               buffer_size=None):
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._compression_type = convert.optional_param_to_tensor(
+        "compression_type",
+        compression_type,
+        argument_default="",
+        argument_dtype=dtypes.string)
+    self._buffer_size = convert.optional_param_to_tensor(
+        "buffer_size", buffer_size, argument_default=0)
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+    # pylint: disable=protected-access
+    self._features = parsing_ops._prepend_none_dimension(features)
+    params = parsing_ops._ParseOpParams.from_features(self._features, [
+        parsing_ops.VarLenFeature, parsing_ops.SparseFeature,
+        parsing_ops.FixedLenFeature, parsing_ops.FixedLenSequenceFeature,
+        parsing_ops.RaggedFeature
+    ])
+    # pylint: enable=protected-access
+    batch_shape = tensor_shape.TensorShape([None])
+
+    self._element_spec = {}
+
+    for (key, value_type) in zip(params.sparse_keys, params.sparse_types):
+      self._element_spec[key] = sparse_tensor.SparseTensorSpec(
+          batch_shape.concatenate([None]), value_type)
+
+    for (key, value_type, dense_shape) in zip(params.dense_keys,
+                                              params.dense_types,
+                                              params.dense_shapes):
+      self._element_spec[key] = tensor_spec.TensorSpec(
+          batch_shape.concatenate(dense_shape), value_type)
+
+    for (key, value_type, splits_type) in zip(params.ragged_keys,
+                                              params.ragged_value_types,
+                                              params.ragged_split_types):
+      self._element_spec[key] = ragged_tensor.RaggedTensorSpec(
+          batch_shape.concatenate([None]), value_type, 1, splits_type)
+
+    variant_tensor = (
+        gen_experimental_dataset_ops.parse_tf_record_example_dataset(
+            self._filenames,
+            self._compression_type,
+            self._buffer_size,
+            self._batch_size,
+            self._drop_remainder,
+            params.dense_defaults_vec,
+            params.sparse_keys,
+            params.dense_keys,
+            params.sparse_types,
+            params.dense_shapes_as_proto,
+            ragged_keys=params.ragged_keys,
+            ragged_value_types=params.ragged_value_types,
+            ragged_split_types=params.ragged_split_types,
+            **self._flat_structure))
+    super(_ParseTFRecordExampleDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return self._element_spec
+
+
 @tf_export("data.experimental.parse_example_dataset")
 @deprecation.deprecated(
     None, "Use `tf.data.Dataset.map(tf.io.parse_example(...))` instead.")
@@ -1209,6 +1209,50 @@ class SqlDatasetV1(dataset_ops.DatasetV1Adapter):
     super(SqlDatasetV1, self).__init__(wrapped)
 
 
+
+def _build_tf_record_index(filenames):
+  """Writes the index of each of `filenames` next to it.
+
+  Args:
+    filenames: A `tf.string` tensor containing one or more filenames of
+      uncompressed TFRecord files.
+
+  Returns:
+    A `tf.int64` tensor with the number of records in each file.
+  """
+  filenames = ops.convert_to_tensor(
+      filenames, dtype=dtypes.string, name="filenames")
+  return gen_experimental_dataset_ops.build_tf_record_index(filenames)
+
+
+class _IndexedTFRecordDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of the records of indexed TFRecord files.
+
+  The files must have been indexed by `_build_tf_record_index`. The dataset
+  knows its cardinality and supports random access.
+  """
+
+  def __init__(self, filenames, buffer_size=None):
+    """Creates an `_IndexedTFRecordDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames of
+        indexed, uncompressed TFRecord files.
+      buffer_size: (Optional.) A `tf.int64` scalar representing the number of
+        bytes in the read buffer. 0 means no buffering.
+    """
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._buffer_size = convert.optional_param_to_tensor(
+        "buffer_size", buffer_size, argument_default=0)
+    variant_tensor = gen_experimental_dataset_ops.indexed_tf_record_dataset(
+        self._filenames, self._buffer_size)
+    super(_IndexedTFRecordDataset, self).__init__(variant_tensor)
+
+  @property
+  def element_spec(self):
+    return tensor_spec.TensorSpec([], dtypes.string)
+
 if tf2.enabled():
   CsvDataset = CsvDatasetV2
   SqlDataset = SqlDatasetV2
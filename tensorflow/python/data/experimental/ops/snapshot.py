@@ -23,6 +23,7 @@ from tensorflow.python.util.tf_export import tf_export
 
 COMPRESSION_GZIP = "GZIP"
 COMPRESSION_SNAPPY = "SNAPPY"
+COMPRESSION_ZSTD = "ZSTD"
 COMPRESSION_NONE = None
 
 
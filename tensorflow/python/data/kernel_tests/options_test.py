@@ -145,6 +145,7 @@ class OptionsTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.autotune.enabled = True
     options.autotune.cpu_budget = 10
     options.autotune.ram_budget = 20
+    options.autotune.tuned_parameters_file = "/tmp/tuned_parameters"
     options.deterministic = True
     options.experimental_external_state_policy = (
         options_lib.ExternalStatePolicy.FAIL)
@@ -159,6 +160,7 @@ class OptionsTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_and_filter_fusion = True
     options.experimental_optimization.map_fusion = True
     options.experimental_optimization.map_parallelization = True
+    options.experimental_optimization.map_vectorization = True
     options.experimental_optimization.noop_elimination = True
     options.experimental_optimization.parallel_batch = True
     options.experimental_optimization.shuffle_and_repeat_fusion = True
@@ -45,12 +45,18 @@ class AutotuneAlgorithm(enum.Enum):
 
   STAGE_BASED: In each optimization step, this algorithm chooses the worst
   bottleneck parameter and increases its value by 1.
+
+  CPU_BUDGET: Similar to HILL_CLIMB, but the parallelism of the pipeline never
+  exceeds a CPU budget, and the pipeline stops getting faster once it keeps up
+  with the consumer. The budget is at most `cpu_budget`, and shrinks while the
+  consumer hardly waits for elements, leaving the remaining cores to it.
   """
   DEFAULT = 0
   HILL_CLIMB = 1
   GRADIENT_DESCENT = 2
   MAX_PARALLELISM = 3
   STAGE_BASED = 4
+  CPU_BUDGET = 5
 
   @classmethod
   def _to_proto(cls, obj):
@@ -64,9 +70,11 @@ class AutotuneAlgorithm(enum.Enum):
       return model_pb2.AutotuneAlgorithm.MAX_PARALLELISM
     if obj == cls.STAGE_BASED:
       return model_pb2.AutotuneAlgorithm.STAGE_BASED
+    if obj == cls.CPU_BUDGET:
+      return model_pb2.AutotuneAlgorithm.CPU_BUDGET
     raise ValueError(
         f"Invalid `obj.` Supported values include `DEFAULT`, `HILL_CLIMB` "
-        f"`GRADIENT_DESCENT`, and `STAGE_BASED`. Got {obj.name}.")
+        f"`GRADIENT_DESCENT`, `STAGE_BASED` and `CPU_BUDGET`. Got {obj.name}.")
 
   @classmethod
   def _from_proto(cls, pb):
@@ -80,9 +88,11 @@ class AutotuneAlgorithm(enum.Enum):
       return cls.MAX_PARALLELISM
     if pb == model_pb2.AutotuneAlgorithm.STAGE_BASED:
       return cls.STAGE_BASED
+    if pb == model_pb2.AutotuneAlgorithm.CPU_BUDGET:
+      return cls.CPU_BUDGET
     raise ValueError(
         f"Invalid `pb.` Supported values include `DEFAULT`, `HILL_CLIMB`, "
-        f"`GRADIENT_DESCENT` and `STAGE_BASED`. Got {pb}.")
+        f"`GRADIENT_DESCENT`, `STAGE_BASED` and `CPU_BUDGET`. Got {pb}.")
 
 
 @tf_export("data.experimental.AutoShardPolicy")
@@ -241,6 +251,19 @@ class AutotuneOptions(options_lib.OptionsBase):
       ),
   )
 
+  tuned_parameters_file = options_lib.create_option(
+      name="tuned_parameters_file",
+      ty=str,
+      docstring=(
+          "When autotuning is enabled (through `autotune`), the file in which"
+          " the tuned parameter values are saved, together with the"
+          " fingerprint of the dataset graph. If the file holds values tuned"
+          " for the same dataset graph by a previous run, autotuning starts"
+          " from them instead of tuning from scratch. If None, tuned"
+          " parameter values are not saved."
+      ),
+  )
+
   def _to_proto(self):
     pb = dataset_options_pb2.AutotuneOptions()
     if self.enabled is not None:
@@ -254,6 +277,8 @@ class AutotuneOptions(options_lib.OptionsBase):
           self.autotune_algorithm)
     if self.initial_parallelism is not None:
       pb.initial_parallelism = self.initial_parallelism
+    if self.tuned_parameters_file is not None:
+      pb.tuned_parameters_file = self.tuned_parameters_file
     return pb
 
   def _from_proto(self, pb):
@@ -268,6 +293,8 @@ class AutotuneOptions(options_lib.OptionsBase):
           pb.autotune_algorithm)
     if pb.WhichOneof("optional_initial_parallelism") is not None:
       self.initial_parallelism = pb.initial_parallelism
+    if pb.WhichOneof("optional_tuned_parameters_file") is not None:
+      self.tuned_parameters_file = pb.tuned_parameters_file
 
   def _set_mutable(self, mutable):
     """Change the mutability value to `mutable` on this options and children."""
@@ -397,6 +424,14 @@ class OptimizationOptions(options_lib.OptionsBase):
       "Whether to parallelize stateless map transformations. If None, defaults "
       "to True.")
 
+  map_vectorization = options_lib.create_option(
+      name="map_vectorization",
+      ty=bool,
+      docstring=
+      "Whether to batch the inputs of map transformations followed by a batch "
+      "transformation, so that element-wise map functions run once per batch. "
+      "If None, defaults to False.")
+
   noop_elimination = options_lib.create_option(
       name="noop_elimination",
       ty=bool,
@@ -435,6 +470,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       pb.map_fusion = self.map_fusion
     if self.map_parallelization is not None:
       pb.map_parallelization = self.map_parallelization
+    if self.map_vectorization is not None:
+      pb.map_vectorization = self.map_vectorization
     if self.noop_elimination is not None:
       pb.noop_elimination = self.noop_elimination
     if self.parallel_batch is not None:
@@ -462,6 +499,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       self.map_fusion = pb.map_fusion
     if pb.WhichOneof("optional_map_parallelization") is not None:
       self.map_parallelization = pb.map_parallelization
+    if pb.WhichOneof("optional_map_vectorization") is not None:
+      self.map_vectorization = pb.map_vectorization
     if pb.WhichOneof("optional_noop_elimination") is not None:
       self.noop_elimination = pb.noop_elimination
     if pb.WhichOneof("optional_parallel_batch") is not None:
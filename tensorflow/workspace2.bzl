@@ -6,6 +6,7 @@ load("@bazel_skylib//lib:versions.bzl", "versions")
 
 # Import external repository rules.
 load("@bazel_tools//tools/build_defs/repo:java.bzl", "java_import_external")
+load("@local_tsl//third_party/net_zstd:workspace.bzl", net_zstd = "repo")
 load("@rules_jvm_external//:defs.bzl", "maven_install")
 load("@tf_runtime//:dependencies.bzl", "tfrt_dependencies")
 load("//tensorflow/tools/def_file_filter:def_file_filter_configure.bzl", "def_file_filter_configure")
@@ -79,6 +80,7 @@ def _initialize_third_party():
     libprotobuf_mutator()
     ml_dtypes()
     nasm()
+    net_zstd()
     opencl_headers()
     pasta()
     pybind11_abseil()
@@ -888,15 +890,6 @@ def _tf_repositories():
         urls = tf_mirror_urls("https://github.com/google/brotli/archive/3914999fcc1fda92e750ef9190aa6db9bf7bdb07.zip"),  # 2022-11-17
     )
 
-    # Required by riegeli.
-    tf_http_archive(
-        name = "net_zstd",
-        build_file = "//third_party:net_zstd.BUILD",
-        sha256 = "b6c537b53356a3af3ca3e621457751fa9a6ba96daf3aebb3526ae0f610863532",
-        strip_prefix = "zstd-1.4.5/lib",
-        urls = tf_mirror_urls("https://github.com/facebook/zstd/archive/v1.4.5.zip"),  # 2020-05-22
-    )
-
     tf_http_archive(
         name = "com_google_highway",
         sha256 = "2eb48f87c099a95123dc13a9f243bd3b74d67fe1d887942903d09a211593da97",
@@ -93,6 +93,11 @@ struct AllocatorStats {
   std::optional<int64_t> pool_bytes;
   std::optional<int64_t> peak_pool_bytes;
 
+  // Number of allocations served from, or missing, a front-end cache such as
+  // SizeClassCacheAllocator, if the allocator has one.
+  std::optional<int64_t> num_cache_hits;
+  std::optional<int64_t> num_cache_misses;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
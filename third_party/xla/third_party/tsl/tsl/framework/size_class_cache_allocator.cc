@@ -0,0 +1,266 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/framework/size_class_cache_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/logging.h"
+
+namespace tsl {
+
+// Bookkeeping stored immediately before every pointer handed out.
+struct SizeClassCacheAllocator::Header {
+  // Index into class_sizes_, or -1 if the block bypassed the caches.
+  int32 size_class;
+  // Distance in bytes from the pointer returned by the wrapped allocator to
+  // the pointer returned to the caller.
+  uint32 offset;
+  size_t requested_size;
+};
+
+// A cache shard. Shards are cacheline-aligned so that threads hitting
+// different shards do not false-share the mutex.
+struct alignas(Allocator::kAllocatorAlignment) SizeClassCacheAllocator::Shard {
+  explicit Shard(size_t num_classes) : free_lists(num_classes) {}
+
+  mutex mu;
+  // Per size class, the base pointers of cached blocks.
+  std::vector<std::vector<void*>> free_lists TF_GUARDED_BY(mu);
+  size_t cached_bytes TF_GUARDED_BY(mu) = 0;
+  int64_t num_hits TF_GUARDED_BY(mu) = 0;
+  int64_t num_misses TF_GUARDED_BY(mu) = 0;
+};
+
+namespace {
+
+// Cached blocks reserve a full alignment unit in front of the caller's
+// pointer so that the returned pointer keeps the default alignment.
+constexpr size_t kCachedHeaderBytes = Allocator::kAllocatorAlignment;
+
+// Smallest size class; smaller requests are rounded up to it.
+constexpr size_t kMinCachedSize = 256;
+
+// Counter used to hand out shard indices to threads.
+std::atomic<uint32> next_thread_shard{0};
+
+}  // namespace
+
+SizeClassCacheAllocator::SizeClassCacheAllocator(
+    std::unique_ptr<Allocator> wrapped, const string& name,
+    const Options& opts)
+    : wrapped_(std::move(wrapped)),
+      name_(name),
+      max_cached_bytes_per_shard_(opts.max_cached_bytes_per_shard) {
+  static_assert(sizeof(Header) <= kCachedHeaderBytes,
+                "Header must fit in the reserved prefix");
+  CHECK(wrapped_ != nullptr);
+  // Size classes step by 1x and 1.5x per power of two, which bounds internal
+  // fragmentation at 33% while keeping the number of free lists small.
+  for (size_t size = kMinCachedSize; size <= kMaxCachedSize; size *= 2) {
+    class_sizes_.push_back(size);
+    if (size + size / 2 <= kMaxCachedSize) {
+      class_sizes_.push_back(size + size / 2);
+    }
+  }
+  int num_shards = opts.num_shards > 0 ? opts.num_shards
+                                       : 2 * std::max(port::MaxParallelism(), 1);
+  shards_.reserve(num_shards);
+  for (int i = 0; i < num_shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>(class_sizes_.size()));
+  }
+  VLOG(1) << "Creating " << name_ << " with " << num_shards << " shards and "
+          << class_sizes_.size() << " size classes in front of "
+          << wrapped_->Name();
+}
+
+SizeClassCacheAllocator::~SizeClassCacheAllocator() { Flush(); }
+
+int SizeClassCacheAllocator::SizeClassFor(size_t num_bytes) const {
+  return std::lower_bound(class_sizes_.begin(), class_sizes_.end(),
+                          num_bytes) -
+         class_sizes_.begin();
+}
+
+SizeClassCacheAllocator::Shard&
+SizeClassCacheAllocator::ShardForCurrentThread() {
+  // A thread keeps the same shard index for its lifetime, so in the common
+  // case each inter-op thread has a shard to itself and the shard mutex is
+  // uncontended.
+  static thread_local uint32 thread_shard =
+      next_thread_shard.fetch_add(1, std::memory_order_relaxed);
+  return *shards_[thread_shard % shards_.size()];
+}
+
+void* SizeClassCacheAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  if (num_bytes == 0) {
+    return nullptr;
+  }
+
+  int size_class = -1;
+  size_t offset;
+  void* base = nullptr;
+  if (num_bytes <= kMaxCachedSize && alignment <= kAllocatorAlignment) {
+    size_class = SizeClassFor(num_bytes);
+    const size_t class_size = class_sizes_[size_class];
+    Shard& shard = ShardForCurrentThread();
+    {
+      mutex_lock l(shard.mu);
+      std::vector<void*>& free_list = shard.free_lists[size_class];
+      if (!free_list.empty()) {
+        base = free_list.back();
+        free_list.pop_back();
+        shard.cached_bytes -= class_size;
+        ++shard.num_hits;
+      } else {
+        ++shard.num_misses;
+      }
+    }
+    offset = kCachedHeaderBytes;
+    if (base == nullptr) {
+      base = AllocateFromWrapped(kAllocatorAlignment, offset + class_size,
+                                 allocation_attr);
+    }
+  } else {
+    offset = std::max(alignment, kCachedHeaderBytes);
+    base = AllocateFromWrapped(std::max(alignment, kAllocatorAlignment),
+                               offset + num_bytes, allocation_attr);
+  }
+  if (base == nullptr) {
+    return nullptr;
+  }
+
+  char* ptr = static_cast<char*>(base) + offset;
+  Header* header = reinterpret_cast<Header*>(ptr) - 1;
+  header->size_class = size_class;
+  header->offset = static_cast<uint32>(offset);
+  header->requested_size = num_bytes;
+  return ptr;
+}
+
+void* SizeClassCacheAllocator::AllocateFromWrapped(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  void* ptr = wrapped_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr != nullptr) {
+    return ptr;
+  }
+  // The wrapped allocator is out of memory, but the caches of all shards may
+  // hold enough free blocks to satisfy the request once they are returned.
+  size_t flushed_bytes = 0;
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    flushed_bytes += FlushShard(*shard);
+  }
+  if (flushed_bytes == 0) {
+    return nullptr;
+  }
+  VLOG(1) << name_ << ": flushed " << flushed_bytes
+          << " cached bytes to retry an allocation of " << num_bytes
+          << " bytes";
+  return wrapped_->AllocateRaw(alignment, num_bytes, allocation_attr);
+}
+
+void SizeClassCacheAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  const Header* header = static_cast<const Header*>(ptr) - 1;
+  void* base = static_cast<char*>(ptr) - header->offset;
+  if (header->size_class >= 0) {
+    const size_t class_size = class_sizes_[header->size_class];
+    Shard& shard = ShardForCurrentThread();
+    mutex_lock l(shard.mu);
+    if (shard.cached_bytes + class_size <= max_cached_bytes_per_shard_) {
+      shard.free_lists[header->size_class].push_back(base);
+      shard.cached_bytes += class_size;
+      return;
+    }
+  }
+  wrapped_->DeallocateRaw(base);
+}
+
+size_t SizeClassCacheAllocator::RequestedSize(const void* ptr) const {
+  CHECK(ptr);
+  return (static_cast<const Header*>(ptr) - 1)->requested_size;
+}
+
+size_t SizeClassCacheAllocator::AllocatedSize(const void* ptr) const {
+  CHECK(ptr);
+  const Header* header = static_cast<const Header*>(ptr) - 1;
+  if (header->size_class >= 0) {
+    return class_sizes_[header->size_class];
+  }
+  return header->requested_size;
+}
+
+size_t SizeClassCacheAllocator::FlushShard(Shard& shard) {
+  std::vector<void*> to_free;
+  size_t flushed_bytes;
+  {
+    mutex_lock l(shard.mu);
+    for (std::vector<void*>& free_list : shard.free_lists) {
+      to_free.insert(to_free.end(), free_list.begin(), free_list.end());
+      free_list.clear();
+    }
+    flushed_bytes = shard.cached_bytes;
+    shard.cached_bytes = 0;
+  }
+  for (void* base : to_free) {
+    wrapped_->DeallocateRaw(base);
+  }
+  return flushed_bytes;
+}
+
+void SizeClassCacheAllocator::Flush() {
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    FlushShard(*shard);
+  }
+}
+
+// Bytes held in the caches are still in use from the wrapped allocator's point
+// of view, so they are included in bytes_in_use.
+absl::optional<AllocatorStats> SizeClassCacheAllocator::GetStats() {
+  absl::optional<AllocatorStats> stats = wrapped_->GetStats();
+  if (!stats) {
+    stats.emplace();
+  }
+  int64_t num_hits = 0;
+  int64_t num_misses = 0;
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    mutex_lock l(shard->mu);
+    num_hits += shard->num_hits;
+    num_misses += shard->num_misses;
+  }
+  stats->num_cache_hits = num_hits;
+  stats->num_cache_misses = num_misses;
+  return stats;
+}
+
+bool SizeClassCacheAllocator::ClearStats() {
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    mutex_lock l(shard->mu);
+    shard->num_hits = 0;
+    shard->num_misses = 0;
+  }
+  wrapped_->ClearStats();
+  return true;
+}
+
+}  // namespace tsl
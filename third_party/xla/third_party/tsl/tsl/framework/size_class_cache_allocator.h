@@ -0,0 +1,134 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_FRAMEWORK_SIZE_CLASS_CACHE_ALLOCATOR_H_
+#define TENSORFLOW_TSL_FRAMEWORK_SIZE_CLASS_CACHE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "tsl/framework/allocator.h"
+#include "tsl/platform/macros.h"
+#include "tsl/platform/mutex.h"
+#include "tsl/platform/thread_annotations.h"
+#include "tsl/platform/types.h"
+
+namespace tsl {
+
+// An Allocator that keeps small freed blocks in size-class free lists in
+// front of another (typically BFC) allocator.
+//
+// BFCAllocator serializes every AllocateRaw/DeallocateRaw behind one mutex,
+// which becomes the bottleneck when many inter-op threads churn through small
+// host tensors. This allocator rounds small requests up to one of a fixed set
+// of size classes and serves them from per-thread cache shards, so the
+// wrapped allocator is only consulted on a cache miss or when a shard is over
+// its byte budget. Requests larger than the biggest size class, or with an
+// alignment above Allocator::kAllocatorAlignment, go straight through.
+//
+// Each returned pointer is preceded by a small header recording its size
+// class and requested size, which lets RequestedSize()/AllocatedSize() answer
+// without touching the wrapped allocator.
+class SizeClassCacheAllocator : public Allocator {
+ public:
+  struct Options {
+    // Maximum number of bytes held in free lists by a single cache shard.
+    // Blocks freed into a full shard are returned to the wrapped allocator.
+    size_t max_cached_bytes_per_shard = 1 << 20;
+
+    // Number of cache shards. Threads are assigned to shards round-robin the
+    // first time they allocate. If <= 0, twice the available parallelism is
+    // used.
+    int num_shards = 0;
+  };
+
+  // Largest request, in bytes, that is served from the size-class caches.
+  static constexpr size_t kMaxCachedSize = 32 << 10;
+
+  SizeClassCacheAllocator(std::unique_ptr<Allocator> wrapped,
+                          const string& name, const Options& opts);
+
+  ~SizeClassCacheAllocator() override;
+
+  string Name() override { return name_; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  bool TracksAllocationSizes() const override { return true; }
+
+  size_t RequestedSize(const void* ptr) const override;
+
+  size_t AllocatedSize(const void* ptr) const override;
+
+  absl::optional<AllocatorStats> GetStats() override;
+
+  bool ClearStats() override;
+
+  void SetSafeFrontier(uint64 count) override {
+    wrapped_->SetSafeFrontier(count);
+  }
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return wrapped_->GetMemoryType();
+  }
+
+  // Returns all cached blocks to the wrapped allocator.
+  void Flush();
+
+ private:
+  struct Header;
+  struct Shard;
+
+  // Returns the index of the smallest size class that fits `num_bytes`.
+  int SizeClassFor(size_t num_bytes) const;
+
+  // Returns the cache shard assigned to the calling thread.
+  Shard& ShardForCurrentThread();
+
+  // Returns the cached blocks of `shard` to the wrapped allocator, and returns
+  // their total size in bytes.
+  size_t FlushShard(Shard& shard);
+
+  // Allocates from the wrapped allocator. If that fails, flushes the caches
+  // and retries once.
+  void* AllocateFromWrapped(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
+
+  const std::unique_ptr<Allocator> wrapped_;
+  const string name_;
+  const size_t max_cached_bytes_per_shard_;
+
+  // Ascending block sizes, one per size class.
+  std::vector<size_t> class_sizes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  SizeClassCacheAllocator(const SizeClassCacheAllocator&) = delete;
+  void operator=(const SizeClassCacheAllocator&) = delete;
+};
+
+}  // namespace tsl
+
+#endif  // TENSORFLOW_TSL_FRAMEWORK_SIZE_CLASS_CACHE_ALLOCATOR_H_
@@ -0,0 +1,183 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/framework/size_class_cache_allocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tsl/platform/env.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/threadpool.h"
+
+namespace tsl {
+namespace {
+
+// Counts the allocations that reach the backing allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    if (max_live_ > 0 && num_live_.load() >= max_live_) {
+      return nullptr;
+    }
+    num_allocs_.fetch_add(1);
+    num_live_.fetch_add(1);
+    return port::AlignedMalloc(num_bytes, static_cast<int>(alignment));
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    num_live_.fetch_sub(1);
+    port::AlignedFree(ptr);
+  }
+
+  int64_t num_allocs() const { return num_allocs_.load(); }
+  int64_t num_live() const { return num_live_.load(); }
+
+  // Fails allocations while `max_live` blocks are live, if positive.
+  void set_max_live(int64_t max_live) { max_live_ = max_live; }
+
+ private:
+  int64_t max_live_ = 0;
+  std::atomic<int64_t> num_allocs_{0};
+  std::atomic<int64_t> num_live_{0};
+};
+
+TEST(SizeClassCacheAllocatorTest, ReusesFreedBlocks) {
+  auto counting = std::make_unique<CountingAllocator>();
+  CountingAllocator* backing = counting.get();
+  SizeClassCacheAllocator::Options opts;
+  opts.num_shards = 1;
+  SizeClassCacheAllocator a(std::move(counting), "test", opts);
+
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment,
+            0);
+  EXPECT_EQ(a.RequestedSize(p), 1000);
+  EXPECT_GE(a.AllocatedSize(p), 1000);
+  a.DeallocateRaw(p);
+
+  // Any request in the same size class is served from the cache.
+  void* q = a.AllocateRaw(Allocator::kAllocatorAlignment, 1010);
+  EXPECT_EQ(q, p);
+  EXPECT_EQ(a.RequestedSize(q), 1010);
+  EXPECT_EQ(backing->num_allocs(), 1);
+
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(*stats->num_cache_hits, 1);
+  EXPECT_EQ(*stats->num_cache_misses, 1);
+
+  a.DeallocateRaw(q);
+  a.Flush();
+  EXPECT_EQ(backing->num_live(), 0);
+}
+
+TEST(SizeClassCacheAllocatorTest, LargeAndOverAlignedBypassCache) {
+  auto counting = std::make_unique<CountingAllocator>();
+  CountingAllocator* backing = counting.get();
+  SizeClassCacheAllocator a(std::move(counting), "test",
+                            SizeClassCacheAllocator::Options());
+
+  const size_t large = SizeClassCacheAllocator::kMaxCachedSize + 1;
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, large);
+  EXPECT_EQ(a.AllocatedSize(p), large);
+  a.DeallocateRaw(p);
+  EXPECT_EQ(backing->num_live(), 0);
+
+  void* q = a.AllocateRaw(4096, 100);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(q) % 4096, 0);
+  EXPECT_EQ(a.RequestedSize(q), 100);
+  a.DeallocateRaw(q);
+  EXPECT_EQ(backing->num_live(), 0);
+}
+
+TEST(SizeClassCacheAllocatorTest, ShardBudgetIsRespected) {
+  auto counting = std::make_unique<CountingAllocator>();
+  CountingAllocator* backing = counting.get();
+  SizeClassCacheAllocator::Options opts;
+  opts.num_shards = 1;
+  opts.max_cached_bytes_per_shard = 4 * 1024;
+  SizeClassCacheAllocator a(std::move(counting), "test", opts);
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 16; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 1024));
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  // Only four 1KiB blocks fit within the shard budget.
+  EXPECT_EQ(backing->num_live(), 4);
+}
+
+TEST(SizeClassCacheAllocatorTest, FlushesCachesWhenOutOfMemory) {
+  auto counting = std::make_unique<CountingAllocator>();
+  CountingAllocator* backing = counting.get();
+  SizeClassCacheAllocator::Options opts;
+  opts.num_shards = 1;
+  SizeClassCacheAllocator a(std::move(counting), "test", opts);
+
+  a.DeallocateRaw(a.AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+  EXPECT_EQ(backing->num_live(), 1);
+
+  // The backing allocator only has room for the cached block, so a request in
+  // another size class succeeds only after the cache is flushed.
+  backing->set_max_live(1);
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 8000);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(backing->num_live(), 1);
+
+  // Without cached blocks, running out of memory still fails.
+  EXPECT_EQ(a.AllocateRaw(Allocator::kAllocatorAlignment, 8000), nullptr);
+  a.DeallocateRaw(p);
+}
+
+TEST(SizeClassCacheAllocatorTest, ConcurrentAllocateDeallocate) {
+  auto counting = std::make_unique<CountingAllocator>();
+  CountingAllocator* backing = counting.get();
+  SizeClassCacheAllocator a(std::move(counting), "test",
+                            SizeClassCacheAllocator::Options());
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 1000; ++i) {
+          ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment,
+                                       64 + (i * 37 + t) % 20000));
+          if (ptrs.size() > 16) {
+            a.DeallocateRaw(ptrs.front());
+            ptrs.erase(ptrs.begin());
+          }
+        }
+        for (void* p : ptrs) {
+          a.DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  // The pool has joined, so every block is either cached or returned.
+  a.Flush();
+  EXPECT_EQ(backing->num_live(), 0);
+}
+
+}  // namespace
+}  // namespace tsl
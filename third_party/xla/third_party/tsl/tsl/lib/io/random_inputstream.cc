@@ -16,25 +16,98 @@ limitations under the License.
 #include "tsl/lib/io/random_inputstream.h"
 
 #include <memory>
+#include <utility>
+
+#include "tsl/platform/notification.h"
 
 namespace tsl {
 namespace io {
 
+// A read started by ReadNBytes() for the chunk that follows it.
+struct RandomAccessInputStream::PendingRead {
+  int64_t offset;
+  tstring buffer;
+  Status status;
+  StringPiece data;
+  Notification done;
+};
+
 RandomAccessInputStream::RandomAccessInputStream(RandomAccessFile* file,
                                                  bool owns_file)
     : file_(file), owns_file_(owns_file) {}
 
+RandomAccessInputStream::RandomAccessInputStream(RandomAccessFile* file,
+                                                 bool owns_file,
+                                                 bool read_ahead)
+    : file_(file), owns_file_(owns_file), read_ahead_(read_ahead) {}
+
 RandomAccessInputStream::~RandomAccessInputStream() {
+  // The read-ahead writes into pending_read_ and reads from file_.
+  TakePendingRead();
   if (owns_file_) {
     delete file_;
   }
 }
 
+std::unique_ptr<RandomAccessInputStream::PendingRead>
+RandomAccessInputStream::TakePendingRead() {
+  std::unique_ptr<PendingRead> read = std::move(pending_read_);
+  if (read != nullptr) {
+    read->done.WaitForNotification();
+  }
+  return read;
+}
+
 Status RandomAccessInputStream::ReadNBytes(int64_t bytes_to_read,
                                            tstring* result) {
   if (bytes_to_read < 0) {
     return errors::InvalidArgument("Cannot read negative number of bytes");
   }
+  if (!read_ahead_) {
+    return ReadFromFile(bytes_to_read, result);
+  }
+
+  std::unique_ptr<PendingRead> read = TakePendingRead();
+  Status s;
+  if (read != nullptr && read->offset == pos_ &&
+      read->buffer.size() == static_cast<size_t>(bytes_to_read)) {
+    s = read->status;
+    if (read->data.data() != read->buffer.data()) {
+      memmove(read->buffer.mdata(), read->data.data(), read->data.size());
+    }
+    read->buffer.resize(read->data.size());
+    result->swap(read->buffer);
+    if (s.ok() || errors::IsOutOfRange(s)) {
+      pos_ += result->size();
+    }
+  } else {
+    // The stream was not read sequentially in chunks of this size.
+    s = ReadFromFile(bytes_to_read, result);
+  }
+  if (!s.ok() || bytes_to_read == 0) {
+    return s;
+  }
+
+  // Reuse the buffer that the caller just handed back through 'result'.
+  auto next = std::make_unique<PendingRead>();
+  if (read != nullptr) {
+    next->buffer.swap(read->buffer);
+  }
+  next->offset = pos_;
+  next->buffer.resize_uninitialized(bytes_to_read);
+  PendingRead* next_ptr = next.get();
+  pending_read_ = std::move(next);
+  file_->ReadAsync(pos_, bytes_to_read, next_ptr->buffer.mdata(),
+                   [next_ptr](const Status& status, StringPiece data) {
+                     next_ptr->status = status;
+                     next_ptr->data = data;
+                     next_ptr->done.Notify();
+                   });
+  return s;
+}
+
+Status RandomAccessInputStream::ReadFromFile(int64_t bytes_to_read,
+                                             tstring* result) {
   result->clear();
   result->resize_uninitialized(bytes_to_read);
   char* result_buffer = &(*result)[0];
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_TSL_LIB_IO_RANDOM_INPUTSTREAM_H_
 #define TENSORFLOW_TSL_LIB_IO_RANDOM_INPUTSTREAM_H_
 
+#include <memory>
+
 #include "tsl/lib/io/inputstream_interface.h"
 #include "tsl/platform/cord.h"
 #include "tsl/platform/file_system.h"
@@ -31,6 +33,14 @@ class RandomAccessInputStream : public InputStreamInterface {
   // must outlive *this.
   RandomAccessInputStream(RandomAccessFile* file, bool owns_file = false);
 
+  // If 'read_ahead' is true, each ReadNBytes(n) call starts reading the n
+  // bytes that follow it with RandomAccessFile::ReadAsync(), so that a reader
+  // consuming the file in fixed-size chunks (e.g. through a
+  // BufferedInputStream) overlaps its I/O with the processing of the previous
+  // chunk. This costs one extra chunk of memory.
+  RandomAccessInputStream(RandomAccessFile* file, bool owns_file,
+                          bool read_ahead);
+
   ~RandomAccessInputStream() override;
 
   Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
@@ -51,9 +61,19 @@ class RandomAccessInputStream : public InputStreamInterface {
   Status Reset() override { return Seek(0); }
 
  private:
+  struct PendingRead;
+
+  // Reads 'bytes_to_read' bytes at pos_ into '*result' and advances pos_.
+  Status ReadFromFile(int64_t bytes_to_read, tstring* result);
+
+  // Waits for the outstanding read-ahead, if any, and takes it.
+  std::unique_ptr<PendingRead> TakePendingRead();
+
   RandomAccessFile* file_;  // Not owned.
   int64_t pos_ = 0;         // Tracks where we are in the file.
   bool owns_file_ = false;
+  const bool read_ahead_ = false;
+  std::unique_ptr<PendingRead> pending_read_;
 };
 
 }  // namespace io
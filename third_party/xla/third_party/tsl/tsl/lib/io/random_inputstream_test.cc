@@ -52,6 +52,38 @@ TEST(RandomInputStream, ReadNBytes) {
   EXPECT_EQ(10, in.Tell());
 }
 
+TEST(RandomInputStream, ReadAhead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/random_inputbuffer_read_ahead_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  tstring read;
+  RandomAccessInputStream in(file.get(), /*owns_file=*/false,
+                             /*read_ahead=*/true);
+  TF_ASSERT_OK(in.ReadNBytes(3, &read));
+  EXPECT_EQ(read, "012");
+  TF_ASSERT_OK(in.ReadNBytes(3, &read));
+  EXPECT_EQ(read, "345");
+  // A read of another size does not use the read-ahead.
+  TF_ASSERT_OK(in.ReadNBytes(2, &read));
+  EXPECT_EQ(read, "67");
+  EXPECT_EQ(8, in.Tell());
+  // Neither does a read after a seek.
+  TF_ASSERT_OK(in.Seek(1));
+  TF_ASSERT_OK(in.ReadNBytes(4, &read));
+  EXPECT_EQ(read, "1234");
+  TF_ASSERT_OK(in.ReadNBytes(4, &read));
+  EXPECT_EQ(read, "5678");
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(4, &read)));
+  EXPECT_EQ(read, "9");
+  EXPECT_EQ(10, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(4, &read)));
+  EXPECT_EQ(read, "");
+  EXPECT_EQ(10, in.Tell());
+}
+
 #if defined(TF_CORD_SUPPORT)
 TEST(RandomInputStream, ReadNBytesWithCords) {
   Env* env = Env::Default();
@@ -0,0 +1,185 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/lib/io/record_index.h"
+
+#include <cstring>
+#include <string>
+
+#include "tsl/lib/hash/crc32c.h"
+#include "tsl/lib/io/inputbuffer.h"
+#include "tsl/lib/io/record_reader.h"
+#include "tsl/platform/coding.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/raw_coding.h"
+
+namespace tsl {
+namespace io {
+namespace {
+
+constexpr char kMagic[] = "TFRIDX01";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+constexpr size_t kIndexHeaderSize =
+    kMagicSize + sizeof(uint64) + sizeof(uint32);
+constexpr size_t kEntrySize = 2 * sizeof(uint64) + sizeof(uint32);
+
+// Buffer size used to scan TFRecord files in BuildRecordIndex().
+constexpr size_t kScanBufferSize = 256 << 10;
+
+uint32 MaskedCrc(const char* data, size_t n) {
+  return crc32c::Mask(crc32c::Value(data, n));
+}
+
+// Returns true if the n bytes at "data" are followed by their masked crc.
+bool HasValidCrc(const char* data, size_t n) {
+  return crc32c::Unmask(core::DecodeFixed32(data + n)) ==
+         crc32c::Value(data, n);
+}
+
+}  // namespace
+
+Status BuildRecordIndex(RandomAccessFile* file,
+                        std::vector<RecordIndexEntry>* entries) {
+  InputBuffer input(file, kScanBufferSize);
+  uint64 offset = 0;
+  std::string header;
+  while (true) {
+    Status s = input.ReadNBytes(RecordReader::kHeaderSize, &header);
+    if (errors::IsOutOfRange(s) && header.empty()) {
+      return OkStatus();
+    }
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    if (!HasValidCrc(header.data(), sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+    const uint64 length = core::DecodeFixed64(header.data());
+    s = input.SkipNBytes(length + RecordReader::kFooterSize);
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    TF_RETURN_IF_ERROR(s);
+    entries->push_back({offset, length});
+    offset += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  }
+}
+
+Status WriteRecordIndex(const std::vector<RecordIndexEntry>& entries,
+                        WritableFile* file) {
+  char header[kIndexHeaderSize];
+  std::memcpy(header, kMagic, kMagicSize);
+  core::EncodeFixed64(header + kMagicSize, entries.size());
+  core::EncodeFixed32(header + kMagicSize + sizeof(uint64),
+                      MaskedCrc(header + kMagicSize, sizeof(uint64)));
+  TF_RETURN_IF_ERROR(file->Append(StringPiece(header, kIndexHeaderSize)));
+
+  std::string buffer;
+  buffer.resize(entries.size() * kEntrySize);
+  char* entry = &buffer[0];
+  for (const RecordIndexEntry& e : entries) {
+    core::EncodeFixed64(entry, e.offset);
+    core::EncodeFixed64(entry + sizeof(uint64), e.length);
+    core::EncodeFixed32(entry + 2 * sizeof(uint64),
+                        MaskedCrc(entry, 2 * sizeof(uint64)));
+    entry += kEntrySize;
+  }
+  return file->Append(buffer);
+}
+
+Status ReadIndexedRecord(RandomAccessFile* file, const RecordIndexEntry& entry,
+                         tstring* record) {
+  const size_t n =
+      RecordReader::kHeaderSize + entry.length + RecordReader::kFooterSize;
+  record->resize_uninitialized(n);
+  StringPiece result;
+  Status s = file->Read(entry.offset, n, &result, record->mdata());
+  if (!s.ok() && !(errors::IsOutOfRange(s) && result.size() == n)) {
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("truncated record at ", entry.offset);
+    }
+    return s;
+  }
+  // Some file systems return a view of their own memory instead of filling in
+  // the scratch buffer.
+  if (result.data() != record->data()) {
+    std::memmove(record->mdata(), result.data(), n);
+  }
+  const char* data = record->data();
+  if (!HasValidCrc(data, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", entry.offset);
+  }
+  if (core::DecodeFixed64(data) != entry.length) {
+    return errors::DataLoss("record at ", entry.offset,
+                            " does not match its index entry");
+  }
+  if (!HasValidCrc(data + RecordReader::kHeaderSize, entry.length)) {
+    return errors::DataLoss("corrupted record at ", entry.offset);
+  }
+  std::memmove(record->mdata(), data + RecordReader::kHeaderSize,
+               entry.length);
+  record->resize(entry.length);
+  return OkStatus();
+}
+
+Status RecordIndexReader::Create(RandomAccessFile* file,
+                                 std::unique_ptr<RecordIndexReader>* reader) {
+  char scratch[kIndexHeaderSize];
+  StringPiece header;
+  Status s = file->Read(0, kIndexHeaderSize, &header, scratch);
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  if (header.size() != kIndexHeaderSize ||
+      std::memcmp(header.data(), kMagic, kMagicSize) != 0) {
+    return errors::DataLoss("not a TFRecord index file");
+  }
+  if (!HasValidCrc(header.data() + kMagicSize, sizeof(uint64))) {
+    return errors::DataLoss("corrupted TFRecord index header");
+  }
+  const uint64 num_records = core::DecodeFixed64(header.data() + kMagicSize);
+  reader->reset(new RecordIndexReader(file, num_records));
+  return OkStatus();
+}
+
+Status RecordIndexReader::GetEntry(uint64 record_number,
+                                   RecordIndexEntry* entry) const {
+  if (record_number >= num_records_) {
+    return errors::OutOfRange("record ", record_number,
+                              " is past the end of the index (",
+                              num_records_, " records)");
+  }
+  char scratch[kEntrySize];
+  StringPiece result;
+  Status s = file_->Read(kIndexHeaderSize + record_number * kEntrySize,
+                         kEntrySize, &result, scratch);
+  if (!s.ok() && !(errors::IsOutOfRange(s) && result.size() == kEntrySize)) {
+    if (errors::IsOutOfRange(s)) {
+      return errors::DataLoss("truncated TFRecord index");
+    }
+    return s;
+  }
+  if (!HasValidCrc(result.data(), 2 * sizeof(uint64))) {
+    return errors::DataLoss("corrupted TFRecord index entry ", record_number);
+  }
+  entry->offset = core::DecodeFixed64(result.data());
+  entry->length = core::DecodeFixed64(result.data() + sizeof(uint64));
+  return OkStatus();
+}
+
+}  // namespace io
+}  // namespace tsl
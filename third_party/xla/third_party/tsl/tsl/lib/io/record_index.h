@@ -0,0 +1,97 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_TSL_LIB_IO_RECORD_INDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include "tsl/platform/status.h"
+#include "tsl/platform/tstring.h"
+#include "tsl/platform/types.h"
+
+namespace tsl {
+
+class RandomAccessFile;
+class WritableFile;
+
+namespace io {
+
+// An index of the records in an uncompressed TFRecord file, which lets readers
+// seek to the n-th record without scanning the records before it. The index
+// of "<file>" is stored next to it as "<file>" + kRecordIndexSuffix.
+//
+// Format of an index file:
+//  char      magic[8]
+//  uint64    number of records
+//  uint32    masked crc of the number of records
+//  entry     entries[number of records]
+//
+// Format of an entry, the n-th of which describes the n-th record:
+//  uint64    offset of the record in the TFRecord file
+//  uint64    length of the record's data
+//  uint32    masked crc of offset and length
+//
+// Entries have a fixed size, so that looking one up costs a single read.
+inline constexpr char kRecordIndexSuffix[] = ".idx";
+
+struct RecordIndexEntry {
+  uint64 offset = 0;
+  uint64 length = 0;
+};
+
+// Scans the uncompressed TFRecord file "*file" and appends an entry for each
+// of its records to "*entries". Only the record headers are validated.
+Status BuildRecordIndex(RandomAccessFile* file,
+                        std::vector<RecordIndexEntry>* entries);
+
+// Writes an index holding "entries" to "*file".
+Status WriteRecordIndex(const std::vector<RecordIndexEntry>& entries,
+                        WritableFile* file);
+
+// Reads the record described by "entry" from the uncompressed TFRecord file
+// "*file" into "*record", using a single read. Returns DATA_LOSS if the record
+// does not match the entry or fails its checksums.
+Status ReadIndexedRecord(RandomAccessFile* file, const RecordIndexEntry& entry,
+                         tstring* record);
+
+// Looks up entries of an index file without loading it into memory.
+//
+// This class is thread safe.
+class RecordIndexReader {
+ public:
+  // Validates the header of the index file "*file" and creates a reader for
+  // it in "*reader". "*file" must outlive the reader.
+  static Status Create(RandomAccessFile* file,
+                       std::unique_ptr<RecordIndexReader>* reader);
+
+  uint64 num_records() const { return num_records_; }
+
+  // Reads the entry of the "record_number"-th record into "*entry".
+  Status GetEntry(uint64 record_number, RecordIndexEntry* entry) const;
+
+ private:
+  RecordIndexReader(RandomAccessFile* file, uint64 num_records)
+      : file_(file), num_records_(num_records) {}
+
+  RandomAccessFile* const file_;
+  const uint64 num_records_;
+};
+
+}  // namespace io
+}  // namespace tsl
+
+#endif  // TENSORFLOW_TSL_LIB_IO_RECORD_INDEX_H_
@@ -0,0 +1,150 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/lib/io/record_index.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/lib/io/record_writer.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/strcat.h"
+#include "tsl/platform/test.h"
+
+namespace tsl {
+namespace io {
+namespace {
+
+std::vector<std::string> TestRecords() {
+  std::vector<std::string> records;
+  for (int i = 0; i < 100; ++i) {
+    records.push_back(std::string(i * 7 % 31, 'a' + i % 26));
+  }
+  return records;
+}
+
+void WriteRecords(const string& fname,
+                  const std::vector<std::string>& records) {
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(fname, &file));
+  RecordWriter writer(file.get());
+  for (const std::string& record : records) {
+    TF_ASSERT_OK(writer.WriteRecord(record));
+  }
+  TF_ASSERT_OK(writer.Close());
+  TF_ASSERT_OK(file->Close());
+}
+
+void WriteIndex(const string& fname, std::vector<RecordIndexEntry>* entries) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  TF_ASSERT_OK(BuildRecordIndex(file.get(), entries));
+  std::unique_ptr<WritableFile> index_file;
+  TF_ASSERT_OK(Env::Default()->NewWritableFile(
+      strings::StrCat(fname, kRecordIndexSuffix), &index_file));
+  TF_ASSERT_OK(WriteRecordIndex(*entries, index_file.get()));
+  TF_ASSERT_OK(index_file->Close());
+}
+
+TEST(RecordIndexTest, ReadsRecordsOutOfOrder) {
+  const string fname = testing::TmpDir() + "/record_index_test_out_of_order";
+  const std::vector<std::string> records = TestRecords();
+  WriteRecords(fname, records);
+  std::vector<RecordIndexEntry> entries;
+  WriteIndex(fname, &entries);
+  ASSERT_EQ(entries.size(), records.size());
+
+  std::unique_ptr<RandomAccessFile> file, index_file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(
+      strings::StrCat(fname, kRecordIndexSuffix), &index_file));
+  std::unique_ptr<RecordIndexReader> index;
+  TF_ASSERT_OK(RecordIndexReader::Create(index_file.get(), &index));
+  EXPECT_EQ(index->num_records(), records.size());
+
+  tstring record;
+  for (int i = records.size() - 1; i >= 0; i -= 3) {
+    RecordIndexEntry entry;
+    TF_ASSERT_OK(index->GetEntry(i, &entry));
+    EXPECT_EQ(entry.offset, entries[i].offset);
+    EXPECT_EQ(entry.length, records[i].size());
+    TF_ASSERT_OK(ReadIndexedRecord(file.get(), entry, &record));
+    EXPECT_EQ(record, records[i]);
+  }
+
+  RecordIndexEntry entry;
+  EXPECT_TRUE(errors::IsOutOfRange(index->GetEntry(records.size(), &entry)));
+}
+
+TEST(RecordIndexTest, EmptyFile) {
+  const string fname = testing::TmpDir() + "/record_index_test_empty";
+  WriteRecords(fname, {});
+  std::vector<RecordIndexEntry> entries;
+  WriteIndex(fname, &entries);
+  EXPECT_TRUE(entries.empty());
+
+  std::unique_ptr<RandomAccessFile> index_file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(
+      strings::StrCat(fname, kRecordIndexSuffix), &index_file));
+  std::unique_ptr<RecordIndexReader> index;
+  TF_ASSERT_OK(RecordIndexReader::Create(index_file.get(), &index));
+  EXPECT_EQ(index->num_records(), 0);
+}
+
+TEST(RecordIndexTest, TruncatedFile) {
+  const string fname = testing::TmpDir() + "/record_index_test_truncated";
+  WriteRecords(fname, {"abc", "defg"});
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname, &contents));
+  contents.resize(contents.size() - 1);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname, contents));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  std::vector<RecordIndexEntry> entries;
+  EXPECT_TRUE(errors::IsDataLoss(BuildRecordIndex(file.get(), &entries)));
+}
+
+TEST(RecordIndexTest, StaleIndex) {
+  const string fname = testing::TmpDir() + "/record_index_test_stale";
+  WriteRecords(fname, {"abc", "defg"});
+  std::vector<RecordIndexEntry> entries;
+  WriteIndex(fname, &entries);
+  // Rewrite the file so that the second record moves.
+  WriteRecords(fname, {"abcd", "efg"});
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  tstring record;
+  EXPECT_TRUE(
+      errors::IsDataLoss(ReadIndexedRecord(file.get(), entries[1], &record)));
+}
+
+TEST(RecordIndexTest, NotAnIndex) {
+  const string fname = testing::TmpDir() + "/record_index_test_not_an_index";
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname, "not an index file"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  std::unique_ptr<RecordIndexReader> index;
+  EXPECT_TRUE(
+      errors::IsDataLoss(RecordIndexReader::Create(file.get(), &index)));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tsl
@@ -24,6 +24,8 @@ limitations under the License.
 #include "tsl/lib/io/snappy/snappy_inputstream.h"
 #include "tsl/lib/io/zlib_compression_options.h"
 #include "tsl/lib/io/zlib_inputstream.h"
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/lib/io/zstd/zstd_inputstream.h"
 #endif  // IS_SLIM_BUILD
 #include "tsl/platform/macros.h"
 #include "tsl/platform/types.h"
@@ -37,7 +39,8 @@ struct RecordReaderOptions {
   enum CompressionType {
     NONE = 0,
     ZLIB_COMPRESSION = 1,
-    SNAPPY_COMPRESSION = 2
+    SNAPPY_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3
   };
   CompressionType compression_type = NONE;
 
@@ -46,6 +49,11 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64_t buffer_size = 0;
 
+  // If read_ahead is true and buffer_size is non-zero, the reader fetches the
+  // next buffer_size bytes of the file asynchronously while the current ones
+  // are consumed. See RandomAccessFile::ReadAsync().
+  bool read_ahead = false;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -53,6 +61,7 @@ struct RecordReaderOptions {
   // Options specific to compression.
   ZlibCompressionOptions zlib_options;
   SnappyCompressionOptions snappy_options;
+  ZstdCompressionOptions zstd_options;
 #endif  // IS_SLIM_BUILD
 };
 
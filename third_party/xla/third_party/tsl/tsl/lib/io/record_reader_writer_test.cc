@@ -343,6 +343,46 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestZstd) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_zstd_test";
+
+  for (auto buf_size : BufferSizes()) {
+    for (const string& dictionary : {string(), string("abcdefg")}) {
+      {
+        std::unique_ptr<WritableFile> file;
+        TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+        io::RecordWriterOptions options;
+        options.compression_type = io::RecordWriterOptions::ZSTD_COMPRESSION;
+        options.zstd_options.output_buffer_size = buf_size;
+        options.zstd_options.dictionary = dictionary;
+        io::RecordWriter writer(file.get(), options);
+        TF_EXPECT_OK(writer.WriteRecord("abc"));
+        TF_EXPECT_OK(writer.WriteRecord("defg"));
+        TF_CHECK_OK(writer.Flush());
+      }
+
+      {
+        std::unique_ptr<RandomAccessFile> read_file;
+        // Read it back with the RecordReader.
+        TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+        io::RecordReaderOptions options;
+        options.compression_type = io::RecordReaderOptions::ZSTD_COMPRESSION;
+        options.zstd_options.input_buffer_size = buf_size;
+        options.zstd_options.dictionary = dictionary;
+        io::RecordReader reader(read_file.get(), options);
+        uint64 offset = 0;
+        tstring record;
+        TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ("abc", record);
+        TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ("defg", record);
+      }
+    }
+  }
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
@@ -25,6 +25,8 @@ limitations under the License.
 #include "tsl/lib/io/snappy/snappy_outputbuffer.h"
 #include "tsl/lib/io/zlib_compression_options.h"
 #include "tsl/lib/io/zlib_outputbuffer.h"
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/lib/io/zstd/zstd_outputbuffer.h"
 #endif  // IS_SLIM_BUILD
 #include "tsl/platform/cord.h"
 #include "tsl/platform/macros.h"
@@ -41,7 +43,8 @@ struct RecordWriterOptions {
   enum CompressionType {
     NONE = 0,
     ZLIB_COMPRESSION = 1,
-    SNAPPY_COMPRESSION = 2
+    SNAPPY_COMPRESSION = 2,
+    ZSTD_COMPRESSION = 3
   };
   CompressionType compression_type = NONE;
 
@@ -52,6 +55,7 @@ struct RecordWriterOptions {
   // Options specific to compression.
   io::ZlibCompressionOptions zlib_options;
   io::SnappyCompressionOptions snappy_options;
+  io::ZstdCompressionOptions zstd_options;
 #endif  // IS_SLIM_BUILD
 };
 
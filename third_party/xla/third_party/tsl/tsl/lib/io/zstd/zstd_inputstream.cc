@@ -0,0 +1,151 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/lib/io/zstd/zstd_inputstream.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "tsl/platform/errors.h"
+
+namespace tsl {
+namespace io {
+
+ZstdInputStream::ZstdInputStream(InputStreamInterface* input_stream,
+                                 size_t input_buffer_bytes,
+                                 size_t output_buffer_bytes,
+                                 const ZstdCompressionOptions& zstd_options,
+                                 bool owns_input_stream)
+    : owns_input_stream_(owns_input_stream),
+      input_stream_(input_stream),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      zstd_options_(zstd_options),
+      input_buffer_(new char[input_buffer_bytes]),
+      output_buffer_(new char[output_buffer_bytes]),
+      dctx_(ZSTD_createDCtx()) {
+  if (dctx_ == nullptr) {
+    init_status_ =
+        errors::ResourceExhausted("Failed to create a zstd context.");
+  } else if (!zstd_options_.dictionary.empty()) {
+    const size_t result =
+        ZSTD_DCtx_loadDictionary(dctx_, zstd_options_.dictionary.data(),
+                                 zstd_options_.dictionary.size());
+    if (ZSTD_isError(result)) {
+      init_status_ = errors::InvalidArgument("Failed to load zstd dictionary: ",
+                                             ZSTD_getErrorName(result));
+    }
+  }
+}
+
+ZstdInputStream::~ZstdInputStream() {
+  ZSTD_freeDCtx(dctx_);
+  if (owns_input_stream_) {
+    delete input_stream_;
+  }
+}
+
+absl::Status ZstdInputStream::Reset() {
+  TF_RETURN_IF_ERROR(init_status_);
+  TF_RETURN_IF_ERROR(input_stream_->Reset());
+  // Resetting the session keeps the dictionary loaded.
+  ZSTD_DCtx_reset(dctx_, ZSTD_reset_session_only);
+  input_pos_ = input_size_ = 0;
+  output_pos_ = output_size_ = 0;
+  flush_pending_ = false;
+  bytes_read_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status ZstdInputStream::ReadFromStream() {
+  // Move unconsumed bytes to the head of the buffer to make room for new data.
+  const size_t unconsumed = input_size_ - input_pos_;
+  if (unconsumed > 0 && input_pos_ > 0) {
+    memmove(input_buffer_.get(), input_buffer_.get() + input_pos_, unconsumed);
+  }
+  input_pos_ = 0;
+  input_size_ = unconsumed;
+
+  tstring data;
+  absl::Status s =
+      input_stream_->ReadNBytes(input_buffer_capacity_ - unconsumed, &data);
+  memcpy(input_buffer_.get() + input_size_, data.data(), data.size());
+  input_size_ += data.size();
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  // Like ZlibInputStream, only report the end of the stream once no new data
+  // could be read.
+  if (data.empty()) {
+    return errors::OutOfRange("EOF reached");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ZstdInputStream::Decompress() {
+  ZSTD_inBuffer in = {input_buffer_.get(), input_size_, input_pos_};
+  ZSTD_outBuffer out = {output_buffer_.get(), output_buffer_capacity_, 0};
+  const size_t result = ZSTD_decompressStream(dctx_, &out, &in);
+  if (ZSTD_isError(result)) {
+    return errors::DataLoss("ZSTD_decompressStream() failed: ",
+                            ZSTD_getErrorName(result));
+  }
+  input_pos_ = in.pos;
+  output_pos_ = 0;
+  output_size_ = out.pos;
+  flush_pending_ = out.pos == out.size;
+  return absl::OkStatus();
+}
+
+absl::Status ZstdInputStream::ReadNBytes(int64_t bytes_to_read,
+                                         tstring* result) {
+  TF_RETURN_IF_ERROR(init_status_);
+  result->clear();
+  result->reserve(bytes_to_read);
+  while (bytes_to_read > 0) {
+    if (output_pos_ == output_size_) {
+      if (input_pos_ == input_size_ && !flush_pending_) {
+        TF_RETURN_IF_ERROR(ReadFromStream());
+      }
+      TF_RETURN_IF_ERROR(Decompress());
+      continue;
+    }
+    const size_t n =
+        std::min<size_t>(bytes_to_read, output_size_ - output_pos_);
+    result->append(output_buffer_.get() + output_pos_, n);
+    output_pos_ += n;
+    bytes_read_ += n;
+    bytes_to_read -= n;
+  }
+  return absl::OkStatus();
+}
+
+#if defined(TF_CORD_SUPPORT)
+absl::Status ZstdInputStream::ReadNBytes(int64_t bytes_to_read,
+                                         absl::Cord* result) {
+  tstring buf;
+  TF_RETURN_IF_ERROR(ReadNBytes(bytes_to_read, &buf));
+  result->Clear();
+  result->Append(buf.data());
+  return absl::OkStatus();
+}
+#endif
+
+int64_t ZstdInputStream::Tell() const { return bytes_read_; }
+
+}  // namespace io
+}  // namespace tsl
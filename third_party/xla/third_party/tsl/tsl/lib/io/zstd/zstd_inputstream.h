@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
+#define TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
+
+#include <memory>
+
+#include "tsl/lib/io/inputstream_interface.h"
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/platform/status.h"
+#include "tsl/platform/types.h"
+
+// Forward declare the zstd decompression context, which is only included in
+// the .cc file.
+struct ZSTD_DCtx_s;
+
+namespace tsl {
+namespace io {
+
+// A ZstdInputStream provides support for reading from a stream compressed
+// using zstd (https://facebook.github.io/zstd/). Concatenated frames are read
+// back as a single stream.
+//
+// A given instance of a ZstdInputStream is NOT safe for concurrent use by
+// multiple threads.
+class ZstdInputStream : public InputStreamInterface {
+ public:
+  // Create a ZstdInputStream for `input_stream` with a buffer of size
+  // `input_buffer_bytes` bytes for reading contents from `input_stream` and
+  // another buffer with size `output_buffer_bytes` for caching decompressed
+  // contents.
+  //
+  // Takes ownership of `input_stream` iff `owns_input_stream` is true.
+  ZstdInputStream(InputStreamInterface* input_stream, size_t input_buffer_bytes,
+                  size_t output_buffer_bytes,
+                  const ZstdCompressionOptions& zstd_options,
+                  bool owns_input_stream);
+
+  ~ZstdInputStream() override;
+
+  // Reads bytes_to_read bytes into *result, overwriting *result.
+  //
+  // Return Status codes:
+  // OK:           If successful.
+  // OUT_OF_RANGE: If there are not enough bytes to read before
+  //               the end of the stream.
+  // DATA_LOSS:    If the compressed data is corrupted.
+  // others:       If reading from stream failed.
+  absl::Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+#if defined(TF_CORD_SUPPORT)
+  absl::Status ReadNBytes(int64_t bytes_to_read, absl::Cord* result) override;
+#endif
+
+  int64_t Tell() const override;
+
+  absl::Status Reset() override;
+
+ private:
+  // Reads more compressed data from `input_stream_` into `input_buffer_`,
+  // after any compressed data that has not been consumed yet. Returns
+  // OutOfRange if no data could be read.
+  absl::Status ReadFromStream();
+
+  // Decompresses buffered input into `output_buffer_`.
+  absl::Status Decompress();
+
+  const bool owns_input_stream_;
+  InputStreamInterface* input_stream_;
+  const size_t input_buffer_capacity_;
+  const size_t output_buffer_capacity_;
+  const ZstdCompressionOptions zstd_options_;
+  absl::Status init_status_;
+
+  std::unique_ptr<char[]> input_buffer_;
+  size_t input_pos_ = 0;   // Next compressed byte to decompress.
+  size_t input_size_ = 0;  // Number of valid bytes in `input_buffer_`.
+
+  std::unique_ptr<char[]> output_buffer_;
+  size_t output_pos_ = 0;   // Next decompressed byte to return.
+  size_t output_size_ = 0;  // Number of valid bytes in `output_buffer_`.
+
+  // Whether zstd may hold decompressed data that did not fit in the output
+  // buffer on the last call.
+  bool flush_pending_ = false;
+
+  ZSTD_DCtx_s* dctx_ = nullptr;
+
+  // Number of *uncompressed* bytes that have been read from this stream.
+  int64_t bytes_read_ = 0;
+
+  ZstdInputStream(const ZstdInputStream&) = delete;
+  void operator=(const ZstdInputStream&) = delete;
+};
+
+}  // namespace io
+}  // namespace tsl
+
+#endif  // TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_INPUTSTREAM_H_
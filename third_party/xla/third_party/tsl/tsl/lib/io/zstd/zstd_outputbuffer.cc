@@ -0,0 +1,157 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tsl/lib/io/zstd/zstd_outputbuffer.h"
+
+#include <zstd.h>
+
+#include "tsl/platform/errors.h"
+
+namespace tsl {
+namespace io {
+
+ZstdOutputBuffer::ZstdOutputBuffer(WritableFile* file,
+                                   size_t input_buffer_bytes,
+                                   size_t output_buffer_bytes,
+                                   const ZstdCompressionOptions& zstd_options)
+    : file_(file),
+      input_buffer_capacity_(input_buffer_bytes),
+      output_buffer_capacity_(output_buffer_bytes),
+      zstd_options_(zstd_options),
+      output_buffer_(new char[output_buffer_bytes]) {
+  input_buffer_.reserve(input_buffer_capacity_);
+}
+
+ZstdOutputBuffer::~ZstdOutputBuffer() {
+  if (cctx_ != nullptr) {
+    LOG(WARNING) << "ZstdOutputBuffer::Close() not called. Possible data loss";
+    ZSTD_freeCCtx(cctx_);
+  }
+}
+
+absl::Status ZstdOutputBuffer::Init() {
+  if (output_buffer_capacity_ == 0) {
+    return errors::InvalidArgument(
+        "ZstdOutputBuffer requires a non-empty output buffer.");
+  }
+  cctx_ = ZSTD_createCCtx();
+  if (cctx_ == nullptr) {
+    return errors::ResourceExhausted("Failed to create a zstd context.");
+  }
+  size_t result = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel,
+                                         zstd_options_.compression_level);
+  if (!ZSTD_isError(result)) {
+    result = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_checksumFlag, 1);
+  }
+  if (!ZSTD_isError(result) && !zstd_options_.dictionary.empty()) {
+    result = ZSTD_CCtx_loadDictionary(cctx_, zstd_options_.dictionary.data(),
+                                      zstd_options_.dictionary.size());
+  }
+  if (ZSTD_isError(result)) {
+    return errors::InvalidArgument("Failed to configure zstd compression: ",
+                                   ZSTD_getErrorName(result));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ZstdOutputBuffer::Compress(StringPiece input, int end_op) {
+  const auto directive = static_cast<ZSTD_EndDirective>(end_op);
+  ZSTD_inBuffer in = {input.data(), input.size(), 0};
+  bool done;
+  do {
+    ZSTD_outBuffer out = {output_buffer_.get(), output_buffer_capacity_, 0};
+    const size_t remaining = ZSTD_compressStream2(cctx_, &out, &in, directive);
+    if (ZSTD_isError(remaining)) {
+      return errors::DataLoss("ZSTD_compressStream2() failed: ",
+                              ZSTD_getErrorName(remaining));
+    }
+    if (out.pos > 0) {
+      TF_RETURN_IF_ERROR(
+          file_->Append(StringPiece(output_buffer_.get(), out.pos)));
+    }
+    // With ZSTD_e_continue, zstd may keep data buffered internally. Other
+    // directives report how much is left to be flushed.
+    done = directive == ZSTD_e_continue ? in.pos == in.size : remaining == 0;
+  } while (!done);
+  return absl::OkStatus();
+}
+
+absl::Status ZstdOutputBuffer::CompressBuffered(int end_op) {
+  TF_RETURN_IF_ERROR(Compress(input_buffer_, end_op));
+  input_buffer_.clear();
+  return absl::OkStatus();
+}
+
+absl::Status ZstdOutputBuffer::Append(StringPiece data) {
+  if (cctx_ == nullptr) {
+    return errors::FailedPrecondition(
+        "ZstdOutputBuffer is not initialized or has been closed.");
+  }
+  if (input_buffer_.size() + data.size() <= input_buffer_capacity_) {
+    input_buffer_.append(data.data(), data.size());
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(CompressBuffered(ZSTD_e_continue));
+  if (data.size() <= input_buffer_capacity_) {
+    input_buffer_.append(data.data(), data.size());
+    return absl::OkStatus();
+  }
+  // Data larger than the buffer is handed to zstd directly.
+  return Compress(data, ZSTD_e_continue);
+}
+
+#if defined(TF_CORD_SUPPORT)
+absl::Status ZstdOutputBuffer::Append(const absl::Cord& cord) {
+  for (absl::string_view fragment : cord.Chunks()) {
+    TF_RETURN_IF_ERROR(Append(fragment));
+  }
+  return absl::OkStatus();
+}
+#endif
+
+absl::Status ZstdOutputBuffer::Flush() {
+  if (cctx_ == nullptr) {
+    return errors::FailedPrecondition(
+        "ZstdOutputBuffer is not initialized or has been closed.");
+  }
+  TF_RETURN_IF_ERROR(CompressBuffered(ZSTD_e_flush));
+  return file_->Flush();
+}
+
+absl::Status ZstdOutputBuffer::Name(StringPiece* result) const {
+  return file_->Name(result);
+}
+
+absl::Status ZstdOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
+absl::Status ZstdOutputBuffer::Close() {
+  if (cctx_ != nullptr) {
+    absl::Status s = CompressBuffered(ZSTD_e_end);
+    ZSTD_freeCCtx(cctx_);
+    cctx_ = nullptr;
+    return s;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ZstdOutputBuffer::Tell(int64_t* position) {
+  return file_->Tell(position);
+}
+
+}  // namespace io
+}  // namespace tsl
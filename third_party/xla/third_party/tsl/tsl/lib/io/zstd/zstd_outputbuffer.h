@@ -0,0 +1,121 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+#define TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
+
+#include <memory>
+#include <string>
+
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/macros.h"
+#include "tsl/platform/status.h"
+#include "tsl/platform/stringpiece.h"
+#include "tsl/platform/types.h"
+
+// Forward declare the zstd compression context, which is only included in the
+// .cc file.
+struct ZSTD_CCtx_s;
+
+namespace tsl {
+namespace io {
+
+// Provides support for writing zstd (https://facebook.github.io/zstd/)
+// compressed output to file. All data appended until `Close()` forms a single
+// zstd frame.
+//
+// A given instance of an ZstdOutputBuffer is NOT safe for concurrent use
+// by multiple threads
+class ZstdOutputBuffer : public WritableFile {
+ public:
+  // Create a ZstdOutputBuffer for `file` with two buffers that cache the
+  // 1. input data to be compressed
+  // 2. the compressed output
+  // with sizes `input_buffer_bytes` and `output_buffer_bytes` respectively.
+  // Does not take ownership of `file`.
+  ZstdOutputBuffer(WritableFile* file, size_t input_buffer_bytes,
+                   size_t output_buffer_bytes,
+                   const ZstdCompressionOptions& zstd_options);
+
+  ~ZstdOutputBuffer() override;
+
+  // Initializes the compression context. This call is required before any
+  // other operation on the buffer.
+  absl::Status Init();
+
+  // Adds `data` to the compression pipeline.
+  //
+  // The input data is buffered and compressed in bulk when the buffer gets
+  // full. To immediately write contents to file call `Flush()`.
+  absl::Status Append(StringPiece data) override;
+
+#if defined(TF_CORD_SUPPORT)
+  absl::Status Append(const absl::Cord& cord) override;
+#endif
+
+  // Compresses any cached input and writes all output to file. The frame is
+  // left open so that more data can be appended.
+  absl::Status Flush() override;
+
+  // Compresses any cached input, ends the zstd frame and writes all output to
+  // file. This must be called before the destructor to avoid any data loss.
+  //
+  // After calling this, any further calls to `Append()` or `Flush()` will
+  // fail. Does not close the underlying file.
+  absl::Status Close() override;
+
+  // Returns the name of the underlying file.
+  absl::Status Name(StringPiece* result) const override;
+
+  // Compresses any cached input, writes all output to file and syncs it.
+  absl::Status Sync() override;
+
+  // Returns the write position in the underlying file. The position does not
+  // reflect buffered, un-flushed data.
+  absl::Status Tell(int64_t* position) override;
+
+ private:
+  // Compresses `input` with the given `ZSTD_EndDirective`, writing all
+  // compressed output to `file_`. On return, all of `input` has been
+  // consumed, and if `end_op` is a flush or end directive, all of it has
+  // been written out.
+  absl::Status Compress(StringPiece input, int end_op);
+
+  // Compresses and clears the contents of `input_buffer_`.
+  absl::Status CompressBuffered(int end_op);
+
+  WritableFile* file_;  // Not owned
+  const size_t input_buffer_capacity_;
+  const size_t output_buffer_capacity_;
+  const ZstdCompressionOptions zstd_options_;
+
+  // Uncompressed data waiting to be compressed.
+  std::string input_buffer_;
+  // Scratch space for compressed data before it is written to `file_`.
+  std::unique_ptr<char[]> output_buffer_;
+
+  // Null before `Init()` and after `Close()`.
+  ZSTD_CCtx_s* cctx_ = nullptr;
+
+  ZstdOutputBuffer(const ZstdOutputBuffer&) = delete;
+  void operator=(const ZstdOutputBuffer&) = delete;
+};
+
+}  // namespace io
+}  // namespace tsl
+
+#endif  // TENSORFLOW_TSL_LIB_IO_ZSTD_ZSTD_OUTPUTBUFFER_H_
@@ -0,0 +1,157 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/lib/io/random_inputstream.h"
+#include "tsl/lib/io/zstd/zstd_compression_options.h"
+#include "tsl/lib/io/zstd/zstd_inputstream.h"
+#include "tsl/lib/io/zstd/zstd_outputbuffer.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/strcat.h"
+#include "tsl/platform/test.h"
+
+namespace tsl {
+namespace io {
+namespace {
+
+string GenTestString(int copies) {
+  string result;
+  for (int i = 0; i < copies; ++i) {
+    strings::StrAppend(&result, "Lorem ipsum dolor sit amet, record ", i,
+                       " consectetur adipiscing elit. ");
+  }
+  return result;
+}
+
+// Writes `num_writes` copies of `data` through a ZstdOutputBuffer and returns
+// the name of the compressed file.
+absl::Status WriteCompressed(const string& data, int num_writes,
+                             bool with_flush, size_t input_buf_size,
+                             size_t output_buf_size,
+                             const ZstdCompressionOptions& options,
+                             string* fname) {
+  Env* env = Env::Default();
+  *fname = testing::TmpDir() + "/zstd_buffers_test";
+  std::unique_ptr<WritableFile> file_writer;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(*fname, &file_writer));
+  ZstdOutputBuffer out(file_writer.get(), input_buf_size, output_buf_size,
+                       options);
+  TF_RETURN_IF_ERROR(out.Init());
+  for (int i = 0; i < num_writes; ++i) {
+    TF_RETURN_IF_ERROR(out.Append(StringPiece(data)));
+    if (with_flush) {
+      TF_RETURN_IF_ERROR(out.Flush());
+    }
+  }
+  TF_RETURN_IF_ERROR(out.Close());
+  return file_writer->Close();
+}
+
+void TestRoundTrip(size_t compress_input_buf_size,
+                   size_t compress_output_buf_size,
+                   size_t uncompress_input_buf_size,
+                   size_t uncompress_output_buf_size, int num_writes,
+                   bool with_flush,
+                   const ZstdCompressionOptions& options = {}) {
+  const string data = GenTestString(20);
+  string fname;
+  TF_ASSERT_OK(WriteCompressed(data, num_writes, with_flush,
+                               compress_input_buf_size,
+                               compress_output_buf_size, options, &fname));
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file_reader));
+  ZstdInputStream in(new RandomAccessInputStream(file_reader.get()),
+                     uncompress_input_buf_size, uncompress_output_buf_size,
+                     options, /*owns_input_stream=*/true);
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (int i = 0; i < num_writes; ++i) {
+      tstring decompressed;
+      TF_ASSERT_OK(in.ReadNBytes(data.size(), &decompressed));
+      EXPECT_EQ(decompressed, data);
+    }
+    EXPECT_EQ(in.Tell(), num_writes * data.size());
+    tstring extra;
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &extra)));
+    TF_ASSERT_OK(in.Reset());
+  }
+}
+
+TEST(ZstdBuffers, RoundTrip) {
+  TestRoundTrip(1024, 1024, 1024, 1024, 3, false);
+}
+
+TEST(ZstdBuffers, RoundTripWithFlush) {
+  TestRoundTrip(1024, 1024, 1024, 1024, 3, true);
+}
+
+TEST(ZstdBuffers, SmallBuffers) { TestRoundTrip(16, 16, 16, 16, 5, false); }
+
+TEST(ZstdBuffers, LargeInputSmallOutput) {
+  TestRoundTrip(1 << 20, 64, 64, 1 << 20, 4, true);
+}
+
+TEST(ZstdBuffers, CompressionLevels) {
+  for (int level : {-5, 1, 19}) {
+    ZstdCompressionOptions options;
+    options.compression_level = level;
+    TestRoundTrip(4096, 4096, 4096, 4096, 2, false, options);
+  }
+}
+
+TEST(ZstdBuffers, Dictionary) {
+  ZstdCompressionOptions options;
+  options.dictionary = GenTestString(4);
+  TestRoundTrip(4096, 4096, 4096, 4096, 2, false, options);
+
+  // Data written with a dictionary cannot be read without it.
+  const string data = GenTestString(20);
+  string fname;
+  TF_ASSERT_OK(WriteCompressed(data, 1, false, 4096, 4096, options, &fname));
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file_reader));
+  ZstdInputStream in(new RandomAccessInputStream(file_reader.get()), 4096,
+                     4096, ZstdCompressionOptions(),
+                     /*owns_input_stream=*/true);
+  tstring decompressed;
+  absl::Status s = in.ReadNBytes(data.size(), &decompressed);
+  EXPECT_TRUE(!s.ok() || decompressed != data);
+}
+
+TEST(ZstdBuffers, TruncatedInput) {
+  const string data = GenTestString(20);
+  string fname;
+  TF_ASSERT_OK(WriteCompressed(data, 1, false, 4096, 4096,
+                               ZstdCompressionOptions(), &fname));
+  string compressed;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), fname, &compressed));
+  compressed.resize(compressed.size() / 2);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), fname, compressed));
+
+  std::unique_ptr<RandomAccessFile> file_reader;
+  TF_ASSERT_OK(Env::Default()->NewRandomAccessFile(fname, &file_reader));
+  ZstdInputStream in(new RandomAccessInputStream(file_reader.get()), 4096,
+                     4096, ZstdCompressionOptions(),
+                     /*owns_input_stream=*/true);
+  tstring decompressed;
+  EXPECT_FALSE(in.ReadNBytes(data.size(), &decompressed).ok());
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tsl
@@ -22,6 +22,13 @@ limitations under the License.
 
 #if defined(__linux__)
 #include <sys/sendfile.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup) && \
+    defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#define TSL_POSIX_IO_URING 1
+#endif
 #endif
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -29,13 +36,18 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "tsl/platform/default/posix_file_system.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/file_system_helper.h"
 #include "tsl/platform/logging.h"
+#include "tsl/platform/mutex.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/strcat.h"
+#include "tsl/platform/threadpool.h"
 #include "tsl/protobuf/error_codes.pb.h"
 
 namespace tsl {
@@ -45,6 +57,241 @@ using ::tsl::errors::IOError;
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+#if defined(TSL_POSIX_IO_URING)
+namespace {
+
+// Serves PosixRandomAccessFile::ReadAsync() from a process-wide io_uring, so
+// that any number of reads can be in flight while a single thread reaps their
+// completions. Callbacks run on a small thread pool rather than on the
+// reaping thread, so that a callback may start another read, and block until
+// the ring has room for it, without stalling the completions that free it.
+//
+// The ring is driven with raw system calls to avoid a dependency on liburing.
+class IoUringReader {
+ public:
+  // Returns the process-wide reader, or nullptr if the kernel does not
+  // support io_uring or it is disabled, e.g. by a seccomp policy.
+  static IoUringReader* Get() {
+    static IoUringReader* reader = [] {
+      auto* candidate = new IoUringReader();
+      if (!candidate->Init()) {
+        delete candidate;
+        return static_cast<IoUringReader*>(nullptr);
+      }
+      return candidate;
+    }();
+    return reader;
+  }
+
+  void Read(int fd, const string* filename, uint64 offset, size_t n,
+            char* scratch, RandomAccessFile::ReadDoneCallback done) {
+    if (n == 0) {
+      done(absl::OkStatus(), StringPiece(scratch, 0));
+      return;
+    }
+    auto* request = new Request;
+    request->fd = fd;
+    request->filename = filename;
+    request->offset = offset;
+    request->scratch = scratch;
+    request->n = n;
+    request->done = std::move(done);
+    absl::Status s;
+    {
+      mutex_lock l(mu_);
+      while (num_in_flight_ >= capacity_) {
+        slot_freed_.wait(l);
+      }
+      s = Submit(request);
+      if (s.ok()) {
+        ++num_in_flight_;
+      }
+    }
+    if (!s.ok()) {
+      Finish(request, s);
+    }
+  }
+
+ private:
+  struct Request {
+    int fd;
+    const string* filename;  // Owned by the file, which outlives the read.
+    uint64 offset;
+    char* scratch;
+    size_t n;
+    size_t bytes_read = 0;
+    struct iovec iov;
+    RandomAccessFile::ReadDoneCallback done;
+  };
+
+  // Number of submission queue entries of the ring.
+  static constexpr unsigned kRingEntries = 256;
+  // Number of threads that run the callbacks of completed reads.
+  static constexpr int kNumCallbackThreads = 4;
+
+  IoUringReader() = default;
+
+  bool Init() {
+    struct io_uring_params params = {};
+    ring_fd_ = syscall(__NR_io_uring_setup, kRingEntries, &params);
+    if (ring_fd_ < 0) {
+      VLOG(1) << "io_uring is unavailable, falling back to a thread pool for "
+                 "asynchronous reads: "
+              << strerror(errno);
+      return false;
+    }
+    size_t sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+#if defined(IORING_FEAT_SINGLE_MMAP)
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+#else
+    // Kernel headers older than 5.4 have neither the flag nor
+    // io_uring_params::features, and the rings are always mapped separately.
+    const bool single_mmap = false;
+#endif
+    if (single_mmap) {
+      sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+    char* sq_ring = static_cast<char*>(
+        mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING));
+    char* cq_ring = sq_ring;
+    if (!single_mmap && sq_ring != MAP_FAILED) {
+      cq_ring = static_cast<char*>(
+          mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING));
+    }
+    void* sqes = MAP_FAILED;
+    if (sq_ring != MAP_FAILED && cq_ring != MAP_FAILED) {
+      sqes = mmap(nullptr, params.sq_entries * sizeof(struct io_uring_sqe),
+                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQES);
+    }
+    if (sqes == MAP_FAILED) {
+      // The mappings are leaked along with the ring: this only happens once
+      // per process, when memory is exhausted.
+      LOG(WARNING) << "Failed to map the io_uring rings: " << strerror(errno);
+      close(ring_fd_);
+      return false;
+    }
+    sq_tail_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+    cq_head_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+    // Bounding the reads in flight by the size of either queue guarantees
+    // that neither of them overflows.
+    capacity_ = std::min(params.sq_entries, params.cq_entries);
+    callback_pool_ = new thread::ThreadPool(
+        Env::Default(), "io_uring_callbacks", kNumCallbackThreads);
+    Env::Default()->StartThread(ThreadOptions(), "io_uring_completions",
+                                [this]() { ReapCompletions(); });
+    return true;
+  }
+
+  // Submits the unread part of "request" to the ring. On error, the request
+  // is not in flight.
+  absl::Status Submit(Request* request) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    // Reads of more than 2GB are split, as pread() does on some platforms.
+    request->iov.iov_base = request->scratch + request->bytes_read;
+    request->iov.iov_len =
+        std::min<size_t>(request->n - request->bytes_read, INT32_MAX);
+    // The kernel only consumes submissions during io_uring_enter(), which is
+    // always called under mu_, so the tail is ours to update.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = request->fd;
+    sqe->off = request->offset + request->bytes_read;
+    sqe->addr = reinterpret_cast<uint64>(&request->iov);
+    sqe->len = 1;
+    sqe->user_data = reinterpret_cast<uint64>(request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        // The submission was not consumed, so take it back.
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        return IOError(*request->filename, errno);
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  void ReapCompletions() {
+    while (true) {
+      const unsigned head = *cq_head_;
+      if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        // Errors (e.g. EINTR) are harmless: the queue is polled again.
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                nullptr, 0);
+        continue;
+      }
+      const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      auto* request = reinterpret_cast<Request*>(cqe.user_data);
+      const int res = cqe.res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      HandleCompletion(request, res);
+    }
+  }
+
+  void HandleCompletion(Request* request, int res) {
+    absl::Status s;
+    if (res > 0) {
+      request->bytes_read += res;
+    }
+    if (res == 0) {
+      s = absl::Status(absl::StatusCode::kOutOfRange,
+                       "Read less bytes than requested");
+    } else if (res < 0 && res != -EINTR && res != -EAGAIN) {
+      s = IOError(*request->filename, -res);
+    } else if (request->bytes_read < request->n) {
+      // Continue a short or interrupted read where it stopped.
+      mutex_lock l(mu_);
+      s = Submit(request);
+      if (s.ok()) return;
+    }
+    {
+      mutex_lock l(mu_);
+      --num_in_flight_;
+    }
+    slot_freed_.notify_one();
+    callback_pool_->Schedule([request, s]() { Finish(request, s); });
+  }
+
+  static void Finish(Request* request, const absl::Status& s) {
+    request->done(s, StringPiece(request->scratch, request->bytes_read));
+    delete request;
+  }
+
+  int ring_fd_ = -1;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe* cqes_ = nullptr;
+  unsigned capacity_ = 0;
+  // Never destroyed, like the reader itself.
+  thread::ThreadPool* callback_pool_ = nullptr;
+
+  mutex mu_;
+  condition_variable slot_freed_;
+  unsigned num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+#endif  // TSL_POSIX_IO_URING
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -97,6 +344,25 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  void ReadAsync(uint64 offset, size_t n, char* scratch,
+                 ReadDoneCallback done) const override {
+#if defined(TSL_POSIX_IO_URING)
+    if (IoUringReader* reader = IoUringReader::Get()) {
+      reader->Read(fd_, &filename_, offset, n, scratch, std::move(done));
+      return;
+    }
+#endif
+    RandomAccessFile::ReadAsync(offset, n, scratch, std::move(done));
+  }
+
+  bool HasNativeReadAsync() const override {
+#if defined(TSL_POSIX_IO_URING)
+    return IoUringReader::Get() != nullptr;
+#else
+    return false;
+#endif
+  }
+
 #if defined(TF_CORD_SUPPORT)
   absl::Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {
@@ -37,9 +37,25 @@ limitations under the License.
 #include "tsl/platform/scanner.h"
 #include "tsl/platform/str_util.h"
 #include "tsl/platform/strcat.h"
+#include "tsl/platform/threadpool.h"
 
 namespace tsl {
 
+namespace {
+
+// Number of threads that serve RandomAccessFile::ReadAsync() for file systems
+// without native asynchronous reads. Reads mostly wait on I/O, so this can
+// exceed the number of cores.
+constexpr int kNumAsyncReadThreads = 16;
+
+thread::ThreadPool* AsyncReadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "async_file_read", kNumAsyncReadThreads);
+  return pool;
+}
+
+}  // namespace
+
 bool FileSystem::Match(const string& filename, const string& pattern) {
 #if defined(PLATFORM_POSIX) || defined(IS_MOBILE_PLATFORM) || \
     defined(PLATFORM_GOOGLE)
@@ -492,4 +508,14 @@ std::string FileSystem::DecodeTransaction(const TransactionToken* token) {
   return "No Transaction";
 }
 
+void RandomAccessFile::ReadAsync(uint64 offset, size_t n, char* scratch,
+                                 ReadDoneCallback done) const {
+  AsyncReadThreadPool()->Schedule(
+      [this, offset, n, scratch, done = std::move(done)]() {
+        StringPiece result;
+        tsl::Status s = Read(offset, n, &result, scratch);
+        done(s, result);
+      });
+}
+
 }  // namespace tsl
@@ -771,6 +771,30 @@ class RandomAccessFile {
   virtual tsl::Status Read(uint64 offset, size_t n, StringPiece* result,
                            char* scratch) const = 0;
 
+  /// \brief Callback of `ReadAsync()`, which receives the status and the
+  /// result that `Read()` would have produced.
+  typedef std::function<void(const tsl::Status&, StringPiece)>
+      ReadDoneCallback;
+
+  /// \brief Starts reading up to `n` bytes from the file starting at
+  /// `offset`, and calls `done` when the read has finished.
+  ///
+  /// Has the same semantics as `Read()`, but lets callers keep many reads in
+  /// flight without blocking a thread on each of them. `scratch[0..n-1]` and
+  /// the file itself must stay live until `done` has run. `done` may run on
+  /// the calling thread or on a thread owned by the file system, so it
+  /// should not block.
+  ///
+  /// The default implementation runs `Read()` on a process-wide thread pool.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadAsync(uint64 offset, size_t n, char* scratch,
+                         ReadDoneCallback done) const;
+
+  /// \brief Returns true if `ReadAsync()` does not occupy a thread while
+  /// the read is in flight, so that reading ahead is cheap.
+  virtual bool HasNativeReadAsync() const { return false; }
+
 #if defined(TF_CORD_SUPPORT)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
   virtual tsl::Status Read(uint64 offset, size_t n, absl::Cord* cord) const {
@@ -25,6 +25,7 @@ load("//third_party/implib_so:workspace.bzl", implib_so = "repo")
 load("//third_party/llvm:setup.bzl", "llvm_setup")
 load("//third_party/nasm:workspace.bzl", nasm = "repo")
 load("//third_party/nccl:nccl_configure.bzl", "nccl_configure")
+load("//third_party/net_zstd:workspace.bzl", net_zstd = "repo")
 load("//third_party/py:python_configure.bzl", "python_configure")
 load("//third_party/py/ml_dtypes:workspace.bzl", ml_dtypes = "repo")
 load("//third_party/pybind11_abseil:workspace.bzl", pybind11_abseil = "repo")
@@ -52,6 +53,7 @@ def _initialize_third_party():
     implib_so()
     ml_dtypes()
     nasm()
+    net_zstd()
     pybind11_abseil()
     pybind11_bazel()
     tensorrt()